@@ -27,6 +27,10 @@
 #include "acamera_connection.h"
 #endif
 
+#if ISP_PLATFORM_CMODEL
+#include "acamera_cmodel.h"
+#endif
+
 // the settings for each firmware context were pre-generated and
 // saved in the header file. They are given as a reference and should be changed
 // according to the customer needs.
@@ -65,7 +69,12 @@ void *callback_dma_alloc_coherent( uint32_t ctx_id, uint64_t size, uint64_t *dma
     *dma_addr -= ISP_SOC_DMA_BUS_OFFSET;
 
     /* compute virt address */
+#if ISP_PLATFORM_CMODEL
+    // the memory the model reads and writes through its bus
+    virt_addr = acamera_cmodel_ddr_ptr( *dma_addr, size );
+#else
     virt_addr = (void *)addr;
+#endif
 
     return virt_addr;
 }
@@ -196,6 +205,12 @@ int main( void )
         while ( acamera_main_loop_active ) {
             // acamera_process must be called for each initialised context
             acamera_process();
+#if ISP_PLATFORM_CMODEL
+            // the host run ends with the model input
+            if ( acamera_cmodel_finished() ) {
+                acamera_main_loop_active = 0;
+            }
+#endif
 #if ISP_HAS_STREAM_CONNECTION && !CONNECTION_IN_THREAD
             // acamera_connection_process is used for communication between
             // firmware and ACT through different possible channels like
@@ -242,7 +242,6 @@ static int dma_writer_configure_pipe( dma_pipe *pipe )
     tframe_t *delay_frame = &pipe->settings.delay_frame;
     dma_writer_reg_ops_t *primary_ops = &pipe->primary;
     dma_writer_reg_ops_t *secondary_ops = &pipe->secondary;
-    int rc;
 
     if ( !p_ctx ) {
         LOG( LOG_ERR, "No context available." );
@@ -267,9 +266,18 @@ static int dma_writer_configure_pipe( dma_pipe *pipe )
     /* delay_frame is the last current frame written in the software config */
     *delay_frame = *curr_frame;
 
-    /* try to get a new buffer from application (V4l2 for example) */
-    rc = dma_writer_stream_get_frame( pipe, curr_frame );
-    if ( rc ) {
+    /* the sensor outputs corrupted frames right after a mode switch */
+    if ( pipe->settings.mode_switches != p_ctx->sensor_mode_switches ) {
+        pipe->settings.mode_switches = p_ctx->sensor_mode_switches;
+        pipe->settings.frames_to_drop = p_ctx->sensor_switch_skip_frames;
+    }
+    if ( pipe->settings.frames_to_drop ) {
+        pipe->settings.frames_to_drop--;
+        pipe->settings.frames_dropped++;
+        curr_frame->primary.status = dma_buf_purge;
+        curr_frame->secondary.status = dma_buf_purge;
+    } else if ( dma_writer_stream_get_frame( pipe, curr_frame ) ) {
+        /* no new buffer from the application (V4l2 for example) */
 #if CONFIG_DMA_WRITER_DEFAULT_BUFFER
         /* if there is no available buffer, use one of the default buffers */
         *curr_frame = pipe->settings.default_frame[pipe->settings.default_index];
@@ -111,6 +111,11 @@ typedef struct dma_pipe_settings {
     uint32_t ctx_id;
     uint8_t pause;
     struct _acamera_context_t *p_ctx;
+
+    uint32_t frames_dropped; // frames dropped while the sensor settles after a mode switch
+
+    uint32_t mode_switches;  // last sensor mode switch seen by the pipe
+    uint32_t frames_to_drop; // frames still to drop after that switch
 } dma_pipe_settings;
 
 
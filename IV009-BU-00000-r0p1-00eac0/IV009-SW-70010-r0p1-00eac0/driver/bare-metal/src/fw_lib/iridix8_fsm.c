@@ -52,6 +52,11 @@ void iridix_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     iridix_fsm_clear( p_fsm );
 
+    // the strength controls are read by index
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_IRIDIX8_STRENGTH_DK_ENH_CONTROL, 14 * sizeof( uint32_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_IRIDIX_EV_LIM_NO_STR, 2 * sizeof( uint32_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_CONTROL, 2 * sizeof( uint32_t ) );
+
     iridix_initialize( p_fsm );
 }
 
@@ -94,14 +94,14 @@ void stitching_error_calculate( noise_reduction_fsm_t *p_fsm )
 
     uint16_t log2_gain = total_gain >> ( LOG2_GAIN_SHIFT - 8 );
     //long medium motion
-    uint16_t lm_np = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_NP ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_NP ) );
-    uint16_t lm_mov_mult = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_MOV_MULT ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_MOV_MULT ) );
+    uint16_t lm_np = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_NP, log2_gain );
+    uint16_t lm_mov_mult = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_MOV_MULT, log2_gain );
     //medium short motion
-    uint16_t ms_np = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_MS_NP ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_MS_NP ) );
-    uint16_t ms_mov_mult = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_MS_MOV_MULT ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_MS_MOV_MULT ) );
+    uint16_t ms_np = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_MS_NP, log2_gain );
+    uint16_t ms_mov_mult = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_MS_MOV_MULT, log2_gain );
     //short very short motion
-    uint16_t svs_np = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_SVS_NP ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_SVS_NP ) );
-    uint16_t svs_mov_mult = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_SVS_MOV_MULT ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_SVS_MOV_MULT ) );
+    uint16_t svs_np = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_SVS_NP, log2_gain );
+    uint16_t svs_mov_mult = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_SVS_MOV_MULT, log2_gain );
 
 
     //change to MC off mode when gain is higher than gain_log2 value found in calibration
@@ -115,7 +115,7 @@ void stitching_error_calculate( noise_reduction_fsm_t *p_fsm )
         // printf("%d %d %d\n",(int)log2_gain, 0,(int)MC_off_enable_gain );
     }
 
-    uint16_t stitching_lm_med_noise_intensity_thresh = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_MED_NOISE_INTENSITY ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_MED_NOISE_INTENSITY ) );
+    uint16_t stitching_lm_med_noise_intensity_thresh = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STITCHING_LM_MED_NOISE_INTENSITY, log2_gain );
 
 #if ISP_WDR_SWITCH
 
@@ -158,6 +158,13 @@ void stitching_error_calculate( noise_reduction_fsm_t *p_fsm )
 #endif
 }
 
+static const acamera_reg_field_t sinter_strength_1_field = ACAMERA_ISP_SINTER_STRENGTH_1_FIELD;
+static const acamera_reg_field_t sinter_int_config_field = ACAMERA_ISP_SINTER_INT_CONFIG_FIELD;
+static const acamera_reg_field_t sinter_thresh_fields[4] = {
+    ACAMERA_ISP_SINTER_THRESH_1H_FIELD, ACAMERA_ISP_SINTER_THRESH_4H_FIELD,
+    ACAMERA_ISP_SINTER_THRESH_1V_FIELD, ACAMERA_ISP_SINTER_THRESH_4V_FIELD,
+};
+
 void sinter_strength_calculate( noise_reduction_fsm_t *p_fsm )
 {
     uint32_t cmos_exp_ratio = 0;
@@ -182,7 +189,7 @@ void sinter_strength_calculate( noise_reduction_fsm_t *p_fsm )
         uint16_t log2_gain = total_gain >> ( LOG2_GAIN_SHIFT - 8 );
 
         // LOG( LOG_NOTICE, "log2_gain %d total_gain %d", log2_gain, total_gain );
-        snr_thresh_master = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength_idx ) );
+        snr_thresh_master = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength_idx, log2_gain );
 #if ( defined( ISP_HAS_IRIDIX8_FSM ) || defined( ISP_HAS_IRIDIX8_MANUAL_FSM ) ) && defined( CALIBRATION_SINTER_STRENGTH_MC_CONTRAST ) //CHECK LOGIC IS CORRECT
         uint32_t sinter_strength_mc_contrast_idx = CALIBRATION_SINTER_STRENGTH_MC_CONTRAST;
         // Adjust strength according to contrast
@@ -191,7 +198,7 @@ void sinter_strength_calculate( noise_reduction_fsm_t *p_fsm )
         acamera_fsm_mgr_get_param( p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_IRIDIX_CONTRAST, NULL, 0, &iridix_contrast, sizeof( iridix_contrast ) );
 
         iridix_contrast = iridix_contrast >> 8;
-        uint32_t snr_thresh_master_contrast = acamera_calc_modulation_u16( iridix_contrast, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength_mc_contrast_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength_mc_contrast_idx ) );
+        uint32_t snr_thresh_master_contrast = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength_mc_contrast_idx, iridix_contrast );
         if ( snr_thresh_master_contrast > 0xFF )
             snr_thresh_master_contrast = 0xFF;
         //it will only affect short exposure
@@ -204,22 +211,23 @@ void sinter_strength_calculate( noise_reduction_fsm_t *p_fsm )
 
         ACAMERA_FSM2CTX_PTR( p_fsm )
             ->stab.global_sinter_threshold_target = ( snr_thresh_master );
-        uint16_t sinter_strenght1 = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength1_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength1_idx ) );
+        uint16_t sinter_strenght1 = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_strength1_idx, log2_gain );
         // LOG( LOG_INFO, "sinter_strenght1 %d log2_gain %d ", (int)sinter_strenght1, (int)log2_gain );
-        acamera_isp_sinter_strength_1_write( p_fsm->cmn.isp_base, sinter_strenght1 );
-        uint16_t sinter_thresh1 = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_thresh1_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_thresh1_idx ) );
-        acamera_isp_sinter_thresh_1h_write( p_fsm->cmn.isp_base, sinter_thresh1 );
-        acamera_isp_sinter_thresh_1v_write( p_fsm->cmn.isp_base, sinter_thresh1 );
-        uint16_t sinter_thresh4 = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_thresh4_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_thresh4_idx ) );
-        acamera_isp_sinter_thresh_4h_write( p_fsm->cmn.isp_base, sinter_thresh4 );
-        acamera_isp_sinter_thresh_4v_write( p_fsm->cmn.isp_base, sinter_thresh4 );
-
-        uint16_t sinter_int_config = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_int_config_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_int_config_idx ) );
-        acamera_isp_sinter_int_config_write( p_fsm->cmn.isp_base, sinter_int_config );
+        fsm_reg_write( p_fsm, FSM_ID_NOISE_REDUCTION, &sinter_strength_1_field, sinter_strenght1 );
+        uint16_t sinter_thresh1 = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_thresh1_idx, log2_gain );
+        uint16_t sinter_thresh4 = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_thresh4_idx, log2_gain );
+        // 1h and 4h share a register, as do 1v and 4v
+        fsm_reg_write( p_fsm, FSM_ID_NOISE_REDUCTION, &sinter_thresh_fields[0], sinter_thresh1 );
+        fsm_reg_write( p_fsm, FSM_ID_NOISE_REDUCTION, &sinter_thresh_fields[1], sinter_thresh4 );
+        fsm_reg_write( p_fsm, FSM_ID_NOISE_REDUCTION, &sinter_thresh_fields[2], sinter_thresh1 );
+        fsm_reg_write( p_fsm, FSM_ID_NOISE_REDUCTION, &sinter_thresh_fields[3], sinter_thresh4 );
+
+        uint16_t sinter_int_config = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_int_config_idx, log2_gain );
+        fsm_reg_write( p_fsm, FSM_ID_NOISE_REDUCTION, &sinter_int_config_field, sinter_int_config );
 
         if ( acamera_isp_isp_global_parameter_status_sinter_version_read( p_fsm->cmn.isp_base ) ) { //sinter 3 is used
             int sinter_sad_inx = CALIBRATION_SINTER_SAD;
-            acamera_isp_sinter_sad_filt_thresh_write( p_fsm->cmn.isp_base, acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_sad_inx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_sad_inx ) ) );
+            acamera_isp_sinter_sad_filt_thresh_write( p_fsm->cmn.isp_base, acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), sinter_sad_inx, log2_gain ) );
         }
     } else {
         snr_thresh_master = ACAMERA_FSM2CTX_PTR( p_fsm )->stab.global_sinter_threshold_target;
@@ -243,7 +251,7 @@ void temper_strength_calculate( noise_reduction_fsm_t *p_fsm )
         acamera_fsm_mgr_get_param( p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_CMOS_TOTAL_GAIN, NULL, 0, &total_gain, sizeof( total_gain ) );
         uint16_t log2_gain = total_gain >> ( LOG2_GAIN_SHIFT - 8 );
         //this drives global offset
-        tnr_thresh_master = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_TEMPER_STRENGTH ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_TEMPER_STRENGTH ) );
+        tnr_thresh_master = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_TEMPER_STRENGTH, log2_gain );
         ACAMERA_FSM2CTX_PTR( p_fsm )
             ->stab.global_temper_threshold_target = ( tnr_thresh_master );
 
@@ -484,7 +492,7 @@ void noise_reduction_update( noise_reduction_fsm_t *p_fsm )
     uint16_t log2_gain = total_gain >> ( LOG2_GAIN_SHIFT - 8 );
     if ( ACAMERA_FSM2CTX_PTR( p_fsm )->stab.global_manual_demosaic == 0 ) {
         int tbl_inx = CALIBRATION_DEMOSAIC_NP_OFFSET;
-        acamera_isp_demosaic_rgb_np_offset_write( p_fsm->cmn.isp_base, acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), tbl_inx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), tbl_inx ) ) );
+        acamera_isp_demosaic_rgb_np_offset_write( p_fsm->cmn.isp_base, acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), tbl_inx, log2_gain ) );
     }
 
     //  Do not update values if manual mode
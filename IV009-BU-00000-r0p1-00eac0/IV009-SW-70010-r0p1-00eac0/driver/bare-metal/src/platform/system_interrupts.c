@@ -23,6 +23,10 @@ void system_interrupt_set_handler( system_interrupt_handler_t handler, void *par
 {
 }
 
+void system_interrupt_set_thread_handler( system_interrupt_handler_t handler, void *param )
+{
+}
+
 void system_interrupts_enable( void )
 {
 }
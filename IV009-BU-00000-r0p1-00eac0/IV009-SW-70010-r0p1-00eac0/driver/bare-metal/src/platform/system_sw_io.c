@@ -35,10 +35,16 @@ int32_t close_sw_io( void )
     return -1;
 }
 
+#if SYSTEM_SW_IO_INLINE
+void system_sw_io_null_access( uintptr_t addr, uint32_t data, int write )
+{
+}
+#else
 uint32_t system_sw_read_32( uintptr_t addr )
 {
     return 0;
 }
+#endif
 
 uint16_t system_sw_read_16( uintptr_t addr )
 {
@@ -51,9 +57,11 @@ uint8_t system_sw_read_8( uintptr_t addr )
 }
 
 
+#if !SYSTEM_SW_IO_INLINE
 void system_sw_write_32( uintptr_t addr, uint32_t data )
 {
 }
+#endif
 
 void system_sw_write_16( uintptr_t addr, uint16_t data )
 {
@@ -62,3 +70,7 @@ void system_sw_write_16( uintptr_t addr, uint16_t data )
 void system_sw_write_8( uintptr_t addr, uint8_t data )
 {
 }
+
+void system_sw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+}
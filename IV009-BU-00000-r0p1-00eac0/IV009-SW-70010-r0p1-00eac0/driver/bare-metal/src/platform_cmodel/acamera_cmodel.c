@@ -0,0 +1,476 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "arm_model_api.h"
+#include "acamera_firmware_config.h"
+#include "acamera_isp_core_nomem_settings.h"
+#include "acamera_logger.h"
+#include "acamera_cmodel.h"
+#include "acamera_cmodel_frame_io.h"
+
+// isp global interrupt registers, see acamera_isp_isp_global_interrupt_*
+#define CMODEL_REG_IRQ_MASK_VECTOR 0x30
+#define CMODEL_REG_IRQ_CLEAR 0x40
+#define CMODEL_REG_IRQ_STATUS_VECTOR 0x44
+
+// the arena stands for the region the application allocates dma memory from
+#define CMODEL_DDR_BUS_BASE ( (uint64_t)ISP_MBLAZE_DMA_COHERENT_DUMMY_ALLOC_BASE - ISP_SOC_DMA_BUS_OFFSET )
+#define CMODEL_DDR_SIZE ( (uint64_t)ISP_MBLAZE_DMA_COHERENT_DUMMY_ALLOC_SIZE )
+
+// output planes allocated for every model output
+#define CMODEL_OUTPUT_PLANES 3
+
+typedef struct {
+    uint64_t frames;
+    uint64_t model_us;     // frame thread cpu time in arm_model_process_frames
+    uint64_t irq_us;       // frame thread cpu time in the firmware interrupt handler
+    uint64_t start_us;     // wall clock at the first frame
+    uint64_t cpu_start_us; // process cpu time at the first frame
+} cmodel_stats_t;
+
+typedef struct {
+    pthread_mutex_t model_lock; // the model is not reentrant
+    pthread_t frame_thread;
+    int thread_started;
+    volatile int running;
+    volatile int finished;
+
+    uint8_t *ddr;
+
+    uint32_t irq_status;
+    uint32_t irq_mask;
+    uint32_t irq_clear;
+    volatile int irq_enabled;
+    system_interrupt_handler_t irq_handler;
+    void *irq_param;
+
+    cmodel_reader_t input;
+    cmodel_format_t input_format;
+    cmodel_writer_t output;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t frames_max;
+    uint32_t frame_us;
+
+    frame_t *frames_in;
+    size_t frames_in_num;
+    frame_t *frames_out;
+    size_t frames_out_num;
+
+    cmodel_stats_t stats;
+} cmodel_t;
+
+static cmodel_t cmodel;
+
+
+static uint64_t cmodel_clock_us( clockid_t clock )
+{
+    struct timespec ts;
+    clock_gettime( clock, &ts );
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t cmodel_env( const char *name, uint32_t def )
+{
+    const char *value = getenv( name );
+    return value ? (uint32_t)strtoul( value, NULL, 0 ) : def;
+}
+
+void *acamera_cmodel_ddr_ptr( uint64_t bus_addr, uint32_t size )
+{
+    if ( cmodel.ddr == NULL || bus_addr < CMODEL_DDR_BUS_BASE || bus_addr - CMODEL_DDR_BUS_BASE + size > CMODEL_DDR_SIZE ) {
+        return NULL;
+    }
+
+    return cmodel.ddr + ( bus_addr - CMODEL_DDR_BUS_BASE );
+}
+
+// AXI accesses of the model, the dma writer outputs land here
+static void cmodel_memory_read( uint8_t *buffer, uint32_t address, uint32_t size )
+{
+    void *p = acamera_cmodel_ddr_ptr( address, size );
+
+    if ( p != NULL ) {
+        memcpy( buffer, p, size );
+    } else {
+        LOG( LOG_ERR, "Model read of %u bytes at 0x%x is out of the DDR arena", (unsigned int)size, (unsigned int)address );
+        memset( buffer, 0, size );
+    }
+}
+
+static void cmodel_memory_write( const uint8_t *buffer, uint32_t address, uint32_t size )
+{
+    void *p = acamera_cmodel_ddr_ptr( address, size );
+
+    if ( p != NULL ) {
+        memcpy( p, buffer, size );
+    } else {
+        LOG( LOG_ERR, "Model write of %u bytes at 0x%x is out of the DDR arena", (unsigned int)size, (unsigned int)address );
+    }
+}
+
+uint32_t acamera_cmodel_read_reg( uint32_t addr )
+{
+    uint32_t data = 0;
+
+    pthread_mutex_lock( &cmodel.model_lock );
+    if ( addr == CMODEL_REG_IRQ_STATUS_VECTOR ) {
+        data = cmodel.irq_status;
+    } else if ( arm_model_read_config( &data, addr, 1 ) != ARM_MODEL_SUCCESS ) {
+        LOG( LOG_ERR, "Model config read at 0x%x failed", (unsigned int)addr );
+    }
+    pthread_mutex_unlock( &cmodel.model_lock );
+
+    return data;
+}
+
+void acamera_cmodel_write_reg( uint32_t addr, uint32_t data )
+{
+    pthread_mutex_lock( &cmodel.model_lock );
+    if ( addr == CMODEL_REG_IRQ_CLEAR ) {
+        // the status vector is cleared on a rising edge of bit 0
+        if ( ( data & 1 ) && !( cmodel.irq_clear & 1 ) ) {
+            cmodel.irq_status = 0;
+        }
+        cmodel.irq_clear = data;
+    } else if ( addr == CMODEL_REG_IRQ_MASK_VECTOR ) {
+        cmodel.irq_mask = data;
+    }
+
+    if ( arm_model_write_config( &data, addr, 1 ) != ARM_MODEL_SUCCESS ) {
+        LOG( LOG_ERR, "Model config write at 0x%x failed", (unsigned int)addr );
+    }
+    pthread_mutex_unlock( &cmodel.model_lock );
+}
+
+void acamera_cmodel_read_config( uint32_t *data, uint32_t addr, uint32_t words )
+{
+    pthread_mutex_lock( &cmodel.model_lock );
+    if ( arm_model_read_config( data, addr, words ) != ARM_MODEL_SUCCESS ) {
+        LOG( LOG_ERR, "Model config read of %u words at 0x%x failed", (unsigned int)words, (unsigned int)addr );
+    }
+    pthread_mutex_unlock( &cmodel.model_lock );
+}
+
+void acamera_cmodel_write_config( const uint32_t *data, uint32_t addr, uint32_t words )
+{
+    pthread_mutex_lock( &cmodel.model_lock );
+    if ( arm_model_write_config( data, addr, words ) != ARM_MODEL_SUCCESS ) {
+        LOG( LOG_ERR, "Model config write of %u words at 0x%x failed", (unsigned int)words, (unsigned int)addr );
+    }
+    pthread_mutex_unlock( &cmodel.model_lock );
+}
+
+// Latch an event in the emulated status vector and call the firmware as the irq line would.
+static void cmodel_raise_irq( uint32_t event )
+{
+    uint32_t status;
+    uint64_t cpu_us;
+
+    pthread_mutex_lock( &cmodel.model_lock );
+    cmodel.irq_status |= ( 1 << event ) & ~cmodel.irq_mask;
+    status = cmodel.irq_status;
+    pthread_mutex_unlock( &cmodel.model_lock );
+
+    if ( !status || !cmodel.irq_enabled || cmodel.irq_handler == NULL ) {
+        return;
+    }
+
+    cpu_us = cmodel_clock_us( CLOCK_THREAD_CPUTIME_ID );
+    cmodel.irq_handler( cmodel.irq_param, status );
+    cmodel.stats.irq_us += cmodel_clock_us( CLOCK_THREAD_CPUTIME_ID ) - cpu_us;
+}
+
+static void cmodel_frames_free( void )
+{
+    size_t idx;
+
+    for ( idx = 0; cmodel.frames_in && idx < cmodel.frames_in_num; idx++ ) {
+        free( cmodel.frames_in[idx].data );
+    }
+    for ( idx = 0; cmodel.frames_out && idx < cmodel.frames_out_num; idx++ ) {
+        free( cmodel.frames_out[idx].data );
+    }
+
+    free( cmodel.frames_in );
+    free( cmodel.frames_out );
+    cmodel.frames_in = NULL;
+    cmodel.frames_out = NULL;
+}
+
+static int32_t cmodel_frames_alloc( void )
+{
+    size_t samples = (size_t)cmodel.width * cmodel.height;
+    size_t idx;
+
+    if ( arm_model_get_frames_number( &cmodel.frames_in_num, &cmodel.frames_out_num ) != ARM_MODEL_SUCCESS || cmodel.frames_in_num == 0 ) {
+        LOG( LOG_CRIT, "Failed to get the number of model frames" );
+        return -1;
+    }
+
+    cmodel.frames_in = calloc( cmodel.frames_in_num, sizeof( frame_t ) );
+    cmodel.frames_out = calloc( cmodel.frames_out_num ? cmodel.frames_out_num : 1, sizeof( frame_t ) );
+    if ( cmodel.frames_in == NULL || cmodel.frames_out == NULL ) {
+        return -1;
+    }
+
+    for ( idx = 0; idx < cmodel.frames_in_num; idx++ ) {
+        frame_t *p_frame = &cmodel.frames_in[idx];
+        p_frame->width = cmodel.width;
+        p_frame->height = cmodel.height;
+        p_frame->planes = 1;
+        p_frame->depth = cmodel.depth;
+        p_frame->data_size = samples * sizeof( data_t );
+        p_frame->data = malloc( p_frame->data_size );
+        if ( p_frame->data == NULL ) {
+            return -1;
+        }
+    }
+
+    // the model fills the dimensions, only the storage is given
+    for ( idx = 0; idx < cmodel.frames_out_num; idx++ ) {
+        frame_t *p_frame = &cmodel.frames_out[idx];
+        p_frame->data_size = samples * CMODEL_OUTPUT_PLANES * sizeof( data_t );
+        p_frame->data = malloc( p_frame->data_size );
+        if ( p_frame->data == NULL ) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// Fill every model input with the next frame, returns 0 when the input has ended.
+static int cmodel_read_frame( void )
+{
+    data_t *data = cmodel.frames_in[0].data;
+    size_t idx;
+
+    if ( cmodel.input.map != NULL ) {
+        const uint8_t *src = cmodel_reader_next( &cmodel.input );
+        if ( src == NULL || cmodel_unpack_frame( cmodel.input_format, src, data, cmodel.width, cmodel.height ) != 0 ) {
+            return 0;
+        }
+    } else if ( cmodel.stats.frames == 0 ) {
+        // a flat mid level frame is enough to run the firmware loop
+        size_t samples = (size_t)cmodel.width * cmodel.height;
+        for ( idx = 0; idx < samples; idx++ ) {
+            data[idx] = 1 << ( cmodel.depth - 1 );
+        }
+    }
+
+    // every exposure of a multi-exposure input gets the same frame
+    for ( idx = 1; idx < cmodel.frames_in_num; idx++ ) {
+        memcpy( cmodel.frames_in[idx].data, cmodel.frames_in[0].data, cmodel.frames_in[0].data_size );
+    }
+
+    return 1;
+}
+
+static void *cmodel_frame_thread( void *arg )
+{
+    while ( cmodel.running ) {
+        uint64_t frame_start = cmodel_clock_us( CLOCK_MONOTONIC );
+        arm_model_error_t err;
+        uint64_t cpu_us;
+
+        if ( cmodel.frames_max && cmodel.stats.frames >= cmodel.frames_max ) {
+            break;
+        }
+
+        if ( !cmodel_read_frame() ) {
+            break;
+        }
+
+        if ( cmodel.stats.frames == 0 ) {
+            cmodel.stats.start_us = frame_start;
+            cmodel.stats.cpu_start_us = cmodel_clock_us( CLOCK_PROCESS_CPUTIME_ID );
+        }
+
+        cmodel_raise_irq( ISP_INTERRUPT_EVENT_ISP_START_FRAME_START );
+
+        pthread_mutex_lock( &cmodel.model_lock );
+        cpu_us = cmodel_clock_us( CLOCK_THREAD_CPUTIME_ID );
+        err = arm_model_process_frames( cmodel.frames_in, cmodel.frames_out, NULL, 0, 0 );
+        cmodel.stats.model_us += cmodel_clock_us( CLOCK_THREAD_CPUTIME_ID ) - cpu_us;
+        pthread_mutex_unlock( &cmodel.model_lock );
+
+        if ( err != ARM_MODEL_SUCCESS ) {
+            LOG( LOG_CRIT, "Model failed to process frame %u, error %d", (unsigned int)cmodel.stats.frames, (int)err );
+            break;
+        }
+
+        cmodel_raise_irq( ISP_INTERRUPT_EVENT_ISP_END_FRAME_END );
+        cmodel.stats.frames++;
+
+        if ( cmodel.output.file != NULL && cmodel.frames_out_num && cmodel_writer_put( &cmodel.output, &cmodel.frames_out[0] ) != 0 ) {
+            LOG( LOG_CRIT, "Failed to store the output of frame %u", (unsigned int)cmodel.stats.frames );
+            break;
+        }
+
+        if ( cmodel.frame_us ) {
+            uint64_t elapsed = cmodel_clock_us( CLOCK_MONOTONIC ) - frame_start;
+            if ( elapsed < cmodel.frame_us ) {
+                usleep( cmodel.frame_us - elapsed );
+            }
+        }
+    }
+
+    cmodel.finished = 1;
+    return NULL;
+}
+
+static void cmodel_report( void )
+{
+    const cmodel_stats_t *p_stats = &cmodel.stats;
+    uint64_t wall_us, cpu_us, fw_us;
+
+    if ( p_stats->frames == 0 ) {
+        LOG( LOG_NOTICE, "C model processed no frames" );
+        return;
+    }
+
+    wall_us = cmodel_clock_us( CLOCK_MONOTONIC ) - p_stats->start_us;
+    cpu_us = cmodel_clock_us( CLOCK_PROCESS_CPUTIME_ID ) - p_stats->cpu_start_us;
+    fw_us = ( cpu_us > p_stats->model_us + p_stats->irq_us ) ? cpu_us - p_stats->model_us - p_stats->irq_us : 0;
+
+    LOG( LOG_NOTICE, "C model processed %u frames in %u ms, %u.%03u fps",
+         (unsigned int)p_stats->frames, (unsigned int)( wall_us / 1000 ),
+         (unsigned int)( p_stats->frames * 1000000 / wall_us ), (unsigned int)( p_stats->frames * 1000000000 / wall_us % 1000 ) );
+    LOG( LOG_NOTICE, "Cpu time per frame: model %u us, firmware interrupt %u us, firmware loop %u us",
+         (unsigned int)( p_stats->model_us / p_stats->frames ), (unsigned int)( p_stats->irq_us / p_stats->frames ), (unsigned int)( fw_us / p_stats->frames ) );
+}
+
+void acamera_cmodel_set_irq_handler( system_interrupt_handler_t handler, void *param )
+{
+    cmodel.irq_param = param;
+    cmodel.irq_handler = handler;
+
+    // the firmware is ready for frames once it handles interrupts
+    if ( handler != NULL && !cmodel.thread_started && cmodel.frames_in != NULL ) {
+        cmodel.running = 1;
+        if ( pthread_create( &cmodel.frame_thread, NULL, cmodel_frame_thread, NULL ) == 0 ) {
+            cmodel.thread_started = 1;
+        } else {
+            LOG( LOG_CRIT, "Failed to start the model frame thread" );
+            cmodel.running = 0;
+            cmodel.finished = 1;
+        }
+    }
+}
+
+void acamera_cmodel_irq_enable( int enable )
+{
+    cmodel.irq_enabled = enable;
+}
+
+int acamera_cmodel_finished( void )
+{
+    return cmodel.finished;
+}
+
+int32_t acamera_cmodel_init( void )
+{
+    const char *input_name = getenv( "CMODEL_INPUT" );
+    const char *input_format = getenv( "CMODEL_INPUT_FORMAT" );
+    const char *output_name = getenv( "CMODEL_OUTPUT" );
+    const char *output_format = getenv( "CMODEL_OUTPUT_FORMAT" );
+    int32_t format_in = cmodel_format_parse( input_format ? input_format : "raw16" );
+    int32_t format_out = cmodel_format_parse( output_format ? output_format : "nv12" );
+
+    memset( &cmodel, 0, sizeof( cmodel ) );
+    pthread_mutex_init( &cmodel.model_lock, NULL );
+    cmodel.irq_enabled = 1;
+    cmodel.input.fd = -1;
+
+    cmodel.width = cmodel_env( "CMODEL_WIDTH", CMODEL_DEFAULT_WIDTH );
+    cmodel.height = cmodel_env( "CMODEL_HEIGHT", CMODEL_DEFAULT_HEIGHT );
+    cmodel.depth = cmodel_env( "CMODEL_DEPTH", CMODEL_DEFAULT_DEPTH );
+    cmodel.frames_max = cmodel_env( "CMODEL_FRAMES", input_name ? 0 : CMODEL_DEFAULT_FRAMES );
+    cmodel.frame_us = cmodel_env( "CMODEL_FRAME_US", 0 );
+    cmodel_frame_io_set_threads( cmodel_env( "CMODEL_THREADS", 0 ) );
+
+    if ( format_in < 0 || format_in > CMODEL_FORMAT_RAW16 || format_out < CMODEL_FORMAT_RAW16 ) {
+        LOG( LOG_CRIT, "Wrong model input format %s or output format %s", input_format ? input_format : "raw16", output_format ? output_format : "nv12" );
+        return -1;
+    }
+    cmodel.input_format = (cmodel_format_t)format_in;
+
+    if ( cmodel.width == 0 || cmodel.height == 0 || cmodel.depth == 0 || cmodel.depth > 16 ) {
+        LOG( LOG_CRIT, "Wrong model input %ux%u, %u bits", (unsigned int)cmodel.width, (unsigned int)cmodel.height, (unsigned int)cmodel.depth );
+        return -1;
+    }
+
+    // the arena is touched only where the firmware allocates, so it is cheap on the host
+    cmodel.ddr = calloc( 1, CMODEL_DDR_SIZE );
+    if ( cmodel.ddr == NULL ) {
+        LOG( LOG_CRIT, "Failed to allocate %u MB for the DDR arena", (unsigned int)( CMODEL_DDR_SIZE >> 20 ) );
+        return -1;
+    }
+
+    if ( input_name != NULL ) {
+        size_t frame_size = cmodel_format_frame_size( cmodel.input_format, cmodel.width, cmodel.height );
+        if ( cmodel_reader_open( &cmodel.input, input_name, frame_size ) != 0 ) {
+            LOG( LOG_CRIT, "Failed to open the model input %s", input_name );
+            acamera_cmodel_destroy();
+            return -1;
+        }
+    }
+
+    if ( output_name != NULL && cmodel_writer_open( &cmodel.output, output_name, (cmodel_format_t)format_out ) != 0 ) {
+        LOG( LOG_CRIT, "Failed to create the model output %s", output_name );
+        acamera_cmodel_destroy();
+        return -1;
+    }
+
+    if ( arm_model_reset() != ARM_MODEL_SUCCESS ||
+         arm_model_set_memory_callbacks( cmodel_memory_read, cmodel_memory_write ) != ARM_MODEL_SUCCESS ||
+         cmodel_frames_alloc() != 0 ) {
+        LOG( LOG_CRIT, "Failed to set up the C model" );
+        acamera_cmodel_destroy();
+        return -1;
+    }
+
+    LOG( LOG_NOTICE, "C model %s, input %ux%u %u bits from %s, %u inputs, %u outputs",
+         arm_model_build_info(), (unsigned int)cmodel.width, (unsigned int)cmodel.height, (unsigned int)cmodel.depth,
+         input_name ? input_name : "flat frame", (unsigned int)cmodel.frames_in_num, (unsigned int)cmodel.frames_out_num );
+
+    return 0;
+}
+
+void acamera_cmodel_destroy( void )
+{
+    if ( cmodel.thread_started ) {
+        cmodel.running = 0;
+        pthread_join( cmodel.frame_thread, NULL );
+        cmodel.thread_started = 0;
+        cmodel_report();
+    }
+
+    cmodel_frames_free();
+
+    cmodel_reader_close( &cmodel.input );
+    cmodel_writer_close( &cmodel.output );
+
+    free( cmodel.ddr );
+    cmodel.ddr = NULL;
+}
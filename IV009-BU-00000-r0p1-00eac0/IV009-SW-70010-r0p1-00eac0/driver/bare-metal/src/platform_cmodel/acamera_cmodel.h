@@ -0,0 +1,65 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#ifndef __ACAMERA_CMODEL_H__
+#define __ACAMERA_CMODEL_H__
+
+#include "acamera_types.h"
+#include "system_interrupts.h"
+
+// Firmware-in-the-loop backend for the host build.
+// Register accesses are served by the config space of the Arm C model,
+// the system DDR is a host memory arena which the model reads and writes
+// through its memory callbacks, and the frame start and frame end
+// interrupts are raised for every frame the model processes.
+//
+// The input is configured from the environment:
+//   CMODEL_INPUT         - raw file of packed frames, a flat frame is used if not set
+//   CMODEL_INPUT_FORMAT  - raw10, raw12 or raw16, raw16 by default
+//   CMODEL_OUTPUT        - file the first model output is stored to, nothing is stored if not set
+//   CMODEL_OUTPUT_FORMAT - raw16, nv12 or rgb888, nv12 by default
+//   CMODEL_THREADS       - threads converting the frames, 0 - one per online cpu
+//   CMODEL_WIDTH         - input width, CMODEL_DEFAULT_WIDTH by default
+//   CMODEL_HEIGHT        - input height, CMODEL_DEFAULT_HEIGHT by default
+//   CMODEL_DEPTH         - bits per sample, CMODEL_DEFAULT_DEPTH by default
+//   CMODEL_FRAMES        - frames to process, 0 - until the input ends
+//   CMODEL_FRAME_US      - minimal frame period, 0 - as fast as the model runs
+
+#define CMODEL_DEFAULT_WIDTH 1920
+#define CMODEL_DEFAULT_HEIGHT 1080
+#define CMODEL_DEFAULT_DEPTH 12
+#define CMODEL_DEFAULT_FRAMES 100
+
+int32_t acamera_cmodel_init( void );
+void acamera_cmodel_destroy( void );
+
+// host pointer for a range of bus addresses in the DDR arena, NULL if it is out of the arena
+void *acamera_cmodel_ddr_ptr( uint64_t bus_addr, uint32_t size );
+
+// registers, the interrupt status and clear registers are emulated
+uint32_t acamera_cmodel_read_reg( uint32_t addr );
+void acamera_cmodel_write_reg( uint32_t addr, uint32_t data );
+
+// blocks of the config space for the config and metering dma
+void acamera_cmodel_read_config( uint32_t *data, uint32_t addr, uint32_t words );
+void acamera_cmodel_write_config( const uint32_t *data, uint32_t addr, uint32_t words );
+
+// frames are fed once the firmware has registered its interrupt handler
+void acamera_cmodel_set_irq_handler( system_interrupt_handler_t handler, void *param );
+void acamera_cmodel_irq_enable( int enable );
+
+// returns 1 when all the input frames were processed
+int acamera_cmodel_finished( void );
+
+#endif /* __ACAMERA_CMODEL_H__ */
@@ -0,0 +1,436 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "acamera_logger.h"
+#include "acamera_cmodel_frame_io.h"
+
+// most threads a conversion is split over
+#define CMODEL_IO_MAX_THREADS 16
+
+static const char *const cmodel_format_name[CMODEL_FORMAT_NUM] = {"raw10", "raw12", "raw16", "nv12", "rgb888"};
+
+static uint32_t cmodel_io_threads = 1;
+
+typedef void ( *cmodel_rows_f )( void *arg, uint32_t row_start, uint32_t row_end );
+
+typedef struct {
+    cmodel_rows_f func;
+    void *arg;
+    uint32_t row_start;
+    uint32_t row_end;
+} cmodel_band_t;
+
+
+int32_t cmodel_format_parse( const char *name )
+{
+    int32_t idx;
+
+    for ( idx = 0; idx < CMODEL_FORMAT_NUM; idx++ ) {
+        if ( strcasecmp( name, cmodel_format_name[idx] ) == 0 ) {
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
+size_t cmodel_format_frame_size( cmodel_format_t format, uint32_t width, uint32_t height )
+{
+    size_t pixels = (size_t)width * height;
+
+    switch ( format ) {
+    case CMODEL_FORMAT_RAW10:
+        return ( width % 4 ) ? 0 : pixels * 5 / 4;
+    case CMODEL_FORMAT_RAW12:
+        return ( width % 2 ) ? 0 : pixels * 3 / 2;
+    case CMODEL_FORMAT_RAW16:
+        return pixels * 2;
+    case CMODEL_FORMAT_NV12:
+        return ( ( width % 2 ) || ( height % 2 ) ) ? 0 : pixels * 3 / 2;
+    case CMODEL_FORMAT_RGB888:
+        return pixels * 3;
+    default:
+        return 0;
+    }
+}
+
+void cmodel_frame_io_set_threads( uint32_t threads )
+{
+    if ( threads == 0 ) {
+        long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+        threads = ( cpus > 0 ) ? (uint32_t)cpus : 1;
+    }
+
+    cmodel_io_threads = ( threads > CMODEL_IO_MAX_THREADS ) ? CMODEL_IO_MAX_THREADS : threads;
+}
+
+static void *cmodel_band_thread( void *arg )
+{
+    cmodel_band_t *p_band = (cmodel_band_t *)arg;
+    p_band->func( p_band->arg, p_band->row_start, p_band->row_end );
+    return NULL;
+}
+
+// Split the rows into bands, row_align keeps the row pairs of 4:2:0 formats together.
+static void cmodel_parallel_rows( uint32_t height, uint32_t row_align, cmodel_rows_f func, void *arg )
+{
+    cmodel_band_t band[CMODEL_IO_MAX_THREADS];
+    pthread_t thread[CMODEL_IO_MAX_THREADS];
+    int started[CMODEL_IO_MAX_THREADS];
+    uint32_t bands = cmodel_io_threads;
+    uint32_t rows = ( height + bands - 1 ) / bands;
+    uint32_t idx;
+
+    rows = ( rows + row_align - 1 ) / row_align * row_align;
+
+    for ( idx = 0; idx < bands; idx++ ) {
+        band[idx].func = func;
+        band[idx].arg = arg;
+        band[idx].row_start = ( idx * rows < height ) ? idx * rows : height;
+        band[idx].row_end = ( ( idx + 1 ) * rows < height ) ? ( idx + 1 ) * rows : height;
+        started[idx] = 0;
+    }
+
+    // the calling thread takes the first band
+    for ( idx = 1; idx < bands; idx++ ) {
+        if ( band[idx].row_start < band[idx].row_end ) {
+            started[idx] = ( pthread_create( &thread[idx], NULL, cmodel_band_thread, &band[idx] ) == 0 );
+            if ( !started[idx] ) {
+                func( arg, band[idx].row_start, band[idx].row_end );
+            }
+        }
+    }
+
+    func( arg, band[0].row_start, band[0].row_end );
+
+    for ( idx = 1; idx < bands; idx++ ) {
+        if ( started[idx] ) {
+            pthread_join( thread[idx], NULL );
+        }
+    }
+}
+
+// The row loops below are kept free of aliasing and branches so the
+// compiler vectorizes them.
+
+static void cmodel_unpack_raw10_row( const uint8_t *__restrict src, data_t *__restrict dst, uint32_t width )
+{
+    uint32_t x;
+
+    for ( x = 0; x < width; x += 4, src += 5, dst += 4 ) {
+        uint8_t lsb = src[4];
+        dst[0] = ( src[0] << 2 ) | ( lsb & 3 );
+        dst[1] = ( src[1] << 2 ) | ( ( lsb >> 2 ) & 3 );
+        dst[2] = ( src[2] << 2 ) | ( ( lsb >> 4 ) & 3 );
+        dst[3] = ( src[3] << 2 ) | ( lsb >> 6 );
+    }
+}
+
+static void cmodel_unpack_raw12_row( const uint8_t *__restrict src, data_t *__restrict dst, uint32_t width )
+{
+    uint32_t x;
+
+    for ( x = 0; x < width; x += 2, src += 3, dst += 2 ) {
+        uint8_t lsb = src[2];
+        dst[0] = ( src[0] << 4 ) | ( lsb & 0xF );
+        dst[1] = ( src[1] << 4 ) | ( lsb >> 4 );
+    }
+}
+
+static void cmodel_unpack_raw16_row( const uint8_t *__restrict src, data_t *__restrict dst, uint32_t width )
+{
+    uint32_t x;
+
+    for ( x = 0; x < width; x++, src += 2 ) {
+        dst[x] = src[0] | ( src[1] << 8 );
+    }
+}
+
+typedef struct {
+    cmodel_format_t format;
+    const uint8_t *src;
+    size_t src_stride;
+    data_t *dst;
+    uint32_t width;
+} cmodel_unpack_t;
+
+static void cmodel_unpack_rows( void *arg, uint32_t row_start, uint32_t row_end )
+{
+    const cmodel_unpack_t *p_job = (const cmodel_unpack_t *)arg;
+    uint32_t y;
+
+    for ( y = row_start; y < row_end; y++ ) {
+        const uint8_t *src = p_job->src + y * p_job->src_stride;
+        data_t *dst = p_job->dst + (size_t)y * p_job->width;
+
+        switch ( p_job->format ) {
+        case CMODEL_FORMAT_RAW10:
+            cmodel_unpack_raw10_row( src, dst, p_job->width );
+            break;
+        case CMODEL_FORMAT_RAW12:
+            cmodel_unpack_raw12_row( src, dst, p_job->width );
+            break;
+        default:
+            cmodel_unpack_raw16_row( src, dst, p_job->width );
+            break;
+        }
+    }
+}
+
+int32_t cmodel_unpack_frame( cmodel_format_t format, const uint8_t *src, data_t *dst, uint32_t width, uint32_t height )
+{
+    cmodel_unpack_t job;
+    size_t size = cmodel_format_frame_size( format, width, height );
+
+    if ( format > CMODEL_FORMAT_RAW16 || size == 0 ) {
+        LOG( LOG_ERR, "Input format %d is not supported for %ux%u", (int)format, (unsigned int)width, (unsigned int)height );
+        return -1;
+    }
+
+    job.format = format;
+    job.src = src;
+    job.src_stride = size / height;
+    job.dst = dst;
+    job.width = width;
+
+    cmodel_parallel_rows( height, 1, cmodel_unpack_rows, &job );
+
+    return 0;
+}
+
+typedef struct {
+    cmodel_format_t format;
+    const data_t *src;
+    uint32_t planes;
+    uint32_t shift;
+    uint8_t *dst;
+    uint32_t width;
+    uint32_t height;
+} cmodel_pack_t;
+
+static void cmodel_pack_rows( void *arg, uint32_t row_start, uint32_t row_end )
+{
+    const cmodel_pack_t *p_job = (const cmodel_pack_t *)arg;
+    const uint32_t width = p_job->width;
+    const uint32_t planes = p_job->planes;
+    const uint32_t shift = p_job->shift;
+    uint32_t x, y;
+
+    for ( y = row_start; y < row_end; y++ ) {
+        const data_t *__restrict src = p_job->src + (size_t)y * width * planes;
+
+        switch ( p_job->format ) {
+        case CMODEL_FORMAT_RAW16: {
+            uint8_t *__restrict dst = p_job->dst + (size_t)y * width * 2;
+            for ( x = 0; x < width; x++ ) {
+                dst[2 * x] = src[x * planes] & 0xFF;
+                dst[2 * x + 1] = ( src[x * planes] >> 8 ) & 0xFF;
+            }
+        } break;
+
+        case CMODEL_FORMAT_RGB888: {
+            uint8_t *__restrict dst = p_job->dst + (size_t)y * width * 3;
+            for ( x = 0; x < width; x++ ) {
+                dst[3 * x] = src[x * planes] >> shift;
+                dst[3 * x + 1] = src[x * planes + 1] >> shift;
+                dst[3 * x + 2] = src[x * planes + 2] >> shift;
+            }
+        } break;
+
+        case CMODEL_FORMAT_NV12: {
+            uint8_t *__restrict dst = p_job->dst + (size_t)y * width;
+            for ( x = 0; x < width; x++ ) {
+                dst[x] = src[x * planes] >> shift;
+            }
+
+            // chroma of a row pair is averaged over 2x2 pixels
+            if ( y & 1 ) {
+                const data_t *__restrict above = src - (size_t)width * planes;
+                uint8_t *__restrict uv = p_job->dst + (size_t)width * p_job->height + (size_t)( y >> 1 ) * width;
+                for ( x = 0; x < width; x += 2 ) {
+                    const data_t *a = above + x * planes;
+                    const data_t *b = src + x * planes;
+                    uv[x] = ( ( a[1] + a[planes + 1] + b[1] + b[planes + 1] + 2 ) >> 2 ) >> shift;
+                    uv[x + 1] = ( ( a[2] + a[planes + 2] + b[2] + b[planes + 2] + 2 ) >> 2 ) >> shift;
+                }
+            }
+        } break;
+
+        default:
+            break;
+        }
+    }
+}
+
+int32_t cmodel_pack_frame( cmodel_format_t format, const frame_t *p_frame, uint8_t *dst )
+{
+    cmodel_pack_t job;
+    uint32_t planes_min = ( format == CMODEL_FORMAT_RGB888 || format == CMODEL_FORMAT_NV12 ) ? 3 : 1;
+
+    if ( format < CMODEL_FORMAT_RAW16 || cmodel_format_frame_size( format, p_frame->width, p_frame->height ) == 0 || p_frame->planes < planes_min ) {
+        LOG( LOG_ERR, "Output format %d is not supported for %ux%u with %u planes", (int)format, (unsigned int)p_frame->width, (unsigned int)p_frame->height, (unsigned int)p_frame->planes );
+        return -1;
+    }
+
+    job.format = format;
+    job.src = p_frame->data;
+    job.planes = p_frame->planes;
+    job.shift = ( p_frame->depth > 8 ) ? p_frame->depth - 8 : 0;
+    job.dst = dst;
+    job.width = p_frame->width;
+    job.height = p_frame->height;
+
+    cmodel_parallel_rows( p_frame->height, 2, cmodel_pack_rows, &job );
+
+    return 0;
+}
+
+int32_t cmodel_reader_open( cmodel_reader_t *p_reader, const char *name, size_t frame_size )
+{
+    struct stat st;
+
+    memset( p_reader, 0, sizeof( *p_reader ) );
+    p_reader->fd = open( name, O_RDONLY );
+    if ( p_reader->fd < 0 ) {
+        LOG( LOG_ERR, "Failed to open %s", name );
+        return -1;
+    }
+
+    if ( fstat( p_reader->fd, &st ) != 0 || frame_size == 0 || (size_t)st.st_size < frame_size ) {
+        LOG( LOG_ERR, "%s holds no frame of %u bytes", name, (unsigned int)frame_size );
+        cmodel_reader_close( p_reader );
+        return -1;
+    }
+
+    p_reader->map_size = st.st_size;
+    p_reader->map = mmap( NULL, p_reader->map_size, PROT_READ, MAP_PRIVATE, p_reader->fd, 0 );
+    if ( p_reader->map == MAP_FAILED ) {
+        LOG( LOG_ERR, "Failed to map %s", name );
+        p_reader->map = NULL;
+        cmodel_reader_close( p_reader );
+        return -1;
+    }
+
+    madvise( (void *)p_reader->map, p_reader->map_size, MADV_SEQUENTIAL );
+
+    p_reader->frame_size = frame_size;
+    p_reader->frames = p_reader->map_size / frame_size;
+
+    return 0;
+}
+
+const uint8_t *cmodel_reader_next( cmodel_reader_t *p_reader )
+{
+    size_t page = (size_t)sysconf( _SC_PAGESIZE );
+
+    if ( p_reader->map == NULL || p_reader->next >= p_reader->frames ) {
+        return NULL;
+    }
+
+    // the previous frame is converted already, its pages are dropped to keep the resident set small
+    if ( p_reader->next > 0 ) {
+        size_t start = ( p_reader->next - 1 ) * p_reader->frame_size / page * page;
+        size_t end = p_reader->next * p_reader->frame_size / page * page;
+        if ( end > start ) {
+            madvise( (void *)( p_reader->map + start ), end - start, MADV_DONTNEED );
+        }
+    }
+
+    return p_reader->map + p_reader->frame_size * p_reader->next++;
+}
+
+void cmodel_reader_close( cmodel_reader_t *p_reader )
+{
+    if ( p_reader->map != NULL ) {
+        munmap( (void *)p_reader->map, p_reader->map_size );
+        p_reader->map = NULL;
+    }
+
+    if ( p_reader->fd >= 0 ) {
+        close( p_reader->fd );
+        p_reader->fd = -1;
+    }
+}
+
+int32_t cmodel_writer_open( cmodel_writer_t *p_writer, const char *name, cmodel_format_t format )
+{
+    memset( p_writer, 0, sizeof( *p_writer ) );
+
+    if ( format < CMODEL_FORMAT_RAW16 || format >= CMODEL_FORMAT_NUM ) {
+        LOG( LOG_ERR, "Output format %d is not supported", (int)format );
+        return -1;
+    }
+
+    p_writer->file = fopen( name, "wb" );
+    if ( p_writer->file == NULL ) {
+        LOG( LOG_ERR, "Failed to create %s", name );
+        return -1;
+    }
+
+    p_writer->format = format;
+
+    return 0;
+}
+
+int32_t cmodel_writer_put( cmodel_writer_t *p_writer, const frame_t *p_frame )
+{
+    size_t size = cmodel_format_frame_size( p_writer->format, p_frame->width, p_frame->height );
+
+    if ( size == 0 ) {
+        return -1;
+    }
+
+    // one packed frame is buffered, the output size may change with the firmware settings
+    if ( size > p_writer->buffer_size ) {
+        uint8_t *buffer = realloc( p_writer->buffer, size );
+        if ( buffer == NULL ) {
+            return -1;
+        }
+        p_writer->buffer = buffer;
+        p_writer->buffer_size = size;
+    }
+
+    if ( cmodel_pack_frame( p_writer->format, p_frame, p_writer->buffer ) != 0 ) {
+        return -1;
+    }
+
+    if ( fwrite( p_writer->buffer, 1, size, p_writer->file ) != size ) {
+        LOG( LOG_ERR, "Failed to write output frame %u", (unsigned int)p_writer->frames );
+        return -1;
+    }
+
+    p_writer->frames++;
+
+    return 0;
+}
+
+void cmodel_writer_close( cmodel_writer_t *p_writer )
+{
+    if ( p_writer->file != NULL ) {
+        fclose( p_writer->file );
+        p_writer->file = NULL;
+    }
+
+    free( p_writer->buffer );
+    p_writer->buffer = NULL;
+    p_writer->buffer_size = 0;
+}
@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#ifndef __ACAMERA_CMODEL_FRAME_IO_H__
+#define __ACAMERA_CMODEL_FRAME_IO_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "acamera_types.h"
+#include "arm_model_api.h"
+
+// Frame I/O of the C model backend.
+// The model keeps every sample as a data_t with the planes interleaved per
+// pixel. Input files stay packed on disk and are mapped, only the frame being
+// converted is resident. Outputs are packed again before they are written.
+// The conversions are split into bands of rows over several threads.
+
+typedef enum {
+    CMODEL_FORMAT_RAW10 = 0, // MIPI packed, 4 samples in 5 bytes
+    CMODEL_FORMAT_RAW12,     // MIPI packed, 2 samples in 3 bytes
+    CMODEL_FORMAT_RAW16,     // 16 bits little endian samples
+    CMODEL_FORMAT_NV12,      // 8 bits Y plane and interleaved UV plane at half resolution
+    CMODEL_FORMAT_RGB888,    // 8 bits R, G and B per pixel
+    CMODEL_FORMAT_NUM
+} cmodel_format_t;
+
+// format by its name, -1 if the name is unknown
+int32_t cmodel_format_parse( const char *name );
+
+// bytes of a packed frame, 0 if the dimensions do not suit the format
+size_t cmodel_format_frame_size( cmodel_format_t format, uint32_t width, uint32_t height );
+
+// threads used by the conversions, 0 - one per online cpu
+void cmodel_frame_io_set_threads( uint32_t threads );
+
+// packed raw input to one plane of data_t samples
+int32_t cmodel_unpack_frame( cmodel_format_t format, const uint8_t *src, data_t *dst, uint32_t width, uint32_t height );
+
+// model output to a packed frame, samples are scaled from the depth of the frame
+int32_t cmodel_pack_frame( cmodel_format_t format, const frame_t *p_frame, uint8_t *dst );
+
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t map_size;
+    size_t frame_size;
+    uint32_t frames;
+    uint32_t next;
+} cmodel_reader_t;
+
+int32_t cmodel_reader_open( cmodel_reader_t *p_reader, const char *name, size_t frame_size );
+// next packed frame, NULL at the end of the file
+const uint8_t *cmodel_reader_next( cmodel_reader_t *p_reader );
+void cmodel_reader_close( cmodel_reader_t *p_reader );
+
+typedef struct {
+    FILE *file;
+    uint8_t *buffer;
+    size_t buffer_size;
+    cmodel_format_t format;
+    uint32_t frames;
+} cmodel_writer_t;
+
+int32_t cmodel_writer_open( cmodel_writer_t *p_writer, const char *name, cmodel_format_t format );
+int32_t cmodel_writer_put( cmodel_writer_t *p_writer, const frame_t *p_frame );
+void cmodel_writer_close( cmodel_writer_t *p_writer );
+
+#endif /* __ACAMERA_CMODEL_FRAME_IO_H__ */
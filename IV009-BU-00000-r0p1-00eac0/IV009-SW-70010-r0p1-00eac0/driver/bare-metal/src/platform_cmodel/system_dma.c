@@ -0,0 +1,166 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#include "acamera_types.h"
+#include "acamera_logger.h"
+#include "acamera_firmware_config.h"
+#include "system_dma.h"
+#include "system_stdlib.h"
+#include "acamera_cmodel.h"
+
+// The config and metering transfers copy between the firmware memory and the
+// model config space. They complete before system_dma_copy_sg returns.
+
+#define SYSTEM_DMA_TOGGLE_COUNT 2
+#define SYSTEM_DMA_MAX_PAIRS 4
+
+typedef struct {
+    dma_addr_pair_t device[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT][SYSTEM_DMA_MAX_PAIRS];
+    fwmem_addr_pair_t fwmem[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT][SYSTEM_DMA_MAX_PAIRS];
+    int32_t device_pairs[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
+    int32_t fwmem_pairs[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
+} system_dma_device_t;
+
+
+int32_t system_dma_init( void **ctx )
+{
+    system_dma_device_t *system_dma_device = system_malloc( sizeof( system_dma_device_t ) );
+
+    if ( system_dma_device == NULL ) {
+        LOG( LOG_CRIT, "No memory for the dma channel" );
+        return -1;
+    }
+
+    system_memset( system_dma_device, 0, sizeof( system_dma_device_t ) );
+    *ctx = system_dma_device;
+
+    return 0;
+}
+
+
+int32_t system_dma_destroy( void *ctx )
+{
+    system_free( ctx );
+    return 0;
+}
+
+// device addresses are bus addresses of the isp, the model config space starts at zero
+static uint32_t system_dma_config_addr( uint32_t dev_phy_addr )
+{
+    return dev_phy_addr - ISP_SOC_START_ADDR;
+}
+
+int32_t system_dma_copy_device_to_memory( void *ctx, void *dst_mem, uint32_t dev_phy_addr, uint32_t size_to_copy )
+{
+    acamera_cmodel_read_config( (uint32_t *)dst_mem, system_dma_config_addr( dev_phy_addr ), size_to_copy >> 2 );
+    return 0;
+}
+
+
+int32_t system_dma_copy_memory_to_device( void *ctx, void *src_mem, uint32_t dev_phy_addr, uint32_t size_to_copy )
+{
+    acamera_cmodel_write_config( (const uint32_t *)src_mem, system_dma_config_addr( dev_phy_addr ), size_to_copy >> 2 );
+    return 0;
+}
+
+
+int32_t system_dma_copy_device_to_memory_async( void *ctx, void *dst_mem, uint32_t dev_phy_addr, uint32_t size_to_copy, dma_completion_callback complete_func, void *arg )
+{
+    int32_t result = system_dma_copy_device_to_memory( ctx, dst_mem, dev_phy_addr, size_to_copy );
+    if ( complete_func ) {
+        complete_func( arg );
+    }
+    return result;
+}
+
+
+int32_t system_dma_copy_memory_to_device_async( void *ctx, void *src_mem, uint32_t dev_phy_addr, uint32_t size_to_copy, dma_completion_callback complete_func, void *arg )
+{
+    int32_t result = system_dma_copy_memory_to_device( ctx, src_mem, dev_phy_addr, size_to_copy );
+    if ( complete_func ) {
+        complete_func( arg );
+    }
+    return result;
+}
+
+int32_t system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t *device_addr_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int32_t i;
+
+    if ( !system_dma_device || !device_addr_pair || addr_pairs <= 0 || addr_pairs > SYSTEM_DMA_MAX_PAIRS || buff_loc >= SYSTEM_DMA_TOGGLE_COUNT || fw_ctx_id >= FIRMWARE_CONTEXT_NUMBER ) {
+        return -1;
+    }
+
+    for ( i = 0; i < addr_pairs; i++ ) {
+        system_dma_device->device[fw_ctx_id][buff_loc][i] = device_addr_pair[i];
+    }
+    system_dma_device->device_pairs[fw_ctx_id][buff_loc] = addr_pairs;
+
+    return 0;
+}
+
+int32_t system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_t *fwmem_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int32_t i;
+
+    if ( !system_dma_device || !fwmem_pair || addr_pairs <= 0 || addr_pairs > SYSTEM_DMA_MAX_PAIRS || buff_loc >= SYSTEM_DMA_TOGGLE_COUNT || fw_ctx_id >= FIRMWARE_CONTEXT_NUMBER ) {
+        return -1;
+    }
+
+    for ( i = 0; i < addr_pairs; i++ ) {
+        system_dma_device->fwmem[fw_ctx_id][buff_loc][i] = fwmem_pair[i];
+    }
+    system_dma_device->fwmem_pairs[fw_ctx_id][buff_loc] = addr_pairs;
+
+    return 0;
+}
+
+void system_dma_unmap_sg( void *ctx )
+{
+}
+
+int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma_completion_callback complete_func, uint32_t fw_ctx_id )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int32_t i, pairs;
+
+    if ( !system_dma_device || buff_loc >= SYSTEM_DMA_TOGGLE_COUNT || fw_ctx_id >= FIRMWARE_CONTEXT_NUMBER ) {
+        return -1;
+    }
+
+    pairs = system_dma_device->device_pairs[fw_ctx_id][buff_loc];
+    if ( pairs != system_dma_device->fwmem_pairs[fw_ctx_id][buff_loc] ) {
+        LOG( LOG_ERR, "Device and memory lists differ: %d and %d pairs", (int)pairs, (int)system_dma_device->fwmem_pairs[fw_ctx_id][buff_loc] );
+        return -1;
+    }
+
+    for ( i = 0; i < pairs; i++ ) {
+        const dma_addr_pair_t *p_dev = &system_dma_device->device[fw_ctx_id][buff_loc][i];
+        const fwmem_addr_pair_t *p_mem = &system_dma_device->fwmem[fw_ctx_id][buff_loc][i];
+
+        if ( direction == SYS_DMA_TO_DEVICE ) {
+            system_dma_copy_memory_to_device( ctx, p_mem->address, p_dev->address, p_dev->size );
+        } else {
+            system_dma_copy_device_to_memory( ctx, p_mem->address, p_dev->address, p_dev->size );
+        }
+    }
+
+    if ( complete_func ) {
+        complete_func( ctx );
+    }
+
+    return 0;
+}
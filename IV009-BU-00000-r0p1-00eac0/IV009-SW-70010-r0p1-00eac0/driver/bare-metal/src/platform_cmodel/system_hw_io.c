@@ -0,0 +1,76 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#include "acamera_logger.h"
+#include "system_hw_io.h"
+#include "acamera_cmodel.h"
+
+
+int32_t init_hw_io( void )
+{
+    return 0;
+}
+
+int32_t close_hw_io( void )
+{
+    return 0;
+}
+
+uint32_t system_hw_read_32( uintptr_t addr )
+{
+    return acamera_cmodel_read_reg( addr );
+}
+
+// the model config space is 32 bits wide, narrow accesses are done on the word
+uint16_t system_hw_read_16( uintptr_t addr )
+{
+    return ( uint16_t )( acamera_cmodel_read_reg( addr & ~3 ) >> ( ( addr & 2 ) << 3 ) );
+}
+
+uint8_t system_hw_read_8( uintptr_t addr )
+{
+    return ( uint8_t )( acamera_cmodel_read_reg( addr & ~3 ) >> ( ( addr & 3 ) << 3 ) );
+}
+
+
+void system_hw_write_32( uintptr_t addr, uint32_t data )
+{
+    acamera_cmodel_write_reg( addr, data );
+}
+
+void system_hw_write_16( uintptr_t addr, uint16_t data )
+{
+    int shift = ( addr & 2 ) << 3;
+    uint32_t word = acamera_cmodel_read_reg( addr & ~3 );
+    word = ( word & ~( 0xFFFF << shift ) ) | ( (uint32_t)data << shift );
+    acamera_cmodel_write_reg( addr & ~3, word );
+}
+
+void system_hw_write_8( uintptr_t addr, uint8_t data )
+{
+    int shift = ( addr & 3 ) << 3;
+    uint32_t word = acamera_cmodel_read_reg( addr & ~3 );
+    word = ( word & ~( 0xFF << shift ) ) | ( (uint32_t)data << shift );
+    acamera_cmodel_write_reg( addr & ~3, word );
+}
+
+void system_hw_read_block_32( uintptr_t addr, uint32_t *data, uint32_t count )
+{
+    acamera_cmodel_read_config( data, addr, count );
+}
+
+void system_hw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+    acamera_cmodel_write_config( data, addr, count );
+}
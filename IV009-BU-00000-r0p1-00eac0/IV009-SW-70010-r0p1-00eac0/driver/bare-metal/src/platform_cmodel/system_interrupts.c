@@ -0,0 +1,42 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#include "acamera_types.h"
+#include "system_interrupts.h"
+#include "acamera_cmodel.h"
+
+// interrupts are raised by the model frame thread, see acamera_cmodel.c
+
+void system_interrupts_init( void )
+{
+}
+
+void system_interrupt_set_handler( system_interrupt_handler_t handler, void *param )
+{
+    acamera_cmodel_set_irq_handler( handler, param );
+}
+
+void system_interrupt_set_thread_handler( system_interrupt_handler_t handler, void *param )
+{
+}
+
+void system_interrupts_enable( void )
+{
+    acamera_cmodel_irq_enable( 1 );
+}
+
+void system_interrupts_disable( void )
+{
+    acamera_cmodel_irq_enable( 0 );
+}
@@ -0,0 +1,89 @@
+//----------------------------------------------------------------------------
+//   The confidential and proprietary information contained in this file may
+//   only be used by a person authorised under and to the extent permitted
+//   by a subsisting licensing agreement from ARM Limited or its affiliates.
+//
+//          (C) COPYRIGHT [2018] ARM Limited or its affiliates.
+//              ALL RIGHTS RESERVED
+//
+//   This entire notice must be reproduced on all copies of this file
+//   and copies of this file may only be made by a person if such person is
+//   permitted to do so under the terms of a subsisting license agreement
+//   from ARM Limited or its affiliates.
+//----------------------------------------------------------------------------
+
+#include "acamera_types.h"
+#include "system_sw_io.h"
+#include "acamera_logger.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+void *system_sw_alloc( uint32_t size )
+{
+    return calloc( 1, size );
+}
+
+void system_sw_free( void *ptr )
+{
+    free( ptr );
+}
+
+int32_t init_sw_io( void )
+{
+    return 0;
+}
+
+int32_t close_sw_io( void )
+{
+    return 0;
+}
+
+#if SYSTEM_SW_IO_INLINE
+void system_sw_io_null_access( uintptr_t addr, uint32_t data, int write )
+{
+    if ( write ) {
+        LOG( LOG_ERR, "Failed to write %d to memory 0x%lx. Base pointer is null ", (int)data, (unsigned long)addr );
+    } else {
+        LOG( LOG_ERR, "Failed to read memory from address 0x%lx. Base pointer is null ", (unsigned long)addr );
+    }
+}
+#else
+uint32_t system_sw_read_32( uintptr_t addr )
+{
+    return *(volatile uint32_t *)addr;
+}
+#endif
+
+uint16_t system_sw_read_16( uintptr_t addr )
+{
+    return *(volatile uint16_t *)addr;
+}
+
+uint8_t system_sw_read_8( uintptr_t addr )
+{
+    return *(volatile uint8_t *)addr;
+}
+
+
+#if !SYSTEM_SW_IO_INLINE
+void system_sw_write_32( uintptr_t addr, uint32_t data )
+{
+    *(volatile uint32_t *)addr = data;
+}
+#endif
+
+void system_sw_write_16( uintptr_t addr, uint16_t data )
+{
+    *(volatile uint16_t *)addr = data;
+}
+
+void system_sw_write_8( uintptr_t addr, uint8_t data )
+{
+    *(volatile uint8_t *)addr = data;
+}
+
+void system_sw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+    memcpy( (void *)addr, data, count * sizeof( uint32_t ) );
+}
@@ -36,6 +36,7 @@
 #endif
 #include "system_hw_io.h"
 #include "system_sw_io.h"
+#include "system_stdlib.h"
 #include "acamera_command_api.h"
 #include "application_command_api.h"
 #include "acamera_isp_core_nomem_settings.h"
@@ -67,6 +68,12 @@ extern struct acamera_socket_strategy acamera_socket_init_strategy();
 
 #define HEADER_SIZE 12
 
+// requests served back to back by one acamera_connection_process() call before
+// the firmware gets back to its own work. They are handled one at a time in the
+// order they arrive, a client which queues several only saves the polls between
+// the replies.
+#define REQUESTS_PER_POLL 4
+
 enum {
     API_RESET = 0,
     API_READ,
@@ -84,7 +91,9 @@ enum TransactionType {
     TransactionTypeAPIWrite,
 
     TransactionTypeBUFRead = 20,
-    TransactionTypeBUFWrite
+    TransactionTypeBUFWrite,
+    TransactionTypeBUFReadChunk,
+    TransactionTypeBUFWriteChunk
 };
 
 typedef int ( *data_read_f )( void *p_ctrl, uint8_t *data, int size );
@@ -97,6 +106,15 @@ enum {
     STATE_TX_PACKET
 };
 
+// calibration buffer received in several BUFWriteChunk requests
+typedef struct {
+    uint8_t *data;
+    uint32_t size;     // size of the whole buffer
+    uint32_t received; // offset the next chunk must start at
+    uint8_t id;
+    uint8_t buf_class;
+} connection_chunk_t;
+
 typedef struct {
     void *param;
     data_read_f data_read;
@@ -107,6 +125,8 @@ typedef struct {
     uint32_t rx_buffer_size;
     uint32_t tx_buffer_inx;
     uint32_t tx_buffer_size;
+    connection_chunk_t chunk;
+    uint32_t transactions;
 } connection_t;
 
 #if ISP_HAS_STREAM_CONNECTION
@@ -120,6 +140,16 @@ static void reset_connection( void )
     ACAMERA_CONNECTION_TRACE( "reset connection" );
 }
 
+static void release_chunk( void )
+{
+    if ( con.chunk.data != NULL ) {
+        system_sw_free( con.chunk.data );
+        con.chunk.data = NULL;
+    }
+    con.chunk.size = 0;
+    con.chunk.received = 0;
+}
+
 extern void *acamera_get_api_ctx_ptr( void );
 
 #if ISP_HAS_CONNECTION_SOCKET
@@ -201,6 +231,8 @@ void acamera_connection_destroy( void )
 #else
     ACAMERA_CONNECTION_TRACE( LOG_WARNING, "Connection destroy method is not defined" );
 #endif /* connection type */
+    release_chunk();
+    LOG( LOG_INFO, "Connection served %u requests", (unsigned int)con.transactions );
     con.param = NULL;
     con.data_read = NULL;
     con.data_write = NULL;
@@ -209,6 +241,38 @@ void acamera_connection_destroy( void )
 
 
 #if ISP_HAS_STREAM_CONNECTION
+// first byte after the ping/pong memory which is served from the software context
+#define SW_REGS_END ( ISP_CONFIG_PING_OFFSET + 2 * ISP_CONFIG_PING_SIZE + 1 )
+
+// words moved through the stack by one hw block access
+#define HW_BURST_WORDS 64
+
+// Use SW registers for ping/pong memory, otherwise, use HW registers.
+static int is_hw_addr( uint32_t addr )
+{
+    return ( addr < ISP_CONFIG_LUT_OFFSET ) || ( addr >= SW_REGS_END );
+}
+
+// number of bytes from addr which are served by the same kind of registers
+static uint32_t region_size( uint32_t addr, uint32_t size )
+{
+    uint32_t limit = size;
+
+    if ( addr < ISP_CONFIG_LUT_OFFSET ) {
+        limit = ISP_CONFIG_LUT_OFFSET - addr;
+    } else if ( addr < SW_REGS_END ) {
+        limit = SW_REGS_END - addr;
+    }
+
+    return MIN( size, limit );
+}
+
+static uint8_t *sw_regs_ptr( uint32_t addr )
+{
+    acamera_context_ptr_t context_ptr = (acamera_context_ptr_t)acamera_get_api_ctx_ptr();
+    return (uint8_t *)( context_ptr->settings.isp_base + addr );
+}
+
 static void write_32( uint32_t addr, uint8_t value, uint8_t msk )
 {
     acamera_context_ptr_t context_ptr = (acamera_context_ptr_t)acamera_get_api_ctx_ptr();
@@ -217,8 +281,7 @@ static void write_32( uint32_t addr, uint8_t value, uint8_t msk )
     uint32_t addr_align = addr & ~3;
 
     // Use SW registers for ping/pong memory, otherwise, use HW registers.
-    if ( ( addr < ISP_CONFIG_LUT_OFFSET ) ||
-         ( addr > ISP_CONFIG_PING_OFFSET + 2 * ISP_CONFIG_PING_SIZE ) ) {
+    if ( is_hw_addr( addr ) ) {
         uint32_t data = system_hw_read_32( addr_align );
         data = ( data & ~mask ) | ( ( uint32_t )( value & msk ) << shift );
         system_hw_write_32( addr_align, data );
@@ -241,8 +304,7 @@ static uint8_t read_32( uint32_t addr )
     uint32_t data = 0;
 
     // Use SW registers for ping/pong memory, otherwise, use HW registers.
-    if ( ( addr < ISP_CONFIG_LUT_OFFSET ) ||
-         ( addr > ISP_CONFIG_PING_OFFSET + 2 * ISP_CONFIG_PING_SIZE ) ) {
+    if ( is_hw_addr( addr ) ) {
         data = system_hw_read_32( addr_align );
     } else {
         uintptr_t sw_addr = context_ptr->settings.isp_base + addr_align;
@@ -253,6 +315,217 @@ static uint8_t read_32( uint32_t addr )
     return result;
 }
 
+// Bytes at unaligned edges go through read_32(), aligned words are read in bursts.
+static void read_hw_block( uint32_t addr, uint8_t *b, uint32_t size )
+{
+    uint32_t words[HW_BURST_WORDS];
+
+    while ( size && ( addr & 3 ) ) {
+        *b++ = read_32( addr++ );
+        size--;
+    }
+
+    while ( size >= 4 ) {
+        uint32_t cnt = MIN( size >> 2, HW_BURST_WORDS );
+        system_hw_read_block_32( addr, words, cnt );
+        system_memcpy( b, words, cnt << 2 );
+        addr += cnt << 2;
+        b += cnt << 2;
+        size -= cnt << 2;
+    }
+
+    while ( size-- ) {
+        *b++ = read_32( addr++ );
+    }
+}
+
+// msk is NULL for a plain write. Masked words are merged before they are
+// written, a word with a partial mask costs one read-modify-write.
+static void write_hw_block( uint32_t addr, const uint8_t *b, const uint8_t *msk, uint32_t size )
+{
+    uint32_t words[HW_BURST_WORDS];
+
+    while ( size && ( addr & 3 ) ) {
+        write_32( addr++, *b++, msk ? *msk++ : 0xFF );
+        size--;
+    }
+
+    while ( size >= 4 ) {
+        uint32_t cnt = MIN( size >> 2, HW_BURST_WORDS );
+        system_memcpy( words, b, cnt << 2 );
+
+        if ( msk == NULL ) {
+            system_hw_write_block_32( addr, words, cnt );
+        } else {
+            uint32_t i;
+            for ( i = 0; i < cnt; i++ ) {
+                uint32_t mask;
+                system_memcpy( &mask, &msk[i << 2], 4 );
+                if ( mask == 0xFFFFFFFF ) {
+                    system_hw_write_32( addr + ( i << 2 ), words[i] );
+                } else if ( mask ) {
+                    uint32_t data = system_hw_read_32( addr + ( i << 2 ) );
+                    system_hw_write_32( addr + ( i << 2 ), ( data & ~mask ) | ( words[i] & mask ) );
+                }
+            }
+            msk += cnt << 2;
+        }
+
+        addr += cnt << 2;
+        b += cnt << 2;
+        size -= cnt << 2;
+    }
+
+    while ( size-- ) {
+        write_32( addr++, *b++, msk ? *msk++ : 0xFF );
+    }
+}
+
+// The software context is plain memory, it is copied directly in both directions.
+static void read_block( uint32_t addr, uint8_t *b, uint32_t size )
+{
+    while ( size ) {
+        uint32_t run = region_size( addr, size );
+
+        if ( is_hw_addr( addr ) ) {
+            read_hw_block( addr, b, run );
+        } else {
+            system_memcpy( b, sw_regs_ptr( addr ), run );
+        }
+
+        addr += run;
+        b += run;
+        size -= run;
+    }
+}
+
+static void write_block( uint32_t addr, const uint8_t *b, const uint8_t *msk, uint32_t size )
+{
+    while ( size ) {
+        uint32_t run = region_size( addr, size );
+
+        if ( is_hw_addr( addr ) ) {
+            write_hw_block( addr, b, msk, run );
+        } else if ( msk == NULL ) {
+            system_memcpy( sw_regs_ptr( addr ), b, run );
+        } else {
+            uint8_t *p = sw_regs_ptr( addr );
+            uint32_t i;
+            for ( i = 0; i < run; i++ ) {
+                p[i] = ( p[i] & ~msk[i] ) | ( b[i] & msk[i] );
+            }
+        }
+
+        addr += run;
+        b += run;
+        if ( msk != NULL ) {
+            msk += run;
+        }
+        size -= run;
+    }
+}
+
+static const acamera_calib_view_t *get_buf_view( uint8_t buf_class, uint8_t id )
+{
+    const acamera_calib_view_t *p_view;
+
+    if ( buf_class != STATIC_CALIBRATIONS_ID && buf_class != DYNAMIC_CALIBRATIONS_ID ) {
+        LOG( LOG_WARNING, "Wrong buffer class %u", (unsigned int)buf_class );
+        return NULL;
+    }
+
+    p_view = _GET_VIEW( acamera_get_api_ctx_ptr(), id );
+    if ( p_view == NULL || p_view->missing ) {
+        LOG( LOG_WARNING, "Calibration buffer %u is not available", (unsigned int)id );
+        return NULL;
+    }
+
+    return p_view;
+}
+
+// The chunk is copied into the reply when the request is accepted, a calibration
+// swap before the reply is sent cannot release the data under it.
+static uint8_t read_buf_chunk( uint8_t buf_class, uint8_t id, uint32_t offset, uint32_t size, uint8_t *data, uint32_t max_size, uint32_t *p_total )
+{
+    const acamera_calib_view_t *p_view = get_buf_view( buf_class, id );
+    uint32_t total;
+
+    *p_total = 0;
+    if ( p_view == NULL ) {
+        return FAIL;
+    }
+
+    total = p_view->len * p_view->width;
+    *p_total = total;
+
+    if ( offset > total || size > total - offset || size > max_size ) {
+        LOG( LOG_WARNING, "Wrong chunk %u at %u for buffer %u of size %u", (unsigned int)size, (unsigned int)offset, (unsigned int)id, (unsigned int)total );
+        return FAIL;
+    }
+
+    system_memcpy( data, (const uint8_t *)p_view->ptr + offset, size );
+
+    return SUCCESS;
+}
+
+// Chunks are staged until the whole buffer is received, then it is applied
+// the same way as a single BUFWrite.
+static uint8_t write_buf_chunk( uint8_t buf_class, uint8_t id, uint32_t offset, uint32_t total, const uint8_t *data, uint32_t size, uint32_t *ret_value )
+{
+    connection_chunk_t *p_chunk = &con.chunk;
+    uint8_t result;
+
+    *ret_value = 0;
+
+    // the first chunk starts a new transfer, an unfinished one is dropped
+    if ( offset == 0 ) {
+        const acamera_calib_view_t *p_view = get_buf_view( buf_class, id );
+
+        release_chunk();
+
+        if ( p_view == NULL ) {
+            *ret_value = ERR_BAD_ARGUMENT;
+            return FAIL;
+        }
+
+        if ( total != p_view->len * p_view->width ) {
+            LOG( LOG_WARNING, "Wrong size %u for buffer %u of size %u", (unsigned int)total, (unsigned int)id, (unsigned int)( p_view->len * p_view->width ) );
+            *ret_value = ERR_WRONG_SIZE;
+            return FAIL;
+        }
+
+        p_chunk->data = system_sw_alloc( total );
+        if ( p_chunk->data == NULL ) {
+            LOG( LOG_ERR, "Failed to allocate %u bytes for buffer %u", (unsigned int)total, (unsigned int)id );
+            return FAIL;
+        }
+
+        p_chunk->size = total;
+        p_chunk->id = id;
+        p_chunk->buf_class = buf_class;
+    }
+
+    if ( p_chunk->data == NULL || p_chunk->id != id || p_chunk->buf_class != buf_class ||
+         p_chunk->size != total || p_chunk->received != offset || size > total - offset ) {
+        LOG( LOG_WARNING, "Unexpected chunk %u at %u for buffer %u", (unsigned int)size, (unsigned int)offset, (unsigned int)id );
+        release_chunk();
+        *ret_value = ERR_BAD_ARGUMENT;
+        return FAIL;
+    }
+
+    system_memcpy( p_chunk->data + offset, data, size );
+    p_chunk->received += size;
+
+    if ( p_chunk->received < p_chunk->size ) {
+        return SUCCESS;
+    }
+
+    result = application_api_calibration( buf_class, id, COMMAND_SET, p_chunk->data, p_chunk->size, ret_value );
+    release_chunk();
+
+    return result;
+}
+
 static void process_request( void )
 {
     uint32_t *rx_buf = (uint32_t *)&con.buffer[8];
@@ -267,11 +540,7 @@ static void process_request( void )
             if ( size <= CONNECTION_BUFFER_SIZE - HEADER_SIZE - 4 ) {
                 con.tx_buffer_size = HEADER_SIZE + 4 + size;
                 tx_buf[3] = SUCCESS;
-                uint8_t *b = &con.buffer[HEADER_SIZE + 4];
-
-                while ( size-- ) {
-                    *b++ = read_32( addr++ ); //system_sw_read_8(addr++);
-                }
+                read_block( addr, &con.buffer[HEADER_SIZE + 4], size );
             } else {
                 con.tx_buffer_size = HEADER_SIZE + 4;
                 tx_buf[3] = FAIL;
@@ -289,10 +558,7 @@ static void process_request( void )
             con.tx_buffer_size = HEADER_SIZE + 4;
             if ( size <= con.rx_buffer_size - HEADER_SIZE - 8 ) {
                 tx_buf[3] = SUCCESS;
-                uint8_t *b = &con.buffer[HEADER_SIZE + 8];
-                while ( size-- ) {
-                    write_32( addr++, *b++, 0xFF );
-                }
+                write_block( addr, &con.buffer[HEADER_SIZE + 8], NULL, size );
             } else {
                 tx_buf[3] = FAIL;
                 LOG( LOG_WARNING, "Wrong request size %u for type %u", (unsigned int)size, (unsigned int)type );
@@ -309,14 +575,7 @@ static void process_request( void )
             con.tx_buffer_size = HEADER_SIZE + 4;
             if ( 2 * size <= con.rx_buffer_size - HEADER_SIZE - 8 ) {
                 tx_buf[3] = SUCCESS;
-                uint8_t *b = &con.buffer[HEADER_SIZE + 8];
-                uint8_t *m = &con.buffer[HEADER_SIZE + 8 + size];
-                while ( size-- ) {
-                    uint8_t mask = *m++;
-                    uint8_t val = *b++;
-                    write_32( addr, val, mask );
-                    addr++;
-                }
+                write_block( addr, &con.buffer[HEADER_SIZE + 8], &con.buffer[HEADER_SIZE + 8 + size], size );
             } else {
                 tx_buf[3] = FAIL;
                 LOG( LOG_WARNING, "Wrong request size %u for type %u", (unsigned int)size, (unsigned int)type );
@@ -451,6 +710,44 @@ static void process_request( void )
             LOG( LOG_WARNING, "Wrong packet size %u for type %u", (unsigned int)con.rx_buffer_size, (unsigned int)type );
         }
         break;
+    case TransactionTypeBUFReadChunk:
+        if ( con.rx_buffer_size == HEADER_SIZE + 12 ) {
+            uint8_t id = rx_buf[0] & 0xFF;
+            uint8_t buf_class = ( rx_buf[0] >> 8 ) & 0xFF;
+            uint32_t offset = rx_buf[1];
+            uint32_t size = rx_buf[2];
+            con.tx_buffer_size = HEADER_SIZE + 8;
+            tx_buf[3] = read_buf_chunk( buf_class, id, offset, size, &con.buffer[HEADER_SIZE + 8], CONNECTION_BUFFER_SIZE - HEADER_SIZE - 8, &tx_buf[4] );
+            if ( tx_buf[3] == SUCCESS ) {
+                con.tx_buffer_size += size;
+            }
+        } else {
+            con.tx_buffer_size = HEADER_SIZE;
+            LOG( LOG_WARNING, "Wrong packet size %u for type %u", (unsigned int)con.rx_buffer_size, (unsigned int)type );
+        }
+        break;
+    case TransactionTypeBUFWriteChunk:
+        if ( con.rx_buffer_size >= HEADER_SIZE + 16 ) {
+            uint8_t id = rx_buf[0] & 0xFF;
+            uint8_t buf_class = ( rx_buf[0] >> 8 ) & 0xFF;
+            uint32_t offset = rx_buf[1];
+            uint32_t total = rx_buf[2];
+            uint32_t size = rx_buf[3];
+            uint32_t value;
+            con.tx_buffer_size = HEADER_SIZE + 8;
+            if ( size <= con.rx_buffer_size - HEADER_SIZE - 16 ) {
+                tx_buf[3] = write_buf_chunk( buf_class, id, offset, total, (const uint8_t *)&rx_buf[4], size, &value );
+                tx_buf[4] = value;
+            } else {
+                tx_buf[3] = FAIL;
+                tx_buf[4] = ERR_WRONG_SIZE;
+                LOG( LOG_WARNING, "Wrong request size %u for type %u", (unsigned int)size, (unsigned int)type );
+            }
+        } else {
+            con.tx_buffer_size = HEADER_SIZE;
+            LOG( LOG_WARNING, "Wrong packet size %u for type %u", (unsigned int)con.rx_buffer_size, (unsigned int)type );
+        }
+        break;
     default:
         con.tx_buffer_size = HEADER_SIZE;
         LOG( LOG_WARNING, "Wrong packet type %d", type );
@@ -513,7 +810,8 @@ void acamera_connection_process( void )
 {
 #if ISP_HAS_STREAM_CONNECTION
     int res = 0;
-    int cnt = 20;
+    int cnt = 20 * REQUESTS_PER_POLL;
+    int served = 0;
     uint32_t *const buf = (uint32_t *)con.buffer;
 
     if ( !con.data_read || !con.data_write ) {
@@ -586,8 +884,11 @@ void acamera_connection_process( void )
             con.tx_buffer_inx += res;
             if ( con.tx_buffer_inx >= con.tx_buffer_size ) {
                 ACAMERA_CONNECTION_TRACE( "packet size %ld is transferred\n", con.tx_buffer_size );
+                con.transactions++;
                 reset_connection();
-                return; // this will make sure that FW itself will work as required
+                if ( ++served >= REQUESTS_PER_POLL ) {
+                    return; // this will make sure that FW itself will work as required
+                }
             }
             break;
         default:
@@ -408,6 +408,26 @@ uint8_t acamera_command( uint32_t ctx_id, uint8_t command_type, uint8_t command,
 //The function to change firmware internal calibrations.
 uint8_t acamera_api_calibration( uint32_t ctx_id, uint8_t type, uint8_t id, uint8_t direction, void* data, uint32_t data_size, uint32_t* ret_value);
 
+typedef struct _acamera_crop_window_t {
+    uint16_t xoffset;
+    uint16_t yoffset;
+    uint16_t xsize;
+    uint16_t ysize;
+    // scaler output size, used for CROP_DS only
+    uint16_t out_xsize;
+    uint16_t out_ysize;
+} acamera_crop_window_t;
+
+typedef struct _acamera_crop_keyframe_t {
+    acamera_crop_window_t window;
+    // frames taken to move here from the previous keyframe, ignored for the first one
+    uint16_t frames;
+} acamera_crop_keyframe_t;
+
+//The function to move the crop window of CROP_FR or CROP_DS along a list of keyframes, one step every frame.
+//count 0 stops a running trajectory and leaves the crop where it is.
+uint8_t acamera_api_crop_trajectory( uint32_t ctx_id, uint16_t resize_type, const acamera_crop_keyframe_t* keyframes, uint32_t count, uint32_t* ret_value);
+
 uint8_t acamera_api_dma_buffer( uint32_t ctx_id, uint8_t type, void* data, uint32_t data_size, uint32_t* ret_value);
 
 #endif//_ACAMERA_COMMAND_API_H_
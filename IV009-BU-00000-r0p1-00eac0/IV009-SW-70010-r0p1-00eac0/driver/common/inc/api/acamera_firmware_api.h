@@ -80,4 +80,59 @@ int32_t acamera_process( void );
 int32_t acamera_interrupt_handler( void );
 
 
+/**
+ *   Latch interrupts
+ *
+ *   Top half of acamera_interrupt_handler. It reads and clears the interrupt status and latches it together with
+ *   the frame counter and a timestamp. On frame start it also switches ping/pong for the next frame.
+ *   It does as little as possible so it can run in the hard interrupt.
+ *
+ *   @return 1 - acamera_interrupt_thread must be called to finish processing
+ *           0 - nothing was latched
+ */
+int32_t acamera_interrupt_latch( void );
+
+
+/**
+ *   Process latched interrupts
+ *
+ *   Bottom half of acamera_interrupt_handler. It starts the metering and config DMA for the latched frame start
+ *   and handles the remaining latched events. It may run in an interrupt thread.
+ *
+ *   @return 0 - success
+ *          -1 - fail.
+ */
+int32_t acamera_interrupt_thread( void );
+
+
+/**
+ *   Open a batch of api commands
+ *
+ *   Commands issued with acamera_command for the context until the matching acamera_command_batch_end are
+ *   applied as one transaction: FSM recomputations they would trigger (colour space matrix, shading mesh)
+ *   are recorded and run once when the batch is closed. Batches may be nested, only the outermost end
+ *   runs the recorded updates. The batch belongs to the context, not to the caller: while it is open the
+ *   updates of commands issued from other threads are recorded as well and run at its end.
+ *
+ *   @param  ctx_id - context the commands are issued to
+ *
+ *   @return 0 - success
+ *          -1 - fail.
+ */
+int32_t acamera_command_batch_begin( uint32_t ctx_id );
+
+
+/**
+ *   Close a batch of api commands
+ *
+ *   Runs the FSM updates recorded since the matching acamera_command_batch_begin.
+ *
+ *   @param  ctx_id - context the commands are issued to
+ *
+ *   @return 0 - success
+ *          -1 - fail, no batch is open.
+ */
+int32_t acamera_command_batch_end( uint32_t ctx_id );
+
+
 #endif // __ACAMERA_FIRMWARE_API_H__
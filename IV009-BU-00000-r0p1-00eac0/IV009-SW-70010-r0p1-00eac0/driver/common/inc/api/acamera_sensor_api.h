@@ -67,6 +67,7 @@ typedef struct _sensor_param_t {
     uint32_t modes_num;                      // The number of predefined modes
     uint8_t mode;                            // Current mode. This value is from the range [ 0 : modes_num - 1 ]
     void *sensor_ctx;                        // Conext to a sensor structure. This structure is not available to firmware
+    uint8_t mode_switch_skip_frames;         // Number of corrupted frames the sensor outputs after a mode switch
 } sensor_param_t;
 
 
@@ -0,0 +1,122 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#ifndef __ACAMERA_ISP1_GROUP_CONFIG_H__
+#define __ACAMERA_ISP1_GROUP_CONFIG_H__
+
+
+#include "system_sw_io.h"
+
+// ------------------------------------------------------------------------------ //
+// Grouped field accessors of instance 'isp1'
+// ------------------------------------------------------------------------------ //
+
+// ------------------------------------------------------------------------------ //
+// Registers whose fields are programmed together every frame are written with
+// a single masked store instead of a read-modify-write per field.
+// ------------------------------------------------------------------------------ //
+
+// ------------------------------------------------------------------------------ //
+// Register: Active Width, Active Height
+// ------------------------------------------------------------------------------ //
+
+// args: width (16-bit), height (16-bit)
+static __inline void acamera_isp_top_active_size_write(uintptr_t base, uint16_t width, uint16_t height) {
+    system_sw_write_32(base + 0x18e88L, (((uint32_t) (width & 0xffff)) << 0) | (((uint32_t) (height & 0xffff)) << 16));
+}
+// ------------------------------------------------------------------------------ //
+// Register: Gain 00, Gain 01
+// ------------------------------------------------------------------------------ //
+
+// args: gain_00 (12-bit), gain_01 (12-bit)
+static __inline void acamera_isp_white_balance_gain_00_01_write(uintptr_t base, uint16_t gain_00, uint16_t gain_01) {
+    system_sw_update_32(base + 0x1ac10L, 0xfff0fff, (((uint32_t) (gain_00 & 0xfff)) << 0) | (((uint32_t) (gain_01 & 0xfff)) << 16));
+}
+// ------------------------------------------------------------------------------ //
+// Register: Gain 10, Gain 11
+// ------------------------------------------------------------------------------ //
+
+// args: gain_10 (12-bit), gain_11 (12-bit)
+static __inline void acamera_isp_white_balance_gain_10_11_write(uintptr_t base, uint16_t gain_10, uint16_t gain_11) {
+    system_sw_update_32(base + 0x1ac14L, 0xfff0fff, (((uint32_t) (gain_10 & 0xfff)) << 0) | (((uint32_t) (gain_11 & 0xfff)) << 16));
+}
+// ------------------------------------------------------------------------------ //
+// Register: Mesh Alpha Bank R, Mesh Alpha Bank G, Mesh Alpha Bank B
+// ------------------------------------------------------------------------------ //
+
+// args: bank_r (3-bit), bank_g (3-bit), bank_b (3-bit)
+static __inline void acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write(uintptr_t base, uint8_t bank_r, uint8_t bank_g, uint8_t bank_b) {
+    system_sw_update_32(base + 0x1ac04L, 0x1ff, (((uint32_t) (bank_r & 0x7)) << 0) | (((uint32_t) (bank_g & 0x7)) << 3) | (((uint32_t) (bank_b & 0x7)) << 6));
+}
+// ------------------------------------------------------------------------------ //
+// Register: Mesh Alpha R, Mesh Alpha G, Mesh Alpha B
+// ------------------------------------------------------------------------------ //
+
+// args: alpha_r (8-bit), alpha_g (8-bit), alpha_b (8-bit)
+static __inline void acamera_isp_mesh_shading_mesh_alpha_rgb_write(uintptr_t base, uint8_t alpha_r, uint8_t alpha_g, uint8_t alpha_b) {
+    system_sw_update_32(base + 0x1ac08L, 0xffffff, (((uint32_t) (alpha_r & 0xff)) << 0) | (((uint32_t) (alpha_g & 0xff)) << 8) | (((uint32_t) (alpha_b & 0xff)) << 16));
+}
+// ------------------------------------------------------------------------------ //
+// Field descriptors for the register scripts of the fsms
+// ------------------------------------------------------------------------------ //
+
+// ------------------------------------------------------------------------------ //
+// { offset in the software config map, mask in the register, shift }
+// ------------------------------------------------------------------------------ //
+#define ACAMERA_ISP_CCM_COEFFT_R_R_FIELD {0x1b080L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_R_G_FIELD {0x1b084L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_R_B_FIELD {0x1b088L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_G_R_FIELD {0x1b090L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_G_G_FIELD {0x1b094L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_G_B_FIELD {0x1b098L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_B_R_FIELD {0x1b0a0L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_B_G_FIELD {0x1b0a4L, 0x1fff, 0}
+#define ACAMERA_ISP_CCM_COEFFT_B_B_FIELD {0x1b0a8L, 0x1fff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_11_FIELD {0x1c09cL, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_12_FIELD {0x1c0a0L, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_13_FIELD {0x1c0a4L, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_21_FIELD {0x1c0a8L, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_22_FIELD {0x1c0acL, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_23_FIELD {0x1c0b0L, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_31_FIELD {0x1c0b4L, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_32_FIELD {0x1c0b8L, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_33_FIELD {0x1c0bcL, 0xffff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_O1_FIELD {0x1c0c0L, 0x7ff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_O2_FIELD {0x1c0c4L, 0x7ff, 0}
+#define ACAMERA_ISP_FR_CS_CONV_COEFFT_O3_FIELD {0x1c0c8L, 0x7ff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_11_FIELD {0x1c210L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_12_FIELD {0x1c214L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_13_FIELD {0x1c218L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_21_FIELD {0x1c21cL, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_22_FIELD {0x1c220L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_23_FIELD {0x1c224L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_31_FIELD {0x1c228L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_32_FIELD {0x1c22cL, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_33_FIELD {0x1c230L, 0xffff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_O1_FIELD {0x1c234L, 0x7ff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_O2_FIELD {0x1c238L, 0x7ff, 0}
+#define ACAMERA_ISP_DS1_CS_CONV_COEFFT_O3_FIELD {0x1c23cL, 0x7ff, 0}
+#define ACAMERA_ISP_SINTER_STRENGTH_1_FIELD {0x19364L, 0xff00, 8}
+#define ACAMERA_ISP_SINTER_THRESH_1H_FIELD {0x1935cL, 0xff00, 8}
+#define ACAMERA_ISP_SINTER_THRESH_1V_FIELD {0x19360L, 0xff00, 8}
+#define ACAMERA_ISP_SINTER_THRESH_4H_FIELD {0x1935cL, 0xff000000, 24}
+#define ACAMERA_ISP_SINTER_THRESH_4V_FIELD {0x19360L, 0xff000000, 24}
+#define ACAMERA_ISP_SINTER_INT_CONFIG_FIELD {0x1934cL, 0xf, 0}
+// ------------------------------------------------------------------------------ //
+#endif //__ACAMERA_ISP1_GROUP_CONFIG_H__
@@ -22,6 +22,7 @@
 
 
 #include "acamera_isp1_config.h"
+#include "acamera_isp1_group_config.h"
 #include "system_sw_io.h"
 
 #include "system_hw_io.h"
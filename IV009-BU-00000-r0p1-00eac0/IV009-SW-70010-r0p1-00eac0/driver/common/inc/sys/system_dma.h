@@ -148,13 +148,10 @@ int32_t system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_
 int32_t system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t *device_addr_pair, int32_t addr_pairs, uint32_t fw_ctx_id );
 
 /**
- *   Needed to unmap the virtual address after dma completes
+ *   Needed to hand the firmware memory back to the cpu after dma completes.
+ *   The memory stays mapped for dma between transfers.
  *
  *   @param ctx - pointer to dma channel data or NULL if error.
- *   @param buff_loc - points to ping or pong buffer.
- *   @param device_addr_pair - pairs of dma bus address and lenght.
- *
- *   @return 0 - on success or -1 on error
  */
 void system_dma_unmap_sg( void *ctx );
 
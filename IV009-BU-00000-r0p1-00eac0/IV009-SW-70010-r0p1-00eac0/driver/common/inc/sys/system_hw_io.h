@@ -97,4 +97,33 @@ void system_hw_write_16( uintptr_t addr, uint16_t data );
 void system_hw_write_8( uintptr_t addr, uint8_t data );
 
 
+/**
+ *   Read consecutive 32 bits words from isp memory
+ *
+ *   This function reads a block of 32 bits words starting from a given
+ *   offset. Every word is read with a single 32 bits access, so it is
+ *   safe to use for register ranges.
+ *
+ *   @param addr - the offset in ISP memory of the first word, 4 bytes aligned.
+ *                 Correct values from 0 to ACAMERA_ISP_MAX_ADDR
+ *   @param data - destination for the words
+ *   @param count - number of words to read
+ */
+void system_hw_read_block_32( uintptr_t addr, uint32_t *data, uint32_t count );
+
+
+/**
+ *   Write consecutive 32 bits words to isp memory
+ *
+ *   This function writes a block of 32 bits words starting from a given
+ *   offset. Every word is written with a single 32 bits access.
+ *
+ *   @param addr - the offset in ISP memory of the first word, 4 bytes aligned.
+ *                 Correct values from 0 to ACAMERA_ISP_MAX_ADDR.
+ *   @param data - words to be written
+ *   @param count - number of words to write
+ */
+void system_hw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count );
+
+
 #endif /* __system_hw_io_H__ */
@@ -55,6 +55,22 @@ void system_interrupts_init( void );
 void system_interrupt_set_handler( system_interrupt_handler_t handler, void *param );
 
 
+/**
+ *   Set an interrupt thread handler
+ *
+ *   This function is used by application to set a handler which runs in a thread after the interrupt handler.
+ *   The interrupt handler then only has to do the time critical part of the processing.
+ *   Platforms without interrupt threads may ignore it.
+ *
+ *   @param
+ *          handler - a callback to finish interrupt processing
+ *          param - pointer to a context which must be send to the handler
+ *
+ *   @return none
+ */
+void system_interrupt_set_thread_handler( system_interrupt_handler_t handler, void *param );
+
+
 /**
  *   Enable system interrupts
  *
@@ -24,6 +24,44 @@
 
 void *system_sw_alloc( uint32_t size );
 void system_sw_free( void *ptr );
+
+#if SYSTEM_SW_IO_INLINE
+// The software config map is plain memory on this platform. The 32 bits
+// accessors are inlined so the field accessors of the generated register
+// headers become a masked load and store, and back to back writes of
+// fields in one register are merged by the compiler. The map is only
+// handed to the DMA through function calls, which order the accesses.
+
+/**
+ *   Report an access to the software config map through a NULL base
+ *
+ *   The inlined accessors keep the NULL base check of the out-of-line
+ *   ones, the report is out of line to keep them small.
+ *
+ *   @param addr - the address accessed
+ *   @param data - data of a write, ignored for a read
+ *   @param write - 1 for a write, 0 for a read
+ */
+void system_sw_io_null_access( uintptr_t addr, uint32_t data, int write );
+
+static __inline uint32_t system_sw_read_32( uintptr_t addr )
+{
+    if ( addr == 0 ) {
+        system_sw_io_null_access( addr, 0, 0 );
+        return 0;
+    }
+    return *(const uint32_t *)addr;
+}
+
+static __inline void system_sw_write_32( uintptr_t addr, uint32_t data )
+{
+    if ( addr == 0 ) {
+        system_sw_io_null_access( addr, data, 1 );
+        return;
+    }
+    *(uint32_t *)addr = data;
+}
+#else
 /**
  *   Read 32 bit word from isp memory
  *
@@ -37,6 +75,35 @@ void system_sw_free( void *ptr );
 uint32_t system_sw_read_32( uintptr_t addr );
 
 
+/**
+ *   Write 32 bits word to isp memory
+ *
+ *   This function writes a 32 bits word to ISP memory with a given offset.
+ *
+ *   @param addr - the offset in ISP memory to write data.
+ *                 Correct values from 0 to ACAMERA_sw_MAX_ADDR.
+ *   @param data - data to be written
+ */
+void system_sw_write_32( uintptr_t addr, uint32_t data );
+#endif // #if SYSTEM_SW_IO_INLINE
+
+
+/**
+ *   Update bits of a 32 bits word in isp memory
+ *
+ *   This function replaces the bits selected by mask with the bits of data,
+ *   it is used to write several fields of one register at once.
+ *
+ *   @param addr - the offset in ISP memory of the word, 4 bytes aligned.
+ *   @param mask - bits to be replaced
+ *   @param data - new value of the bits, bits out of the mask are ignored
+ */
+static __inline void system_sw_update_32( uintptr_t addr, uint32_t mask, uint32_t data )
+{
+    system_sw_write_32( addr, ( system_sw_read_32( addr ) & ~mask ) | ( data & mask ) );
+}
+
+
 /**
  *   Read 16 bit word from isp memory
  *
@@ -64,39 +131,41 @@ uint8_t system_sw_read_8( uintptr_t addr );
 
 
 /**
- *   Write 32 bits word to isp memory
+ *   Write 16 bits word to isp memory
  *
- *   This function writes a 32 bits word to ISP memory with a given offset.
+ *   This function writes a 16 bits word to ISP memory with a given offset.
  *
  *   @param addr - the offset in ISP memory to write data.
  *                 Correct values from 0 to ACAMERA_sw_MAX_ADDR.
  *   @param data - data to be written
  */
-void system_sw_write_32( uintptr_t addr, uint32_t data );
+void system_sw_write_16( uintptr_t addr, uint16_t data );
 
 
 /**
- *   Write 16 bits word to isp memory
+ *   Write 8 bits word to isp memory
  *
- *   This function writes a 16 bits word to ISP memory with a given offset.
+ *   This function writes a 8 bits word to ISP memory with a given offset.
  *
  *   @param addr - the offset in ISP memory to write data.
  *                 Correct values from 0 to ACAMERA_sw_MAX_ADDR.
  *   @param data - data to be written
  */
-void system_sw_write_16( uintptr_t addr, uint16_t data );
+void system_sw_write_8( uintptr_t addr, uint8_t data );
 
 
 /**
- *   Write 8 bits word to isp memory
+ *   Write consecutive 32 bits words to isp memory
  *
- *   This function writes a 8 bits word to ISP memory with a given offset.
+ *   This function writes a block of 32 bits words starting from a given
+ *   offset, it is used to load LUTs and packed register sequences.
  *
- *   @param addr - the offset in ISP memory to write data.
+ *   @param addr - the offset in ISP memory of the first word, 4 bytes aligned.
  *                 Correct values from 0 to ACAMERA_sw_MAX_ADDR.
- *   @param data - data to be written
+ *   @param data - words to be written
+ *   @param count - number of words to write
  */
-void system_sw_write_8( uintptr_t addr, uint8_t data );
+void system_sw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count );
 
 
 #endif /* __system_sw_io_H__ */
@@ -96,6 +96,28 @@ uint16_t acamera_sqrt32( uint32_t arg );
 uint16_t acamera_line_offset( uint16_t line_len, uint8_t bytes_per_pixel );
 
 
+typedef struct _acamera_reciprocal_t {
+    uint32_t mul;
+    uint8_t shift1;
+    uint8_t shift2;
+} acamera_reciprocal_t;
+
+
+void acamera_reciprocal_init( acamera_reciprocal_t *p_rcp, uint32_t divisor );
+
+//  n / divisor for a divisor prepared with acamera_reciprocal_init()
+static inline uint32_t acamera_reciprocal_div( uint32_t n, const acamera_reciprocal_t *p_rcp )
+{
+    const uint32_t t = ( uint32_t )( ( (uint64_t)p_rcp->mul * n ) >> 32 );
+    return ( t + ( ( n - t ) >> p_rcp->shift1 ) ) >> p_rcp->shift2;
+}
+
+#define ACAMERA_FINGERPRINT_SEED 0x811c9dc5
+
+// FNV-1a over size bytes, chained from seed. Used to detect unchanged inputs.
+uint32_t acamera_fingerprint32( uint32_t seed, const void *p_data, uint32_t size );
+
+
 #define ACAMERA_MODULO( N, D ) ( ( N ) - ( ( ( N ) / ( D ) ) * ( D ) ) )
 
 
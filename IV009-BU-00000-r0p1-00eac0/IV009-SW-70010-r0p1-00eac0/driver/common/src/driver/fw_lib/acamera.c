@@ -27,6 +27,7 @@
 #include "acamera_isp_core_nomem_settings.h"
 #include "system_stdlib.h"
 #include "system_dma.h"
+#include "system_timer.h"
 #include "acamera_metering_stats_mem_config.h"
 #include "acamera_aexp_hist_stats_mem_config.h"
 #include "acamera_decompander0_mem_config.h"
@@ -109,6 +110,18 @@ void acamera_notify_evt_data_avail( void )
     system_semaphore_raise( g_firmware.sem_evt_avail );
 }
 
+static uint32_t acamera_ticks_to_ms( uint32_t ticks )
+{
+    uint32_t freq = system_timer_frequency();
+
+    // avoid the overflow of ticks * 1000 with fast timers
+    if ( freq >= 1000 ) {
+        return ticks / ( freq / 1000 );
+    }
+
+    return freq ? ticks * 1000 / freq : 0;
+}
+
 static int32_t validate_settings( acamera_settings *settings, uint32_t ctx_num )
 {
 
@@ -228,6 +241,8 @@ int32_t acamera_init( acamera_settings *settings, uint32_t ctx_num )
     int32_t result = 0;
     uint32_t idx = 0;
 
+    g_firmware.init_start = system_timer_timestamp();
+
     result = validate_settings( settings, ctx_num );
 
     if ( result == 0 ) {
@@ -288,6 +303,9 @@ int32_t acamera_init( acamera_settings *settings, uint32_t ctx_num )
 {
     int32_t result = 0;
     uint32_t idx;
+    uint32_t ctx_start;
+
+    g_firmware.init_start = system_timer_timestamp();
 
     result = validate_settings( settings, ctx_num );
 
@@ -312,6 +330,9 @@ int32_t acamera_init( acamera_settings *settings, uint32_t ctx_num )
 
             system_semaphore_init( &g_firmware.sem_evt_avail );
 
+            system_spinlock_init( &g_firmware.irq_latch.lock );
+            g_firmware.irq_latch.dma_buf = -1;
+
             if ( ctx_num <= FIRMWARE_CONTEXT_NUMBER ) {
 
                 g_firmware.context_number = ctx_num;
@@ -342,10 +363,13 @@ int32_t acamera_init( acamera_settings *settings, uint32_t ctx_num )
                         if ( result )
                             break;
 
+                        ctx_start = system_timer_timestamp();
                         system_dma_copy_sg( g_firmware.dma_chan_isp_config, ISP_CONFIG_PING, SYS_DMA_FROM_DEVICE, 0, idx );
                         // init context
                         result = acamera_init_context( p_ctx, &settings[idx], &g_firmware );
                         if ( result == 0 ) {
+                            LOG( LOG_NOTICE, "Context %d initialized in %u ms", (int)idx, (unsigned int)acamera_ticks_to_ms( system_timer_timestamp() - ctx_start ) );
+                            LOG( LOG_NOTICE, "Context %d memory: context %u bytes, software config map %u bytes", (int)idx, (unsigned int)sizeof( struct _acamera_context_t ), (unsigned int)ACAMERA_CONTEXT_SIZE );
                             // initialize ping
                             LOG( LOG_INFO, "DMA config from DDR to ping and pong of size %d", ACAMERA_ISP1_SIZE );
                             // system_dma_copy current software context to the ping and pong
@@ -403,6 +427,9 @@ int32_t acamera_init( acamera_settings *settings, uint32_t ctx_num )
     acamera_isp_isp_global_mcu_override_config_select_write( 0, 1 ); //put ping pong in slave mode
     g_firmware.dma_flag_isp_config_completed = 1;
     g_firmware.dma_flag_isp_metering_completed = 1;
+
+    LOG( LOG_NOTICE, "Firmware initialized in %u ms, result %d", (unsigned int)acamera_ticks_to_ms( system_timer_timestamp() - g_firmware.init_start ), (int)result );
+
     return result;
 }
 
@@ -436,6 +463,8 @@ static void acamera_deinit( void )
             p_ctx->sw_reg_map.isp_sw_config_map = NULL;
         }
     }
+
+    acamera_release_sequences();
 }
 
 int32_t acamera_terminate()
@@ -443,6 +472,8 @@ int32_t acamera_terminate()
     acamera_logger_empty(); //empty the logger buffer and print remaining logs
     acamera_deinit();
     system_semaphore_destroy( g_firmware.sem_evt_avail );
+    system_spinlock_destroy( g_firmware.irq_latch.lock );
+    g_firmware.irq_latch.lock = NULL;
 
     return 0;
 }
@@ -450,6 +481,16 @@ int32_t acamera_terminate()
 
 #if USER_MODULE
 // single context handler
+int32_t acamera_interrupt_latch()
+{
+    return 0;
+}
+
+int32_t acamera_interrupt_thread()
+{
+    return 0;
+}
+
 int32_t acamera_interrupt_handler()
 {
     return 0;
@@ -500,6 +541,125 @@ static void dma_complete_metering_func( void *arg )
     // after we finish transfer context and metering we can start processing the current data
 }
 
+// Frame start in the top half: switch ping/pong for the next frame and
+// latch which buffer the thread has to transfer. Nothing is logged here.
+static void acamera_interrupt_latch_frame_start( acamera_context_ptr_t p_ctx, acamera_irq_latch_t *p_latch )
+{
+    p_latch->frame_counter++;
+    p_latch->timestamp = system_timer_timestamp();
+
+    if ( g_firmware.dma_flag_isp_metering_completed == 0 || g_firmware.dma_flag_isp_config_completed == 0 ) {
+        p_latch->dma_busy++;
+        return;
+    }
+
+    // we must finish all previous processing before scheduling new dma
+    if ( !acamera_event_queue_empty( &p_ctx->fsm_mgr.event_queue ) ) {
+        p_latch->queue_busy++;
+        return;
+    }
+
+    // the writes of a calibration set being published must reach one frame
+    if ( g_firmware.calib_publishing ) {
+        p_latch->queue_busy++;
+        return;
+    }
+
+    // these flags are used for sync of callbacks
+    g_firmware.dma_flag_isp_config_completed = 0;
+    g_firmware.dma_flag_isp_metering_completed = 0;
+
+    //if (!acamera_isp_isp_global_mcu_ping_pong_config_select_read(0)) { // cmodel compatibility
+    if ( acamera_isp_isp_global_ping_pong_config_select_read( 0 ) == ISP_CONFIG_PONG ) {
+        //            |^^^^^^^^^|
+        // next --->  |  PING   |
+        //            |_________|
+
+        // use ping for the next frame
+        acamera_isp_isp_global_mcu_ping_pong_config_select_write( 0, ISP_CONFIG_PING );
+        p_latch->dma_buf = ISP_CONFIG_PING;
+    } else {
+        //            |^^^^^^^^^|
+        // next --->  |  PONG   |
+        //            |_________|
+
+        // use pong for the next frame
+        acamera_isp_isp_global_mcu_ping_pong_config_select_write( 0, ISP_CONFIG_PONG );
+        p_latch->dma_buf = ISP_CONFIG_PONG;
+    }
+}
+
+// Take the latched state and reset it for the next interrupts.
+static void acamera_interrupt_take_latch( acamera_irq_latch_t *p_taken )
+{
+    acamera_irq_latch_t *p_latch = &g_firmware.irq_latch;
+    unsigned long flags = system_spinlock_lock( p_latch->lock );
+
+    *p_taken = *p_latch;
+    p_latch->irq_mask = 0;
+    p_latch->dma_buf = -1;
+    p_latch->dma_busy = 0;
+    p_latch->queue_busy = 0;
+
+    system_spinlock_unlock( p_latch->lock, flags );
+}
+
+// Startup time is reported once per context, from acamera_init to the
+// first frame start handled for it.
+static void acamera_interrupt_first_frame( acamera_context_ptr_t p_ctx )
+{
+    if ( p_ctx->first_frame_reported ) {
+        return;
+    }
+
+    p_ctx->first_frame_reported = 1;
+
+    LOG( LOG_NOTICE, "Context %d first frame %u ms after the firmware init started",
+         (int)p_ctx->context_id, (unsigned int)acamera_ticks_to_ms( system_timer_timestamp() - g_firmware.init_start ) );
+}
+
+// Frame start in the thread: report what the top half skipped and start
+// the metering and config transfers for the buffer it selected.
+static int32_t acamera_interrupt_frame_start( const acamera_irq_latch_t *p_latch, uint32_t metering_ctx, uint32_t config_ctx )
+{
+    int32_t result = 0;
+    uint32_t merged = p_latch->frame_counter - g_firmware.irq_frame_handled;
+
+    g_firmware.irq_frame_handled = p_latch->frame_counter;
+
+    if ( p_latch->frame_counter <= 10 ) {
+        LOG( LOG_INFO, "[KeyMsg]: FS interrupt: %d", (int)p_latch->frame_counter - 1 );
+    }
+
+    if ( merged > 1 ) {
+        LOG( LOG_WARNING, "%u frame starts were latched before the interrupt thread ran", (unsigned int)merged );
+    }
+
+    LOG( LOG_DEBUG, "FS %u handled %u ticks after the interrupt", (unsigned int)p_latch->frame_counter, (unsigned int)( system_timer_timestamp() - p_latch->timestamp ) );
+
+#if ISP_DMA_RAW_CAPTURE
+    dma_raw_capture_interrupt( &g_firmware, ACAMERA_IRQ_FRAME_END );
+#endif
+
+    if ( p_latch->dma_busy ) {
+        LOG( LOG_ERR, "DMA is not finished, cfg: %d, meter: %d, skip this frame.", g_firmware.dma_flag_isp_config_completed, g_firmware.dma_flag_isp_metering_completed );
+        result = -2;
+    }
+
+    if ( p_latch->queue_busy ) {
+        LOG( LOG_ERR, "Attempt to start a new frame before processing is done for the prevous frame. Skip this frame" );
+    }
+
+    if ( p_latch->dma_buf >= 0 ) {
+        LOG( LOG_INFO, "DMA metering to DDR and config from DDR through %s, size %d and %d", ( p_latch->dma_buf == ISP_CONFIG_PING ) ? "ping" : "pong", ACAMERA_METERING_STATS_MEM_SIZE, ACAMERA_ISP1_SIZE );
+        // dma all stat memory only to the software context
+        system_dma_copy_sg( g_firmware.dma_chan_isp_metering, p_latch->dma_buf, SYS_DMA_FROM_DEVICE, dma_complete_metering_func, metering_ctx );
+        system_dma_copy_sg( g_firmware.dma_chan_isp_config, p_latch->dma_buf, SYS_DMA_TO_DEVICE, dma_complete_context_func, config_ctx );
+    }
+
+    return result;
+}
+
 
 #if ISP_HAS_DMA_INPUT
 
@@ -545,12 +705,12 @@ static int32_t fpga_irq_handler( uint32_t isp_event )
 }
 
 // multiple contexts handler
-int32_t acamera_interrupt_handler()
+int32_t acamera_interrupt_latch()
 {
     int32_t result = 0;
-    int32_t irq_bit = ISP_INTERRUPT_EVENT_NONES_COUNT - 1;
     int32_t irq = 0;
-    LOG( LOG_INFO, "Interrupt handler called" );
+    acamera_irq_latch_t *p_latch = &g_firmware.irq_latch;
+    unsigned long flags;
 
     uint32_t fpga_irq_mask = acamera_fpga_fe_isp_interrupts_interrupt_status_read( 0 );
 
@@ -558,145 +718,89 @@ int32_t acamera_interrupt_handler()
     acamera_fpga_fe_isp_interrupts_interrupt_clear_write( 0, 0 );
     acamera_fpga_fe_isp_interrupts_interrupt_clear_write( 0, fpga_irq_mask );
 
-    // process interrupts
-    if ( fpga_irq_mask > 0 ) {
-        while ( fpga_irq_mask > 0 && irq < ISP_INTERRUPT_EVENT_NONES_COUNT ) {
-            int32_t lsb = ( fpga_irq_mask & 1 );
-            fpga_irq_mask >>= 1;
-            if ( lsb ) {
-                if ( g_firmware.dma_input.fpga_isp_interrupt_source_read[irq] != NULL ) {
-                    uint32_t isp_event = g_firmware.dma_input.fpga_isp_interrupt_source_read[irq]( 0 );
-
-                    fpga_irq_handler( isp_event );
-
-                } else {
-                    result = -1;
-                    LOG( LOG_ERR, "IRQ mask had interrupt %d but irq handler routine is null", (int)irq );
-                }
-            }
-            irq++;
-        }
-
-        if ( fpga_irq_mask != 0 ) {
-            LOG( LOG_INFO, "irq_mask is not zero. Some interrupts have been left unprocessed" );
+    // the dma input switches contexts, so it is done before the isp irq vector is latched
+    while ( fpga_irq_mask > 0 && irq < ISP_INTERRUPT_EVENT_NONES_COUNT ) {
+        int32_t lsb = ( fpga_irq_mask & 1 );
+        fpga_irq_mask >>= 1;
+        if ( lsb && g_firmware.dma_input.fpga_isp_interrupt_source_read[irq] != NULL ) {
+            fpga_irq_handler( g_firmware.dma_input.fpga_isp_interrupt_source_read[irq]( 0 ) );
         }
+        irq++;
     }
 
-    int32_t last_ctx = fpga_dma_input_last_context( &g_firmware );
     int32_t cur_ctx = fpga_dma_input_current_context( &g_firmware );
-    int32_t next_ctx = fpga_dma_input_next_context( &g_firmware );
-
     acamera_context_ptr_t p_ctx = (acamera_context_ptr_t)&g_firmware.fw_ctx[cur_ctx];
 
     // read the irq vector from isp
     uint32_t irq_mask = acamera_isp_isp_global_interrupt_status_vector_read( 0 );
 
-    LOG( LOG_INFO, "IRQ MASK is 0x%x, last_ctx: %d, cur_ctx: %d, next_ctx: %d.", irq_mask, last_ctx, cur_ctx, next_ctx );
-
     // clear irq vector
     acamera_isp_isp_global_interrupt_clear_write( 0, 0 );
     acamera_isp_isp_global_interrupt_clear_write( 0, 1 );
 
     if ( irq_mask > 0 ) {
+        flags = system_spinlock_lock( p_latch->lock );
 
-        /*#if defined( ISP_INTERRUPT_EVENT_BROKEN_FRAME ) && defined( ISP_INTERRUPT_EVENT_MULTICTX_ERROR ) && defined( ISP_INTERRUPT_EVENT_DMA_ERROR ) && defined( ISP_INTERRUPT_EVENT_WATCHDOG_EXP ) && defined( ISP_INTERRUPT_EVENT_FRAME_COLLISION )
-        //check for errors in the interrupt
-        if ( ( irq_mask & 1 << ISP_INTERRUPT_EVENT_BROKEN_FRAME ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_MULTICTX_ERROR ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_DMA_ERROR ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_WATCHDOG_EXP ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_FRAME_COLLISION ) ) {
-
-            LOG( LOG_CRIT, "Found error resetting ISP. MASK is 0x%x", irq_mask );
+        p_latch->irq_mask |= irq_mask;
+        p_latch->last_ctx = fpga_dma_input_last_context( &g_firmware );
+        p_latch->cur_ctx = cur_ctx;
+        p_latch->next_ctx = fpga_dma_input_next_context( &g_firmware );
 
-            acamera_fw_error_routine( p_ctx, irq_mask );
-            return -1; //skip other interrupts in case of error
+        if ( irq_mask & ( 1 << ISP_INTERRUPT_EVENT_ISP_START_FRAME_START ) ) {
+            acamera_interrupt_latch_frame_start( p_ctx, p_latch );
         }
-#endif*/
-
-        while ( irq_mask > 0 && irq_bit >= 0 ) {
-            int32_t irq_is_1 = ( irq_mask & ( 1 << irq_bit ) );
-            irq_mask &= ~( 1 << irq_bit );
-            if ( irq_is_1 ) {
-                // process interrupts
-                if ( irq_bit == ISP_INTERRUPT_EVENT_ISP_START_FRAME_START ) {
-                    static uint32_t fs_cnt = 0;
 
-                    LOG( LOG_INFO, "FS interrupt: %d", fs_cnt++ );
-
-#if ISP_DMA_RAW_CAPTURE
-                    dma_raw_capture_interrupt( &g_firmware, ACAMERA_IRQ_FRAME_END );
-#endif
+        system_spinlock_unlock( p_latch->lock, flags );
+        result = 1;
+    }
 
-                    if ( g_firmware.dma_flag_isp_metering_completed == 0 || g_firmware.dma_flag_isp_config_completed == 0 ) {
-                        LOG( LOG_CRIT, "DMA is not finished, cfg: %d, meter: %d, skip this frame.", g_firmware.dma_flag_isp_config_completed, g_firmware.dma_flag_isp_metering_completed );
-                        return -2;
-                    }
+    return result;
+}
 
-                    // we must finish all previous processing before scheduling new dma
-                    if ( acamera_event_queue_empty( &p_ctx->fsm_mgr.event_queue ) ) {
-                        // switch to ping/pong contexts for the next frame
-
-                        // these flags are used for sync of callbacks
-                        g_firmware.dma_flag_isp_config_completed = 0;
-                        g_firmware.dma_flag_isp_metering_completed = 0;
-
-                        if ( acamera_isp_isp_global_ping_pong_config_select_read( 0 ) == ISP_CONFIG_PONG ) {
-                            LOG( LOG_INFO, "Current config is pong" );
-                            //            |^^^^^^^^^|
-                            // next --->  |  PING   |
-                            //            |_________|
-
-                            // use ping for the next frame
-                            acamera_isp_isp_global_mcu_ping_pong_config_select_write( 0, ISP_CONFIG_PING );
-                            //
-                            //            |^^^^^^^^^|
-                            // conf --->  |  PONG   |
-                            //            |_________|
-                            LOG( LOG_INFO, "DMA metering from pong to DDR of size %d", ACAMERA_METERING_STATS_MEM_SIZE );
-                            // dma all stat memory only to the software context
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_metering, ISP_CONFIG_PING, SYS_DMA_FROM_DEVICE, dma_complete_metering_func, last_ctx );
-                            LOG( LOG_INFO, "DMA config from pong to DDR of size %d", ACAMERA_ISP1_SIZE );
-
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_config, ISP_CONFIG_PING, SYS_DMA_TO_DEVICE, dma_complete_context_func, next_ctx );
-                        } else {
-                            LOG( LOG_INFO, "Current config is ping" );
-                            //            |^^^^^^^^^|
-                            // next --->  |  PONG   |
-                            //            |_________|
+int32_t acamera_interrupt_thread()
+{
+    int32_t result = 0;
+    int32_t irq_bit = ISP_INTERRUPT_EVENT_NONES_COUNT - 1;
+    acamera_irq_latch_t latch;
 
-                            // use pong for the next frame
-                            acamera_isp_isp_global_mcu_ping_pong_config_select_write( 0, ISP_CONFIG_PONG );
+    acamera_interrupt_take_latch( &latch );
 
-                            //            |^^^^^^^^^|
-                            // conf --->  |  PING   |
-                            //            |_________|
+    LOG( LOG_INFO, "IRQ MASK is 0x%x, last_ctx: %d, cur_ctx: %d, next_ctx: %d.", latch.irq_mask, latch.last_ctx, latch.cur_ctx, latch.next_ctx );
 
-                            LOG( LOG_INFO, "DMA metering from ping to DDR of size %d", ACAMERA_METERING_STATS_MEM_SIZE );
-                            // dma all stat memory only to the software context
+#if ISP_HAS_ERROR_RECOVERY
+    acamera_context_ptr_t p_ctx = (acamera_context_ptr_t)&g_firmware.fw_ctx[latch.cur_ctx];
 
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_metering, ISP_CONFIG_PONG, SYS_DMA_FROM_DEVICE, dma_complete_metering_func, last_ctx );
-                            LOG( LOG_INFO, "DMA config from DDR to ping of size %d", ACAMERA_ISP1_SIZE );
+    //check for errors in the interrupt, the recovery is done by the process loop
+    if ( acamera_fw_errors_latch( &p_ctx->err_stats, latch.irq_mask, latch.next_ctx ) >= 0 ) {
+        acamera_notify_evt_data_avail();
+        return -1; //skip other interrupts in case of error
+    }
+#endif
 
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_config, ISP_CONFIG_PONG, SYS_DMA_TO_DEVICE, dma_complete_context_func, next_ctx );
-                        }
-                    } else {
-                        LOG( LOG_ERR, "Attempt to start a new frame before processing is done for the prevous frame. Skip this frame" );
-                    }
-                } else if ( irq_bit == ISP_INTERRUPT_EVENT_ISP_END_FRAME_END ) {
-                    static uint32_t fe_cnt = 0;
+    while ( latch.irq_mask > 0 && irq_bit >= 0 ) {
+        int32_t irq_is_1 = ( latch.irq_mask & ( 1 << irq_bit ) );
+        latch.irq_mask &= ~( 1 << irq_bit );
+        if ( irq_is_1 ) {
+            // process interrupts
+            if ( irq_bit == ISP_INTERRUPT_EVENT_ISP_START_FRAME_START ) {
+                result = acamera_interrupt_frame_start( &latch, latch.last_ctx, latch.next_ctx );
+                acamera_interrupt_first_frame( &g_firmware.fw_ctx[latch.cur_ctx] );
+#if ISP_HAS_ERROR_RECOVERY
+                acamera_fw_errors_frame_start( &p_ctx->err_stats, latch.dma_buf );
+#endif
+            } else if ( irq_bit == ISP_INTERRUPT_EVENT_ISP_END_FRAME_END ) {
+                static uint32_t fe_cnt = 0;
 
-                    LOG( LOG_INFO, "FE interrupt: %d", fe_cnt++ );
+                LOG( LOG_INFO, "FE interrupt: %d", fe_cnt++ );
 
-                    fpga_dma_input_interrupt( &g_firmware, ACAMERA_IRQ_FRAME_END, cur_ctx );
+                fpga_dma_input_interrupt( &g_firmware, ACAMERA_IRQ_FRAME_END, latch.cur_ctx );
 
-                } else {
-                    // unhandled irq
-                    LOG( LOG_INFO, "Unhandled interrupt bit %d", irq_bit );
-                }
+            } else {
+                // unhandled irq
+                LOG( LOG_INFO, "Unhandled interrupt bit %d", irq_bit );
             }
-            irq_bit--;
         }
+        irq_bit--;
     }
 
     return result;
@@ -705,128 +809,122 @@ int32_t acamera_interrupt_handler()
 #else
 
 // single context handler
-int32_t acamera_interrupt_handler()
+int32_t acamera_interrupt_latch()
 {
     int32_t result = 0;
-    int32_t irq_bit = ISP_INTERRUPT_EVENT_NONES_COUNT - 1;
-    LOG( LOG_INFO, "Interrupt handler called" );
-
     acamera_context_ptr_t p_ctx = (acamera_context_ptr_t)&g_firmware.fw_ctx[0];
-
+    acamera_irq_latch_t *p_latch = &g_firmware.irq_latch;
+    unsigned long flags;
 
     // read the irq vector from isp
     uint32_t irq_mask = acamera_isp_isp_global_interrupt_status_vector_read( 0 );
 
-    LOG( LOG_INFO, "IRQ MASK is %d", irq_mask );
-
     // clear irq vector
     acamera_isp_isp_global_interrupt_clear_write( 0, 0 );
     acamera_isp_isp_global_interrupt_clear_write( 0, 1 );
 
     if ( irq_mask > 0 ) {
-        /*
-#if defined( ISP_INTERRUPT_EVENT_BROKEN_FRAME ) && defined( ISP_INTERRUPT_EVENT_MULTICTX_ERROR ) && defined( ISP_INTERRUPT_EVENT_DMA_ERROR ) && defined( ISP_INTERRUPT_EVENT_WATCHDOG_EXP ) && defined( ISP_INTERRUPT_EVENT_FRAME_COLLISION )
-        //check for errors in the interrupt
-        if ( ( irq_mask & 1 << ISP_INTERRUPT_EVENT_BROKEN_FRAME ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_MULTICTX_ERROR ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_DMA_ERROR ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_WATCHDOG_EXP ) ||
-             ( irq_mask & 1 << ISP_INTERRUPT_EVENT_FRAME_COLLISION ) ) {
-
-            LOG( LOG_ERR, "Found error resetting ISP. MASK is 0x%x", irq_mask );
-
-            acamera_fw_error_routine( p_ctx, irq_mask );
-            return -1; //skip other interrupts in case of error
+        flags = system_spinlock_lock( p_latch->lock );
+
+        p_latch->irq_mask |= irq_mask;
+
+        if ( irq_mask & ( 1 << ISP_INTERRUPT_EVENT_ISP_START_FRAME_START ) ) {
+            acamera_interrupt_latch_frame_start( p_ctx, p_latch );
         }
-#endif*/
-
-        while ( irq_mask > 0 && irq_bit >= 0 ) {
-            int32_t irq_is_1 = ( irq_mask & ( 1 << irq_bit ) );
-            irq_mask &= ~( 1 << irq_bit );
-            if ( irq_is_1 ) {
-                // process interrupts
-                if ( irq_bit == ISP_INTERRUPT_EVENT_ISP_START_FRAME_START ) {
-                    static uint32_t fs_cnt = 0;
-                    if ( fs_cnt < 10 ) {
-                        LOG( LOG_INFO, "[KeyMsg]: FS interrupt: %d", fs_cnt++ );
-                    }
 
-#if ISP_DMA_RAW_CAPTURE
-                    dma_raw_capture_interrupt( &g_firmware, ACAMERA_IRQ_FRAME_END );
-#endif
+        system_spinlock_unlock( p_latch->lock, flags );
+        result = 1;
+    }
 
-                    if ( g_firmware.dma_flag_isp_metering_completed == 0 || g_firmware.dma_flag_isp_config_completed == 0 ) {
-                        LOG( LOG_ERR, "DMA is not finished, cfg: %d, meter: %d, skip this frame.", g_firmware.dma_flag_isp_config_completed, g_firmware.dma_flag_isp_metering_completed );
-                        return -2;
-                    }
+    return result;
+}
 
-                    // we must finish all previous processing before scheduling new dma
-                    if ( acamera_event_queue_empty( &p_ctx->fsm_mgr.event_queue ) ) {
-                        // switch to ping/pong contexts for the next frame
-
-                        // these flags are used for sync of callbacks
-                        g_firmware.dma_flag_isp_config_completed = 0;
-                        g_firmware.dma_flag_isp_metering_completed = 0;
-
-                        //if (!acamera_isp_isp_global_mcu_ping_pong_config_select_read(0)) { // cmodel compatibility
-                        if ( acamera_isp_isp_global_ping_pong_config_select_read( 0 ) == ISP_CONFIG_PONG ) {
-                            LOG( LOG_INFO, "Current config is pong" );
-                            //            |^^^^^^^^^|
-                            // next --->  |  PING   |
-                            //            |_________|
-
-                            // use ping for the next frame
-                            acamera_isp_isp_global_mcu_ping_pong_config_select_write( 0, ISP_CONFIG_PING );
-                            //
-                            //            |^^^^^^^^^|
-                            // conf --->  |  PONG   |
-                            //            |_________|
-                            LOG( LOG_INFO, "DMA metering from pong to DDR of size %d", ACAMERA_METERING_STATS_MEM_SIZE );
-                            // dma all stat memory only to the software context
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_metering, ISP_CONFIG_PING, SYS_DMA_FROM_DEVICE, dma_complete_metering_func, 0 );
-                            LOG( LOG_INFO, "DMA config from pong to DDR of size %d", ACAMERA_ISP1_SIZE );
-
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_config, ISP_CONFIG_PING, SYS_DMA_TO_DEVICE, dma_complete_context_func, 0 );
-                        } else {
-                            LOG( LOG_INFO, "Current config is ping" );
-                            //            |^^^^^^^^^|
-                            // next --->  |  PONG   |
-                            //            |_________|
+int32_t acamera_interrupt_thread()
+{
+    int32_t result = 0;
+    int32_t irq_bit = ISP_INTERRUPT_EVENT_NONES_COUNT - 1;
+    acamera_irq_latch_t latch;
 
-                            // use pong for the next frame
-                            acamera_isp_isp_global_mcu_ping_pong_config_select_write( 0, ISP_CONFIG_PONG );
+    acamera_interrupt_take_latch( &latch );
 
-                            //            |^^^^^^^^^|
-                            // conf --->  |  PING   |
-                            //            |_________|
+    LOG( LOG_INFO, "IRQ MASK is %d", latch.irq_mask );
 
-                            LOG( LOG_INFO, "DMA metering from ping to DDR of size %d", ACAMERA_METERING_STATS_MEM_SIZE );
-                            // dma all stat memory only to the software context
+#if ISP_HAS_ERROR_RECOVERY
+    acamera_context_ptr_t p_ctx = (acamera_context_ptr_t)&g_firmware.fw_ctx[0];
 
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_metering, ISP_CONFIG_PONG, SYS_DMA_FROM_DEVICE, dma_complete_metering_func, 0 );
-                            LOG( LOG_INFO, "DMA config from DDR to ping of size %d", ACAMERA_ISP1_SIZE );
+    //check for errors in the interrupt, the recovery is done by the process loop
+    if ( acamera_fw_errors_latch( &p_ctx->err_stats, latch.irq_mask, 0 ) >= 0 ) {
+        acamera_notify_evt_data_avail();
+        return -1; //skip other interrupts in case of error
+    }
+#endif
 
-                            system_dma_copy_sg( g_firmware.dma_chan_isp_config, ISP_CONFIG_PONG, SYS_DMA_TO_DEVICE, dma_complete_context_func, 0 );
-                        }
-                    } else {
-                        LOG( LOG_ERR, "Attempt to start a new frame before processing is done for the prevous frame. Skip this frame" );
-                    }
-                } else {
-                    // unhandled irq
-                    LOG( LOG_INFO, "Unhandled interrupt bit %d", irq_bit );
-                }
+    while ( latch.irq_mask > 0 && irq_bit >= 0 ) {
+        int32_t irq_is_1 = ( latch.irq_mask & ( 1 << irq_bit ) );
+        latch.irq_mask &= ~( 1 << irq_bit );
+        if ( irq_is_1 ) {
+            // process interrupts
+            if ( irq_bit == ISP_INTERRUPT_EVENT_ISP_START_FRAME_START ) {
+                result = acamera_interrupt_frame_start( &latch, 0, 0 );
+                acamera_interrupt_first_frame( &g_firmware.fw_ctx[0] );
+#if ISP_HAS_ERROR_RECOVERY
+                acamera_fw_errors_frame_start( &p_ctx->err_stats, latch.dma_buf );
+#endif
+            } else {
+                // unhandled irq
+                LOG( LOG_INFO, "Unhandled interrupt bit %d", irq_bit );
             }
-            irq_bit--;
         }
+        irq_bit--;
     }
 
     return result;
 }
 #endif // ISP_HAS_DMA_INPUT
 
+int32_t acamera_interrupt_handler()
+{
+    int32_t result = 0;
+
+    LOG( LOG_INFO, "Interrupt handler called" );
+
+    if ( acamera_interrupt_latch() ) {
+        result = acamera_interrupt_thread();
+    }
+
+    return result;
+}
+
 #endif // USER_MODULE
 
 
+#if ISP_HAS_ERROR_RECOVERY
+// Recover in place from the most severe error the interrupt thread latched.
+// Safe stop is polled with sleeps, so this runs in the process loop.
+static void acamera_process_errors( acamera_context_ptr_t p_ctx )
+{
+    uint32_t config_ctx;
+    int32_t err_class = acamera_fw_errors_take( &p_ctx->err_stats, &config_ctx );
+
+    if ( err_class < 0 ) {
+        return;
+    }
+
+    LOG( LOG_ERR, "Recovering ISP in place from error class %d", (int)err_class );
+
+    int32_t stop_result = acamera_fw_error_routine( p_ctx, (acamera_fw_error_class_t)err_class );
+
+    // transfers started for the broken frame are not waited for
+    g_firmware.dma_flag_isp_config_completed = 1;
+    g_firmware.dma_flag_isp_metering_completed = 1;
+
+    // both ping and pong may hold a partial config, restore them from the software map
+    acamera_update_cur_settings_to_isp( config_ctx );
+
+    acamera_fw_errors_recovered( &p_ctx->err_stats, stop_result );
+}
+#endif
+
 int32_t acamera_process( void )
 {
     int32_t result = 0;
@@ -835,6 +933,9 @@ int32_t acamera_process( void )
     if ( g_firmware.initialized == 1 ) {
         for ( idx = 0; idx < g_firmware.context_number; idx++ ) {
             acamera_context_ptr_t p_ctx = ( acamera_context_ptr_t ) & ( g_firmware.fw_ctx[idx] );
+#if ISP_HAS_ERROR_RECOVERY
+            acamera_process_errors( p_ctx );
+#endif
             acamera_fw_process( p_ctx );
         }
     } else {
@@ -850,3 +951,73 @@ int32_t acamera_process( void )
 
     return result;
 }
+
+
+int32_t acamera_command_batch_begin( uint32_t ctx_id )
+{
+    acamera_context_ptr_t p_ctx = (acamera_context_ptr_t)acamera_get_ctx_ptr( ctx_id );
+
+    unsigned long flags;
+
+    if ( p_ctx == NULL ) {
+        return -1;
+    }
+
+    flags = system_spinlock_lock( p_ctx->cmd_batch_lock );
+    if ( p_ctx->cmd_batch_depth == 0xFF ) {
+        system_spinlock_unlock( p_ctx->cmd_batch_lock, flags );
+        LOG( LOG_ERR, "Too many command batches are open on context %d", (int)ctx_id );
+        return -1;
+    }
+    p_ctx->cmd_batch_depth++;
+    system_spinlock_unlock( p_ctx->cmd_batch_lock, flags );
+
+    return 0;
+}
+
+int32_t acamera_command_batch_end( uint32_t ctx_id )
+{
+    acamera_context_ptr_t p_ctx = (acamera_context_ptr_t)acamera_get_ctx_ptr( ctx_id );
+    uint32_t pending;
+    unsigned long flags;
+
+    if ( p_ctx == NULL ) {
+        return -1;
+    }
+
+    flags = system_spinlock_lock( p_ctx->cmd_batch_lock );
+
+    if ( p_ctx->cmd_batch_depth == 0 ) {
+        system_spinlock_unlock( p_ctx->cmd_batch_lock, flags );
+        LOG( LOG_ERR, "No command batch is open on context %d", (int)ctx_id );
+        return -1;
+    }
+
+    if ( --p_ctx->cmd_batch_depth ) {
+        system_spinlock_unlock( p_ctx->cmd_batch_lock, flags );
+        return 0;
+    }
+
+    // the updates run without the lock, they are not deferred any more
+    pending = p_ctx->cmd_batch_pending;
+    p_ctx->cmd_batch_pending = 0;
+    system_spinlock_unlock( p_ctx->cmd_batch_lock, flags );
+
+#if defined( ISP_HAS_MATRIX_YUV_FSM )
+    if ( pending & ACAMERA_CMD_BATCH_MATRIX_YUV ) {
+        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_MATRIX_YUV_UPDATE, NULL, 0 );
+    }
+#endif
+
+#if ISP_HAS_COLOR_MATRIX_FSM
+    if ( pending & ACAMERA_CMD_BATCH_SHADING_MESH ) {
+        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_SHADING_MESH_RELOAD, NULL, 0 );
+    }
+#endif
+
+    if ( pending ) {
+        LOG( LOG_DEBUG, "Command batch on context %d closed, deferred updates 0x%x", (int)ctx_id, (unsigned int)pending );
+    }
+
+    return 0;
+}
@@ -21,13 +21,203 @@
 #include "acamera_fw.h"
 #include "acamera_firmware_config.h"
 #include "acamera_logger.h"
-#include "system_timer.h"
+#include "system_stdlib.h"
+
+// A LUT missing from the calibration set is bound to one zero entry backed by
+// this storage, so the FSMs never see a NULL table. Entries readers map a
+// fixed layout on are backed by the layout storage of the context instead.
+#define CALIBRATION_DEFAULT_WORDS 256
+static const uint32_t calibration_default_data[CALIBRATION_DEFAULT_WORDS];
 
 static ACameraCalibrations *get_current_set( void *p_ctx )
 {
     return &( (acamera_context_ptr_t)p_ctx )->acameraCalibrations;
 }
 
+static acamera_calib_views_t *get_views( void *p_ctx )
+{
+    return &( (acamera_context_ptr_t)p_ctx )->calib_views;
+}
+
+static void calibration_lut_missing( void *p_ctx, uint32_t idx )
+{
+    fsm_param_mon_err_head_t mon_err_head;
+
+    mon_err_head.err_type = MON_TYPE_ERR_CALIBRATION_LUT_NULL;
+    mon_err_head.err_param = idx;
+    acamera_fsm_mgr_set_param( &( (acamera_context_ptr_t)p_ctx )->fsm_mgr, FSM_PARAM_SET_MON_ERROR_REPORT, &mon_err_head, sizeof( mon_err_head ) );
+
+    LOG( LOG_ERR, "Calibration LUT 0x%x is not provided by the calibration set, a zero table is used", (int)idx );
+}
+
+// back a fixed layout entry the set leaves out or provides short with
+// zeroed storage, the part of the LUT which is provided is kept
+static int32_t calibration_view_layout( acamera_calib_views_t *p_views, uint32_t idx, const LookupTable *lut )
+{
+    acamera_calib_view_t *p_view = &p_views->view[idx];
+    uint32_t size = p_views->layout_size[idx];
+    uint32_t words = ( size + sizeof( uint32_t ) - 1 ) / sizeof( uint32_t );
+    uint8_t *p_storage;
+    uint32_t width;
+
+    if ( p_views->layout_used + words > CALIBRATION_LAYOUT_STORAGE_WORDS ) {
+        LOG( LOG_CRIT, "No layout storage left for calibration LUT 0x%x of %d bytes", (int)idx, (int)size );
+        return -1;
+    }
+
+    p_storage = (uint8_t *)&p_views->layout_storage[p_views->layout_used];
+    p_views->layout_used += words;
+
+    system_memset( p_storage, 0, words * sizeof( uint32_t ) );
+    width = sizeof( uint32_t );
+    if ( lut != NULL && lut->ptr != NULL && lut->width != 0 ) {
+        width = lut->width;
+        system_memcpy( p_storage, lut->ptr, (uint32_t)lut->rows * lut->cols * lut->width );
+    }
+
+    p_view->ptr = p_storage;
+    p_view->rows = 1;
+    p_view->cols = words * sizeof( uint32_t ) / width;
+    p_view->len = p_view->cols;
+    p_view->width = width;
+
+    return 0;
+}
+
+// returns 1 when the view of idx is not backed by the LUT of the set
+static uint8_t calibration_view_bind( void *p_ctx, uint32_t idx )
+{
+    acamera_calib_views_t *p_views = get_views( p_ctx );
+    const LookupTable *lut = get_current_set( p_ctx )->calibrations[idx];
+    acamera_calib_view_t *p_view = &p_views->view[idx];
+    uint32_t size = 0;
+
+    if ( lut != NULL && lut->ptr != NULL ) {
+        size = (uint32_t)lut->rows * lut->cols * lut->width;
+        if ( size >= p_views->layout_size[idx] ) {
+            p_view->ptr = lut->ptr;
+            p_view->rows = lut->rows;
+            p_view->cols = lut->cols;
+            p_view->len = (uint32_t)lut->rows * lut->cols;
+            p_view->width = lut->width;
+            p_view->missing = 0;
+            return 0;
+        }
+        LOG( LOG_ERR, "Calibration LUT 0x%x has %d bytes but its readers need %d, a zero padded table is used", (int)idx, (int)size, (int)p_views->layout_size[idx] );
+    } else {
+        calibration_lut_missing( p_ctx, idx );
+    }
+
+    if ( p_views->layout_size[idx] == 0 || calibration_view_layout( p_views, idx, size ? lut : NULL ) != 0 ) {
+        p_view->ptr = calibration_default_data;
+        p_view->rows = 1;
+        p_view->cols = 1;
+        p_view->len = 1;
+        p_view->width = sizeof( calibration_default_data[0] );
+    }
+    p_view->missing = 1;
+
+    return 1;
+}
+
+void acamera_calibrations_init( void *p_ctx )
+{
+    system_memset( get_views( p_ctx ), 0, sizeof( acamera_calib_views_t ) );
+}
+
+int32_t acamera_calibrations_bind( void *p_ctx )
+{
+    acamera_calib_views_t *p_views = get_views( p_ctx );
+    uint32_t idx;
+
+    p_views->missing = 0;
+    p_views->layout_used = 0;
+
+    for ( idx = 0; idx < CALIBRATION_TOTAL_SIZE; idx++ ) {
+        p_views->missing += calibration_view_bind( p_ctx, idx );
+    }
+
+    p_views->generation++;
+
+    LOG( LOG_INFO, "Calibration set bound, generation %u, %u LUTs missing", (unsigned int)p_views->generation, (unsigned int)p_views->missing );
+
+    return p_views->missing;
+}
+
+void acamera_calibrations_require( void *p_ctx, uint32_t idx, uint32_t size )
+{
+    acamera_calib_views_t *p_views = get_views( p_ctx );
+    acamera_calib_view_t *p_view;
+
+    if ( idx >= CALIBRATION_TOTAL_SIZE ) {
+        LOG( LOG_CRIT, "Trying to access an isp lut with invalid index %d", (int)idx );
+        return;
+    }
+
+    if ( size <= p_views->layout_size[idx] ) {
+        return;
+    }
+    p_views->layout_size[idx] = size;
+
+    // a set bound before the reader was created is checked right away
+    p_view = &p_views->view[idx];
+    if ( p_view->ptr != NULL && p_view->len * p_view->width < size ) {
+        p_views->missing += !p_view->missing;
+        calibration_view_bind( p_ctx, idx );
+        p_views->generation++;
+    }
+}
+
+int32_t acamera_calibrations_validate( void *p_ctx, const ACameraCalibrations *p_set )
+{
+    const acamera_calib_views_t *p_views = get_views( p_ctx );
+    int32_t result = 0;
+    uint32_t idx;
+
+    for ( idx = 0; idx < CALIBRATION_TOTAL_SIZE; idx++ ) {
+        const LookupTable *lut = p_set->calibrations[idx];
+
+        if ( lut == NULL || lut->ptr == NULL ) {
+            // a LUT the pipeline is using now must not vanish on a swap
+            if ( !p_views->view[idx].missing ) {
+                LOG( LOG_ERR, "Staged calibration set drops LUT 0x%x", (int)idx );
+                result = -1;
+            }
+            continue;
+        }
+
+        if ( lut->rows == 0 || lut->cols == 0 || lut->width == 0 ) {
+            LOG( LOG_ERR, "Staged calibration LUT 0x%x is malformed: rows %d, cols %d, width %d", (int)idx, (int)lut->rows, (int)lut->cols, (int)lut->width );
+            result = -1;
+        } else if ( (uint32_t)lut->rows * lut->cols * lut->width < p_views->layout_size[idx] ) {
+            LOG( LOG_ERR, "Staged calibration LUT 0x%x is shorter than the %d bytes its readers need", (int)idx, (int)p_views->layout_size[idx] );
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+uint32_t acamera_calibrations_generation( void *p_ctx )
+{
+    return get_views( p_ctx )->generation;
+}
+
+void acamera_calibrations_touch( void *p_ctx )
+{
+    get_views( p_ctx )->generation++;
+}
+
+const acamera_calib_view_t *_GET_VIEW( void *p_ctx, uint32_t idx )
+{
+    if ( idx < CALIBRATION_TOTAL_SIZE ) {
+        return &get_views( p_ctx )->view[idx];
+    }
+
+    LOG( LOG_CRIT, "Trying to access an isp lut with invalid index %d", (int)idx );
+    return NULL;
+}
+
 LookupTable *_GET_LOOKUP_PTR( void *p_ctx, uint32_t idx )
 {
     LookupTable *result = NULL;
@@ -43,23 +233,8 @@ LookupTable *_GET_LOOKUP_PTR( void *p_ctx, uint32_t idx )
 
 const void *_GET_LUT_PTR( void *p_ctx, uint32_t idx )
 {
-    const void *result = NULL;
-    LookupTable *lut = _GET_LOOKUP_PTR( p_ctx, idx );
-    if ( lut != NULL ) {
-        result = lut->ptr;
-    } else {
-        while ( 1 ) {
-            fsm_param_mon_err_head_t mon_err_head;
-            mon_err_head.err_type = MON_TYPE_ERR_CALIBRATION_LUT_NULL;
-            mon_err_head.err_param = idx;
-            acamera_fsm_mgr_set_param( &( (acamera_context_ptr_t)p_ctx )->fsm_mgr, FSM_PARAM_SET_MON_ERROR_REPORT, &mon_err_head, sizeof( mon_err_head ) );
-            LOG( LOG_CRIT, "LUT 0x%x is not initialized. Pointer is NULL. Going to the infinite loop", (int)idx );
-
-            // sleep 3 second to avoid affect system performance badly.
-            system_timer_usleep( 3 * 1000 * 1000 );
-        };
-    }
-    return result;
+    const acamera_calib_view_t *p_view = _GET_VIEW( p_ctx, idx );
+    return ( p_view != NULL ) ? p_view->ptr : calibration_default_data;
 }
 
 // use fast version of lut access routines
@@ -95,50 +270,30 @@ modulation_entry_32_t *_GET_MOD_ENTRY32_PTR( void *p_ctx, uint32_t idx )
 
 uint32_t _GET_ROWS( void *p_ctx, uint32_t idx )
 {
-    uint32_t result = 0;
-    LookupTable *lut = _GET_LOOKUP_PTR( p_ctx, idx );
-    if ( lut != NULL ) {
-        result = lut->rows;
-    }
-    return result;
+    const acamera_calib_view_t *p_view = _GET_VIEW( p_ctx, idx );
+    return ( p_view != NULL ) ? p_view->rows : 0;
 }
 
 uint32_t _GET_COLS( void *p_ctx, uint32_t idx )
 {
-    uint32_t result = 0;
-    LookupTable *lut = _GET_LOOKUP_PTR( p_ctx, idx );
-    if ( lut != NULL ) {
-        result = lut->cols;
-    }
-    return result;
+    const acamera_calib_view_t *p_view = _GET_VIEW( p_ctx, idx );
+    return ( p_view != NULL ) ? p_view->cols : 0;
 }
 
 uint32_t _GET_LEN( void *p_ctx, uint32_t idx )
 {
-    uint32_t result = 0;
-    LookupTable *lut = _GET_LOOKUP_PTR( p_ctx, idx );
-    if ( lut != NULL ) {
-        result = lut->cols * lut->rows;
-    }
-    return result;
+    const acamera_calib_view_t *p_view = _GET_VIEW( p_ctx, idx );
+    return ( p_view != NULL ) ? p_view->len : 0;
 }
 
 uint32_t _GET_WIDTH( void *p_ctx, uint32_t idx )
 {
-    uint32_t result = 0;
-    LookupTable *lut = _GET_LOOKUP_PTR( p_ctx, idx );
-    if ( lut != NULL ) {
-        result = lut->width;
-    }
-    return result;
+    const acamera_calib_view_t *p_view = _GET_VIEW( p_ctx, idx );
+    return ( p_view != NULL ) ? p_view->width : 0;
 }
 
 uint32_t _GET_SIZE( void *p_ctx, uint32_t idx )
 {
-    uint32_t result = 0;
-    LookupTable *lut = _GET_LOOKUP_PTR( p_ctx, idx );
-    if ( lut != NULL ) {
-        result = lut->cols * lut->rows * lut->width;
-    }
-    return result;
+    const acamera_calib_view_t *p_view = _GET_VIEW( p_ctx, idx );
+    return ( p_view != NULL ) ? p_view->len * p_view->width : 0;
 }
@@ -29,6 +29,66 @@
 #define CALIBRATION_PREVIEW_SET 1
 
 
+// Validated copy of one calibration entry.
+// Views are rebuilt by acamera_calibrations_bind() whenever a new
+// calibration set is loaded, the address of a view never changes so
+// FSMs may keep a pointer to it for the lifetime of the context.
+// ptr is never NULL: a LUT missing from the set is reported when the set
+// is bound and its view holds a single zero entry with missing set. An
+// entry with a fixed layout, see acamera_calibrations_require(), is never
+// shorter than that layout.
+typedef struct _acamera_calib_view_t {
+    const void *ptr;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t len;
+    uint32_t width;
+    uint8_t missing;
+} acamera_calib_view_t;
+
+// zeroed storage for fixed layout entries the bound set leaves out or
+// provides short, it has to hold all of the layouts of one context
+#define CALIBRATION_LAYOUT_STORAGE_WORDS 512
+
+typedef struct _acamera_calib_views_t {
+    // incremented on every bind so derived data can be refreshed
+    uint32_t generation;
+    // number of missing entries found by the last bind
+    uint32_t missing;
+    acamera_calib_view_t view[CALIBRATION_TOTAL_SIZE];
+    // size in bytes of the layout readers map on each entry, 0 for none
+    uint32_t layout_size[CALIBRATION_TOTAL_SIZE];
+    uint32_t layout_used;
+    uint32_t layout_storage[CALIBRATION_LAYOUT_STORAGE_WORDS];
+} acamera_calib_views_t;
+
+
+// Forgets the views and the layouts of a context before its FSMs are created.
+void acamera_calibrations_init( void *p_ctx );
+
+int32_t acamera_calibrations_bind( void *p_ctx );
+
+// Declares that a reader maps a fixed layout of size bytes on entry idx
+// instead of honouring its length. From then on a set which leaves the
+// entry out or provides it shorter gets it backed by zeroed storage of
+// the layout size, and a staged set which provides it shorter is not
+// published.
+void acamera_calibrations_require( void *p_ctx, uint32_t idx, uint32_t size );
+
+// Checks a staged calibration set before it is published.
+// Every entry must be well formed and no LUT provided by the current
+// set may disappear. Returns 0 when the set can be published.
+int32_t acamera_calibrations_validate( void *p_ctx, const ACameraCalibrations *p_set );
+
+uint32_t acamera_calibrations_generation( void *p_ctx );
+
+// Marks the bound set as changed after a LUT was rewritten in place,
+// so that results derived from it are recomputed.
+void acamera_calibrations_touch( void *p_ctx );
+
+const acamera_calib_view_t *_GET_VIEW( void *p_ctx, uint32_t idx );
+
+
 LookupTable *_GET_LOOKUP_PTR( void *p_ctx, uint32_t idx );
 
 const void *_GET_LUT_PTR( void *p_ctx, uint32_t idx );
@@ -726,6 +726,8 @@ uint8_t system_iso_gain( acamera_fsm_mgr_t *instance, uint32_t value, uint8_t di
         if ( value % 100 == 0 ) {
             cmos_control_param_t *param = (cmos_control_param_t *)_GET_UINT_PTR( ACAMERA_MGR2CTX_PTR( instance ), CALIBRATION_CMOS_CONTROL );
             iso_base_100_gains_t *iso_gains = (iso_base_100_gains_t *)_GET_UINT_PTR( ACAMERA_MGR2CTX_PTR( instance ), CALIBRATION_ISO_100_GAIN );
+            if ( _GET_SIZE( ACAMERA_MGR2CTX_PTR( instance ), CALIBRATION_ISO_100_GAIN ) < sizeof( iso_base_100_gains_t ) )
+                return FAIL;
             if ( iso_gains->iso_base_100_again == 0 || param->global_max_sensor_analog_gain / iso_gains->iso_base_100_again == 0 )
                 return FAIL;
             if ( value == 0 && iso_base != 0 ) { //disable iso gain
@@ -3739,7 +3741,9 @@ uint8_t orientation_hflip( acamera_fsm_mgr_t *instance, uint32_t value, uint8_t
 
 // reload some tables according with flip
 #if FW_DO_INITIALIZATION && ISP_HAS_COLOR_MATRIX_FSM
-        acamera_fsm_mgr_set_param( instance, FSM_PARAM_SET_SHADING_MESH_RELOAD, NULL, 0 );
+        if ( !acamera_cmd_batch_defer( ACAMERA_MGR2CTX_PTR( instance ), ACAMERA_CMD_BATCH_SHADING_MESH ) ) {
+            acamera_fsm_mgr_set_param( instance, FSM_PARAM_SET_SHADING_MESH_RELOAD, NULL, 0 );
+        }
 #endif
 
 #ifdef AF_ROI_ID
@@ -4017,7 +4021,12 @@ static uint8_t acamera_calibration_update( acamera_fsm_mgr_t *instance, uint32_t
     *ret_value = 0;
     if ( id < CALIBRATION_TOTAL_SIZE && data != NULL ) {
         // we require preceise size of source and destanation
-        if ( data_size == _GET_SIZE( ACAMERA_MGR2CTX_PTR( instance ), id ) ) {
+        if ( direction == COMMAND_SET && _GET_VIEW( ACAMERA_MGR2CTX_PTR( instance ), id )->missing ) {
+            // the view is not backed by the set, there is nothing to update
+            LOG( LOG_ERR, "Calibration LUT 0x%x is not provided by the calibration set and cannot be set", (int)id );
+            result = FAIL;
+            *ret_value = ERR_BAD_ARGUMENT;
+        } else if ( data_size == _GET_SIZE( ACAMERA_MGR2CTX_PTR( instance ), id ) ) {
             // assume command_set by default
             uint8_t *src = (uint8_t *)data;
             uint8_t *dst = (uint8_t *)_GET_LUT_PTR( ACAMERA_MGR2CTX_PTR( instance ), id );
@@ -4031,6 +4040,9 @@ static uint8_t acamera_calibration_update( acamera_fsm_mgr_t *instance, uint32_t
             for ( idx = 0; idx < data_size; idx++ ) {
                 dst[idx] = src[idx];
             }
+            if ( direction == COMMAND_SET ) {
+                acamera_calibrations_touch( ACAMERA_MGR2CTX_PTR( instance ) );
+            }
             result = SUCCESS;
             *ret_value = 0;
         } else {
@@ -4212,6 +4224,37 @@ uint8_t acamera_api_calibration( uint32_t ctx_id, uint8_t type, uint8_t id, uint
 }
 
 
+uint8_t acamera_api_crop_trajectory( uint32_t ctx_id, uint16_t resize_type, const acamera_crop_keyframe_t *keyframes, uint32_t count, uint32_t *ret_value )
+{
+#if defined( ISP_HAS_CROP_FSM )
+    acamera_fsm_mgr_t *instance = &( ( (acamera_context_t *)acamera_get_ctx_ptr( ctx_id ) )->fsm_mgr );
+    fsm_param_crop_trajectory_t trajectory;
+    *ret_value = 0;
+
+    // the FSM parameter holds a 16-bit count
+    if ( ( count != 0 && keyframes == NULL ) || count > 0xFFFF ) {
+        *ret_value = ERR_BAD_ARGUMENT;
+        return FAIL;
+    }
+
+    trajectory.resize_type = resize_type;
+    trajectory.count = count;
+    trajectory.keyframes = keyframes;
+
+    // keyframes are copied, the caller keeps ownership of the array
+    if ( acamera_fsm_mgr_set_param( instance, FSM_PARAM_SET_CROP_TRAJECTORY, &trajectory, sizeof( trajectory ) ) != 0 ) {
+        *ret_value = ERR_BAD_ARGUMENT;
+        return FAIL;
+    }
+
+    return SUCCESS;
+#else
+    *ret_value = 0;
+    return NOT_SUPPORTED;
+#endif
+}
+
+
 #ifdef CALIBRATION_UPDATE
 extern int32_t acamera_update_calibration_set( acamera_context_ptr_t p_ctx );
 uint8_t calibration_update( acamera_fsm_mgr_t *instance, uint32_t value, uint8_t direction, uint32_t *ret_value )
@@ -4220,7 +4263,8 @@ uint8_t calibration_update( acamera_fsm_mgr_t *instance, uint32_t value, uint8_t
     acamera_context_ptr_t p_ctx = (acamera_context_t *)acamera_get_api_ctx_ptr();
     *ret_value = 0;
     if ( direction == COMMAND_GET ) {
-        *ret_value = DONE;
+        // the set is staged by the SET call and published after the next frame end
+        *ret_value = ( p_ctx->calib_swap_state == CALIB_SWAP_IDLE ) ? DONE : UPDATE;
         return SUCCESS;
     } else if ( direction == COMMAND_SET ) {
         if ( value == UPDATE ) {
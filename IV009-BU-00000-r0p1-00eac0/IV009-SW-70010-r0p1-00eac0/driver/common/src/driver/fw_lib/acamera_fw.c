@@ -27,6 +27,7 @@
 #include "acamera_isp_core_nomem_settings.h"
 #include "acamera_metering_stats_mem_config.h"
 #include "system_timer.h"
+#include "system_sw_io.h"
 #include "acamera_logger.h"
 #include "acamera_sbus_api.h"
 #include "sensor_init.h"
@@ -54,9 +55,156 @@ void acamera_load_isp_sequence( uintptr_t isp_base, const acam_reg_t **sequence,
 }
 
 
+// The default sequences are loaded into the software config map of every
+// context and again on every wdr switch. They are compiled once into
+// words of the map sorted by offset, with the 8 and 16 bits writes and the
+// masks of one word merged. Loading is then a block write for runs of
+// whole words and a read-modify-write for the rest, instead of an sbus
+// access per entry.
+// Only the software map is packed, registers keep their write order.
+#define PACKED_SEQUENCE_NUM ( sizeof( SENSOR_ISP_SEQUENCE_DEFAULT ) / sizeof( SENSOR_ISP_SEQUENCE_DEFAULT[0] ) )
+
+typedef enum {
+    PACKED_SEQUENCE_EMPTY = 0,
+    PACKED_SEQUENCE_READY,
+    PACKED_SEQUENCE_UNPACKABLE, // has waits, bad sizes or misaligned entries, loaded entry by entry
+} packed_sequence_state_t;
+
+typedef struct {
+    packed_sequence_state_t state;
+    uint32_t count;
+    uint32_t *offset;
+    uint32_t *mask;
+    uint32_t *value;
+} packed_sequence_t;
+
+static packed_sequence_t packed_sequences[PACKED_SEQUENCE_NUM];
+
+static void packed_sequence_add( packed_sequence_t *p_packed, uint32_t offset, uint32_t mask, uint32_t value )
+{
+    uint32_t idx;
+
+    // later entries of the same word override the earlier ones
+    for ( idx = 0; idx < p_packed->count; idx++ ) {
+        if ( p_packed->offset[idx] == offset ) {
+            p_packed->value[idx] = ( p_packed->value[idx] & ~mask ) | value;
+            p_packed->mask[idx] |= mask;
+            return;
+        }
+    }
+
+    // keep the words sorted so whole words at consecutive offsets form runs
+    for ( idx = p_packed->count; idx > 0 && p_packed->offset[idx - 1] > offset; idx-- ) {
+        p_packed->offset[idx] = p_packed->offset[idx - 1];
+        p_packed->mask[idx] = p_packed->mask[idx - 1];
+        p_packed->value[idx] = p_packed->value[idx - 1];
+    }
+
+    p_packed->offset[idx] = offset;
+    p_packed->mask[idx] = mask;
+    p_packed->value[idx] = value;
+    p_packed->count++;
+}
+
+static void packed_sequence_compile( packed_sequence_t *p_packed, const acam_reg_t *seq )
+{
+    uint32_t len = 0;
+    uint32_t size = 0;
+    uint32_t *buf;
+
+    for ( len = 0; seq[len].address != 0 || seq[len].len != 0 || seq[len].value != 0; len++ ) {
+        if ( seq[len].len ) {
+            size = seq[len].len;
+        }
+        if ( seq[len].address == 0xFFFF || ( size != 1 && size != 2 && size != 4 ) || ( seq[len].address & ( size - 1 ) ) ) {
+            p_packed->state = PACKED_SEQUENCE_UNPACKABLE;
+            return;
+        }
+    }
+
+    buf = system_sw_alloc( 3 * len * sizeof( uint32_t ) + sizeof( uint32_t ) );
+    if ( buf == NULL ) {
+        p_packed->state = PACKED_SEQUENCE_UNPACKABLE;
+        return;
+    }
+
+    p_packed->offset = buf;
+    p_packed->mask = buf + len;
+    p_packed->value = buf + 2 * len;
+    p_packed->count = 0;
+
+    for ( ; seq->address != 0 || seq->len != 0 || seq->value != 0; seq++ ) {
+        uint32_t shift = 8 * ( seq->address & 3 );
+        uint32_t width;
+        uint32_t mask;
+
+        if ( seq->len ) {
+            size = seq->len;
+        }
+
+        width = ( size == 4 ) ? 0xFFFFFFFF : ( ( 1U << ( 8 * size ) ) - 1 );
+        mask = ( seq->mask ? seq->mask : width ) & width;
+
+        packed_sequence_add( p_packed, seq->address & ~3U, mask << shift, ( seq->value & mask ) << shift );
+    }
+
+    p_packed->state = PACKED_SEQUENCE_READY;
+
+    LOG( LOG_INFO, "Sequence of %d entries packed into %d words", (int)len, (int)p_packed->count );
+}
+
+static void packed_sequence_load( const packed_sequence_t *p_packed, uintptr_t isp_base )
+{
+    uint32_t idx = 0;
+
+    while ( idx < p_packed->count ) {
+        uint32_t run = 1;
+
+        if ( p_packed->mask[idx] != 0xFFFFFFFF ) {
+            uintptr_t addr = isp_base + p_packed->offset[idx];
+            system_sw_write_32( addr, ( system_sw_read_32( addr ) & ~p_packed->mask[idx] ) | p_packed->value[idx] );
+        } else {
+            while ( idx + run < p_packed->count &&
+                    p_packed->mask[idx + run] == 0xFFFFFFFF &&
+                    p_packed->offset[idx + run] == p_packed->offset[idx] + 4 * run ) {
+                run++;
+            }
+            system_sw_write_block_32( isp_base + p_packed->offset[idx], &p_packed->value[idx], run );
+        }
+
+        idx += run;
+    }
+}
+
+void acamera_release_sequences( void )
+{
+    uint32_t idx;
+
+    for ( idx = 0; idx < PACKED_SEQUENCE_NUM; idx++ ) {
+        if ( packed_sequences[idx].offset != NULL ) {
+            system_sw_free( packed_sequences[idx].offset );
+        }
+        system_memset( &packed_sequences[idx], 0, sizeof( packed_sequences[idx] ) );
+    }
+}
+
 void acamera_load_sw_sequence( uintptr_t isp_base, const acam_reg_t **sequence, uint8_t num )
 {
     acamera_sbus_t sbus;
+
+    if ( sequence == p_isp_data && num < PACKED_SEQUENCE_NUM ) {
+        packed_sequence_t *p_packed = &packed_sequences[num];
+
+        if ( p_packed->state == PACKED_SEQUENCE_EMPTY ) {
+            packed_sequence_compile( p_packed, sequence[num] );
+        }
+
+        if ( p_packed->state == PACKED_SEQUENCE_READY ) {
+            packed_sequence_load( p_packed, isp_base );
+            return;
+        }
+    }
+
     sbus.mask = SBUS_MASK_SAMPLE_32BITS | SBUS_MASK_SAMPLE_16BITS | SBUS_MASK_SAMPLE_8BITS | SBUS_MASK_ADDR_STEP_32BITS | SBUS_MASK_ADDR_32BITS;
     acamera_sbus_init( &sbus, sbus_isp_sw );
     acamera_load_array_sequence( &sbus, isp_base, 0, sequence, num );
@@ -65,6 +213,13 @@ void acamera_load_sw_sequence( uintptr_t isp_base, const acam_reg_t **sequence,
 
 #define IRQ_ID_UNDEFINED 0xFF
 
+// longest time a staged calibration set waits for a frame boundary
+#define CALIBRATION_SWAP_TIMEOUT_MS 100
+
+// longest time the pipeline gets to reach safe stop during error recovery
+#define FW_ERROR_STOP_TIMEOUT_US 20000
+#define FW_ERROR_STOP_POLL_US 200
+
 
 void acamera_fw_init( acamera_context_t *p_ctx )
 {
@@ -83,11 +238,34 @@ void acamera_fw_init( acamera_context_t *p_ctx )
 
     p_ctx->irq_flag = 1;
 
+    acamera_calibrations_init( p_ctx );
+#ifdef CALIBRATION_INTERRUPTS
+    // the interrupt counters are indexed by the interrupt source
+    acamera_calibrations_require( p_ctx, CALIBRATION_INTERRUPTS, ACAMERA_IRQ_COUNT * sizeof( uint32_t ) );
+#endif
+    p_ctx->calib_swap_state = CALIB_SWAP_IDLE;
+    p_ctx->calib_swap_frame_end = 0;
+    p_ctx->calib_swap_published = 0;
+    p_ctx->calib_swap_rejected = 0;
+    p_ctx->calib_swap_timeouts = 0;
+    system_spinlock_init( &p_ctx->calib_swap_lock );
+
+    acamera_fw_errors_init( &p_ctx->err_stats );
+
     p_ctx->fsm_mgr.p_ctx = p_ctx;
     p_ctx->fsm_mgr.ctx_id = p_ctx->context_id;
+    p_ctx->fsm_mgr.in_event_pass = 0;
+    acamera_reg_script_init( &p_ctx->reg_script );
+    system_spinlock_init( &p_ctx->cmd_batch_lock );
+    p_ctx->cmd_batch_depth = 0;
+    p_ctx->cmd_batch_pending = 0;
+
     p_ctx->fsm_mgr.isp_base = p_ctx->settings.isp_base;
     acamera_fsm_mgr_init( &p_ctx->fsm_mgr );
 
+    // the initial config is copied to the hardware right after the init
+    acamera_reg_script_apply( &p_ctx->reg_script, p_ctx->settings.isp_base );
+
     p_ctx->irq_flag = 0;
     acamera_fw_interrupts_enable( p_ctx );
     p_ctx->system_state = FW_RUN;
@@ -97,38 +275,62 @@ void acamera_fw_deinit( acamera_context_t *p_ctx )
 {
     p_ctx->fsm_mgr.p_ctx = p_ctx;
     acamera_fsm_mgr_deinit( &p_ctx->fsm_mgr );
+
+    acamera_reg_script_deinit( &p_ctx->reg_script );
+    system_spinlock_destroy( p_ctx->cmd_batch_lock );
+    system_spinlock_destroy( p_ctx->calib_swap_lock );
+    acamera_fw_errors_deinit( &p_ctx->err_stats );
 }
 
-void acamera_fw_error_routine( acamera_context_t *p_ctx, uint32_t irq_mask )
+// Reset in place only the blocks an error class affects, the firmware keeps running.
+// The caller restores the config from the software map afterwards.
+int32_t acamera_fw_error_routine( acamera_context_t *p_ctx, acamera_fw_error_class_t err_class )
 {
+    uintptr_t isp_base = p_ctx->settings.isp_base;
+    uint32_t waited_us = 0;
+    int32_t result = 0;
+
+    // stale context config needs no hardware reset
+    if ( err_class == FW_ERROR_CONTEXT ) {
+        return 0;
+    }
+
     //masked all interrupts
     acamera_isp_isp_global_interrupt_mask_vector_write( 0, ISP_IRQ_DISABLE_ALL_IRQ );
     //safe stop
-    acamera_isp_input_port_mode_request_write( p_ctx->settings.isp_base, ACAMERA_ISP_INPUT_PORT_MODE_REQUEST_SAFE_STOP );
-
-    // check whether the HW is stopped or not.
-    uint32_t count = 0;
-    while ( acamera_isp_input_port_mode_status_read( p_ctx->settings.isp_base ) != ACAMERA_ISP_INPUT_PORT_MODE_REQUEST_SAFE_STOP || acamera_isp_isp_global_monitor_fr_pipeline_busy_read( p_ctx->settings.isp_base ) ) {
-        //cannot sleep use this delay
-        do {
-            count++;
-        } while ( count % 32 != 0 );
-
-        if ( ( count >> 5 ) > 50 ) {
-            LOG( LOG_ERR, "stopping isp failed, timeout: %u.", (unsigned int)count * 1000 );
+    acamera_isp_input_port_mode_request_write( isp_base, ACAMERA_ISP_INPUT_PORT_MODE_REQUEST_SAFE_STOP );
+
+    // check whether the HW is stopped or not, for a bounded time
+    while ( acamera_isp_input_port_mode_status_read( isp_base ) != ACAMERA_ISP_INPUT_PORT_MODE_REQUEST_SAFE_STOP || acamera_isp_isp_global_monitor_fr_pipeline_busy_read( isp_base ) ) {
+        if ( waited_us >= FW_ERROR_STOP_TIMEOUT_US ) {
+            LOG( LOG_ERR, "stopping isp failed, timeout: %u us.", (unsigned int)waited_us );
+            result = -1;
             break;
         }
+
+        system_timer_usleep( FW_ERROR_STOP_POLL_US );
+        waited_us += FW_ERROR_STOP_POLL_US;
     }
 
-    acamera_isp_isp_global_global_fsm_reset_write( p_ctx->settings.isp_base, 1 );
-    acamera_isp_isp_global_global_fsm_reset_write( p_ctx->settings.isp_base, 0 );
+    // a restart of the input port is enough for frame errors
+    if ( err_class != FW_ERROR_FRAME ) {
+        acamera_isp_isp_global_global_fsm_reset_write( isp_base, 1 );
+        acamera_isp_isp_global_global_fsm_reset_write( isp_base, 0 );
+    }
+
+    if ( err_class == FW_ERROR_WATCHDOG ) {
+        acamera_isp_isp_global_scaler_fsm_reset_write( isp_base, 1 );
+        acamera_isp_isp_global_scaler_fsm_reset_write( isp_base, 0 );
+    }
 
     //return the interrupts
     acamera_isp_isp_global_interrupt_mask_vector_write( 0, ISP_IRQ_MASK_VECTOR );
 
-    acamera_isp_input_port_mode_request_write( p_ctx->settings.isp_base, ACAMERA_ISP_INPUT_PORT_MODE_REQUEST_SAFE_START );
+    acamera_isp_input_port_mode_request_write( isp_base, ACAMERA_ISP_INPUT_PORT_MODE_REQUEST_SAFE_START );
 
-    LOG( LOG_NOTICE, "starting isp from error" );
+    LOG( LOG_NOTICE, "starting isp from error class %d, stop took %u us", (int)err_class, (unsigned int)waited_us );
+
+    return result;
 }
 
 
@@ -143,6 +345,8 @@ void acamera_fw_process( acamera_context_t *p_ctx )
     if ( ( p_ctx->system_state == FW_RUN ) ) //need to capture on firmware freeze
     {
         // firmware not frozen
+        acamera_calibration_swap_process( p_ctx );
+
         // 0 means handle all the events and then return.
         acamera_fsm_mgr_process_events( &p_ctx->fsm_mgr, 0 );
     }
@@ -190,44 +394,195 @@ void acamera_fsm_mgr_raise_event( acamera_fsm_mgr_t *p_fsm_mgr, event_id_t event
 }
 
 
-int32_t acamera_update_calibration_set( acamera_context_ptr_t p_ctx )
+// fetch the calibration set for the current sensor mode into the staging set
+static int32_t calibration_set_fetch( acamera_context_ptr_t p_ctx )
 {
-    int32_t result = 0;
     void *sensor_arg = 0;
-    if ( p_ctx->settings.get_calibrations != NULL ) {
-        {
-            const sensor_param_t *param = NULL;
-            acamera_fsm_mgr_get_param( &p_ctx->fsm_mgr, FSM_PARAM_GET_SENSOR_PARAM, NULL, 0, &param, sizeof( param ) );
+    {
+        const sensor_param_t *param = NULL;
+        acamera_fsm_mgr_get_param( &p_ctx->fsm_mgr, FSM_PARAM_GET_SENSOR_PARAM, NULL, 0, &param, sizeof( param ) );
 
-            uint32_t cur_mode = param->mode;
-            if ( cur_mode < param->modes_num ) {
-                sensor_arg = &( param->modes_table[cur_mode] );
-            }
-        }
-        if ( p_ctx->settings.get_calibrations( p_ctx->context_id, sensor_arg, &p_ctx->acameraCalibrations ) != 0 ) {
-            LOG( LOG_ERR, "Failed to get calibration set for. Fatal error" );
+        uint32_t cur_mode = param->mode;
+        if ( cur_mode < param->modes_num ) {
+            sensor_arg = &( param->modes_table[cur_mode] );
         }
+    }
+
+    // the callback keeps the new set away from the memory of the set passed
+    // in, so it has to be the one in use and not a set which is still pending
+    system_memcpy( &p_ctx->calib_staging, &p_ctx->acameraCalibrations, sizeof( ACameraCalibrations ) );
+
+    if ( p_ctx->settings.get_calibrations( p_ctx->context_id, sensor_arg, &p_ctx->calib_staging ) != 0 ) {
+        LOG( LOG_ERR, "Failed to get calibration set for. Fatal error" );
+        return -1;
+    }
+
+    return 0;
+}
+
+// make the staged set current and refresh everything derived from it
+static void calibration_set_publish( acamera_context_ptr_t p_ctx )
+{
+    system_memcpy( &p_ctx->acameraCalibrations, &p_ctx->calib_staging, sizeof( ACameraCalibrations ) );
+
+    acamera_calibrations_bind( p_ctx );
 
 #if defined( ISP_HAS_GENERAL_FSM )
-        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_RELOAD_CALIBRATION, NULL, 0 );
+    acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_RELOAD_CALIBRATION, NULL, 0 );
 #endif
 
 // Update some FSMs variables which depends on calibration data.
 #if defined( ISP_HAS_AE_BALANCED_FSM ) || defined( ISP_HAS_AE_MANUAL_FSM )
-        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_AE_INIT, NULL, 0 );
+    acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_AE_INIT, NULL, 0 );
 #endif
 
 #if defined( ISP_HAS_IRIDIX_FSM ) || defined( ISP_HAS_IRIDIX_HIST_FSM ) || defined( ISP_HAS_IRIDIX_MANUAL_FSM )
-        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_IRIDIX_INIT, NULL, 0 );
+    acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_IRIDIX_INIT, NULL, 0 );
 #endif
 
 #if defined( ISP_HAS_COLOR_MATRIX_FSM )
-        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_CCM_CHANGE, NULL, 0 );
+    acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_CCM_CHANGE, NULL, 0 );
 #endif
 
 #if defined( ISP_HAS_SBUF_FSM )
-        acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_SBUF_CALIBRATION_UPDATE, NULL, 0 );
+    acamera_fsm_mgr_set_param( &p_ctx->fsm_mgr, FSM_PARAM_SET_SBUF_CALIBRATION_UPDATE, NULL, 0 );
+#endif
+}
+
+// Move the swap state on, fails if the current state is not one of the two expected.
+static int32_t calibration_swap_transition( acamera_context_ptr_t p_ctx, uint8_t from_a, uint8_t from_b, uint8_t to )
+{
+    int32_t result = -1;
+    unsigned long flags = system_spinlock_lock( p_ctx->calib_swap_lock );
+
+    if ( p_ctx->calib_swap_state == from_a || p_ctx->calib_swap_state == from_b ) {
+        p_ctx->calib_swap_state = to;
+        result = 0;
+    }
+
+    system_spinlock_unlock( p_ctx->calib_swap_lock, flags );
+
+    return result;
+}
+
+#if USER_MODULE
+// the config transfers are started by the kernel half, there is nothing to hold back
+static int32_t calibration_swap_hold( acamera_context_ptr_t p_ctx )
+{
+    return calibration_swap_transition( p_ctx, CALIB_SWAP_PENDING, CALIB_SWAP_PENDING, CALIB_SWAP_PUBLISHING );
+}
+
+static void calibration_swap_release( acamera_context_ptr_t p_ctx )
+{
+}
+#else
+// The set is published only when the config transfer is finished, and no new
+// transfer is started until all the writes derived from it are done.
+static int32_t calibration_swap_hold( acamera_context_ptr_t p_ctx )
+{
+    acamera_firmware_t *p_gfw = p_ctx->p_gfw;
+    int32_t result = -1;
+    unsigned long flags = system_spinlock_lock( p_gfw->irq_latch.lock );
+
+    if ( p_gfw->dma_flag_isp_config_completed && calibration_swap_transition( p_ctx, CALIB_SWAP_PENDING, CALIB_SWAP_PENDING, CALIB_SWAP_PUBLISHING ) == 0 ) {
+        p_gfw->calib_publishing = 1;
+        result = 0;
+    }
+
+    system_spinlock_unlock( p_gfw->irq_latch.lock, flags );
+
+    return result;
+}
+
+static void calibration_swap_release( acamera_context_ptr_t p_ctx )
+{
+    acamera_firmware_t *p_gfw = p_ctx->p_gfw;
+    unsigned long flags = system_spinlock_lock( p_gfw->irq_latch.lock );
+
+    p_gfw->calib_publishing = 0;
+
+    system_spinlock_unlock( p_gfw->irq_latch.lock, flags );
+}
 #endif
+
+// Called from the firmware thread only, all the writes derived from the set reach the same frame.
+static int32_t calibration_swap_publish( acamera_context_ptr_t p_ctx )
+{
+    if ( calibration_swap_hold( p_ctx ) != 0 ) {
+        return -1;
+    }
+
+    calibration_set_publish( p_ctx );
+    p_ctx->calib_swap_published++;
+
+    calibration_swap_release( p_ctx );
+    calibration_swap_transition( p_ctx, CALIB_SWAP_PUBLISHING, CALIB_SWAP_PUBLISHING, CALIB_SWAP_IDLE );
+
+    LOG( LOG_INFO, "Calibration set published after %u ticks, total %u published", (unsigned int)( system_timer_timestamp() - p_ctx->calib_swap_request_ts ), (unsigned int)p_ctx->calib_swap_published );
+
+    return 0;
+}
+
+static uint32_t calibration_swap_timeout_ticks( void )
+{
+    return system_timer_frequency() / ( 1000 / CALIBRATION_SWAP_TIMEOUT_MS );
+}
+
+// Load and validate the next set while the current one stays in use.
+// A set which is still pending is replaced, the call never waits.
+static int32_t calibration_set_stage( acamera_context_ptr_t p_ctx )
+{
+    unsigned long flags;
+
+    if ( calibration_swap_transition( p_ctx, CALIB_SWAP_IDLE, CALIB_SWAP_PENDING, CALIB_SWAP_STAGING ) != 0 ) {
+        LOG( LOG_ERR, "Calibration set is being published, try again later" );
+        return -1;
+    }
+
+    if ( calibration_set_fetch( p_ctx ) != 0 || acamera_calibrations_validate( p_ctx, &p_ctx->calib_staging ) != 0 ) {
+        p_ctx->calib_swap_rejected++;
+        calibration_swap_transition( p_ctx, CALIB_SWAP_STAGING, CALIB_SWAP_STAGING, CALIB_SWAP_IDLE );
+        LOG( LOG_ERR, "Staged calibration set is rejected, keep using the current one" );
+        return -1;
+    }
+
+    flags = system_spinlock_lock( p_ctx->calib_swap_lock );
+    p_ctx->calib_swap_request_ts = system_timer_timestamp();
+    p_ctx->calib_swap_frame_end = 0;
+    p_ctx->calib_swap_state = CALIB_SWAP_PENDING;
+    system_spinlock_unlock( p_ctx->calib_swap_lock, flags );
+
+    return 0;
+}
+
+void acamera_calibration_swap_process( acamera_context_ptr_t p_ctx )
+{
+    if ( p_ctx->calib_swap_state != CALIB_SWAP_PENDING ) {
+        return;
+    }
+
+    // a busy config transfer leaves the set pending for the next pass
+    if ( p_ctx->calib_swap_frame_end ) {
+        calibration_swap_publish( p_ctx );
+    } else if ( system_timer_timestamp() - p_ctx->calib_swap_request_ts >= calibration_swap_timeout_ticks() ) {
+        // no frame end seen, the pipeline is not running
+        if ( calibration_swap_publish( p_ctx ) == 0 ) {
+            p_ctx->calib_swap_timeouts++;
+        }
+    }
+}
+
+// The set is only staged here, the firmware thread publishes it after the
+// next frame end so the API thread does not wait for the pipeline.
+int32_t acamera_update_calibration_set( acamera_context_ptr_t p_ctx )
+{
+    int32_t result = 0;
+    if ( p_ctx->settings.get_calibrations != NULL ) {
+        result = calibration_set_stage( p_ctx );
+        if ( result == 0 ) {
+            // wake up the processing loop even if no frames are coming
+            acamera_notify_evt_data_avail();
+        }
     } else {
         LOG( LOG_ERR, "Calibration callback is null. Failed to get calibrations" );
         result = -1;
@@ -240,33 +595,29 @@ int32_t acamera_update_calibration_set( acamera_context_ptr_t p_ctx )
 int32_t acamera_init_calibrations( acamera_context_ptr_t p_ctx )
 {
     int32_t result = 0;
-    void *sensor_arg = 0;
 #ifdef SENSOR_ISP_SEQUENCE_DEFAULT_FULL
     acamera_load_isp_sequence( p_ctx->settings.isp_base, p_ctx->isp_sequence, SENSOR_ISP_SEQUENCE_DEFAULT_FULL );
 #endif
 
-    // if "p_ctx->initialized" is 1, that means we are changing the preset and wdr_mode,
-    // we need to update the calibration data and update some FSM variables which
-    // depends on calibration data.
-    if ( p_ctx->initialized == 1 ) {
-        acamera_update_calibration_set( p_ctx );
-    } else {
-        if ( p_ctx->settings.get_calibrations != NULL ) {
-            const sensor_param_t *param = NULL;
-            acamera_fsm_mgr_get_param( &p_ctx->fsm_mgr, FSM_PARAM_GET_SENSOR_PARAM, NULL, 0, &param, sizeof( param ) );
-
-            uint32_t cur_mode = param->mode;
-            if ( cur_mode < param->modes_num ) {
-                sensor_arg = &( param->modes_table[cur_mode] );
-            }
-
-            if ( p_ctx->settings.get_calibrations( p_ctx->context_id, sensor_arg, &p_ctx->acameraCalibrations ) != 0 ) {
-                LOG( LOG_ERR, "Failed to get calibration set for. Fatal error" );
+    if ( p_ctx->settings.get_calibrations != NULL ) {
+        // if "p_ctx->initialized" is 1, that means we are changing the preset and wdr_mode,
+        // the input port is stopped here so the new set is published straight away and
+        // the FSM variables which depend on calibration data are updated.
+        // A set which cannot be published yet stays pending for the process loop.
+        if ( p_ctx->initialized == 1 ) {
+            if ( calibration_set_stage( p_ctx ) == 0 ) {
+                calibration_swap_publish( p_ctx );
+            } else {
+                result = -1;
             }
         } else {
-            LOG( LOG_ERR, "Calibration callback is null. Failed to get calibrations" );
-            result = -1;
+            calibration_set_fetch( p_ctx );
+            system_memcpy( &p_ctx->acameraCalibrations, &p_ctx->calib_staging, sizeof( ACameraCalibrations ) );
+            acamera_calibrations_bind( p_ctx );
         }
+    } else {
+        LOG( LOG_ERR, "Calibration callback is null. Failed to get calibrations" );
+        result = -1;
     }
     return result;
 }
@@ -503,6 +854,9 @@ void acamera_general_interrupt_hanlder( acamera_context_ptr_t p_ctx, uint8_t eve
         p_ctx->isp_frame_counter++;
         LOG( LOG_DEBUG, "Meta frame counter = %d", (int)p_ctx->isp_frame_counter );
 
+        // a staged calibration set may be published from now on
+        p_ctx->calib_swap_frame_end = 1;
+
 #if ISP_DMA_RAW_CAPTURE
         p_ctx->isp_frame_counter_raw++;
 #endif
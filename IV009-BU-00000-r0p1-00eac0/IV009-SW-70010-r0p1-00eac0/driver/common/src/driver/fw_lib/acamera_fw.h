@@ -25,6 +25,7 @@
 #include "acamera_calibrations.h"
 #include "system_interrupts.h"
 #include "system_semaphore.h"
+#include "system_spinlock.h"
 #include "acamera_firmware_api.h"
 #include "acamera_isp_core_nomem_settings.h"
 #include "acamera_firmware_config.h"
@@ -34,6 +35,12 @@
 #define FW_PAUSE 0
 #define FW_RUN 1
 
+// calibration swap states, see acamera_calibration_swap_process()
+#define CALIB_SWAP_IDLE 0
+#define CALIB_SWAP_STAGING 1    // the API thread loads calib_staging
+#define CALIB_SWAP_PENDING 2    // calib_staging waits for a frame end
+#define CALIB_SWAP_PUBLISHING 3 // the firmware thread makes calib_staging current
+
 
 struct _acamera_fsm_mgr_t;
 struct _acamera_context_t;
@@ -52,6 +59,8 @@ struct _isp_info_t {
 };
 
 #include "acamera_fsm_mgr.h"
+#include "acamera_reg_script.h"
+#include "acamera_fw_errors.h"
 #include "fsm_util.h"
 #include "fsm_param.h"
 #include "sensor_init.h"
@@ -131,6 +140,19 @@ struct _acamera_context_t {
     // current calibration set
     ACameraCalibrations acameraCalibrations;
 
+    // validated views of the current calibration set
+    acamera_calib_views_t calib_views;
+
+    // calibration set waiting to be published at a frame boundary
+    ACameraCalibrations calib_staging;
+    sys_spinlock calib_swap_lock;
+    uint8_t calib_swap_state;     // CALIB_SWAP_*, changed under calib_swap_lock
+    uint8_t calib_swap_frame_end; // a frame end was handled since the set was staged
+    uint32_t calib_swap_request_ts;
+    uint32_t calib_swap_published;
+    uint32_t calib_swap_rejected;
+    uint32_t calib_swap_timeouts;
+
     // global settings which can be shared through fsms
     system_tab stab;
 
@@ -147,11 +169,44 @@ struct _acamera_context_t {
     /* frame counters */
     uint32_t isp_frame_counter_raw; // frame counter for raw callback
     uint32_t isp_frame_counter;     // frame counter for frame / metadata callbacks
+    uint32_t first_frame_reported;  // startup time to the first frame start was logged
+
+    // sensor mode switches and the corrupted frames the dma writers drop after each
+    uint32_t sensor_mode_switches;
+    uint8_t sensor_switch_skip_frames;
 
     acamera_isp_sw_regs_map sw_reg_map;
+
+    // error recovery statistics
+    acamera_fw_error_stats_t err_stats;
+
+    // register outputs of the fsms waiting for the end of event processing
+    acamera_reg_script_t reg_script;
+
+    // api command batch, see acamera_command_batch_begin(). The api and the
+    // frame path may both issue commands, the lock keeps the state consistent.
+    sys_spinlock cmd_batch_lock;
+    uint8_t cmd_batch_depth;
+    uint32_t cmd_batch_pending; // ACAMERA_CMD_BATCH_* updates deferred to the end of the batch
 };
 
 
+// interrupt state latched by acamera_interrupt_latch for acamera_interrupt_thread
+typedef struct _acamera_irq_latch_t {
+    sys_spinlock lock;
+    uint32_t irq_mask;      // status bits not handled by the thread yet
+    uint32_t frame_counter; // frame start interrupts seen by the top half
+    uint32_t timestamp;     // system_timer_timestamp of the last frame start
+    int32_t dma_buf;        // ping/pong buffer selected for the next frame, -1 if no transfer is due
+    uint32_t dma_busy;      // frame starts skipped because the previous transfers were not finished
+    uint32_t queue_busy;    // frame starts skipped because the previous frame was still processed
+#if ISP_HAS_DMA_INPUT
+    int32_t last_ctx;
+    int32_t cur_ctx;
+    int32_t next_ctx;
+#endif
+} acamera_irq_latch_t;
+
 struct _acamera_firmware_t {
 #if ISP_DMA_RAW_CAPTURE
     // dma_capture
@@ -172,13 +227,20 @@ struct _acamera_firmware_t {
     void *dma_chan_isp_metering;
     uint32_t dma_flag_isp_metering_completed;
 
+    acamera_irq_latch_t irq_latch;
+    uint32_t irq_frame_handled; // last latched frame start handled by the thread
+    uint8_t calib_publishing;   // a context publishes a calibration set, no config transfer is started
+
     uint32_t initialized;
+    uint32_t init_start; // system_timer_timestamp when acamera_init started
 
     semaphore_t sem_evt_avail;
 };
 
 void acamera_load_isp_sequence( uintptr_t isp_base, const acam_reg_t **sequence, uint8_t num );
 void acamera_load_sw_sequence( uintptr_t isp_base, const acam_reg_t **sequence, uint8_t num );
+// frees the packed default sequences, they are compiled again on the next load
+void acamera_release_sequences( void );
 void load_sensor_sequence( uint8_t num );
 void acamera_load_array_sequence( acamera_sbus_ptr_t p_sbus, uintptr_t isp_offset, char size, const acam_reg_t **sequence, int group );
 
@@ -215,6 +277,27 @@ static __inline void acamera_isp_interrupts_disable( acamera_fsm_mgr_t *p_fsm_mg
     }
 }
 
+// updates which run once at the end of an api command batch
+#define ACAMERA_CMD_BATCH_MATRIX_YUV ( 1 << 0 )
+#define ACAMERA_CMD_BATCH_SHADING_MESH ( 1 << 1 )
+
+// Returns 1 when a command batch is open and the update was recorded for its end,
+// 0 when the caller has to run the update now.
+static __inline uint8_t acamera_cmd_batch_defer( acamera_context_ptr_t p_ctx, uint32_t update )
+{
+    uint8_t deferred = 0;
+    unsigned long flags;
+
+    flags = system_spinlock_lock( p_ctx->cmd_batch_lock );
+    if ( p_ctx->cmd_batch_depth ) {
+        p_ctx->cmd_batch_pending |= update;
+        deferred = 1;
+    }
+    system_spinlock_unlock( p_ctx->cmd_batch_lock, flags );
+
+    return deferred;
+}
+
 void acamera_fw_raise_event( acamera_context_ptr_t p_ctx, event_id_t event_id );
 
 void acamera_fw_process( acamera_context_t *p_ctx );
@@ -226,9 +309,11 @@ void acamera_deinit_context( acamera_context_t *p_ctx );
 void acamera_general_interrupt_hanlder( acamera_context_ptr_t p_ctx, uint8_t event );
 
 int32_t acamera_init_calibrations( acamera_context_ptr_t p_ctx );
+int32_t acamera_update_calibration_set( acamera_context_ptr_t p_ctx );
+void acamera_calibration_swap_process( acamera_context_ptr_t p_ctx );
 void acamera_change_resolution( acamera_context_ptr_t p_ctx, uint32_t exposure_correction );
 void configure_buffers( acamera_context_ptr_t p_ctx, uint32_t start_addr, uint16_t width, uint16_t height );
-void acamera_fw_error_routine( acamera_context_t *p_ctx, uint32_t irq_mask );
+int32_t acamera_fw_error_routine( acamera_context_t *p_ctx, acamera_fw_error_class_t err_class );
 
 #define ACAMERA_MGR2CTX_PTR( p_fsm_mgr ) \
     ( ( p_fsm_mgr )->p_ctx )
@@ -242,4 +327,19 @@ void acamera_fw_error_routine( acamera_context_t *p_ctx, uint32_t irq_mask );
 #define ACAMERA_FSM2CTX_PTR( p_fsm ) \
     ( ( p_fsm )->p_fsm_mgr->p_ctx )
 
+// queue a field write of the fsm to the register script of its context
+#define fsm_reg_write( p_fsm, fsm_id, p_field, value ) \
+    acamera_reg_script_write( &ACAMERA_FSM2CTX_PTR( p_fsm )->reg_script, ( p_fsm )->cmn.isp_base, ( fsm_id ), ( p_field ), ( value ) )
+
+// direct view access for a compile-time calibration index
+#define ACAMERA_CALIB_VIEW( p_ctx, idx ) \
+    ( &( (acamera_context_ptr_t)( p_ctx ) )->calib_views.view[( idx )] )
+
+static __inline uint16_t acamera_calib_modulation_u16( void *p_ctx, uint32_t idx, uint16_t x )
+{
+    const acamera_calib_view_t *p_view = ACAMERA_CALIB_VIEW( p_ctx, idx );
+
+    return acamera_calc_modulation_u16( x, (const modulation_entry_t *)p_view->ptr, p_view->rows );
+}
+
 #endif /* __ACAMERA_FW_H__ */
@@ -0,0 +1,155 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "acamera_fw_errors.h"
+#include "acamera_logger.h"
+#include "system_stdlib.h"
+#include "system_spinlock.h"
+#include "system_timer.h"
+
+void acamera_fw_errors_init( acamera_fw_error_stats_t *p_stats )
+{
+    system_memset( p_stats, 0, sizeof( *p_stats ) );
+    system_spinlock_init( &p_stats->lock );
+}
+
+void acamera_fw_errors_deinit( acamera_fw_error_stats_t *p_stats )
+{
+    system_spinlock_destroy( p_stats->lock );
+}
+
+#if ISP_HAS_ERROR_RECOVERY
+int32_t acamera_fw_errors_latch( acamera_fw_error_stats_t *p_stats, uint32_t irq_mask, uint32_t config_ctx )
+{
+    int32_t err_class = -1;
+    unsigned long flags;
+
+    if ( ( irq_mask & 1 << ISP_INTERRUPT_EVENT_BROKEN_FRAME ) ||
+         ( irq_mask & 1 << ISP_INTERRUPT_EVENT_FRAME_COLLISION ) ) {
+        p_stats->count[FW_ERROR_FRAME]++;
+        p_stats->frame_errors_in_row++;
+
+        // a single broken frame is dropped by the hardware, only a run of them needs a restart
+        if ( p_stats->frame_errors_in_row >= ISP_FRAME_ERRORS_IN_ROW_LIMIT ) {
+            err_class = FW_ERROR_FRAME;
+            p_stats->frame_errors_in_row = 0;
+        } else {
+            LOG( LOG_WARNING, "Frame error, MASK is 0x%x, %u in a row", irq_mask, (unsigned int)p_stats->frame_errors_in_row );
+        }
+    } else if ( irq_mask & 1 << ISP_INTERRUPT_EVENT_ISP_END_FRAME_END ) {
+        // only a frame which ended cleanly breaks a run of frame errors
+        p_stats->frame_errors_in_row = 0;
+    }
+
+    if ( irq_mask & 1 << ISP_INTERRUPT_EVENT_MULTICTX_ERROR ) {
+        p_stats->count[FW_ERROR_CONTEXT]++;
+        err_class = FW_ERROR_CONTEXT;
+    }
+
+    if ( irq_mask & 1 << ISP_INTERRUPT_EVENT_DMA_ERROR ) {
+        p_stats->count[FW_ERROR_DMA]++;
+        err_class = FW_ERROR_DMA;
+    }
+
+    if ( irq_mask & 1 << ISP_INTERRUPT_EVENT_WATCHDOG_EXP ) {
+        p_stats->count[FW_ERROR_WATCHDOG]++;
+        err_class = FW_ERROR_WATCHDOG;
+    }
+
+    if ( err_class < 0 ) {
+        return -1;
+    }
+
+    LOG( LOG_ERR, "Found error class %d, requesting in place recovery. MASK is 0x%x", (int)err_class, irq_mask );
+
+    if ( !p_stats->recovery_pending ) {
+        p_stats->recovery_pending = 1;
+        p_stats->recovery_start = system_timer_timestamp();
+        p_stats->recovery_frames = 0;
+    }
+
+    flags = system_spinlock_lock( p_stats->lock );
+    p_stats->request |= 1 << err_class;
+    p_stats->request_ctx = config_ctx;
+    system_spinlock_unlock( p_stats->lock, flags );
+
+    return err_class;
+}
+#else
+int32_t acamera_fw_errors_latch( acamera_fw_error_stats_t *p_stats, uint32_t irq_mask, uint32_t config_ctx )
+{
+    return -1;
+}
+#endif
+
+void acamera_fw_errors_frame_start( acamera_fw_error_stats_t *p_stats, int32_t dma_buf )
+{
+    uint32_t elapsed_ms;
+
+    if ( !p_stats->recovery_pending ) {
+        return;
+    }
+
+    // a frame started before the process loop recovered does not count as good
+    if ( dma_buf < 0 || p_stats->frame_errors_in_row || p_stats->request || p_stats->recovering ) {
+        p_stats->recovery_frames++;
+        return;
+    }
+
+    elapsed_ms = ( system_timer_timestamp() - p_stats->recovery_start ) * 1000 / system_timer_frequency();
+
+    p_stats->recovery_pending = 0;
+    p_stats->recovery_time_last = elapsed_ms;
+    if ( elapsed_ms > p_stats->recovery_time_max ) {
+        p_stats->recovery_time_max = elapsed_ms;
+    }
+
+    LOG( LOG_NOTICE, "ISP recovered in %u ms, %u frames skipped, recoveries: %u, stop timeouts: %u",
+         (unsigned int)elapsed_ms, (unsigned int)p_stats->recovery_frames, (unsigned int)p_stats->recoveries, (unsigned int)p_stats->stop_timeouts );
+}
+
+int32_t acamera_fw_errors_take( acamera_fw_error_stats_t *p_stats, uint32_t *p_config_ctx )
+{
+    int32_t err_class = FW_ERROR_CLASS_NUM - 1;
+    unsigned long flags;
+    uint32_t request;
+
+    flags = system_spinlock_lock( p_stats->lock );
+    request = p_stats->request;
+    p_stats->request = 0;
+    p_stats->recovering = ( request != 0 );
+    *p_config_ctx = p_stats->request_ctx;
+    system_spinlock_unlock( p_stats->lock, flags );
+
+    // one recovery of the most severe class covers the others
+    while ( err_class >= 0 && !( request & 1 << err_class ) ) {
+        err_class--;
+    }
+
+    return err_class;
+}
+
+void acamera_fw_errors_recovered( acamera_fw_error_stats_t *p_stats, int32_t stop_result )
+{
+    if ( stop_result != 0 ) {
+        p_stats->stop_timeouts++;
+    }
+    p_stats->recoveries++;
+    p_stats->recovering = 0;
+}
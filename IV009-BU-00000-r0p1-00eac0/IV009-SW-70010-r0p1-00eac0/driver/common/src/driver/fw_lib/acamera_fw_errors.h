@@ -0,0 +1,81 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#if !defined( __ACAMERA_FW_ERRORS_H__ )
+#define __ACAMERA_FW_ERRORS_H__
+
+#include "acamera_types.h"
+#include "system_spinlock.h"
+#include "acamera_isp_core_nomem_settings.h"
+
+// Bookkeeping of the isp error interrupts. The interrupt thread classifies
+// the error bits and raises a recovery request, the process loop takes the
+// request and does the recovery, which polls the hardware with sleeps.
+
+#if defined( ISP_INTERRUPT_EVENT_BROKEN_FRAME ) && defined( ISP_INTERRUPT_EVENT_MULTICTX_ERROR ) && defined( ISP_INTERRUPT_EVENT_DMA_ERROR ) && defined( ISP_INTERRUPT_EVENT_WATCHDOG_EXP ) && defined( ISP_INTERRUPT_EVENT_FRAME_COLLISION )
+#define ISP_HAS_ERROR_RECOVERY 1
+#endif
+
+// frame errors in a row after which the input port is restarted
+#define ISP_FRAME_ERRORS_IN_ROW_LIMIT 3
+
+// isp error classes, each one is recovered by resetting as little as possible
+typedef enum {
+    FW_ERROR_FRAME = 0, // broken frame or frame collision on the input
+    FW_ERROR_CONTEXT,   // multi-context error, the config of the context is stale
+    FW_ERROR_DMA,       // dma error, the pipeline has to be stopped and reset
+    FW_ERROR_WATCHDOG,  // watchdog expired, every fsm is reset
+    FW_ERROR_CLASS_NUM
+} acamera_fw_error_class_t;
+
+typedef struct _acamera_fw_error_stats_t {
+    sys_spinlock lock;                  // the request is shared by the interrupt thread and the process loop
+    uint32_t request;                   // bit per error class waiting for the process loop
+    uint32_t request_ctx;               // context whose config is restored by the recovery
+    uint32_t recovering;                // 1 - a request was taken and the recovery is not done yet
+    uint32_t count[FW_ERROR_CLASS_NUM]; // errors seen per class
+    uint32_t frame_errors_in_row;       // consecutive frames with a frame error
+    uint32_t recoveries;                // in-place recoveries done
+    uint32_t stop_timeouts;             // recoveries where safe stop did not complete
+    uint32_t recovery_pending;          // 1 - no good frame seen since the last recovery
+    uint32_t recovery_start;            // system_timer_timestamp of the error which started the recovery
+    uint32_t recovery_frames;           // frame starts skipped since the recovery started
+    uint32_t recovery_time_last;        // time from error to the first good frame, in ms
+    uint32_t recovery_time_max;         // longest recovery time, in ms
+} acamera_fw_error_stats_t;
+
+void acamera_fw_errors_init( acamera_fw_error_stats_t *p_stats );
+void acamera_fw_errors_deinit( acamera_fw_error_stats_t *p_stats );
+
+// Interrupt thread: classify the error bits of a latched irq mask. A run of
+// frame errors is ended only by a frame end without one. Returns the class
+// of the recovery requested, or -1 when no recovery is needed.
+int32_t acamera_fw_errors_latch( acamera_fw_error_stats_t *p_stats, uint32_t irq_mask, uint32_t config_ctx );
+
+// Interrupt thread: a frame with a config transfer and no frame error
+// completes a pending recovery.
+void acamera_fw_errors_frame_start( acamera_fw_error_stats_t *p_stats, int32_t dma_buf );
+
+// Process loop: take the most severe requested class, or -1 if none.
+int32_t acamera_fw_errors_take( acamera_fw_error_stats_t *p_stats, uint32_t *p_config_ctx );
+
+// Process loop: account a recovery done, stop_result is the one of acamera_fw_error_routine.
+void acamera_fw_errors_recovered( acamera_fw_error_stats_t *p_stats, int32_t stop_result );
+
+#endif /* __ACAMERA_FW_ERRORS_H__ */
@@ -0,0 +1,108 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#include "acamera_fw.h"
+#include "acamera_reg_script.h"
+#include "acamera_logger.h"
+#include "system_sw_io.h"
+#include "system_spinlock.h"
+
+static void reg_script_apply( acamera_reg_script_t *p_script, uintptr_t isp_base )
+{
+    uint32_t idx;
+
+    for ( idx = 0; idx < p_script->count; idx++ ) {
+        const acamera_reg_write_t *p_write = &p_script->write[idx];
+        uintptr_t addr = isp_base + p_write->offset;
+        uint32_t curr = system_sw_read_32( addr );
+        uint32_t data = ( curr & ~p_write->mask ) | p_write->value;
+
+        if ( data != curr ) {
+            system_sw_write_32( addr, data );
+            p_script->written[p_write->fsm_id]++;
+        } else {
+            p_script->skipped[p_write->fsm_id]++;
+        }
+    }
+
+    p_script->count = 0;
+}
+
+void acamera_reg_script_init( acamera_reg_script_t *p_script )
+{
+    system_memset( p_script, 0, sizeof( *p_script ) );
+    system_spinlock_init( &p_script->lock );
+}
+
+void acamera_reg_script_deinit( acamera_reg_script_t *p_script )
+{
+    acamera_reg_script_report( p_script );
+    system_spinlock_destroy( p_script->lock );
+}
+
+void acamera_reg_script_write( acamera_reg_script_t *p_script, uintptr_t isp_base, uint8_t fsm_id, const acamera_reg_field_t *p_field, uint32_t value )
+{
+    acamera_reg_write_t *p_write;
+    unsigned long flags;
+
+    value = ( value << p_field->shift ) & p_field->mask;
+
+    flags = system_spinlock_lock( p_script->lock );
+
+    // fields of one register are usually written back to back
+    if ( p_script->count ) {
+        p_write = &p_script->write[p_script->count - 1];
+        if ( p_write->offset == p_field->offset && p_write->fsm_id == fsm_id ) {
+            p_write->value = ( p_write->value & ~p_field->mask ) | value;
+            p_write->mask |= p_field->mask;
+            system_spinlock_unlock( p_script->lock, flags );
+            return;
+        }
+    }
+
+    if ( p_script->count == ACAMERA_REG_SCRIPT_SIZE ) {
+        reg_script_apply( p_script, isp_base );
+    }
+
+    p_write = &p_script->write[p_script->count++];
+    p_write->offset = p_field->offset;
+    p_write->mask = p_field->mask;
+    p_write->value = value;
+    p_write->fsm_id = fsm_id;
+
+    system_spinlock_unlock( p_script->lock, flags );
+}
+
+void acamera_reg_script_apply( acamera_reg_script_t *p_script, uintptr_t isp_base )
+{
+    unsigned long flags = system_spinlock_lock( p_script->lock );
+    reg_script_apply( p_script, isp_base );
+    system_spinlock_unlock( p_script->lock, flags );
+}
+
+void acamera_reg_script_report( const acamera_reg_script_t *p_script )
+{
+    uint32_t idx;
+
+    for ( idx = 0; idx < FSM_ID_MAX; idx++ ) {
+        if ( p_script->written[idx] || p_script->skipped[idx] ) {
+            LOG( LOG_INFO, "FSM %d register writes: %u applied, %u unchanged", (int)idx, (unsigned int)p_script->written[idx], (unsigned int)p_script->skipped[idx] );
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#if !defined( __ACAMERA_REG_SCRIPT_H__ )
+#define __ACAMERA_REG_SCRIPT_H__
+
+#include "acamera_types.h"
+#include "system_spinlock.h"
+
+// Register outputs of the fsms collected during frame processing and
+// written to the software config map in one pass when all events of the
+// frame are processed. Writes which do not change the register are dropped.
+// A set_param() outside of the event pass applies the script on return, and
+// the metadata fsm applies it before it reads the registers back.
+
+#define ACAMERA_REG_SCRIPT_SIZE 64
+
+// a register field as described by the generated headers
+typedef struct _acamera_reg_field_t {
+    uint32_t offset; // offset of the register in the software config map
+    uint32_t mask;   // bits of the field in the register
+    uint8_t shift;   // position of the field lsb
+} acamera_reg_field_t;
+
+typedef struct _acamera_reg_write_t {
+    uint32_t offset;
+    uint32_t mask;
+    uint32_t value; // already shifted into the mask
+    uint8_t fsm_id;
+} acamera_reg_write_t;
+
+typedef struct _acamera_reg_script_t {
+    sys_spinlock lock; // fsms may be updated from the api as well
+    acamera_reg_write_t write[ACAMERA_REG_SCRIPT_SIZE];
+    uint32_t count;
+    uint32_t written[FSM_ID_MAX]; // registers changed by each fsm
+    uint32_t skipped[FSM_ID_MAX]; // writes of each fsm which did not change the register
+} acamera_reg_script_t;
+
+void acamera_reg_script_init( acamera_reg_script_t *p_script );
+void acamera_reg_script_deinit( acamera_reg_script_t *p_script );
+void acamera_reg_script_write( acamera_reg_script_t *p_script, uintptr_t isp_base, uint8_t fsm_id, const acamera_reg_field_t *p_field, uint32_t value );
+void acamera_reg_script_apply( acamera_reg_script_t *p_script, uintptr_t isp_base );
+void acamera_reg_script_report( const acamera_reg_script_t *p_script );
+
+#endif /* __ACAMERA_REG_SCRIPT_H__ */
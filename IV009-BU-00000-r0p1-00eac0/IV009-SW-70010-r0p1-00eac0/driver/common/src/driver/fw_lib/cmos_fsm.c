@@ -71,6 +71,10 @@ void cmos_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     cmos_fsm_clear( p_fsm );
 
+    // the control and status parameters are read as structures
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_CMOS_CONTROL, sizeof( cmos_control_param_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STATUS_INFO, sizeof( status_info_param_t ) );
+
     cmos_init( p_fsm );
 }
 
@@ -34,6 +34,8 @@ void color_matrix_fsm_clear( color_matrix_fsm_t *p_fsm )
     p_fsm->light_source_change_frames = 20;
     p_fsm->light_source_change_frames_left = 0;
     p_fsm->manual_CCM = 0;
+    p_fsm->ccm_fingerprint_valid = 0;
+    p_fsm->mesh_fingerprint_valid = 0;
 }
 
 void color_matrix_request_interrupt( color_matrix_fsm_ptr_t p_fsm, system_fw_interrupt_mask_t mask )
@@ -52,6 +54,11 @@ void color_matrix_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     color_matrix_fsm_clear( p_fsm );
 
+    // the CCMs are read as 3x3 matrices
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_MT_ABSOLUTE_LS_A_CCM, 9 * sizeof( uint16_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_MT_ABSOLUTE_LS_D40_CCM, 9 * sizeof( uint16_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_MT_ABSOLUTE_LS_D50_CCM, 9 * sizeof( uint16_t ) );
+
     color_matrix_initialize( p_fsm );
     color_matrix_request_interrupt( p_fsm, ACAMERA_IRQ_MASK( ACAMERA_IRQ_FRAME_END ) );
 }
@@ -150,6 +157,16 @@ int color_matrix_fsm_get_param( void *fsm, uint32_t param_id, void *input, uint3
 
         break;
 
+    case FSM_PARAM_GET_COLOR_MATRIX_REUSE_STATS:
+        if ( !output || output_size != sizeof( fsm_param_reuse_stats_t ) ) {
+            LOG( LOG_ERR, "Invalid param, param_id: %d.", param_id );
+            rc = -1;
+            break;
+        }
+
+        *(fsm_param_reuse_stats_t *)output = p_fsm->reuse_stats;
+        break;
+
     default:
         rc = -1;
         break;
@@ -67,6 +67,11 @@ struct _color_matrix_fsm_t {
     uint8_t manual_CCM;
     int16_t manual_color_matrix[9];
     int32_t temperature_threshold[8];
+    uint32_t ccm_fingerprint;
+    uint32_t mesh_fingerprint;
+    uint8_t ccm_fingerprint_valid;
+    uint8_t mesh_fingerprint_valid;
+    fsm_param_reuse_stats_t reuse_stats;
 };
 
 
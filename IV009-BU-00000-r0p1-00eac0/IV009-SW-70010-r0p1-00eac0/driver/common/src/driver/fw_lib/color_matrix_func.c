@@ -144,7 +144,7 @@ static void mesh_shading_modulate_strength( color_matrix_fsm_ptr_t p_fsm )
     if ( ACAMERA_FSM2CTX_PTR( p_fsm )->stab.global_manual_shading == 0 ) {
         acamera_fsm_mgr_get_param( p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_CMOS_TOTAL_GAIN, NULL, 0, &total_gain, sizeof( total_gain ) );
         uint16_t log2_gain = total_gain >> ( LOG2_GAIN_SHIFT - 8 );
-        uint16_t strength = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_MESH_SHADING_STRENGTH ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_MESH_SHADING_STRENGTH ) );
+        uint16_t strength = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_MESH_SHADING_STRENGTH, log2_gain );
         acamera_isp_mesh_shading_mesh_strength_write( p_fsm->cmn.isp_base, strength );
     }
 }
@@ -165,7 +165,10 @@ void color_matrix_shading_mesh_reload( color_matrix_fsm_ptr_t p_fsm )
 
     // determine the shading size. assume the tables have identical dimentions NxN
     uint32_t dim = acamera_sqrt32(mesh_size);
-    
+
+    uint32_t inputs[3] = {mirror, mesh_size, acamera_calibrations_generation( ACAMERA_FSM2CTX_PTR( p_fsm ) )};
+    uint32_t fingerprint = acamera_fingerprint32( ACAMERA_FINGERPRINT_SEED, inputs, sizeof( inputs ) );
+    uint8_t reload = !p_fsm->mesh_fingerprint_valid || p_fsm->mesh_fingerprint != fingerprint;
 
     //for mesh shading light switching
     acamera_isp_top_bypass_mesh_shading_write( p_fsm->cmn.isp_base, 0 );
@@ -178,6 +181,17 @@ void color_matrix_shading_mesh_reload( color_matrix_fsm_ptr_t p_fsm )
     acamera_isp_mesh_shading_mesh_alpha_mode_write( p_fsm->cmn.isp_base, 2 );
 
 
+    // the mesh memory keeps its content, only the config above may have been reset
+    if ( !reload ) {
+        p_fsm->reuse_stats.hits++;
+        acamera_isp_mesh_shading_enable_write( p_fsm->cmn.isp_base, 1 );
+        acamera_isp_mesh_shading_mesh_show_write( p_fsm->cmn.isp_base, 0 );
+        return;
+    }
+    p_fsm->mesh_fingerprint = fingerprint;
+    p_fsm->mesh_fingerprint_valid = 1;
+    p_fsm->reuse_stats.misses++;
+
     mesh_page[0][0] = _GET_UCHAR_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_SHADING_LS_A_R );
     mesh_page[0][1] = _GET_UCHAR_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_SHADING_LS_A_G );
     mesh_page[0][2] = _GET_UCHAR_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_SHADING_LS_A_B );
@@ -220,6 +234,17 @@ void color_matrix_recalculate( color_matrix_fsm_t *p_fsm )
     }
 
     saturation = ACAMERA_FSM2CTX_PTR( p_fsm )->stab.global_saturation_target;
+
+    uint32_t fingerprint = acamera_fingerprint32( ACAMERA_FINGERPRINT_SEED, &saturation, sizeof( saturation ) );
+    fingerprint = acamera_fingerprint32( fingerprint, p_fsm->color_correction_matrix, sizeof( p_fsm->color_correction_matrix ) );
+    if ( p_fsm->ccm_fingerprint_valid && p_fsm->ccm_fingerprint == fingerprint ) {
+        p_fsm->reuse_stats.hits++;
+        return;
+    }
+    p_fsm->ccm_fingerprint = fingerprint;
+    p_fsm->ccm_fingerprint_valid = 1;
+    p_fsm->reuse_stats.misses++;
+
     color_mat_calculate_saturation_matrix( p_fsm->color_saturation_matrix, (uint8_t)saturation );
     // New colour management:
     matrix_matrix_multiply( p_fsm->color_saturation_matrix, p_fsm->color_correction_matrix, p_fsm->color_matrix, 3, 3, 3 );
@@ -307,13 +332,9 @@ void color_matrix_initialize( color_matrix_fsm_t *p_fsm )
     p_fsm->shading_direction = 2; //0 ->inc  1->dec 2->do nothing
     p_fsm->shading_source_previous = AWB_LIGHT_SOURCE_D50;
 
-    acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-    acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-    acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
+    acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK, OV_08835_MESH_SHADING_LS_D50_BANK, OV_08835_MESH_SHADING_LS_D50_BANK );
 
-    acamera_isp_mesh_shading_mesh_alpha_r_write( p_fsm->cmn.isp_base, 0 );
-    acamera_isp_mesh_shading_mesh_alpha_g_write( p_fsm->cmn.isp_base, 0 );
-    acamera_isp_mesh_shading_mesh_alpha_b_write( p_fsm->cmn.isp_base, 0 );
+    acamera_isp_mesh_shading_mesh_alpha_rgb_write( p_fsm->cmn.isp_base, 0, 0, 0 );
 
     p_fsm->temperature_threshold[0] = 3000;
     p_fsm->temperature_threshold[1] = 3900;
@@ -330,37 +351,27 @@ void color_matrix_initialize( color_matrix_fsm_t *p_fsm )
 #endif // FW_DO_INITIALIZATION
 }
 
+static const acamera_reg_field_t ccm_fields[9] = {
+    ACAMERA_ISP_CCM_COEFFT_R_R_FIELD, ACAMERA_ISP_CCM_COEFFT_R_G_FIELD, ACAMERA_ISP_CCM_COEFFT_R_B_FIELD,
+    ACAMERA_ISP_CCM_COEFFT_G_R_FIELD, ACAMERA_ISP_CCM_COEFFT_G_G_FIELD, ACAMERA_ISP_CCM_COEFFT_G_B_FIELD,
+    ACAMERA_ISP_CCM_COEFFT_B_R_FIELD, ACAMERA_ISP_CCM_COEFFT_B_G_FIELD, ACAMERA_ISP_CCM_COEFFT_B_B_FIELD,
+};
+
 void color_matrix_write( color_matrix_fsm_t *p_fsm )
 {
+    const int16_t *p_ccm = p_fsm->color_matrix;
+    int i;
+
     if ( p_fsm->manual_CCM ) {
-        acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-        acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-        acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-        acamera_isp_mesh_shading_mesh_alpha_r_write( p_fsm->cmn.isp_base, 0 );
-        acamera_isp_mesh_shading_mesh_alpha_g_write( p_fsm->cmn.isp_base, 0 );
-        acamera_isp_mesh_shading_mesh_alpha_b_write( p_fsm->cmn.isp_base, 0 );
-
-        acamera_isp_ccm_coefft_r_r_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[0] );
-        acamera_isp_ccm_coefft_r_g_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[1] );
-        acamera_isp_ccm_coefft_r_b_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[2] );
-        acamera_isp_ccm_coefft_g_r_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[3] );
-        acamera_isp_ccm_coefft_g_g_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[4] );
-        acamera_isp_ccm_coefft_g_b_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[5] );
-        acamera_isp_ccm_coefft_b_r_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[6] );
-        acamera_isp_ccm_coefft_b_g_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[7] );
-        acamera_isp_ccm_coefft_b_b_write( p_fsm->cmn.isp_base, p_fsm->manual_color_matrix[8] );
+        acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK, OV_08835_MESH_SHADING_LS_D50_BANK, OV_08835_MESH_SHADING_LS_D50_BANK );
+        acamera_isp_mesh_shading_mesh_alpha_rgb_write( p_fsm->cmn.isp_base, 0, 0, 0 );
 
-    } else {
+        p_ccm = p_fsm->manual_color_matrix;
+    }
 
-        acamera_isp_ccm_coefft_r_r_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[0] );
-        acamera_isp_ccm_coefft_r_g_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[1] );
-        acamera_isp_ccm_coefft_r_b_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[2] );
-        acamera_isp_ccm_coefft_g_r_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[3] );
-        acamera_isp_ccm_coefft_g_g_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[4] );
-        acamera_isp_ccm_coefft_g_b_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[5] );
-        acamera_isp_ccm_coefft_b_r_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[6] );
-        acamera_isp_ccm_coefft_b_g_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[7] );
-        acamera_isp_ccm_coefft_b_b_write( p_fsm->cmn.isp_base, p_fsm->color_matrix[8] );
+    // the matrix is written every frame, mostly unchanged
+    for ( i = 0; i < 9; i++ ) {
+        fsm_reg_write( p_fsm, FSM_ID_COLOR_MATRIX, &ccm_fields[i], (uint16_t)p_ccm[i] );
     }
 }
 
@@ -425,9 +436,7 @@ void color_matrix_update( color_matrix_fsm_t *p_fsm )
 
         if ( ( wb_info.temperature_detected < p_fsm->temperature_threshold[0] ) ) //0->1
         {
-            acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK );
+            acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK, OV_08835_MESH_SHADING_LS_A_BANK, OV_08835_MESH_SHADING_LS_A_BANK );
             p_fsm->shading_alpha = 0;
             p_fsm->shading_source_previous = AWB_LIGHT_SOURCE_A;
 
@@ -435,9 +444,7 @@ void color_matrix_update( color_matrix_fsm_t *p_fsm )
         // if  current temp  between 4100 and 3900 use D40
         else if ( ( wb_info.temperature_detected > p_fsm->temperature_threshold[1] ) && ( wb_info.temperature_detected < p_fsm->temperature_threshold[2] ) ) //1->2
         {
-            acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK );
+            acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK, OV_08835_MESH_SHADING_LS_D40_BANK, OV_08835_MESH_SHADING_LS_D40_BANK );
             p_fsm->shading_direction = 1; //0 ->inc  1->dec
             p_fsm->shading_alpha = 0;
             p_fsm->shading_source_previous = AWB_LIGHT_SOURCE_D40;
@@ -446,9 +453,7 @@ void color_matrix_update( color_matrix_fsm_t *p_fsm )
         // if  current temp > 4900 go to d65
         else if ( ( wb_info.temperature_detected > p_fsm->temperature_threshold[3] ) ) //2->1
         {
-            acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK );
+            acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D50_BANK, OV_08835_MESH_SHADING_LS_D50_BANK, OV_08835_MESH_SHADING_LS_D50_BANK );
             p_fsm->shading_direction = 0; //0 ->inc  1->dec
             p_fsm->shading_alpha = 0;
             p_fsm->shading_source_previous = AWB_LIGHT_SOURCE_D50;
@@ -458,9 +463,7 @@ void color_matrix_update( color_matrix_fsm_t *p_fsm )
         // if prev if d50 and current temp < 3700 go to d40
         else if ( ( wb_info.temperature_detected > p_fsm->temperature_threshold[4] ) && ( wb_info.temperature_detected < p_fsm->temperature_threshold[5] ) ) //2->0
         {
-            acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK );
+            acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_A_BANK, OV_08835_MESH_SHADING_LS_A_BANK, OV_08835_MESH_SHADING_LS_A_BANK );
 
             if ( p_fsm->temperature_threshold[5] != p_fsm->temperature_threshold[4] )
                 p_fsm->shading_alpha = ( 255 * ( wb_info.temperature_detected - p_fsm->temperature_threshold[4] ) ) / ( p_fsm->temperature_threshold[5] - p_fsm->temperature_threshold[4] ); // division by zero is checked
@@ -470,17 +473,13 @@ void color_matrix_update( color_matrix_fsm_t *p_fsm )
         // if  current temp > 4750 go to d65
         else if ( ( wb_info.temperature_detected > p_fsm->temperature_threshold[6] ) && ( wb_info.temperature_detected < p_fsm->temperature_threshold[7] ) ) //2->1
         {
-            acamera_isp_mesh_shading_mesh_alpha_bank_r_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_g_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK );
-            acamera_isp_mesh_shading_mesh_alpha_bank_b_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK );
+            acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( p_fsm->cmn.isp_base, OV_08835_MESH_SHADING_LS_D40_BANK, OV_08835_MESH_SHADING_LS_D40_BANK, OV_08835_MESH_SHADING_LS_D40_BANK );
 
             if ( p_fsm->temperature_threshold[7] != p_fsm->temperature_threshold[6] )
                 p_fsm->shading_alpha = ( 255 * ( wb_info.temperature_detected - p_fsm->temperature_threshold[6] ) ) / ( p_fsm->temperature_threshold[7] - p_fsm->temperature_threshold[6] ); // division by zero is checked
                                                                                                                                                                                              //p_fsm->shading_source_previous = AWB_LIGHT_SOURCE_D50;
         }
-        acamera_isp_mesh_shading_mesh_alpha_r_write( p_fsm->cmn.isp_base, p_fsm->shading_alpha );
-        acamera_isp_mesh_shading_mesh_alpha_g_write( p_fsm->cmn.isp_base, p_fsm->shading_alpha );
-        acamera_isp_mesh_shading_mesh_alpha_b_write( p_fsm->cmn.isp_base, p_fsm->shading_alpha );
+        acamera_isp_mesh_shading_mesh_alpha_rgb_write( p_fsm->cmn.isp_base, p_fsm->shading_alpha, p_fsm->shading_alpha, p_fsm->shading_alpha );
     }
 
     //this will put the ccm into the right format used in purple fringe and write to registers
@@ -24,6 +24,7 @@
 #include "acamera.h"
 #include "fsm_intf.h"
 #include "fsm_param_id.h"
+#include "acamera_command_api.h"
 
 enum {
     CMOS_CURRENT_EXPOSURE_LOG2,
@@ -204,6 +205,23 @@ typedef struct _fsm_param_crop_setting_ {
     uint32_t flag;
 } fsm_param_crop_setting_t;
 
+typedef acamera_crop_window_t fsm_param_crop_window_t;
+
+// a declared zoom path whose configurations are computed in advance
+typedef struct _fsm_param_crop_preload_ {
+    // CROP_FR or CROP_DS
+    uint16_t resize_type;
+    uint16_t count;
+    const fsm_param_crop_window_t *windows;
+} fsm_param_crop_preload_t;
+
+typedef struct _fsm_param_crop_trajectory_ {
+    // CROP_FR or CROP_DS
+    uint16_t resize_type;
+    uint16_t count;
+    const acamera_crop_keyframe_t *keyframes;
+} fsm_param_crop_trajectory_t;
+
 
 enum fsm_param_reg_setting_bit {
     REG_SETTING_BIT_REG_ADDR = ( 1 << 0 ),
@@ -230,6 +248,11 @@ typedef struct _fsm_param_ccm_manual_ {
     int16_t manual_color_matrix[9];
 } fsm_param_ccm_manual_t;
 
+typedef struct _fsm_param_reuse_stats_ {
+    uint32_t hits;   // previous result reused, inputs unchanged
+    uint32_t misses; // result recomputed
+} fsm_param_reuse_stats_t;
+
 typedef struct _fsm_param_set_wdr_param_ {
     uint32_t wdr_mode;
     uint32_t exp_number;
@@ -55,6 +55,10 @@ void general_fsm_init( void *fsm, fsm_init_param_t *init_param )
     p_fsm->cmn.isp_base = init_param->isp_base;
     p_fsm->p_fsm_mgr = init_param->p_fsm_mgr;
 
+    // mesh and radial parameters are read by index
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_CA_CORRECTION, 3 * sizeof( uint16_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_PF_RADIAL_PARAMS, 3 * sizeof( uint16_t ) );
+
     general_initialize( p_fsm );
 }
 
@@ -332,12 +332,17 @@ void acamera_reload_isp_calibratons( general_fsm_ptr_t p_fsm )
 
     const uint8_t *np_lut_wdr = _GET_UCHAR_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_WDR_NP_LUT );
     const uint8_t *np_lut = _GET_UCHAR_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_NOISE_PROFILE );
+    const uint32_t np_lut_wdr_len = _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_WDR_NP_LUT );
 
     for ( i = 0; i < _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_NOISE_PROFILE ); i++ ) {
 
         acamera_isp_sinter_noise_profile_lut_weight_lut_write( p_fsm->cmn.isp_base, i, np_lut[i] );
         acamera_isp_temper_noise_profile_lut_weight_lut_write( p_fsm->cmn.isp_base, i, np_lut[i] );
 
+        // the wdr table is indexed with the length of the linear one
+        if ( i >= np_lut_wdr_len )
+            continue;
+
         acamera_isp_frame_stitch_np_lut_vs_weight_lut_write( p_fsm->cmn.isp_base, i, np_lut_wdr[i] );
         acamera_isp_frame_stitch_np_lut_s_weight_lut_write( p_fsm->cmn.isp_base, i, np_lut_wdr[i] );
         acamera_isp_frame_stitch_np_lut_m_weight_lut_write( p_fsm->cmn.isp_base, i, np_lut_wdr[i] );
@@ -374,9 +379,7 @@ void acamera_reload_isp_calibratons( general_fsm_ptr_t p_fsm )
     uint32_t ca_filter_mem_len = _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_CA_FILTER_MEM );
     const uint32_t *p_ca_filter_mem = _GET_UINT_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_CA_FILTER_MEM );
     LOG( LOG_INFO, "ca_filter_mem_len: %d", ca_filter_mem_len );
-    for ( i = 0; i < ca_filter_mem_len; i++ ) {
-        acamera_ca_correction_filter_mem_array_data_write( p_fsm->cmn.isp_base, i, p_ca_filter_mem[i] );
-    }
+    system_sw_write_block_32( p_fsm->cmn.isp_base + ACAMERA_CA_CORRECTION_FILTER_MEM_ARRAY_DATA_OFFSET, p_ca_filter_mem, ca_filter_mem_len );
 #endif
 
     if ( acamera_isp_isp_global_parameter_status_cac_read( p_fsm->cmn.isp_base ) == 0 ) {
@@ -390,22 +393,20 @@ void acamera_reload_isp_calibratons( general_fsm_ptr_t p_fsm )
         uint32_t lut3d_mem_len = _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_LUT3D_MEM );
         const uint32_t *p_lut3d_mem = _GET_UINT_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_LUT3D_MEM );
         LOG( LOG_INFO, "lut3d_mem_len: %d", lut3d_mem_len );
-        for ( i = 0; i < lut3d_mem_len; i++ ) {
-            acamera_lut3d_mem_array_data_write( p_fsm->cmn.isp_base, i, p_lut3d_mem[i] );
-        }
+        system_hw_write_block_32( ACAMERA_LUT3D_MEM_ARRAY_DATA_OFFSET, p_lut3d_mem, lut3d_mem_len );
 #endif
     }
 
 #if defined( CALIBRATION_DECOMPANDER0_MEM )
-    for ( i = 0; i < _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER0_MEM ); i++ ) {
-        acamera_decompander0_mem_array_data_write( p_fsm->cmn.isp_base, i, _GET_UINT_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER0_MEM )[i] );
-    }
+    system_sw_write_block_32( p_fsm->cmn.isp_base + ACAMERA_DECOMPANDER0_MEM_ARRAY_DATA_OFFSET,
+                              _GET_UINT_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER0_MEM ),
+                              _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER0_MEM ) );
 #endif
 
 #if defined( CALIBRATION_DECOMPANDER1_MEM )
-    for ( i = 0; i < _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER1_MEM ); i++ ) {
-        acamera_decompander1_mem_array_data_write( p_fsm->cmn.isp_base, i, _GET_UINT_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER1_MEM )[i] );
-    }
+    system_sw_write_block_32( p_fsm->cmn.isp_base + ACAMERA_DECOMPANDER1_MEM_ARRAY_DATA_OFFSET,
+                              _GET_UINT_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER1_MEM ),
+                              _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_DECOMPANDER1_MEM ) );
 #endif
 
 #if defined( CALIBRATION_SHADING_RADIAL_R ) && defined( CALIBRATION_SHADING_RADIAL_G ) && defined( CALIBRATION_SHADING_RADIAL_B )
@@ -53,6 +53,9 @@ void matrix_yuv_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     matrix_yuv_fsm_clear( p_fsm );
 
+    // the conversion matrix is read as 12 coefficients
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_RGB2YUV_CONVERSION, 12 * sizeof( uint16_t ) );
+
     matrix_yuv_initialize( p_fsm );
     matrix_yuv_update( p_fsm );
     matrix_yuv_request_interrupt( p_fsm, ACAMERA_IRQ_MASK( ACAMERA_IRQ_FRAME_END ) );
@@ -73,7 +76,7 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->fr_pipe_output_format = *(uint32_t *)input;
-        matrix_yuv_update( p_fsm );
+        matrix_yuv_request_update( p_fsm );
         break;
 
 #if ISP_HAS_DS1
@@ -85,7 +88,7 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->ds1_pipe_output_format = *(uint32_t *)input;
-        matrix_yuv_update( p_fsm );
+        matrix_yuv_request_update( p_fsm );
         break;
 #endif
 
@@ -97,7 +100,7 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->saturation_strength = *(uint32_t *)input;
-        matrix_yuv_update( p_fsm );
+        matrix_yuv_request_update( p_fsm );
 
         break;
 
@@ -109,7 +112,7 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->hue_theta = *(uint32_t *)input;
-        matrix_yuv_update( p_fsm );
+        matrix_yuv_request_update( p_fsm );
         break;
 
     case FSM_PARAM_SET_MATRIX_YUV_BRIGHTNESS_STRENGTH:
@@ -120,7 +123,7 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->brightness_strength = *(uint32_t *)input;
-        matrix_yuv_update( p_fsm );
+        matrix_yuv_request_update( p_fsm );
         break;
 
     case FSM_PARAM_SET_MATRIX_YUV_CONTRAST_STRENGTH:
@@ -131,7 +134,7 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->contrast_strength = *(uint32_t *)input;
-        matrix_yuv_update( p_fsm );
+        matrix_yuv_request_update( p_fsm );
         break;
 
     case FSM_PARAM_SET_MATRIX_YUV_COLOR_MODE:
@@ -142,6 +145,10 @@ int matrix_yuv_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_
         }
 
         p_fsm->color_mode = *(uint32_t *)input;
+        matrix_yuv_request_update( p_fsm );
+        break;
+
+    case FSM_PARAM_SET_MATRIX_YUV_UPDATE:
         matrix_yuv_update( p_fsm );
         break;
 
@@ -232,6 +239,16 @@ int matrix_yuv_fsm_get_param( void *fsm, uint32_t param_id, void *input, uint32_
         *(uint32_t *)output = p_fsm->color_mode;
         break;
 
+    case FSM_PARAM_GET_MATRIX_YUV_REUSE_STATS:
+        if ( !output || output_size != sizeof( fsm_param_reuse_stats_t ) ) {
+            LOG( LOG_ERR, "Invalid param, param_id: %d.", param_id );
+            rc = -1;
+            break;
+        }
+
+        *(fsm_param_reuse_stats_t *)output = p_fsm->reuse_stats;
+        break;
+
     default:
         rc = -1;
         break;
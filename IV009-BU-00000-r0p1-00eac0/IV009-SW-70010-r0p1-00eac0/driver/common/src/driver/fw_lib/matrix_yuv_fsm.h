@@ -43,6 +43,7 @@ void matrix_identity( int16_t *m, int dim );
 int16_t color_matrix_direct_to_complement( uint16_t v );
 void matrix_yuv_initialize( matrix_yuv_fsm_ptr_t p_fsm );
 void matrix_yuv_update( matrix_yuv_fsm_ptr_t p_fsm );
+void matrix_yuv_request_update( matrix_yuv_fsm_ptr_t p_fsm );
 void matrix_yuv_recompute( matrix_yuv_fsm_ptr_t p_fsm );
 void matrix_yuv_coefft_write_to_hardware( matrix_yuv_fsm_ptr_t p_fsm );
 void matrix_yuv_set_FR_mode( uint16_t v );
@@ -75,6 +76,9 @@ struct _matrix_yuv_fsm_t {
     int16_t manual_matrix_yuv[9];
     int32_t temperature_threshold[8];
     uint16_t fr_format;
+    uint32_t input_fingerprint;
+    uint8_t input_fingerprint_valid;
+    fsm_param_reuse_stats_t reuse_stats;
 };
 
 
@@ -104,21 +104,21 @@ static void matrix_yuv_clip( int16_t *input )
         }
     }
 }
+static const acamera_reg_field_t fr_cs_conv_fields[12] = {
+    ACAMERA_ISP_FR_CS_CONV_COEFFT_11_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_12_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_13_FIELD,
+    ACAMERA_ISP_FR_CS_CONV_COEFFT_21_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_22_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_23_FIELD,
+    ACAMERA_ISP_FR_CS_CONV_COEFFT_31_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_32_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_33_FIELD,
+    ACAMERA_ISP_FR_CS_CONV_COEFFT_O1_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_O2_FIELD, ACAMERA_ISP_FR_CS_CONV_COEFFT_O3_FIELD,
+};
+
 static void matrix_yuv_fr_coefft_write_to_hardware( matrix_yuv_fsm_t *p_fsm )
 {
     int16_t *yuv_matrix = p_fsm->fr_composite_yuv_matrix;
-    acamera_isp_fr_cs_conv_coefft_11_write( p_fsm->cmn.isp_base, yuv_matrix[0] );
-    acamera_isp_fr_cs_conv_coefft_12_write( p_fsm->cmn.isp_base, yuv_matrix[1] );
-    acamera_isp_fr_cs_conv_coefft_13_write( p_fsm->cmn.isp_base, yuv_matrix[2] );
-    acamera_isp_fr_cs_conv_coefft_21_write( p_fsm->cmn.isp_base, yuv_matrix[3] );
-    acamera_isp_fr_cs_conv_coefft_22_write( p_fsm->cmn.isp_base, yuv_matrix[4] );
-    acamera_isp_fr_cs_conv_coefft_23_write( p_fsm->cmn.isp_base, yuv_matrix[5] );
-    acamera_isp_fr_cs_conv_coefft_31_write( p_fsm->cmn.isp_base, yuv_matrix[6] );
-    acamera_isp_fr_cs_conv_coefft_32_write( p_fsm->cmn.isp_base, yuv_matrix[7] );
-    acamera_isp_fr_cs_conv_coefft_33_write( p_fsm->cmn.isp_base, yuv_matrix[8] );
-    acamera_isp_fr_cs_conv_coefft_o1_write( p_fsm->cmn.isp_base, yuv_matrix[9] );
-    acamera_isp_fr_cs_conv_coefft_o2_write( p_fsm->cmn.isp_base, yuv_matrix[10] );
-    acamera_isp_fr_cs_conv_coefft_o3_write( p_fsm->cmn.isp_base, yuv_matrix[11] );
+    int i;
+
+    for ( i = 0; i < 12; i++ ) {
+        fsm_reg_write( p_fsm, FSM_ID_MATRIX_YUV, &fr_cs_conv_fields[i], (uint16_t)yuv_matrix[i] );
+    }
     acamera_isp_fr_cs_conv_enable_matrix_write( p_fsm->cmn.isp_base, 1 );
     switch ( p_fsm->fr_pipe_output_format ) {
     case PIPE_OUT_YUV422:
@@ -144,23 +144,25 @@ static void matrix_yuv_fr_coefft_write_to_hardware( matrix_yuv_fsm_t *p_fsm )
     }
 }
 
+#if ISP_HAS_DS1
+static const acamera_reg_field_t ds1_cs_conv_fields[12] = {
+    ACAMERA_ISP_DS1_CS_CONV_COEFFT_11_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_12_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_13_FIELD,
+    ACAMERA_ISP_DS1_CS_CONV_COEFFT_21_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_22_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_23_FIELD,
+    ACAMERA_ISP_DS1_CS_CONV_COEFFT_31_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_32_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_33_FIELD,
+    ACAMERA_ISP_DS1_CS_CONV_COEFFT_O1_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_O2_FIELD, ACAMERA_ISP_DS1_CS_CONV_COEFFT_O3_FIELD,
+};
+#endif
+
 static void matrix_yuv_ds_write_to_hardware( matrix_yuv_fsm_t *p_fsm )
 {
 
 #if ISP_HAS_DS1
     int16_t *yuv_matrix = p_fsm->ds1_composite_yuv_matrix;
-    acamera_isp_ds1_cs_conv_coefft_11_write( p_fsm->cmn.isp_base, yuv_matrix[0] );
-    acamera_isp_ds1_cs_conv_coefft_12_write( p_fsm->cmn.isp_base, yuv_matrix[1] );
-    acamera_isp_ds1_cs_conv_coefft_13_write( p_fsm->cmn.isp_base, yuv_matrix[2] );
-    acamera_isp_ds1_cs_conv_coefft_21_write( p_fsm->cmn.isp_base, yuv_matrix[3] );
-    acamera_isp_ds1_cs_conv_coefft_22_write( p_fsm->cmn.isp_base, yuv_matrix[4] );
-    acamera_isp_ds1_cs_conv_coefft_23_write( p_fsm->cmn.isp_base, yuv_matrix[5] );
-    acamera_isp_ds1_cs_conv_coefft_31_write( p_fsm->cmn.isp_base, yuv_matrix[6] );
-    acamera_isp_ds1_cs_conv_coefft_32_write( p_fsm->cmn.isp_base, yuv_matrix[7] );
-    acamera_isp_ds1_cs_conv_coefft_33_write( p_fsm->cmn.isp_base, yuv_matrix[8] );
-    acamera_isp_ds1_cs_conv_coefft_o1_write( p_fsm->cmn.isp_base, yuv_matrix[9] );
-    acamera_isp_ds1_cs_conv_coefft_o2_write( p_fsm->cmn.isp_base, yuv_matrix[10] );
-    acamera_isp_ds1_cs_conv_coefft_o3_write( p_fsm->cmn.isp_base, yuv_matrix[11] );
+    int i;
+
+    for ( i = 0; i < 12; i++ ) {
+        fsm_reg_write( p_fsm, FSM_ID_MATRIX_YUV, &ds1_cs_conv_fields[i], (uint16_t)yuv_matrix[i] );
+    }
     acamera_isp_ds1_cs_conv_enable_matrix_write( p_fsm->cmn.isp_base, 1 );
     switch ( p_fsm->ds1_pipe_output_format ) {
     case PIPE_OUT_YUV422:
@@ -447,8 +449,38 @@ static void compute_transfrom_matrix( matrix_yuv_fsm_t *p_fsm, int16_t *final_co
     }
     matrix_yuv_clip( final_composite_yuv_matrix );
 }
+static uint32_t matrix_yuv_input_fingerprint( matrix_yuv_fsm_t *p_fsm )
+{
+    uint32_t inputs[8];
+
+    inputs[0] = p_fsm->color_mode;
+    inputs[1] = p_fsm->brightness_strength;
+    inputs[2] = p_fsm->contrast_strength;
+    inputs[3] = p_fsm->saturation_strength;
+    inputs[4] = p_fsm->hue_theta;
+    inputs[5] = p_fsm->fr_pipe_output_format;
+#if ISP_HAS_DS1
+    inputs[6] = p_fsm->ds1_pipe_output_format;
+#else
+    inputs[6] = 0;
+#endif
+    // the rgb2yuv conversion comes from the calibration set
+    inputs[7] = acamera_calibrations_generation( ACAMERA_FSM2CTX_PTR( p_fsm ) );
+
+    return acamera_fingerprint32( ACAMERA_FINGERPRINT_SEED, inputs, sizeof( inputs ) );
+}
+
 void matrix_yuv_recompute( matrix_yuv_fsm_t *p_fsm )
 {
+    uint32_t fingerprint = matrix_yuv_input_fingerprint( p_fsm );
+
+    if ( p_fsm->input_fingerprint_valid && p_fsm->input_fingerprint == fingerprint ) {
+        p_fsm->reuse_stats.hits++;
+        return;
+    }
+    p_fsm->input_fingerprint = fingerprint;
+    p_fsm->input_fingerprint_valid = 1;
+    p_fsm->reuse_stats.misses++;
 
     matrix_compute_color_mode( p_fsm->color_mode, p_fsm->color_mode_matrix, p_fsm );
     matrix_compute_brightness( p_fsm->brightness_strength, p_fsm->brightness_matrix );
@@ -470,6 +502,14 @@ void matrix_yuv_update( matrix_yuv_fsm_t *p_fsm )
     matrix_yuv_recompute( p_fsm );
     matrix_yuv_coefft_write_to_hardware( p_fsm );
 }
+
+// inside an api command batch the update runs once when the batch is closed
+void matrix_yuv_request_update( matrix_yuv_fsm_t *p_fsm )
+{
+    if ( !acamera_cmd_batch_defer( ACAMERA_FSM2CTX_PTR( p_fsm ), ACAMERA_CMD_BATCH_MATRIX_YUV ) ) {
+        matrix_yuv_update( p_fsm );
+    }
+}
 void matrix_yuv_initialize( matrix_yuv_fsm_t *p_fsm )
 {
     uint16_t identity_matrix[12] = {0x0100, 0x0000, 0x0000, 0x0000, 0x0100, 0x0000, 0x0000, 0x0000, 0x0100, 0, 0, 0};
@@ -478,6 +518,7 @@ void matrix_yuv_initialize( matrix_yuv_fsm_t *p_fsm )
     p_fsm->contrast_strength = 128;
     p_fsm->brightness_strength = 128;
     p_fsm->hue_theta = 180;
+    p_fsm->input_fingerprint_valid = 0;
 #if defined( COLOR_MODE_ID )
     p_fsm->color_mode = NORMAL;
 #endif
@@ -114,6 +114,11 @@ void sensor_hw_init( sensor_fsm_ptr_t p_fsm )
 
     // 2): set to wdr_mode through general router (wdr_mode changed in sensor param in 1st step).
     const sensor_param_t *param = p_fsm->ctrl.get_parameters( p_fsm->sensor_ctx );
+    if ( param->mode_switch_skip_frames ) {
+        LOG( LOG_NOTICE, "Dropping %d frames after switching the sensor to mode %d", param->mode_switch_skip_frames, param->mode );
+    }
+    ACAMERA_FSM2CTX_PTR( p_fsm )->sensor_switch_skip_frames = param->mode_switch_skip_frames;
+    ACAMERA_FSM2CTX_PTR( p_fsm )->sensor_mode_switches++;
 
     fsm_param_set_wdr_param_t set_wdr_param;
     set_wdr_param.wdr_mode = param->modes_table[param->mode].wdr_mode;
@@ -133,8 +138,7 @@ void sensor_sw_init( sensor_fsm_ptr_t p_fsm )
 
 #if FW_DO_INITIALIZATION
     /* sensor resolution */
-    acamera_isp_top_active_width_write( p_fsm->cmn.isp_base, param->active.width );
-    acamera_isp_top_active_height_write( p_fsm->cmn.isp_base, param->active.height );
+    acamera_isp_top_active_size_write( p_fsm->cmn.isp_base, param->active.width, param->active.height );
 
     acamera_isp_metering_af_active_width_write( p_fsm->cmn.isp_base, param->active.width );
     acamera_isp_metering_af_active_height_write( p_fsm->cmn.isp_base, param->active.height );
@@ -171,10 +175,10 @@ void sensor_update_black( sensor_fsm_ptr_t p_fsm )
     uint32_t idx_b = CALIBRATION_BLACK_LEVEL_B;
     uint32_t idx_gr = CALIBRATION_BLACK_LEVEL_GR;
     uint32_t idx_gb = CALIBRATION_BLACK_LEVEL_GB;
-    uint32_t r = acamera_calc_modulation_u16( again_log2, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_r ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_r ) );
-    uint32_t b = acamera_calc_modulation_u16( again_log2, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_b ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_b ) );
-    uint32_t gr = acamera_calc_modulation_u16( again_log2, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_gr ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_gr ) );
-    uint32_t gb = acamera_calc_modulation_u16( again_log2, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_gb ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_gb ) );
+    uint32_t r = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_r, again_log2 );
+    uint32_t b = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_b, again_log2 );
+    uint32_t gr = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_gr, again_log2 );
+    uint32_t gb = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), idx_gb, again_log2 );
 
     p_fsm->black_level = r;
 
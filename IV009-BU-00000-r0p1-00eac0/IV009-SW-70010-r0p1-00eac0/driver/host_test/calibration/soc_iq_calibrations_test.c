@@ -0,0 +1,212 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// Host test of the two IQ calibration banks of a context. The firmware side
+// of a swap follows acamera_fw.c: the set in use is copied into the staging
+// set before the callback loads the new one, and the staging set becomes the
+// set in use when it is published at a frame boundary. Sets are restaged
+// while one is still pending, the set in use must keep its memory and data.
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "acamera_types.h"
+#include "acamera_command_api.h"
+#include "acamera_firmware_settings.h"
+#include "soc_iq.h"
+#include "media/v4l2-subdev.h"
+#include "linux/slab.h"
+
+extern uint32_t soc_iq_get_calibrations( int32_t, void *, ACameraCalibrations *c );
+
+#define SIM_MODES 3
+#define SIM_MAX_BLOCKS 64
+
+typedef struct _sim_t {
+    uint32_t load; // marks the data of every LUT of one load
+    uint32_t mode_rows[SIM_MODES];
+    void *blocks[SIM_MAX_BLOCKS];
+    size_t sizes[SIM_MAX_BLOCKS];
+    uint32_t blocks_num;
+    uint32_t frees;
+} sim_t;
+
+static sim_t sim;
+static ACameraCalibrations live;
+static ACameraCalibrations staging;
+static uint32_t live_load;
+
+void *acamera_camera_v4l2_get_subdev_by_name( const char *name )
+{
+    return &sim;
+}
+
+// the rows of every LUT grow with the mode so a bigger mode needs a new bank
+long sim_iq_ioctl( struct v4l2_subdev *sd, unsigned int cmd, void *arg )
+{
+    struct soc_iq_ioctl_args *args = (struct soc_iq_ioctl_args *)arg;
+    uint32_t idx;
+
+    if ( cmd == V4L2_SOC_IQ_IOCTL_REQUEST_INFO ) {
+        uint32_t mode = *(uint32_t *)args->ioctl.request_info.sensor_arg;
+        args->ioctl.request_info.lut.rows = sim.mode_rows[mode];
+        args->ioctl.request_info.lut.cols = 1;
+        args->ioctl.request_info.lut.width = sizeof( uint32_t );
+        args->ioctl.request_info.lut.ptr = NULL;
+        return 0;
+    }
+
+    if ( cmd == V4L2_SOC_IQ_IOCTL_REQUEST_DATA ) {
+        uint32_t *data = (uint32_t *)args->ioctl.request_data.ptr;
+        for ( idx = 0; idx < args->ioctl.request_data.data_size / sizeof( uint32_t ); idx++ ) {
+            data[idx] = ( sim.load << 16 ) | args->ioctl.request_data.id;
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+void *sim_kmalloc( size_t size )
+{
+    void *ptr = malloc( size );
+    if ( sim.blocks_num < SIM_MAX_BLOCKS ) {
+        sim.blocks[sim.blocks_num] = ptr;
+        sim.sizes[sim.blocks_num] = size;
+        sim.blocks_num++;
+    }
+    return ptr;
+}
+
+// released memory is poisoned and kept, a set still using it shows up
+void sim_kfree( const void *ptr )
+{
+    uint32_t idx;
+    for ( idx = 0; idx < sim.blocks_num; idx++ ) {
+        if ( sim.blocks[idx] == ptr ) {
+            memset( sim.blocks[idx], 0xa5, sim.sizes[idx] );
+        }
+    }
+    sim.frees++;
+}
+
+static int stage( uint32_t mode )
+{
+    static uint32_t modes[SIM_MODES] = {0, 1, 2};
+
+    sim.load++;
+    memcpy( &staging, &live, sizeof( staging ) );
+    return soc_iq_get_calibrations( 0, &modes[mode], &staging );
+}
+
+static void publish( void )
+{
+    memcpy( &live, &staging, sizeof( live ) );
+    live_load = sim.load;
+}
+
+// every LUT of the set in use still holds the data of its own load
+static void check_live( const char *step )
+{
+    uint32_t idx, i;
+    uint32_t bad = 0;
+
+    for ( idx = 0; idx < CALIBRATION_TOTAL_SIZE; idx++ ) {
+        const LookupTable *lut = live.calibrations[idx];
+        const uint32_t *data = (const uint32_t *)lut->ptr;
+        if ( lut->cols != 1 || lut->width != sizeof( uint32_t ) ) {
+            bad++;
+            continue;
+        }
+        for ( i = 0; i < lut->rows; i++ ) {
+            if ( data[i] != ( ( live_load << 16 ) | idx ) ) {
+                bad++;
+                break;
+            }
+        }
+    }
+
+    CHECK( bad == 0, "%s: %u LUTs of the set in use were overwritten", step, bad );
+}
+
+// the staged set must not share memory with the set in use
+static void check_apart( const char *step )
+{
+    const uint8_t *a = (const uint8_t *)live.calibrations[0];
+    const uint8_t *b = (const uint8_t *)staging.calibrations[0];
+    uint32_t idx;
+    int32_t bank_a = -1, bank_b = -1;
+
+    for ( idx = 0; idx < sim.blocks_num; idx++ ) {
+        const uint8_t *block = (const uint8_t *)sim.blocks[idx];
+        if ( a >= block && a < block + sim.sizes[idx] )
+            bank_a = idx;
+        if ( b >= block && b < block + sim.sizes[idx] )
+            bank_b = idx;
+    }
+
+    CHECK( bank_a >= 0 && bank_b >= 0 && bank_a != bank_b, "%s: staged set shares memory block %d with the set in use", step, bank_b );
+}
+
+int main( int argc, char **argv )
+{
+    memset( &sim, 0, sizeof( sim ) );
+    sim.mode_rows[0] = 4;
+    sim.mode_rows[1] = 8;
+    sim.mode_rows[2] = 16;
+
+    // initial load, published straight away
+    CHECK( stage( 0 ) == 0, "initial load failed" );
+    publish();
+    check_live( "initial" );
+
+    // two restages of the same mode before a frame end
+    CHECK( stage( 0 ) == 0, "first restage failed" );
+    check_live( "first restage" );
+    check_apart( "first restage" );
+    CHECK( stage( 0 ) == 0, "second restage failed" );
+    check_live( "second restage" );
+    check_apart( "second restage" );
+
+    // restages which need a bigger bank, the pending one is reallocated
+    CHECK( stage( 1 ) == 0, "restage to mode 1 failed" );
+    check_live( "restage to mode 1" );
+    CHECK( stage( 2 ) == 0, "restage to mode 2 failed" );
+    check_live( "restage to mode 2" );
+    check_apart( "restage to mode 2" );
+    CHECK( sim.frees > 0, "the pending bank was never reallocated" );
+
+    // the frame end publishes the last staged set
+    publish();
+    check_live( "publish" );
+    CHECK( live.calibrations[0]->rows == sim.mode_rows[2], "published set has %u rows, expected %u", live.calibrations[0]->rows, sim.mode_rows[2] );
+
+    // and the same again with the other bank in use
+    CHECK( stage( 0 ) == 0, "third restage failed" );
+    CHECK( stage( 1 ) == 0, "fourth restage failed" );
+    check_live( "restage after publish" );
+    check_apart( "restage after publish" );
+    publish();
+    check_live( "second publish" );
+
+    printf( "soc_iq_calibrations: %u loads, %u banks allocated, %u released\n", sim.load, sim.blocks_num, sim.frees );
+    printf( "soc_iq_calibrations: %s\n", failures ? "FAILED" : "passed" );
+    return failures;
+}
@@ -0,0 +1,36 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+#ifndef __STUB_LINUX_SLAB_H__
+#define __STUB_LINUX_SLAB_H__
+
+// allocations go through the test so it can see which memory is released
+
+#include <stddef.h>
+
+#define GFP_KERNEL 0
+
+void *sim_kmalloc( size_t size );
+void sim_kfree( const void *ptr );
+#define kmalloc( size, flags ) sim_kmalloc( size )
+#define kfree( ptr ) sim_kfree( ptr )
+
+#endif /* __STUB_LINUX_SLAB_H__ */
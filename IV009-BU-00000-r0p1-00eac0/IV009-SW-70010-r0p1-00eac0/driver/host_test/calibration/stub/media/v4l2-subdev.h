@@ -0,0 +1,32 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+#ifndef __STUB_MEDIA_V4L2_SUBDEV_H__
+#define __STUB_MEDIA_V4L2_SUBDEV_H__
+
+// the IQ subdevice is simulated by the test
+
+struct v4l2_subdev;
+
+long sim_iq_ioctl( struct v4l2_subdev *sd, unsigned int cmd, void *arg );
+#define v4l2_subdev_call( sd, o, f, cmd, arg ) sim_iq_##f( sd, cmd, arg )
+
+#endif /* __STUB_MEDIA_V4L2_SUBDEV_H__ */
@@ -0,0 +1,337 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// Loopback test of the control connection. The buffer manager is replaced by
+// two ring buffers of the size the command queues give it, the client side of
+// the test fills and drains them between acamera_connection_process() polls.
+// Besides the replies the test reports how many polls a transaction costs,
+// with one request in flight and with requests queued back to back.
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "acamera_command_api.h"
+#include "acamera_calibrations.h"
+#include "acamera_connection.h"
+#include "acamera_buffer_manager.h"
+#include "acamera_cmd_queues_config.h"
+#include "application_command_api.h"
+#include "system_hw_io.h"
+#include "system_sw_io.h"
+#include "system_stdlib.h"
+
+#define RING_SIZE ( ( ACAMERA_CMD_QUEUES_SIZE >> 1 ) - 24 ) // data part of one half of the queues
+#define HEADER_SIZE 12
+
+#define TYPE_REG_READ 1
+#define TYPE_BUF_READ_CHUNK 22
+
+// a process loop which wakes once per frame of a 30 fps stream
+#define POLLS_PER_SECOND 30
+
+#define LUT_ID 3
+#define LUT_SIZE 8192
+
+// one direction of the loopback, the writer keeps 4 bytes free like the buffer manager
+typedef struct _ring_t {
+    uint8_t data[RING_SIZE];
+    uint32_t rd, wr;
+} ring_t;
+
+static ring_t rx_ring; // client to firmware
+static ring_t tx_ring; // firmware to client
+
+static uint32_t ring_used( const ring_t *p_ring )
+{
+    return ( p_ring->wr + RING_SIZE - p_ring->rd ) % RING_SIZE;
+}
+
+static int ring_read( ring_t *p_ring, uint8_t *data, int size )
+{
+    int n = 0;
+    while ( n < size && ring_used( p_ring ) ) {
+        data[n++] = p_ring->data[p_ring->rd];
+        p_ring->rd = ( p_ring->rd + 1 ) % RING_SIZE;
+    }
+    return n;
+}
+
+static int ring_write( ring_t *p_ring, const uint8_t *data, int size )
+{
+    int n = 0;
+    while ( n < size && ring_used( p_ring ) < RING_SIZE - 4 ) {
+        p_ring->data[p_ring->wr] = data[n++];
+        p_ring->wr = ( p_ring->wr + 1 ) % RING_SIZE;
+    }
+    return n;
+}
+
+void acamera_buffer_manager_init( acamera_buffer_manager_t *p_ctrl, uint32_t base, uint32_t size )
+{
+    memset( &rx_ring, 0, sizeof( rx_ring ) );
+    memset( &tx_ring, 0, sizeof( tx_ring ) );
+}
+
+int acamera_buffer_manager_read( acamera_buffer_manager_t *p_ctrl, uint8_t *data, int size )
+{
+    return ring_read( &rx_ring, data, size );
+}
+
+int acamera_buffer_manager_write( acamera_buffer_manager_t *p_ctrl, const uint8_t *data, int size )
+{
+    return ring_write( &tx_ring, data, size );
+}
+
+// isp registers read back a pattern, the command queues read as idle
+static uint32_t hw_pattern( uintptr_t addr )
+{
+    if ( addr >= ACAMERA_CMD_QUEUES_BASE_ADDR && addr < ACAMERA_CMD_QUEUES_BASE_ADDR + ACAMERA_CMD_QUEUES_SIZE )
+        return 0;
+    return (uint32_t)addr * 2654435761u;
+}
+
+uint32_t system_hw_read_32( uintptr_t addr ) { return hw_pattern( addr ); }
+void system_hw_write_32( uintptr_t addr, uint32_t data ) {}
+void system_hw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count ) {}
+uint32_t system_sw_read_32( uintptr_t addr ) { return 0; }
+void system_sw_write_32( uintptr_t addr, uint32_t data ) {}
+
+void system_hw_read_block_32( uintptr_t addr, uint32_t *data, uint32_t count )
+{
+    while ( count-- ) {
+        *data++ = hw_pattern( addr );
+        addr += 4;
+    }
+}
+
+int32_t system_memcpy( void *dst, const void *src, uint32_t size )
+{
+    memcpy( dst, src, size );
+    return 0;
+}
+
+void *system_sw_alloc( uint32_t size ) { return malloc( size ); }
+void system_sw_free( void *ptr ) { free( ptr ); }
+
+static uint8_t *lut;
+static acamera_calib_view_t view;
+static int api_ctx;
+
+void *acamera_get_api_ctx_ptr( void ) { return &api_ctx; }
+
+const acamera_calib_view_t *_GET_VIEW( void *p_ctx, uint32_t idx )
+{
+    return idx == LUT_ID ? &view : NULL;
+}
+
+uint8_t application_command( uint8_t command_type, uint8_t command, uint32_t value, uint8_t direction, uint32_t *ret_value )
+{
+    return SUCCESS;
+}
+
+uint8_t application_api_calibration( uint8_t type, uint8_t id, uint8_t direction, void *data, uint32_t data_size, uint32_t *ret_value )
+{
+    return SUCCESS;
+}
+
+// a calibration swap: the set the views pointed to is released
+static void swap_lut( void )
+{
+    uint8_t *next = malloc( LUT_SIZE );
+    memset( next, 0xEE, LUT_SIZE );
+    memset( lut, 0xDD, LUT_SIZE );
+    free( lut );
+    lut = next;
+    view.ptr = lut;
+}
+
+// client side of the loopback
+static uint8_t reply[CONNECTION_BUFFER_SIZE];
+static uint32_t reply_size;
+static uint32_t polls;
+
+static void poll_firmware( void )
+{
+    acamera_connection_process();
+    polls++;
+}
+
+static void send_request( uint32_t id, uint32_t type, const uint32_t *args, uint32_t nargs )
+{
+    uint32_t packet[8];
+    uint32_t i;
+
+    packet[0] = HEADER_SIZE + 4 * nargs;
+    packet[1] = id;
+    packet[2] = type;
+    for ( i = 0; i < nargs; i++ )
+        packet[3 + i] = args[i];
+    CHECK( ring_write( &rx_ring, (const uint8_t *)packet, packet[0] ) == (int)packet[0], "request %u does not fit the queue", id );
+}
+
+// collects a reply, it returns 1 once the reply is complete. Replies are
+// padded to 4 bytes and may take several polls when they exceed the ring.
+static int take_reply( void )
+{
+    uint32_t padded;
+
+    if ( reply_size < 4 )
+        reply_size += ring_read( &tx_ring, reply + reply_size, 4 - reply_size );
+    if ( reply_size < 4 )
+        return 0;
+    padded = ( ( (uint32_t *)reply )[0] + 3 ) & ~3u;
+    if ( padded > sizeof( reply ) ) {
+        CHECK( 0, "reply size %u", ( (uint32_t *)reply )[0] );
+        padded = sizeof( reply );
+    }
+    reply_size += ring_read( &tx_ring, reply + reply_size, padded - reply_size );
+    if ( reply_size < padded )
+        return 0;
+    reply_size = 0;
+    return 1;
+}
+
+static void wait_reply( void )
+{
+    int guard = 1000;
+
+    do {
+        poll_firmware();
+        if ( take_reply() )
+            return;
+    } while ( --guard );
+    CHECK( 0, "no reply" );
+}
+
+static int read_chunk( uint32_t id, uint32_t offset, uint32_t size )
+{
+    uint32_t args[3] = {LUT_ID | ( STATIC_CALIBRATIONS_ID << 8 ), offset, size};
+    memset( reply, 0, sizeof( reply ) );
+    send_request( id, TYPE_BUF_READ_CHUNK, args, 3 );
+    wait_reply();
+    return ( (uint32_t *)reply )[3];
+}
+
+static void test_requests( void )
+{
+    const uint32_t *words = (const uint32_t *)reply;
+    uint32_t args[2] = {0x1000, 64};
+    uint8_t copy[4096];
+    uint32_t i;
+    int ok = 1;
+
+    memset( reply, 0, sizeof( reply ) );
+    send_request( 7, TYPE_REG_READ, args, 2 );
+    wait_reply();
+    CHECK( words[0] == HEADER_SIZE + 4 + 64 && words[1] == 7 && words[3] == SUCCESS, "register read reply %u id %u status %u", words[0], words[1], words[3] );
+    for ( i = 0; i < 16; i++ )
+        ok &= words[4 + i] == hw_pattern( 0x1000 + 4 * i );
+    CHECK( ok, "register read data" );
+
+    CHECK( read_chunk( 8, 100, 256 ) == SUCCESS, "chunk read failed" );
+    CHECK( words[0] == HEADER_SIZE + 8 + 256 && words[1] == 8 && words[4] == LUT_SIZE, "chunk reply size %u id %u total %u", words[0], words[1], words[4] );
+    CHECK( memcmp( reply + HEADER_SIZE + 8, lut + 100, 256 ) == 0, "chunk data" );
+
+    CHECK( read_chunk( 9, LUT_SIZE - 16, 32 ) == FAIL, "chunk past the buffer end accepted" );
+    CHECK( words[0] == HEADER_SIZE + 8 && words[4] == LUT_SIZE, "failed chunk reply size %u total %u", words[0], words[4] );
+    CHECK( read_chunk( 10, 0, CONNECTION_BUFFER_SIZE ) == FAIL || LUT_SIZE < CONNECTION_BUFFER_SIZE, "chunk larger than the connection buffer accepted" );
+
+    // the chunk is taken when the request is accepted, a swap while the reply is sent does not change it
+    memcpy( copy, lut, sizeof( copy ) );
+    {
+        uint32_t chunk_args[3] = {LUT_ID | ( STATIC_CALIBRATIONS_ID << 8 ), 0, sizeof( copy )};
+        memset( reply, 0, sizeof( reply ) );
+        send_request( 11, TYPE_BUF_READ_CHUNK, chunk_args, 3 );
+        poll_firmware();
+        CHECK( ring_used( &tx_ring ) > 0 && ring_used( &tx_ring ) < sizeof( copy ), "chunk reply was not split across polls" );
+        swap_lut();
+        wait_reply();
+        CHECK( words[1] == 11 && words[3] == SUCCESS, "chunk reply across a swap: id %u status %u", words[1], words[3] );
+        CHECK( memcmp( reply + HEADER_SIZE + 8, copy, sizeof( copy ) ) == 0, "chunk changed by a calibration swap" );
+    }
+}
+
+// transactions of 64 byte register reads with up to depth requests queued
+static double polls_per_transaction( uint32_t count, uint32_t depth, double *p_seconds )
+{
+    uint32_t args[2] = {0x2000, 64};
+    uint32_t sent = 0, done = 0, next_id = 1000;
+    uint32_t start_polls = polls;
+    double start = now_s();
+
+    while ( done < count ) {
+        while ( sent < count && sent - done < depth ) {
+            send_request( next_id + sent, TYPE_REG_READ, args, 2 );
+            sent++;
+        }
+        poll_firmware();
+        while ( take_reply() ) {
+            CHECK( ( (uint32_t *)reply )[1] == next_id + done, "reply %u out of order", ( (uint32_t *)reply )[1] );
+            done++;
+        }
+    }
+
+    *p_seconds = now_s() - start;
+    return (double)( polls - start_polls ) / count;
+}
+
+static void test_throughput( int bench )
+{
+    const uint32_t count = 20000;
+    double one_s, queued_s;
+    double one = polls_per_transaction( count, 1, &one_s );
+    double queued = polls_per_transaction( count, 8, &queued_s );
+
+    CHECK( one <= 1.0, "%.2f polls per transaction with one request in flight", one );
+    CHECK( queued <= 0.3, "%.2f polls per transaction with requests queued", queued );
+
+    // the connection is polled once per pass of the process loop, when the
+    // loop sleeps until the next frame the poll rate rather than the cpu
+    // bounds the transactions
+    printf( "register reads: %.2f polls per transaction one at a time, %.2f queued\n", one, queued );
+    printf( "at %d polls/s: %.0f transactions/s one at a time, %.0f queued\n", POLLS_PER_SECOND, POLLS_PER_SECOND / one, POLLS_PER_SECOND / queued );
+    if ( bench )
+        printf( "loopback: %.0f transactions/s one at a time, %.0f queued (host cpu, no bus time)\n", count / one_s, count / queued_s );
+}
+
+int main( int argc, char **argv )
+{
+    uint32_t i;
+
+    lut = malloc( LUT_SIZE );
+    for ( i = 0; i < LUT_SIZE; i++ )
+        lut[i] = (uint8_t)rng();
+    view.ptr = lut;
+    view.rows = 1;
+    view.cols = LUT_SIZE;
+    view.len = LUT_SIZE;
+    view.width = 1;
+
+    acamera_connection_init();
+
+    test_requests();
+    test_throughput( bench_enabled( argc, argv ) );
+
+    acamera_connection_destroy();
+    free( lut );
+
+    printf( "acamera_connection: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#include "crop_cfg_ref.h"
+
+static int ref_crop_cfg_key_equal( const crop_cfg_key_t *p_a, const crop_cfg_key_t *p_b )
+{
+    return p_a->in_width == p_b->in_width && p_a->in_height == p_b->in_height &&
+           p_a->crop_xoffset == p_b->crop_xoffset && p_a->crop_yoffset == p_b->crop_yoffset &&
+           p_a->crop_xsize == p_b->crop_xsize && p_a->crop_ysize == p_b->crop_ysize &&
+           p_a->out_xsize == p_b->out_xsize && p_a->out_ysize == p_b->out_ysize &&
+           p_a->crop_enable == p_b->crop_enable && p_a->scaler_enable == p_b->scaler_enable;
+}
+
+const crop_cfg_t *ref_crop_cfg_get( ref_crop_cfg_cache_t *p_cache, const crop_cfg_key_t *p_key )
+{
+    crop_cfg_t *p_cfg;
+    uint32_t i;
+    uint32_t idx = p_cache->last;
+
+    for ( i = 0; i < CROP_CFG_CACHE_SIZE; i++ ) {
+        p_cfg = &p_cache->entry[idx];
+        if ( p_cfg->valid && ref_crop_cfg_key_equal( &p_cfg->key, p_key ) ) {
+            p_cache->last = idx;
+            return p_cfg;
+        }
+        idx = ( idx + 1 ) % CROP_CFG_CACHE_SIZE;
+    }
+
+    idx = p_cache->next;
+    p_cache->next = ( idx + 1 ) % CROP_CFG_CACHE_SIZE;
+    p_cache->last = idx;
+
+    p_cfg = &p_cache->entry[idx];
+    p_cfg->key = *p_key;
+    crop_cfg_compute( p_cfg );
+
+    return p_cfg;
+}
@@ -0,0 +1,38 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#ifndef __CROP_CFG_REF_H__
+#define __CROP_CFG_REF_H__
+
+// Previous crop configuration cache: a linear scan comparing the full key
+// from the last used entry, with round robin eviction. The host test
+// measures the hashed cache against it.
+
+#include "crop_cfg.h"
+
+typedef struct _ref_crop_cfg_cache_t {
+    crop_cfg_t entry[CROP_CFG_CACHE_SIZE];
+    uint8_t last;
+    uint8_t next;
+} ref_crop_cfg_cache_t;
+
+const crop_cfg_t *ref_crop_cfg_get( ref_crop_cfg_cache_t *p_cache, const crop_cfg_key_t *p_key );
+
+#endif /* __CROP_CFG_REF_H__ */
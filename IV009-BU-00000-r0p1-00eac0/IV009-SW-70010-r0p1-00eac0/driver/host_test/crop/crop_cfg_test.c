@@ -0,0 +1,263 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+// Host test of the crop and scaler configuration cache.
+// Checks every cached entry against a direct computation and reports the
+// per-frame cost of a zoom ramp with and without the cache, next to the
+// previous 32-entry linear scan.
+
+#include "host_test.h"
+#include "crop_cfg.h"
+#include "crop_cfg_ref.h"
+
+#define IN_WIDTH 1920
+#define IN_HEIGHT 1080
+#define RAMP_FRAMES 30
+
+static void key_init( crop_cfg_key_t *p_key )
+{
+    memset( p_key, 0, sizeof( *p_key ) );
+    p_key->in_width = IN_WIDTH;
+    p_key->in_height = IN_HEIGHT;
+    p_key->crop_enable = 1;
+    p_key->scaler_enable = 1;
+}
+
+// DS output ramp from 1920x1080 down to 960x540 with the crop fixed,
+// successive keys differ only in their last fields
+static void scale_key( crop_cfg_key_t *p_key, uint32_t frame )
+{
+    key_init( p_key );
+    p_key->crop_xsize = IN_WIDTH;
+    p_key->crop_ysize = IN_HEIGHT;
+    p_key->out_xsize = IN_WIDTH - ( IN_WIDTH / 2 ) * frame / ( RAMP_FRAMES - 1 );
+    p_key->out_ysize = IN_HEIGHT - ( IN_HEIGHT / 2 ) * frame / ( RAMP_FRAMES - 1 );
+}
+
+// DS zoom from the full input to its centre half, scaled to 1280x720
+static void ramp_key( crop_cfg_key_t *p_key, uint32_t frame )
+{
+    key_init( p_key );
+    p_key->crop_xsize = IN_WIDTH - ( IN_WIDTH / 2 ) * frame / ( RAMP_FRAMES - 1 );
+    p_key->crop_ysize = IN_HEIGHT - ( IN_HEIGHT / 2 ) * frame / ( RAMP_FRAMES - 1 );
+    p_key->crop_xoffset = ( IN_WIDTH - p_key->crop_xsize ) / 2;
+    p_key->crop_yoffset = ( IN_HEIGHT - p_key->crop_ysize ) / 2;
+    p_key->out_xsize = 1280;
+    p_key->out_ysize = 720;
+}
+
+static void random_key( crop_cfg_key_t *p_key )
+{
+    key_init( p_key );
+    p_key->crop_enable = rng() & 1;
+    p_key->scaler_enable = rng() & 1;
+    p_key->crop_xoffset = rng() % IN_WIDTH;
+    p_key->crop_yoffset = rng() % IN_HEIGHT;
+    p_key->crop_xsize = 1 + rng() % IN_WIDTH;
+    p_key->crop_ysize = 1 + rng() % IN_HEIGHT;
+    p_key->out_xsize = rng() % IN_WIDTH;
+    p_key->out_ysize = rng() % IN_HEIGHT;
+}
+
+static int cfg_equal( const crop_cfg_t *p_a, const crop_cfg_t *p_b )
+{
+    return p_a->scaler_valid == p_b->scaler_valid &&
+           p_a->crop_xoffset == p_b->crop_xoffset && p_a->crop_yoffset == p_b->crop_yoffset &&
+           p_a->crop_xsize == p_b->crop_xsize && p_a->crop_ysize == p_b->crop_ysize &&
+           p_a->scaler_width == p_b->scaler_width && p_a->scaler_height == p_b->scaler_height &&
+           p_a->out_xsize == p_b->out_xsize && p_a->out_ysize == p_b->out_ysize &&
+           p_a->width == p_b->width && p_a->height == p_b->height &&
+           ( !p_a->scaler_valid || ( p_a->hfilt_tinc == p_b->hfilt_tinc && p_a->vfilt_tinc == p_b->vfilt_tinc &&
+                                     p_a->hfilt_coefset == p_b->hfilt_coefset && p_a->vfilt_coefset == p_b->vfilt_coefset ) );
+}
+
+static crop_cfg_cache_t cache;
+
+static void test_lookup( void )
+{
+    crop_cfg_key_t keys[64];
+    uint32_t mismatch = 0;
+    uint32_t i, pass;
+
+    crop_cfg_cache_reset( &cache );
+    for ( i = 0; i < 64; i++ ) {
+        random_key( &keys[i] );
+    }
+
+    // twice the cache size, every lookup has to return the entry for its key
+    for ( pass = 0; pass < 4; pass++ ) {
+        for ( i = 0; i < 64; i++ ) {
+            const crop_cfg_t *p_cfg = crop_cfg_get( &cache, &keys[i] );
+            crop_cfg_t expected;
+
+            expected.key = keys[i];
+            crop_cfg_compute( &expected );
+            mismatch += memcmp( &p_cfg->key, &keys[i], sizeof( keys[i] ) ) != 0 || !cfg_equal( p_cfg, &expected );
+        }
+    }
+    CHECK( mismatch == 0, "cache lookup: %u entries differ from a direct computation", mismatch );
+
+    // a repeated key is a hit
+    crop_cfg_cache_reset( &cache );
+    crop_cfg_get( &cache, &keys[0] );
+    crop_cfg_get( &cache, &keys[0] );
+    CHECK( cache.hits == 1 && cache.misses == 1, "repeated key: %u hits, %u misses", cache.hits, cache.misses );
+
+    // a preloaded ramp is all hits on the frame path
+    crop_cfg_cache_reset( &cache );
+    for ( i = 0; i < RAMP_FRAMES; i++ ) {
+        crop_cfg_key_t key;
+        ramp_key( &key, i );
+        crop_cfg_get( &cache, &key );
+    }
+    cache.hits = cache.misses = 0;
+    for ( i = 0; i < RAMP_FRAMES; i++ ) {
+        crop_cfg_key_t key;
+        ramp_key( &key, i );
+        crop_cfg_get( &cache, &key );
+    }
+    printf( "preloaded zoom ramp of %d frames: %u hits, %u misses\n", RAMP_FRAMES, cache.hits, cache.misses );
+    CHECK( cache.misses == 0, "preloaded zoom ramp: %u of %d frames missed", cache.misses, RAMP_FRAMES );
+
+    // configurations computed outside of the cache and put into it are hits
+    // on the frame path, putting a cached key again does not add an entry
+    crop_cfg_cache_reset( &cache );
+    for ( pass = 0; pass < 2; pass++ ) {
+        for ( i = 0; i < RAMP_FRAMES; i++ ) {
+            crop_cfg_t cfg;
+            ramp_key( &cfg.key, i );
+            crop_cfg_compute( &cfg );
+            crop_cfg_put( &cache, &cfg );
+        }
+    }
+    CHECK( cache.next == RAMP_FRAMES && cache.hits == 0 && cache.misses == 0, "put ramp: next %u, %u hits, %u misses", cache.next, cache.hits, cache.misses );
+    mismatch = 0;
+    for ( i = 0; i < RAMP_FRAMES; i++ ) {
+        crop_cfg_key_t key;
+        crop_cfg_t expected;
+        ramp_key( &key, i );
+        expected.key = key;
+        crop_cfg_compute( &expected );
+        mismatch += !cfg_equal( crop_cfg_get( &cache, &key ), &expected );
+    }
+    CHECK( mismatch == 0 && cache.misses == 0, "put ramp: %u entries differ, %u of %d frames missed", mismatch, cache.misses, RAMP_FRAMES );
+}
+
+#define BENCH_RAMPS 100000
+#define BENCH_REPEATS 5
+
+// best of BENCH_REPEATS runs, the setup is done before each run
+#define BENCH_RAMP( name, setup, lookup )                                                    \
+    do {                                                                                     \
+        volatile uint32_t sink = 0;                                                          \
+        double best = 0;                                                                     \
+        uint32_t k, r, f;                                                                    \
+        for ( k = 0; k < BENCH_REPEATS; k++ ) {                                              \
+            double t0;                                                                       \
+            setup;                                                                           \
+            t0 = now_s();                                                                    \
+            for ( r = 0; r < BENCH_RAMPS; r++ ) {                                            \
+                for ( f = 0; f < RAMP_FRAMES; f++ ) {                                        \
+                    sink += ( lookup );                                                      \
+                }                                                                            \
+            }                                                                                \
+            t0 = now_s() - t0;                                                               \
+            if ( k == 0 || t0 < best )                                                       \
+                best = t0;                                                                   \
+        }                                                                                    \
+        printf( "  %-44s %6.1f ns/frame\n", name, best * 1e9 / ( BENCH_RAMPS * RAMP_FRAMES ) ); \
+        (void)sink;                                                                          \
+    } while ( 0 )
+
+static crop_cfg_t scratch;
+static ref_crop_cfg_cache_t ref_cache;
+
+static uint32_t compute_key( const crop_cfg_key_t *p_key )
+{
+    scratch.key = *p_key;
+    crop_cfg_compute( &scratch );
+    return scratch.hfilt_tinc;
+}
+
+// the other outputs cached before the ramp, the previous cache scans past them
+static void fill_cache( void )
+{
+    uint32_t i;
+
+    crop_cfg_cache_reset( &cache );
+    for ( i = 0; i < CROP_CFG_CACHE_SIZE; i++ ) {
+        crop_cfg_key_t key;
+        random_key( &key );
+        crop_cfg_get( &cache, &key );
+    }
+}
+
+static void fill_ref_cache( void )
+{
+    uint32_t i;
+
+    memset( &ref_cache, 0, sizeof( ref_cache ) );
+    for ( i = 0; i < CROP_CFG_CACHE_SIZE; i++ ) {
+        crop_cfg_key_t key;
+        random_key( &key );
+        ref_crop_cfg_get( &ref_cache, &key );
+    }
+}
+
+// A forward ramp hits the entry after the last one. Stepping by 7 frames
+// makes every lookup search the cache, as after a jump on the zoom path.
+#define JUMP( f ) ( ( ( f ) * 7 ) % RAMP_FRAMES )
+
+static void bench( void )
+{
+    crop_cfg_key_t ramp[RAMP_FRAMES];
+    crop_cfg_key_t scale[RAMP_FRAMES];
+    uint32_t f;
+
+    for ( f = 0; f < RAMP_FRAMES; f++ ) {
+        ramp_key( &ramp[f], f );
+        scale_key( &scale[f], f );
+    }
+
+    printf( "zoom ramp cost, %d frames repeated:\n", RAMP_FRAMES );
+    BENCH_RAMP( "compute every frame", , compute_key( &ramp[f] ) );
+    BENCH_RAMP( "previous cache, static crop", memset( &ref_cache, 0, sizeof( ref_cache ) ), ref_crop_cfg_get( &ref_cache, &ramp[0] )->hfilt_tinc );
+    BENCH_RAMP( "hashed cache, static crop", crop_cfg_cache_reset( &cache ), crop_cfg_get( &cache, &ramp[0] )->hfilt_tinc );
+    BENCH_RAMP( "previous cache, forward crop ramp", memset( &ref_cache, 0, sizeof( ref_cache ) ), ref_crop_cfg_get( &ref_cache, &ramp[f] )->hfilt_tinc );
+    BENCH_RAMP( "hashed cache, forward crop ramp", crop_cfg_cache_reset( &cache ), crop_cfg_get( &cache, &ramp[f] )->hfilt_tinc );
+    BENCH_RAMP( "previous cache, crop ramp with jumps", memset( &ref_cache, 0, sizeof( ref_cache ) ), ref_crop_cfg_get( &ref_cache, &ramp[JUMP( f )] )->hfilt_tinc );
+    BENCH_RAMP( "hashed cache, crop ramp with jumps", crop_cfg_cache_reset( &cache ), crop_cfg_get( &cache, &ramp[JUMP( f )] )->hfilt_tinc );
+    BENCH_RAMP( "previous cache, scaler ramp with jumps", memset( &ref_cache, 0, sizeof( ref_cache ) ), ref_crop_cfg_get( &ref_cache, &scale[JUMP( f )] )->hfilt_tinc );
+    BENCH_RAMP( "hashed cache, scaler ramp with jumps", crop_cfg_cache_reset( &cache ), crop_cfg_get( &cache, &scale[JUMP( f )] )->hfilt_tinc );
+    BENCH_RAMP( "previous cache, miss on a full cache", fill_ref_cache(), ref_crop_cfg_get( &ref_cache, &ramp[f] )->hfilt_tinc + ( ref_cache.entry[ref_cache.last].valid = 0 ) );
+    BENCH_RAMP( "hashed cache, miss on a full cache", fill_cache(), crop_cfg_get( &cache, &ramp[f] )->hfilt_tinc + ( cache.hash[cache.last] = 0 ) + ( cache.entry[cache.last].valid = 0 ) );
+}
+
+int main( int argc, char **argv )
+{
+    test_lookup();
+
+    if ( bench_enabled( argc, argv ) ) {
+        bench();
+    }
+
+    printf( "crop_cfg: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,200 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+// Host test of the per-frame crop trajectories.
+// Runs trajectories frame by frame and checks every window against the
+// rounded linear interpolation of its segment, the keyframe hits at the
+// segment ends and the keyframe validation.
+
+#include <math.h>
+#include "host_test.h"
+#include "crop_cfg.h"
+
+#define IN_WIDTH 1920
+#define IN_HEIGHT 1080
+
+static void window_set( acamera_crop_window_t *p_window, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t ow, uint16_t oh )
+{
+    p_window->xoffset = x;
+    p_window->yoffset = y;
+    p_window->xsize = w;
+    p_window->ysize = h;
+    p_window->out_xsize = ow;
+    p_window->out_ysize = oh;
+}
+
+static int window_equal( const acamera_crop_window_t *p_a, const acamera_crop_window_t *p_b )
+{
+    return memcmp( p_a, p_b, sizeof( *p_a ) ) == 0;
+}
+
+// rounded half away from zero like the firmware
+static uint16_t expected_lerp( uint16_t from, uint16_t to, uint32_t step, uint32_t frames )
+{
+    double offset = ( (double)to - from ) * step / frames;
+    return (uint16_t)( from + ( offset >= 0 ? floor( offset + 0.5 ) : -floor( -offset + 0.5 ) ) );
+}
+
+static void expected_window( const acamera_crop_window_t *p_from, const acamera_crop_window_t *p_to, uint32_t step, uint32_t frames, acamera_crop_window_t *p_window )
+{
+    p_window->xoffset = expected_lerp( p_from->xoffset, p_to->xoffset, step, frames );
+    p_window->yoffset = expected_lerp( p_from->yoffset, p_to->yoffset, step, frames );
+    p_window->xsize = expected_lerp( p_from->xsize, p_to->xsize, step, frames );
+    p_window->ysize = expected_lerp( p_from->ysize, p_to->ysize, step, frames );
+    p_window->out_xsize = expected_lerp( p_from->out_xsize, p_to->out_xsize, step, frames );
+    p_window->out_ysize = expected_lerp( p_from->out_ysize, p_to->out_ysize, step, frames );
+}
+
+// Runs the trajectory to its end, one step per frame, and checks each window.
+// Returns the number of frames the trajectory took.
+static uint32_t run_and_check( const acamera_crop_keyframe_t *p_keys, uint8_t count, const char *name )
+{
+    crop_trajectory_t traj;
+    acamera_crop_window_t window, expected;
+    uint32_t frame = 0, mismatch = 0, invalid = 0;
+    uint32_t segment = 0, step = 0;
+
+    crop_trajectory_load( &traj, p_keys, count );
+    while ( traj.active && frame < 100000 ) {
+        crop_trajectory_step( &traj, &window );
+
+        if ( frame == 0 ) {
+            expected = p_keys[0].window;
+        } else {
+            if ( step == p_keys[segment + 1].frames ) {
+                segment++;
+                step = 0;
+            }
+            step++;
+            expected_window( &p_keys[segment].window, &p_keys[segment + 1].window, step, p_keys[segment + 1].frames, &expected );
+            // every segment ends on its keyframe
+            if ( step == p_keys[segment + 1].frames && !window_equal( &window, &p_keys[segment + 1].window ) ) {
+                mismatch++;
+            }
+        }
+        if ( !window_equal( &window, &expected ) ) {
+            if ( mismatch++ == 0 ) {
+                printf( "  %s frame %u: got %u,%u %ux%u -> %ux%u, expected %u,%u %ux%u -> %ux%u\n", name, frame,
+                        window.xoffset, window.yoffset, window.xsize, window.ysize, window.out_xsize, window.out_ysize,
+                        expected.xoffset, expected.yoffset, expected.xsize, expected.ysize, expected.out_xsize, expected.out_ysize );
+            }
+        }
+
+        // a window between two valid keyframes is valid as well
+        {
+            acamera_crop_keyframe_t key = {window, 0};
+            invalid += !crop_keyframe_valid( &key, 0, IN_WIDTH, IN_HEIGHT, 1 );
+        }
+        frame++;
+    }
+
+    CHECK( mismatch == 0, "%s: %u frames differ from the interpolated path", name, mismatch );
+    CHECK( invalid == 0, "%s: %u interpolated windows are not valid", name, invalid );
+    return frame;
+}
+
+static void test_paths( void )
+{
+    acamera_crop_keyframe_t keys[CROP_TRAJECTORY_MAX_KEYFRAMES];
+    uint32_t frames, total, i;
+    int k;
+
+    // 2x zoom into the centre over 30 frames, the scaler output is fixed
+    window_set( &keys[0].window, 0, 0, 1920, 1080, 1280, 720 );
+    window_set( &keys[1].window, 480, 270, 960, 540, 960, 540 );
+    keys[1].frames = 30;
+    frames = run_and_check( keys, 2, "zoom in" );
+    CHECK( frames == 31, "zoom in: %u frames, expected the start window and 30 steps", frames );
+
+    // the same zoom out again
+    keys[0].window = keys[1].window;
+    window_set( &keys[1].window, 0, 0, 1920, 1080, 1280, 720 );
+    frames = run_and_check( keys, 2, "zoom out" );
+    CHECK( frames == 31, "zoom out: %u frames", frames );
+
+    // three segments with different lengths, including a one frame jump
+    window_set( &keys[0].window, 0, 0, 1920, 1080, 1920, 1080 );
+    window_set( &keys[1].window, 100, 50, 1000, 600, 640, 360 );
+    keys[1].frames = 7;
+    window_set( &keys[2].window, 101, 49, 999, 601, 641, 359 );
+    keys[2].frames = 1;
+    window_set( &keys[3].window, 900, 500, 1020, 580, 320, 180 );
+    keys[3].frames = 13;
+    frames = run_and_check( keys, 4, "segments" );
+    CHECK( frames == 1 + 7 + 1 + 13, "segments: %u frames", frames );
+
+    // a single keyframe is applied on the next frame only
+    frames = run_and_check( keys, 1, "jump" );
+    CHECK( frames == 1, "jump: %u frames", frames );
+
+    // random trajectories of valid keyframes
+    total = 0;
+    for ( i = 0; i < 2000; i++ ) {
+        uint8_t count = 1 + rng() % CROP_TRAJECTORY_MAX_KEYFRAMES;
+        for ( k = 0; k < count; k++ ) {
+            do {
+                uint16_t w = 16 + rng() % ( IN_WIDTH - 16 );
+                uint16_t h = 16 + rng() % ( IN_HEIGHT - 16 );
+                window_set( &keys[k].window, rng() % ( IN_WIDTH - w + 1 ), rng() % ( IN_HEIGHT - h + 1 ), w, h, 1 + rng() % w, 1 + rng() % h );
+                keys[k].frames = 1 + rng() % 120;
+            } while ( !crop_keyframe_valid( &keys[k], k, IN_WIDTH, IN_HEIGHT, 1 ) );
+        }
+        total += run_and_check( keys, count, "random" );
+    }
+    printf( "2000 random trajectories, %u frames checked\n", total );
+}
+
+static void test_validation( void )
+{
+    acamera_crop_keyframe_t key;
+
+    window_set( &key.window, 0, 0, 1920, 1080, 1280, 720 );
+    key.frames = 0;
+    CHECK( crop_keyframe_valid( &key, 0, IN_WIDTH, IN_HEIGHT, 1 ), "full window rejected" );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "later keyframe with 0 frames accepted" );
+
+    key.frames = 10;
+    window_set( &key.window, 1, 0, 1920, 1080, 1280, 720 );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "window past the right edge accepted" );
+    window_set( &key.window, 0, 0, 0, 1080, 1280, 720 );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "empty window accepted" );
+    window_set( &key.window, 0xFFFF, 0, 2, 1080, 1, 720 );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "16-bit offset overflow accepted" );
+
+    // output sizes matter with the scaler only
+    window_set( &key.window, 0, 0, 1920, 1080, 0, 0 );
+    CHECK( crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 0 ), "zero output size rejected without the scaler" );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "zero output size accepted" );
+    window_set( &key.window, 0, 0, 960, 540, 961, 540 );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "upscaling accepted" );
+    window_set( &key.window, 0, 0, 1920, 1080, 120, 68 );
+    CHECK( !crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "16x downscaling accepted" );
+    window_set( &key.window, 0, 0, 1920, 1080, 121, 68 );
+    CHECK( crop_keyframe_valid( &key, 1, IN_WIDTH, IN_HEIGHT, 1 ), "downscaling below 16x rejected" );
+}
+
+int main( int argc, char **argv )
+{
+    test_paths();
+    test_validation();
+
+    printf( "crop_trajectory: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#ifndef __STUB_LINUX_KERNEL_H__
+#define __STUB_LINUX_KERNEL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define container_of( ptr, type, member ) ( (type *)( (char *)( ptr ) - offsetof( type, member ) ) )
+
+#endif /* __STUB_LINUX_KERNEL_H__ */
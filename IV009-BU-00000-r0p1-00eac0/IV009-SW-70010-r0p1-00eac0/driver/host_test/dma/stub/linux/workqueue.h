@@ -0,0 +1,80 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#ifndef __STUB_LINUX_WORKQUEUE_H__
+#define __STUB_LINUX_WORKQUEUE_H__
+
+// Work items run one at a time on a worker thread of the test, which can hold
+// the queue to keep an item pending. Completions, spinlocks and atomics come
+// in through this header in the kernel as well.
+
+#include <stdint.h>
+#include <pthread.h>
+
+struct work_struct;
+typedef void ( *work_func_t )( struct work_struct *work );
+
+struct work_struct {
+    work_func_t func;
+    volatile int pending;
+    struct work_struct *next;
+};
+
+struct workqueue_struct;
+extern struct workqueue_struct *system_highpri_wq;
+
+#define INIT_WORK( w, f )     \
+    do {                      \
+        ( w )->func = ( f );  \
+        ( w )->pending = 0;   \
+        ( w )->next = NULL;   \
+    } while ( 0 )
+
+int queue_work( struct workqueue_struct *wq, struct work_struct *work );
+int cancel_work_sync( struct work_struct *work );
+#define work_pending( w ) ( ( w )->pending )
+
+struct completion {
+    volatile int done;
+};
+
+void init_completion( struct completion *comp );
+void complete( struct completion *comp );
+void wait_for_completion( struct completion *comp );
+
+// the test runs on any number of cpus, a spinning holder could be preempted
+typedef struct {
+    pthread_mutex_t mutex;
+} spinlock_t;
+
+void spin_lock_init( spinlock_t *lock );
+unsigned long sim_spin_lock( spinlock_t *lock );
+void sim_spin_unlock( spinlock_t *lock );
+#define spin_lock_irqsave( lock, flags ) ( ( flags ) = sim_spin_lock( lock ) )
+#define spin_unlock_irqrestore( lock, flags ) ( (void)( flags ), sim_spin_unlock( lock ) )
+
+typedef struct {
+    volatile int counter;
+} atomic_t;
+
+#define atomic_set( a, v ) __atomic_store_n( &( a )->counter, ( v ), __ATOMIC_SEQ_CST )
+#define atomic_inc_return( a ) __atomic_add_fetch( &( a )->counter, 1, __ATOMIC_SEQ_CST )
+
+#endif /* __STUB_LINUX_WORKQUEUE_H__ */
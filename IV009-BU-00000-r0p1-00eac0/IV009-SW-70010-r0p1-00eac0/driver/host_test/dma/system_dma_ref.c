@@ -0,0 +1,170 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#include <linux/kernel.h>
+#include <linux/slab.h>
+#include <linux/interrupt.h>
+#include <asm/io.h>
+#include "acamera_logger.h"
+#include "system_dma_ref.h"
+
+#define SYSTEM_DMA_TOGGLE_COUNT 2
+#define SYSTEM_DMA_MAX_CHANNEL 2
+
+typedef struct {
+    void *dev_addr;
+    void *fw_addr;
+    size_t size;
+    void *sys_back_ptr;
+} mem_addr_pair_t;
+
+typedef struct {
+    struct tasklet_struct m_task;
+    mem_addr_pair_t *mem_data;
+} mem_tasklet_t;
+
+typedef struct {
+    unsigned int sg_device_nents[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
+    unsigned int sg_fwmem_nents[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
+    mem_addr_pair_t *mem_addrs[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
+    mem_tasklet_t task_list[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT][SYSTEM_DMA_MAX_CHANNEL];
+
+    int32_t buff_loc;
+    uint32_t direction;
+    uint32_t cur_fw_ctx_id;
+
+    dma_completion_callback complete_func;
+    atomic_t nents_done;
+    struct completion comp;
+} system_dma_device_t;
+
+int32_t ref_system_dma_init( void **ctx )
+{
+    *ctx = calloc( 1, sizeof( system_dma_device_t ) );
+    return *ctx ? 0 : -1;
+}
+
+int32_t ref_system_dma_destroy( void *ctx )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int32_t idx, i;
+
+    for ( idx = 0; idx < FIRMWARE_CONTEXT_NUMBER; idx++ ) {
+        for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ ) {
+            kfree( system_dma_device->mem_addrs[idx][i] );
+        }
+    }
+    kfree( ctx );
+    return 0;
+}
+
+static void dma_complete_func( void *ctx )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+
+    unsigned int nents_done = atomic_inc_return( &system_dma_device->nents_done );
+    if ( nents_done >= system_dma_device->sg_device_nents[system_dma_device->cur_fw_ctx_id][system_dma_device->buff_loc] ) {
+        if ( system_dma_device->complete_func ) {
+            system_dma_device->complete_func( ctx );
+        } else {
+            complete( &system_dma_device->comp );
+        }
+    }
+}
+
+int32_t ref_system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t *device_addr_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int i;
+
+    system_dma_device->sg_device_nents[fw_ctx_id][buff_loc] = addr_pairs;
+    if ( !system_dma_device->mem_addrs[fw_ctx_id][buff_loc] )
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc] = kmalloc( sizeof( mem_addr_pair_t ) * SYSTEM_DMA_MAX_CHANNEL, GFP_KERNEL );
+
+    for ( i = 0; i < addr_pairs; i++ ) {
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i].dev_addr = ioremap( device_addr_pair[i].address, device_addr_pair[i].size );
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i].size = device_addr_pair[i].size;
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i].sys_back_ptr = ctx;
+    }
+    return 0;
+}
+
+int32_t ref_system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_t *fwmem_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int i;
+
+    system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] = addr_pairs;
+    if ( !system_dma_device->mem_addrs[fw_ctx_id][buff_loc] )
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc] = kmalloc( sizeof( mem_addr_pair_t ) * SYSTEM_DMA_MAX_CHANNEL, GFP_KERNEL );
+
+    for ( i = 0; i < addr_pairs; i++ ) {
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i].fw_addr = fwmem_pair[i].address;
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i].size = fwmem_pair[i].size;
+        system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i].sys_back_ptr = ctx;
+    }
+    return 0;
+}
+
+static void memcopy_func( unsigned long p_task )
+{
+    mem_tasklet_t *mem_task = (mem_tasklet_t *)p_task;
+    mem_addr_pair_t *mem_addr = (mem_addr_pair_t *)mem_task->mem_data;
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)mem_addr->sys_back_ptr;
+
+    if ( system_dma_device->direction == SYS_DMA_TO_DEVICE ) {
+        memcpy( mem_addr->dev_addr, mem_addr->fw_addr, mem_addr->size );
+    } else {
+        memcpy( mem_addr->fw_addr, mem_addr->dev_addr, mem_addr->size );
+    }
+
+    dma_complete_func( mem_addr->sys_back_ptr );
+}
+
+int32_t ref_system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma_completion_callback complete_func, uint32_t fw_ctx_id )
+{
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
+    int32_t i;
+
+    system_dma_device->cur_fw_ctx_id = fw_ctx_id;
+
+    atomic_set( &system_dma_device->nents_done, 0 );
+    if ( complete_func == NULL ) {
+        system_dma_device->complete_func = NULL;
+        init_completion( &system_dma_device->comp );
+    } else {
+        system_dma_device->complete_func = complete_func;
+    }
+    system_dma_device->direction = direction;
+    system_dma_device->buff_loc = buff_loc;
+
+    for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
+        system_dma_device->task_list[fw_ctx_id][buff_loc][i].mem_data = &( system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i] );
+        system_dma_device->task_list[fw_ctx_id][buff_loc][i].m_task.data = (unsigned long)&system_dma_device->task_list[fw_ctx_id][buff_loc][i];
+        system_dma_device->task_list[fw_ctx_id][buff_loc][i].m_task.func = memcopy_func;
+        tasklet_schedule( &system_dma_device->task_list[fw_ctx_id][buff_loc][i].m_task );
+    }
+
+    if ( complete_func == NULL ) {
+        wait_for_completion( &system_dma_device->comp );
+    }
+
+    return 0;
+}
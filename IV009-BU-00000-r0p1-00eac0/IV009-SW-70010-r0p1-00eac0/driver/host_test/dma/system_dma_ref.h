@@ -0,0 +1,36 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#ifndef __SYSTEM_DMA_REF_H__
+#define __SYSTEM_DMA_REF_H__
+
+// Previous memcpy fallback of the kernel DMA layer: one tasklet per entry of
+// a buffer and the transfer parameters kept in the device. The host test
+// measures the work item per buffer against it.
+
+#include "system_dma.h"
+
+int32_t ref_system_dma_init( void **ctx );
+int32_t ref_system_dma_destroy( void *ctx );
+int32_t ref_system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t *device_addr_pair, int32_t addr_pairs, uint32_t fw_ctx_id );
+int32_t ref_system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_t *fwmem_pair, int32_t addr_pairs, uint32_t fw_ctx_id );
+int32_t ref_system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma_completion_callback complete_func, uint32_t fw_ctx_id );
+
+#endif /* __SYSTEM_DMA_REF_H__ */
@@ -0,0 +1,335 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+// Host test of the memcpy fallback of the kernel DMA layer, built without
+// FW_USE_SYSTEM_DMA. Work items run on a worker thread that the test can
+// hold, so a transfer can be kept pending while the next one is requested.
+// Also reports the submission to completion latency of the config copies
+// next to the previous tasklet per entry fallback.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <linux/kernel.h>
+#include <linux/workqueue.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <asm/io.h>
+#include "host_test.h"
+#include "system_dma.h"
+#include "system_dma_ref.h"
+
+#define ISP_CONFIG_PING 0
+#define ISP_CONFIG_PONG 1
+
+// entries of one config buffer, as set up by acamera.c
+#define CONFIG_LUT_SIZE 0xe31c
+#define CONFIG_REG_SIZE 0x4000
+#define CONFIG_SIZE ( CONFIG_LUT_SIZE + CONFIG_REG_SIZE )
+
+static uint8_t sim_device[2 * CONFIG_SIZE];
+static uint8_t fw_config[2][CONFIG_SIZE];
+
+// worker thread of the simulated system_highpri_wq
+static pthread_mutex_t wq_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wq_cond = PTHREAD_COND_INITIALIZER;
+static struct work_struct *wq_head, *wq_tail, *wq_running;
+static int wq_hold, wq_stop;
+static pthread_t wq_thread;
+
+struct workqueue_struct *system_highpri_wq;
+
+static void *wq_worker( void *arg )
+{
+    pthread_mutex_lock( &wq_mutex );
+    while ( !wq_stop ) {
+        struct work_struct *work = wq_head;
+
+        if ( wq_hold || work == NULL ) {
+            pthread_cond_wait( &wq_cond, &wq_mutex );
+            continue;
+        }
+        wq_head = work->next;
+        if ( wq_head == NULL )
+            wq_tail = NULL;
+        // cleared before the item runs, it may be queued again from there
+        work->pending = 0;
+        wq_running = work;
+        pthread_mutex_unlock( &wq_mutex );
+
+        work->func( work );
+
+        pthread_mutex_lock( &wq_mutex );
+        wq_running = NULL;
+        pthread_cond_broadcast( &wq_cond );
+    }
+    pthread_mutex_unlock( &wq_mutex );
+    return NULL;
+}
+
+static void wq_set_hold( int hold )
+{
+    pthread_mutex_lock( &wq_mutex );
+    wq_hold = hold;
+    pthread_cond_broadcast( &wq_cond );
+    pthread_mutex_unlock( &wq_mutex );
+}
+
+int queue_work( struct workqueue_struct *wq, struct work_struct *work )
+{
+    int queued = 0;
+
+    pthread_mutex_lock( &wq_mutex );
+    if ( !work->pending ) {
+        work->pending = 1;
+        work->next = NULL;
+        if ( wq_tail )
+            wq_tail->next = work;
+        else
+            wq_head = work;
+        wq_tail = work;
+        queued = 1;
+        pthread_cond_broadcast( &wq_cond );
+    }
+    pthread_mutex_unlock( &wq_mutex );
+    return queued;
+}
+
+int cancel_work_sync( struct work_struct *work )
+{
+    struct work_struct **pp;
+    int pending;
+
+    pthread_mutex_lock( &wq_mutex );
+    pending = work->pending;
+    for ( pp = &wq_head; *pp; pp = &( *pp )->next ) {
+        if ( *pp == work ) {
+            *pp = work->next;
+            break;
+        }
+    }
+    for ( wq_tail = wq_head; wq_tail && wq_tail->next; wq_tail = wq_tail->next )
+        ;
+    work->pending = 0;
+    while ( wq_running == work )
+        pthread_cond_wait( &wq_cond, &wq_mutex );
+    pthread_mutex_unlock( &wq_mutex );
+    return pending;
+}
+
+static void tasklet_work( struct work_struct *work )
+{
+    struct tasklet_struct *t = container_of( work, struct tasklet_struct, work );
+    t->func( t->data );
+}
+
+void tasklet_schedule( struct tasklet_struct *t )
+{
+    t->work.func = tasklet_work;
+    queue_work( system_highpri_wq, &t->work );
+}
+
+void init_completion( struct completion *comp )
+{
+    comp->done = 0;
+}
+
+void complete( struct completion *comp )
+{
+    pthread_mutex_lock( &wq_mutex );
+    comp->done = 1;
+    pthread_cond_broadcast( &wq_cond );
+    pthread_mutex_unlock( &wq_mutex );
+}
+
+void wait_for_completion( struct completion *comp )
+{
+    pthread_mutex_lock( &wq_mutex );
+    while ( !comp->done )
+        pthread_cond_wait( &wq_cond, &wq_mutex );
+    pthread_mutex_unlock( &wq_mutex );
+}
+
+void spin_lock_init( spinlock_t *lock )
+{
+    pthread_mutex_init( &lock->mutex, NULL );
+}
+
+unsigned long sim_spin_lock( spinlock_t *lock )
+{
+    pthread_mutex_lock( &lock->mutex );
+    return 0;
+}
+
+void sim_spin_unlock( spinlock_t *lock )
+{
+    pthread_mutex_unlock( &lock->mutex );
+}
+
+ktime_t ktime_get( void )
+{
+    return (ktime_t)( now_s() * 1e9 );
+}
+
+void *ioremap( unsigned long phys_addr, unsigned long size )
+{
+    return &sim_device[phys_addr];
+}
+
+void iounmap( void *addr )
+{
+}
+
+void *system_malloc( uint32_t size )
+{
+    return calloc( 1, size );
+}
+
+static volatile int callbacks;
+
+static void copy_done( void *arg )
+{
+    __atomic_add_fetch( &callbacks, 1, __ATOMIC_SEQ_CST );
+}
+
+static int wait_callbacks( int count )
+{
+    double start = now_s();
+
+    while ( __atomic_load_n( &callbacks, __ATOMIC_SEQ_CST ) < count ) {
+        if ( now_s() - start > 1.0 )
+            return 0;
+    }
+    return 1;
+}
+
+typedef int32_t ( *dma_setup_device_t )( void *, int32_t, dma_addr_pair_t *, int32_t, uint32_t );
+typedef int32_t ( *dma_setup_fwmem_t )( void *, int32_t, fwmem_addr_pair_t *, int32_t, uint32_t );
+
+// both config buffers of context 0, the device copies lie side by side
+static void setup_config( void *ctx, dma_setup_device_t setup_device, dma_setup_fwmem_t setup_fwmem )
+{
+    int32_t buff_loc;
+
+    for ( buff_loc = ISP_CONFIG_PING; buff_loc <= ISP_CONFIG_PONG; buff_loc++ ) {
+        dma_addr_pair_t dev[2] = {
+            {buff_loc * CONFIG_SIZE, CONFIG_LUT_SIZE},
+            {buff_loc * CONFIG_SIZE + CONFIG_LUT_SIZE, CONFIG_REG_SIZE}};
+        fwmem_addr_pair_t fw[2] = {
+            {fw_config[buff_loc], CONFIG_LUT_SIZE},
+            {fw_config[buff_loc] + CONFIG_LUT_SIZE, CONFIG_REG_SIZE}};
+
+        setup_device( ctx, buff_loc, dev, 2, 0 );
+        setup_fwmem( ctx, buff_loc, fw, 2, 0 );
+    }
+}
+
+// A ping write and a pong read back queued before either runs keep their
+// own direction, and a request for a buffer whose copy is still pending is
+// refused instead of being lost or waiting forever.
+static void test_pending( void )
+{
+    void *ctx = NULL;
+    int32_t result;
+
+    CHECK( system_dma_init( &ctx ) == 0, "system_dma_init failed" );
+    setup_config( ctx, system_dma_sg_device_setup, system_dma_sg_fwmem_setup );
+
+    memset( fw_config[ISP_CONFIG_PING], 0xa5, CONFIG_SIZE );
+    memset( fw_config[ISP_CONFIG_PONG], 0, CONFIG_SIZE );
+    memset( sim_device, 0, CONFIG_SIZE );
+    memset( sim_device + CONFIG_SIZE, 0x5a, CONFIG_SIZE );
+    callbacks = 0;
+
+    wq_set_hold( 1 );
+    result = system_dma_copy_sg( ctx, ISP_CONFIG_PING, SYS_DMA_TO_DEVICE, copy_done, 0 );
+    CHECK( result == 0, "ping write was not queued: %d", result );
+    result = system_dma_copy_sg( ctx, ISP_CONFIG_PONG, SYS_DMA_FROM_DEVICE, copy_done, 0 );
+    CHECK( result == 0, "pong read back was not queued: %d", result );
+    result = system_dma_copy_sg( ctx, ISP_CONFIG_PING, SYS_DMA_FROM_DEVICE, copy_done, 0 );
+    CHECK( result == -1, "async request on a pending ping returned %d", result );
+    result = system_dma_copy_sg( ctx, ISP_CONFIG_PING, SYS_DMA_TO_DEVICE, NULL, 0 );
+    CHECK( result == -1, "sync request on a pending ping returned %d", result );
+    wq_set_hold( 0 );
+
+    CHECK( wait_callbacks( 2 ), "%d of 2 copies completed", callbacks );
+    CHECK( sim_device[0] == 0xa5 && sim_device[CONFIG_SIZE - 1] == 0xa5, "ping was not written to the device" );
+    CHECK( fw_config[ISP_CONFIG_PONG][0] == 0x5a && fw_config[ISP_CONFIG_PONG][CONFIG_SIZE - 1] == 0x5a, "pong was not read back" );
+    CHECK( fw_config[ISP_CONFIG_PING][0] == 0xa5, "ping was overwritten by a read back" );
+
+    // once the copy ran the buffer takes requests again
+    memset( fw_config[ISP_CONFIG_PING], 0x3c, CONFIG_SIZE );
+    result = system_dma_copy_sg( ctx, ISP_CONFIG_PING, SYS_DMA_TO_DEVICE, NULL, 0 );
+    CHECK( result == 0 && sim_device[CONFIG_LUT_SIZE] == 0x3c, "sync ping write after completion: %d", result );
+
+    system_dma_destroy( ctx );
+}
+
+#define BENCH_FRAMES 20000
+
+// sync writes of both config buffers, as on a context switch
+static double bench_config( int32_t ( *copy_sg )( void *, int32_t, uint32_t, dma_completion_callback, uint32_t ), void *ctx )
+{
+    double t0 = now_s();
+    uint32_t f;
+
+    for ( f = 0; f < BENCH_FRAMES; f++ ) {
+        copy_sg( ctx, ISP_CONFIG_PING, SYS_DMA_TO_DEVICE, NULL, 0 );
+        copy_sg( ctx, ISP_CONFIG_PONG, SYS_DMA_TO_DEVICE, NULL, 0 );
+    }
+    return ( now_s() - t0 ) * 1e9 / ( 2 * BENCH_FRAMES );
+}
+
+static void bench( void )
+{
+    void *ctx = NULL;
+    void *ref_ctx = NULL;
+
+    system_dma_init( &ctx );
+    setup_config( ctx, system_dma_sg_device_setup, system_dma_sg_fwmem_setup );
+    ref_system_dma_init( &ref_ctx );
+    setup_config( ref_ctx, ref_system_dma_sg_device_setup, ref_system_dma_sg_fwmem_setup );
+
+    printf( "config copy of %d bytes, submission to completion:\n", CONFIG_SIZE );
+    printf( "  %-44s %8.0f ns\n", "previous, one tasklet per entry", bench_config( ref_system_dma_copy_sg, ref_ctx ) );
+    printf( "  %-44s %8.0f ns\n", "one work item per buffer", bench_config( system_dma_copy_sg, ctx ) );
+
+    system_dma_destroy( ctx );
+    ref_system_dma_destroy( ref_ctx );
+}
+
+int main( int argc, char **argv )
+{
+    pthread_create( &wq_thread, NULL, wq_worker, NULL );
+
+    test_pending();
+
+    if ( bench_enabled( argc, argv ) ) {
+        bench();
+    }
+
+    pthread_mutex_lock( &wq_mutex );
+    wq_stop = 1;
+    pthread_cond_broadcast( &wq_cond );
+    pthread_mutex_unlock( &wq_mutex );
+    pthread_join( wq_thread, NULL );
+
+    printf( "system_dma: %s\n", failures ? "FAILED" : "passed" );
+    return failures;
+}
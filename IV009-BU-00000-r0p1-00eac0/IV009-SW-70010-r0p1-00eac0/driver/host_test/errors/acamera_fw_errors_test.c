@@ -0,0 +1,172 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// Error injection test of the isp error bookkeeping. Latched irq masks with
+// error bits are fed to the interrupt thread side and the recovery requests
+// the process loop takes are checked, the way the interrupt thread and
+// acamera_process use them.
+
+#include "host_test.h"
+#include "acamera_fw_errors.h"
+#include "system_stdlib.h"
+#include "system_timer.h"
+
+#define IRQ( event ) ( 1u << ( event ) )
+#define IRQ_FS IRQ( ISP_INTERRUPT_EVENT_ISP_START_FRAME_START )
+#define IRQ_FE IRQ( ISP_INTERRUPT_EVENT_ISP_END_FRAME_END )
+#define IRQ_BROKEN IRQ( ISP_INTERRUPT_EVENT_BROKEN_FRAME )
+
+static int locked = 0;
+static uint32_t timestamp = 0;
+
+int system_spinlock_init( sys_spinlock *lock )
+{
+    *lock = &locked;
+    return 0;
+}
+
+unsigned long system_spinlock_lock( sys_spinlock lock )
+{
+    CHECK( lock == &locked && !locked, "spinlock taken twice" );
+    locked = 1;
+    return 0;
+}
+
+void system_spinlock_unlock( sys_spinlock lock, unsigned long flags )
+{
+    CHECK( locked, "spinlock released twice" );
+    locked = 0;
+}
+
+void system_spinlock_destroy( sys_spinlock lock )
+{
+}
+
+int32_t system_memset( void *ptr, uint8_t value, uint32_t size )
+{
+    memset( ptr, value, size );
+    return 0;
+}
+
+uint32_t system_timer_timestamp( void )
+{
+    return timestamp;
+}
+
+uint32_t system_timer_frequency( void )
+{
+    return 1000;
+}
+
+static acamera_fw_error_stats_t stats;
+
+static int32_t take( uint32_t *p_ctx )
+{
+    uint32_t ctx = 0xff;
+    int32_t err_class = acamera_fw_errors_take( &stats, &ctx );
+    if ( p_ctx )
+        *p_ctx = ctx;
+    return err_class;
+}
+
+// the process loop takes the request and recovers
+static int32_t recover( void )
+{
+    int32_t err_class = take( NULL );
+    if ( err_class >= 0 )
+        acamera_fw_errors_recovered( &stats, 0 );
+    return err_class;
+}
+
+static void test_frame_errors( void )
+{
+    int i;
+
+    // isolated broken frames separated by clean frames need no recovery
+    acamera_fw_errors_init( &stats );
+    for ( i = 0; i < 10; i++ ) {
+        CHECK( acamera_fw_errors_latch( &stats, IRQ_BROKEN | IRQ_FE, 0 ) < 0, "isolated broken frame %d requested a recovery", i );
+        CHECK( acamera_fw_errors_latch( &stats, IRQ_FS, 0 ) < 0, "frame start requested a recovery" );
+        CHECK( acamera_fw_errors_latch( &stats, IRQ_FE, 0 ) < 0, "clean frame end requested a recovery" );
+    }
+    CHECK( stats.count[FW_ERROR_FRAME] == 10, "%u frame errors counted", stats.count[FW_ERROR_FRAME] );
+    CHECK( take( NULL ) < 0, "recovery requested for isolated broken frames" );
+
+    // a frame start or another interrupt between broken frames does not end the run
+    acamera_fw_errors_init( &stats );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ_BROKEN, 0 ) < 0, "first broken frame requested a recovery" );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ_FS, 0 ) < 0, "frame start requested a recovery" );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ_BROKEN, 0 ) < 0, "second broken frame requested a recovery" );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ_FS, 0 ) < 0, "frame start requested a recovery" );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ_BROKEN | IRQ_FE, 0 ) == FW_ERROR_FRAME, "run of broken frames not recovered" );
+    CHECK( stats.frame_errors_in_row == 0, "run not restarted after the request" );
+    CHECK( recover() == FW_ERROR_FRAME, "frame recovery not taken" );
+    CHECK( take( NULL ) < 0, "request taken twice" );
+
+    // frame collisions count as frame errors
+    CHECK( acamera_fw_errors_latch( &stats, IRQ( ISP_INTERRUPT_EVENT_FRAME_COLLISION ), 0 ) < 0, "collision requested a recovery" );
+    CHECK( stats.frame_errors_in_row == 1, "collision not counted" );
+}
+
+static void test_deferred( void )
+{
+    uint32_t ctx;
+
+    // the interrupt side only requests, the recovery waits for the process loop
+    acamera_fw_errors_init( &stats );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ( ISP_INTERRUPT_EVENT_DMA_ERROR ) | IRQ_FS, 2 ) == FW_ERROR_DMA, "dma error not requested" );
+    CHECK( stats.recoveries == 0, "recovered in the interrupt thread" );
+    CHECK( stats.recovery_pending, "recovery not pending" );
+    CHECK( take( &ctx ) == FW_ERROR_DMA && ctx == 2, "dma error not taken, config ctx %u", ctx );
+
+    // frames before the process loop is done do not complete the recovery
+    acamera_fw_errors_frame_start( &stats, ISP_CONFIG_PING );
+    CHECK( stats.recovery_pending && stats.recovery_frames == 1, "recovery completed before it was done" );
+    acamera_fw_errors_recovered( &stats, -1 );
+    CHECK( stats.recoveries == 1 && stats.stop_timeouts == 1, "recovery not accounted" );
+
+    // a frame with no config transfer does not complete it either
+    acamera_fw_errors_frame_start( &stats, -1 );
+    CHECK( stats.recovery_pending, "recovery completed by a frame with no config" );
+
+    timestamp = 40;
+    acamera_fw_errors_frame_start( &stats, ISP_CONFIG_PONG );
+    CHECK( !stats.recovery_pending, "recovery not completed by a good frame" );
+    CHECK( stats.recovery_time_last == 40 && stats.recovery_frames == 2, "recovery took %u ms and %u frames", stats.recovery_time_last, stats.recovery_frames );
+
+    // errors latched before the process loop runs are handled by one recovery of the worst class
+    CHECK( acamera_fw_errors_latch( &stats, IRQ( ISP_INTERRUPT_EVENT_MULTICTX_ERROR ), 1 ) == FW_ERROR_CONTEXT, "context error not requested" );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ( ISP_INTERRUPT_EVENT_WATCHDOG_EXP ), 1 ) == FW_ERROR_WATCHDOG, "watchdog not requested" );
+    CHECK( acamera_fw_errors_latch( &stats, IRQ( ISP_INTERRUPT_EVENT_DMA_ERROR ), 1 ) == FW_ERROR_DMA, "dma error not requested" );
+    CHECK( recover() == FW_ERROR_WATCHDOG, "most severe error not taken" );
+    CHECK( take( NULL ) < 0, "less severe errors recovered again" );
+    CHECK( stats.count[FW_ERROR_CONTEXT] == 1 && stats.count[FW_ERROR_WATCHDOG] == 1 && stats.count[FW_ERROR_DMA] == 2, "error counts" );
+    CHECK( !locked, "spinlock left taken" );
+}
+
+int main( int argc, char **argv )
+{
+    test_frame_errors();
+    test_deferred();
+
+    printf( "acamera_fw_errors: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
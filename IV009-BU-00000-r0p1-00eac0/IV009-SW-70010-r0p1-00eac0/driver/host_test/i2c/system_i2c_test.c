@@ -0,0 +1,370 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+// Host test of the subdev I2C master against a simulated AXI IIC controller.
+// The controller consumes one tx fifo entry per byte time of a 400kHz bus on
+// a simulated clock, so the test checks both the reported status of queued
+// writes and how often the driver looks at the controller while it waits.
+
+#include <asm/io.h>
+#include <linux/delay.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include "host_test.h"
+#include "system_i2c.h"
+
+#define SIM_BUS 0x40005000
+#define SIM_DEVICE 0x10
+#define SIM_BYTE_NS 25000 // 9 bits at 400kHz plus some clock stretching
+#define SIM_MMIO_NS 100
+#define SIM_TX_DEPTH 16
+
+#define REG_ISR 0x020
+#define REG_CR 0x100
+#define REG_SR 0x104
+#define REG_TX_FIFO 0x108
+#define REG_RX_FIFO 0x10c
+#define REG_TX_FIFO_OCY 0x114
+
+#define ISR_ARB_LOST 0x1
+#define ISR_TX_ERROR 0x2
+
+typedef struct _sim_t {
+    uint64_t now_ns;
+    uint64_t bus_ns;  // when the byte on the bus is done
+    uint64_t done_ns; // when the last byte was done
+    uint32_t tx[SIM_TX_DEPTH];
+    uint32_t tx_head, tx_count;
+    uint8_t rx[SIM_TX_DEPTH];
+    uint32_t rx_head, rx_count;
+    uint32_t isr;
+    int busy;       // between the start and the stop condition
+    int stalled;    // a failed transaction waits for the tx fifo reset
+    int read_mode;  // the last start condition was a read
+    int read_left;  // bytes still to receive
+    uint32_t index; // data byte of the current write transaction
+    // the device
+    uint8_t ptr;
+    uint8_t mem[256];
+    int nack_after;  // the device does not acknowledge this data byte, -1 never
+    int arb_lost;    // the next start condition loses the arbitration
+    int hold;        // the device holds the clock low, nothing moves on the bus
+    // what the driver did
+    uint32_t sr_reads;
+    uint32_t sleeps;
+    uint32_t overflows;
+} sim_t;
+
+static sim_t sim;
+static uint8_t sim_regs[0x1000];
+
+static void sim_reset( void )
+{
+    memset( &sim, 0, sizeof( sim ) );
+    sim.nack_after = -1;
+}
+
+static void sim_fail( uint32_t bit )
+{
+    sim.isr |= bit;
+    sim.busy = 0;
+    sim.stalled = 1;
+}
+
+static void sim_consume( uint32_t entry )
+{
+    if ( entry & 0x100 ) {
+        if ( sim.arb_lost ) {
+            sim.arb_lost = 0;
+            sim_fail( ISR_ARB_LOST );
+            return;
+        }
+        sim.busy = 1;
+        sim.read_mode = entry & 1;
+        sim.index = 0;
+        if ( ( ( entry & 0xff ) >> 1 ) != SIM_DEVICE )
+            sim_fail( ISR_TX_ERROR );
+        return;
+    }
+    if ( sim.read_mode ) {
+        // the byte count of a read, always sent with the stop bit
+        sim.read_left = entry & 0xff;
+        return;
+    }
+    if ( sim.nack_after >= 0 && sim.index >= (uint32_t)sim.nack_after ) {
+        sim_fail( ISR_TX_ERROR );
+        return;
+    }
+    if ( sim.index++ == 0 )
+        sim.ptr = entry & 0xff;
+    else
+        sim.mem[sim.ptr++] = entry & 0xff;
+    if ( entry & 0x200 )
+        sim.busy = 0;
+}
+
+// runs the bus up to the current time
+static void sim_advance( void )
+{
+    for ( ;; ) {
+        if ( sim.hold ) {
+            sim.bus_ns = sim.now_ns;
+            break;
+        }
+        if ( sim.read_left ) {
+            if ( sim.bus_ns + SIM_BYTE_NS > sim.now_ns || sim.rx_count == SIM_TX_DEPTH )
+                break;
+            sim.bus_ns += SIM_BYTE_NS;
+            sim.done_ns = sim.bus_ns;
+            sim.rx[( sim.rx_head + sim.rx_count++ ) % SIM_TX_DEPTH] = sim.mem[sim.ptr++];
+            if ( --sim.read_left == 0 )
+                sim.busy = 0;
+        } else if ( sim.tx_count && !sim.stalled ) {
+            if ( sim.bus_ns + SIM_BYTE_NS > sim.now_ns )
+                break;
+            sim.bus_ns += SIM_BYTE_NS;
+            sim.done_ns = sim.bus_ns;
+            sim_consume( sim.tx[sim.tx_head] );
+            sim.tx_head = ( sim.tx_head + 1 ) % SIM_TX_DEPTH;
+            sim.tx_count--;
+        } else {
+            // nothing to send, the bus waits for the next entry
+            sim.bus_ns = sim.now_ns;
+            break;
+        }
+    }
+}
+
+uint32_t ioread32( const volatile void *addr )
+{
+    uint32_t offset = (uint32_t)( (const volatile uint8_t *)addr - sim_regs );
+    uint32_t result = 0;
+
+    sim.now_ns += SIM_MMIO_NS;
+    sim_advance();
+    switch ( offset ) {
+    case REG_SR:
+        sim.sr_reads++;
+        result = ( sim.rx_count == 0 ) << 6 | ( sim.tx_count == 0 ) << 7 | ( sim.tx_count == SIM_TX_DEPTH ) << 4 | ( sim.busy || sim.read_left ) << 2;
+        break;
+    case REG_ISR:
+        result = sim.isr;
+        break;
+    case REG_TX_FIFO_OCY:
+        result = sim.tx_count ? sim.tx_count - 1 : 0;
+        break;
+    case REG_RX_FIFO:
+        if ( sim.rx_count ) {
+            result = sim.rx[sim.rx_head];
+            sim.rx_head = ( sim.rx_head + 1 ) % SIM_TX_DEPTH;
+            sim.rx_count--;
+        }
+        break;
+    }
+    return result;
+}
+
+void iowrite32( uint32_t val, volatile void *addr )
+{
+    uint32_t offset = (uint32_t)( (volatile uint8_t *)addr - sim_regs );
+
+    sim.now_ns += SIM_MMIO_NS;
+    sim_advance();
+    switch ( offset ) {
+    case REG_ISR:
+        sim.isr ^= val;
+        break;
+    case REG_CR:
+        if ( val & 2 ) {
+            sim.tx_count = 0;
+            sim.stalled = 0;
+        }
+        break;
+    case REG_TX_FIFO:
+        if ( sim.tx_count == SIM_TX_DEPTH ) {
+            sim.overflows++;
+            break;
+        }
+        if ( sim.tx_count == 0 && !sim.read_left && sim.bus_ns < sim.now_ns )
+            sim.bus_ns = sim.now_ns;
+        sim.tx[( sim.tx_head + sim.tx_count++ ) % SIM_TX_DEPTH] = val;
+        break;
+    }
+}
+
+void *ioremap( unsigned long phys_addr, unsigned long size )
+{
+    return sim_regs;
+}
+
+unsigned long sim_jiffies( void )
+{
+    return (unsigned long)( sim.now_ns / 1000000 );
+}
+
+void usleep_range( unsigned long min, unsigned long max )
+{
+    sim.sleeps++;
+    sim.now_ns += min * 1000;
+}
+
+void cpu_relax( void )
+{
+    sim.now_ns += 1000;
+}
+
+ktime_t ktime_get( void )
+{
+    return (ktime_t)sim.now_ns;
+}
+
+static uint8_t write_regs( uint8_t device, uint8_t reg, const uint8_t *p_data, uint32_t size )
+{
+    uint8_t buf[64];
+    buf[0] = reg;
+    memcpy( buf + 1, p_data, size );
+    return system_i2c_write( SIM_BUS, device, buf, size + 1 );
+}
+
+static uint8_t read_regs( uint8_t device, uint8_t reg, uint8_t *p_data, uint32_t size )
+{
+    uint8_t result = system_i2c_write( SIM_BUS, device | 0x20000, &reg, 1 );
+    if ( result == I2C_OK )
+        result = system_i2c_read( SIM_BUS, device, p_data, size );
+    return result;
+}
+
+static void test_status( void )
+{
+    uint8_t data[40], back[40];
+    uint32_t i;
+    uint64_t start;
+
+    for ( i = 0; i < sizeof( data ); i++ )
+        data[i] = (uint8_t)( 0xa0 + i );
+
+    // an acknowledged write is queued and then reported as done
+    start = sim.now_ns;
+    CHECK( write_regs( SIM_DEVICE, 0x10, data, 4 ) == I2C_OK, "write was not queued" );
+    CHECK( sim.now_ns - start < SIM_BYTE_NS, "write waited for the bus: %llu ns", (unsigned long long)( sim.now_ns - start ) );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "acknowledged write reported as failed" );
+    CHECK( memcmp( sim.mem + 0x10, data, 4 ) == 0, "write did not reach the device" );
+
+    // a write to a missing device is queued but reported by the next sync
+    CHECK( write_regs( SIM_DEVICE + 1, 0x10, data, 4 ) == I2C_OK, "write was not queued" );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_NOACK, "missing device not reported" );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "status was not cleared by sync" );
+
+    // the failure is kept until the sync even when more writes follow
+    CHECK( write_regs( SIM_DEVICE + 1, 0x20, data, 2 ) == I2C_OK, "write was not queued" );
+    CHECK( write_regs( SIM_DEVICE, 0x20, data, 2 ) == I2C_OK, "write after a failed one was not queued" );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_NOACK, "failure followed by a good write not reported" );
+    CHECK( memcmp( sim.mem + 0x20, data, 2 ) == 0, "write after a failed one did not reach the device" );
+
+    // a block longer than the fifo is one transaction
+    CHECK( write_regs( SIM_DEVICE, 0x40, data, sizeof( data ) ) == I2C_OK, "long write failed" );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "long write reported as failed" );
+    CHECK( memcmp( sim.mem + 0x40, data, sizeof( data ) ) == 0, "long write did not reach the device" );
+    CHECK( sim.overflows == 0, "tx fifo overflowed %u times", sim.overflows );
+
+    // the device stops acknowledging in the middle of a long block
+    sim.nack_after = 20;
+    {
+        uint8_t status = write_regs( SIM_DEVICE, 0x80, data, sizeof( data ) );
+        if ( status == I2C_OK )
+            status = system_i2c_sync( SIM_BUS );
+        CHECK( status == I2C_NOACK, "partial long write not reported, status %d", status );
+    }
+    sim.nack_after = -1;
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "bus did not recover after a partial write" );
+
+    // a bus which stops moving fails the write without any status bit set
+    sim.hold = 1;
+    memset( sim.mem + 0x90, 0, sizeof( data ) );
+    CHECK( write_regs( SIM_DEVICE, 0x90, data, sizeof( data ) ) == I2C_NOACK, "write to a stuck bus was reported as queued" );
+    sim.hold = 0;
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "bus did not recover after a stuck write" );
+    CHECK( sim.mem[0x90] == 0, "unterminated write reached the device" );
+
+    // lost arbitration is reported as such
+    sim.arb_lost = 1;
+    CHECK( write_regs( SIM_DEVICE, 0x10, data, 2 ) == I2C_OK, "write was not queued" );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_ABITRATION_LOST, "lost arbitration not reported" );
+
+    // reads see the queued writes and fail fast on a missing device
+    CHECK( write_regs( SIM_DEVICE, 0x30, data, 8 ) == I2C_OK, "write was not queued" );
+    memset( back, 0, sizeof( back ) );
+    CHECK( read_regs( SIM_DEVICE, 0x30, back, 8 ) == I2C_OK, "read failed" );
+    CHECK( memcmp( back, data, 8 ) == 0, "read returned other data than written" );
+    start = sim.now_ns;
+    CHECK( read_regs( SIM_DEVICE + 1, 0x30, back, 1 ) != I2C_OK, "read from a missing device succeeded" );
+    CHECK( sim.now_ns - start < 20 * SIM_BYTE_NS, "failed read waited %llu us", (unsigned long long)( ( sim.now_ns - start ) / 1000 ) );
+    CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "failed read left a status behind" );
+}
+
+// An exposure update writes a few registers and syncs once. The driver
+// should sleep through the bus time and look at the controller only a few
+// times, and the sync should return soon after the last byte is sent.
+static void test_timing( int report )
+{
+    const uint32_t updates = 100;
+    uint32_t i, sr_reads, sleeps;
+    uint64_t late_ns = 0, max_late_ns = 0;
+    uint8_t data[16] = {0};
+
+    sr_reads = sim.sr_reads;
+    sleeps = sim.sleeps;
+    for ( i = 0; i < updates; i++ ) {
+        uint64_t late;
+        data[0] = (uint8_t)i;
+        write_regs( SIM_DEVICE, 0x00, data, 2 );
+        write_regs( SIM_DEVICE, 0x08, data, 2 );
+        write_regs( SIM_DEVICE, 0x10, data, 16 );
+        CHECK( system_i2c_sync( SIM_BUS ) == I2C_OK, "update %u failed", i );
+        late = sim.now_ns - sim.done_ns;
+        late_ns += late;
+        if ( late > max_late_ns )
+            max_late_ns = late;
+        // the next frame
+        sim.now_ns += 1000000;
+    }
+    sr_reads = sim.sr_reads - sr_reads;
+    sleeps = sim.sleeps - sleeps;
+
+    CHECK( sr_reads <= 12 * updates, "%u status reads per update", sr_reads / updates );
+    CHECK( max_late_ns <= 2 * SIM_BYTE_NS, "sync returned %llu us after the bus was done", (unsigned long long)( max_late_ns / 1000 ) );
+    if ( report ) {
+        printf( "exposure update of 3 writes (25 bytes): %.1f status reads, %.1f sleeps, sync %.1f us after the last byte (max %.1f us)\n",
+                (double)sr_reads / updates, (double)sleeps / updates, late_ns / 1000.0 / updates, max_late_ns / 1000.0 );
+    }
+}
+
+int main( int argc, char **argv )
+{
+    sim_reset();
+    system_i2c_init( SIM_BUS );
+
+    test_status();
+    test_timing( bench_enabled( argc, argv ) );
+
+    system_i2c_deinit( SIM_BUS );
+    printf( "system_i2c: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#ifndef __ACAMERA_LOGGER_H__
+#define __ACAMERA_LOGGER_H__
+
+// host test logger: firmware messages are dropped unless HOST_TEST_LOG is set
+
+#include <stdio.h>
+
+#define LOG_DEBUG 0
+#define LOG_INFO 1
+#define LOG_NOTICE 2
+#define LOG_WARNING 3
+#define LOG_ERR 4
+#define LOG_CRIT 5
+#define LOG_NOTHING 6
+
+#if defined( HOST_TEST_LOG )
+#define LOG( level, ... )                    \
+    do {                                     \
+        if ( ( level ) >= HOST_TEST_LOG ) {  \
+            printf( "  [fw] " __VA_ARGS__ ); \
+            printf( "\n" );                  \
+        }                                    \
+    } while ( 0 )
+#else
+#define LOG( level, ... ) \
+    do {                  \
+    } while ( 0 )
+#endif
+
+#endif /* __ACAMERA_LOGGER_H__ */
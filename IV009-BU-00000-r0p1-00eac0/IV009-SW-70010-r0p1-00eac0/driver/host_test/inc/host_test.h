@@ -0,0 +1,65 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#if !defined( __HOST_TEST_H__ )
+#define __HOST_TEST_H__
+
+// Helpers shared by the host tests: failure counting, a monotonic clock
+// for the throughput reports and a reproducible pseudo random sequence.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+static int failures = 0;
+
+#define CHECK( cond, ... )                  \
+    do {                                    \
+        if ( !( cond ) ) {                  \
+            failures++;                     \
+            printf( "FAIL: " __VA_ARGS__ ); \
+            printf( "\n" );                 \
+        }                                   \
+    } while ( 0 )
+
+static double now_s( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng( void )
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// the throughput reports are skipped with --no-bench
+static int bench_enabled( int argc, char **argv )
+{
+    return argc < 2 || strcmp( argv[1], "--no-bench" ) != 0;
+}
+
+#endif /* __HOST_TEST_H__ */
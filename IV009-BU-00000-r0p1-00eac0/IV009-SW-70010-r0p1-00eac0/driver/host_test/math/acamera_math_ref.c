@@ -0,0 +1,327 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#include "acamera_math_ref.h"
+
+static uint8_t ref_leading_one_position( const uint32_t in )
+{
+    uint8_t pos = 0;
+    uint32_t val = in;
+    if ( val >= 1 << 16 ) {
+        val >>= 16;
+        pos += 16;
+    }
+    if ( val >= 1 << 8 ) {
+        val >>= 8;
+        pos += 8;
+    }
+    if ( val >= 1 << 4 ) {
+        val >>= 4;
+        pos += 4;
+    }
+    if ( val >= 1 << 2 ) {
+        val >>= 2;
+        pos += 2;
+    }
+    if ( val >= 1 << 1 ) {
+        pos += 1;
+    }
+    return pos;
+}
+
+static int ref_leading_one_position_64( uint64_t val )
+{
+    int pos = 0;
+    if ( val >= (uint64_t)1 << 32 ) {
+        val >>= 32;
+        pos += 32;
+    }
+    if ( val >= 1 << 16 ) {
+        val >>= 16;
+        pos += 16;
+    }
+    if ( val >= 1 << 8 ) {
+        val >>= 8;
+        pos += 8;
+    }
+    if ( val >= 1 << 4 ) {
+        val >>= 4;
+        pos += 4;
+    }
+    if ( val >= 1 << 2 ) {
+        val >>= 2;
+        pos += 2;
+    }
+    if ( val >= 1 << 1 ) {
+        pos += 1;
+    }
+    return pos;
+}
+
+uint32_t ref_acamera_log2_int_to_fixed( const uint32_t val, const uint8_t out_precision, const uint8_t shift_out )
+{
+    int i;
+    int pos = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t in = val;
+    uint32_t result = 0;
+    const unsigned char precision = out_precision;
+
+    if ( 0 == val ) {
+        return 0;
+    }
+    pos = ref_leading_one_position( val );
+    a = ( pos <= 15 ) ? ( in << ( 15 - pos ) ) : ( in >> ( pos - 15 ) );
+    for ( i = 0; i < precision; ++i ) {
+        b = a * a;
+        if ( b & ( (uint32_t)1 << 31 ) ) {
+            result = ( result << 1 ) + 1;
+            a = b >> 16;
+        } else {
+            result = ( result << 1 );
+            a = b >> 15;
+        }
+    }
+    return ( ( ( pos << precision ) + result ) << shift_out ) | ( ( a & 0x7fff ) >> ( 15 - shift_out ) );
+}
+
+static uint32_t ref_log2_int_to_fixed_64( uint64_t val, uint8_t out_precision, uint8_t shift_out )
+{
+    int i;
+    int pos = 0;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    uint64_t in = val;
+    uint64_t result = 0;
+    const unsigned char precision = out_precision;
+
+    if ( 0 == val ) {
+        return 0;
+    }
+    pos = ref_leading_one_position_64( val );
+    a = ( pos <= 15 ) ? ( in << ( 15 - pos ) ) : ( in >> ( pos - 15 ) );
+    for ( i = 0; i < precision; ++i ) {
+        b = a * a;
+        if ( b & ( (uint32_t)1 << 31 ) ) {
+            result = ( result << 1 ) + 1;
+            a = b >> 16;
+        } else {
+            result = ( result << 1 );
+            a = b >> 15;
+        }
+    }
+    return ( uint32_t )( ( ( ( pos << precision ) + result ) << shift_out ) | ( ( a & 0x7fff ) >> ( 15 - shift_out ) ) );
+}
+
+int32_t ref_acamera_log2_fixed_to_fixed_64( uint64_t val, int32_t in_fix_point, uint8_t out_fix_point )
+{
+    return ref_log2_int_to_fixed_64( val, out_fix_point, 0 ) - ( in_fix_point << out_fix_point );
+}
+
+uint32_t ref_acamera_sqrt64( uint64_t arg )
+{
+    uint64_t mask = (uint64_t)1 << 31;
+    uint32_t res = 0;
+    int i = 0;
+
+    for ( i = 0; i < 32; i++ ) {
+        if ( ( res + ( mask >> i ) ) * ( res + ( mask >> i ) ) <= arg )
+            res = res + ( mask >> i );
+    }
+    return res;
+}
+
+uint16_t ref_acamera_sqrt32( uint32_t arg )
+{
+    uint32_t mask = (uint32_t)1 << 15;
+    uint16_t res = 0;
+    int i = 0;
+
+    for ( i = 0; i < 16; i++ ) {
+        if ( ( res + ( mask >> i ) ) * ( res + ( mask >> i ) ) <= arg )
+            res = res + ( mask >> i );
+    }
+    return res;
+}
+
+uint8_t ref_acamera_sqrt16( uint16_t arg )
+{
+    uint8_t mask = 128;
+    uint8_t res = 0;
+    uint8_t i = 0;
+
+    for ( i = 0; i < 8; i++ ) {
+        if ( ( res + ( mask >> i ) ) * ( res + ( mask >> i ) ) <= arg ) {
+            res = res + ( mask >> i );
+        }
+    }
+    return res;
+}
+
+uint8_t ref_acamera_log16( uint16_t arg )
+{
+    uint8_t k = 0;
+    uint8_t res = 0;
+
+    for ( k = 0; k < 16; k++ ) {
+        if ( arg > ( 1 << k ) ) {
+            res = ( k << 4 ) + ( ( arg << 4 ) / ( 1 << ( k ) ) ) - 16;
+        }
+    }
+    return res;
+}
+
+uint32_t ref_acamera_div_fixed( uint32_t a, uint32_t b, const int16_t fraction_size )
+{
+    if ( b == 0 ) {
+        return a << fraction_size;
+    }
+    return ( uint32_t )( ( (uint64_t)a << fraction_size ) / b );
+}
+
+uint16_t ref_acamera_calc_modulation_u16( uint16_t x, const modulation_entry_t *p_table, int table_len )
+{
+    int i;
+
+    if ( x <= p_table->x ) {
+        return p_table->y;
+    }
+    if ( x >= p_table[table_len - 1].x ) {
+        return p_table[table_len - 1].y;
+    }
+    for ( i = 1; i < table_len; ++i ) {
+        if ( x < p_table[i].x ) {
+            break;
+        }
+    }
+    if ( ( p_table[i].x - p_table[i - 1].x ) != 0 ) {
+        int alpha = ( x - p_table[i - 1].x ) * 256 / ( p_table[i].x - p_table[i - 1].x );
+        return ( p_table[i].y * alpha + p_table[i - 1].y * ( 256 - alpha ) ) >> 8;
+    }
+    return p_table[i].y;
+}
+
+uint32_t ref_acamera_calc_modulation_u32( uint32_t x, const modulation_entry_32_t *p_table, int table_len )
+{
+    uint16_t i;
+
+    if ( x <= p_table->x ) {
+        return p_table->y;
+    }
+    if ( x >= p_table[table_len - 1].x ) {
+        return p_table[table_len - 1].y;
+    }
+    for ( i = 1; i < table_len; ++i ) {
+        if ( x < p_table[i].x ) {
+            break;
+        }
+    }
+    if ( ( p_table[i].x - p_table[i - 1].x ) != 0 ) {
+        uint32_t alpha = ( x - p_table[i - 1].x ) * 256 / ( p_table[i].x - p_table[i - 1].x );
+        return ( p_table[i].y * alpha + p_table[i - 1].y * ( 256 - alpha ) ) >> 8;
+    }
+    return p_table[i].y;
+}
+
+uint16_t ref_acamera_calc_scaled_modulation_u16( uint16_t x, uint16_t target_min_y, uint16_t target_max_y, const modulation_entry_t *p_table, int table_len )
+{
+    if ( x <= p_table[0].x ) {
+        return target_min_y;
+    }
+    if ( x >= p_table[table_len - 1].x ) {
+        return target_max_y;
+    }
+    if ( ( p_table[0].y == 0 ) || ( p_table[table_len - 1].y == 0 ) || ( ( p_table[table_len - 1].x - p_table[0].x ) == 0 ) ) {
+        return 0;
+    } else {
+        uint32_t scale_min_y = (uint32_t)target_min_y * 256 / p_table[0].y;
+        uint32_t scale_max_y = (uint32_t)target_max_y * 256 / p_table[table_len - 1].y;
+        int alpha = ( x - p_table[0].x ) * 256 / ( p_table[table_len - 1].x - p_table[0].x );
+        uint32_t scale_factor = ( scale_max_y * alpha + scale_min_y * ( 256 - alpha ) ) >> 8;
+        int i;
+        for ( i = 1; i < table_len; ++i ) {
+            if ( x < p_table[i].x ) {
+                break;
+            }
+        }
+        if ( ( p_table[i].x - p_table[i - 1].x ) != 0 ) {
+            alpha = ( x - p_table[i - 1].x ) * 256 / ( p_table[i].x - p_table[i - 1].x );
+            return scale_factor * ( p_table[i].y * alpha + p_table[i - 1].y * ( 256 - alpha ) ) >> 16;
+        }
+        return p_table[i].y;
+    }
+}
+
+uint16_t ref_acamera_calc_inv_equidistant_modulation_u16( uint16_t x, const uint16_t *p_table, uint16_t table_len )
+{
+    int i;
+    uint16_t d;
+    uint16_t alpha;
+
+    if ( x <= p_table[0] ) {
+        return 0;
+    }
+    if ( x >= p_table[table_len - 1] ) {
+        return ( ( 1 << 16 ) - 1 );
+    }
+    if ( table_len == 1 ) {
+        return 0;
+    }
+    for ( i = 1; i < table_len; ++i ) {
+        if ( x < p_table[i] ) {
+            break;
+        }
+    }
+    d = ( 1 << 16 ) / ( table_len - 1 );
+    if ( p_table[i] == p_table[i - 1] ) {
+        return d * i;
+    }
+    alpha = ( x - p_table[i - 1] ) * 256 / ( p_table[i] - p_table[i - 1] );
+    return ( d * i * alpha + d * ( i - 1 ) * ( 256 - alpha ) ) / 256;
+}
+
+uint32_t ref_acamera_calc_inv_equidistant_modulation_u32( uint32_t x, const uint32_t *p_table, uint32_t table_len )
+{
+    int i;
+    uint32_t d;
+    uint32_t alpha;
+
+    if ( x <= p_table[0] ) {
+        return 0;
+    }
+    if ( x >= p_table[table_len - 1] ) {
+        return ( ( 1 << 16 ) - 1 );
+    }
+    if ( table_len == 1 ) {
+        return 0;
+    }
+    for ( i = 1; i < table_len; ++i ) {
+        if ( x < p_table[i] ) {
+            break;
+        }
+    }
+    d = ( 1 << 16 ) / ( table_len - 1 );
+    if ( p_table[i] == p_table[i - 1] ) {
+        return d * i;
+    }
+    alpha = ( x - p_table[i - 1] ) * 256 / ( p_table[i] - p_table[i - 1] );
+    return ( d * i * alpha + d * ( i - 1 ) * ( 256 - alpha ) ) / 256;
+}
@@ -0,0 +1,42 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#ifndef __ACAMERA_MATH_REF_H__
+#define __ACAMERA_MATH_REF_H__
+
+// Previous bit-serial and linear-scan versions of the acamera_math.c functions.
+// The host test checks the table driven implementation against them.
+
+#include "acamera_math.h"
+
+uint32_t ref_acamera_log2_int_to_fixed( const uint32_t val, const uint8_t out_precision, const uint8_t shift_out );
+int32_t ref_acamera_log2_fixed_to_fixed_64( uint64_t val, int32_t in_fix_point, uint8_t out_fix_point );
+uint32_t ref_acamera_sqrt64( uint64_t arg );
+uint16_t ref_acamera_sqrt32( uint32_t arg );
+uint8_t ref_acamera_sqrt16( uint16_t arg );
+uint8_t ref_acamera_log16( uint16_t arg );
+uint32_t ref_acamera_div_fixed( uint32_t a, uint32_t b, const int16_t fraction_size );
+uint16_t ref_acamera_calc_modulation_u16( uint16_t x, const modulation_entry_t *p_table, int table_len );
+uint32_t ref_acamera_calc_modulation_u32( uint32_t x, const modulation_entry_32_t *p_table, int table_len );
+uint16_t ref_acamera_calc_scaled_modulation_u16( uint16_t x, uint16_t target_min_y, uint16_t target_max_y, const modulation_entry_t *p_table, int table_len );
+uint16_t ref_acamera_calc_inv_equidistant_modulation_u16( uint16_t x, const uint16_t *p_table, uint16_t table_len );
+uint32_t ref_acamera_calc_inv_equidistant_modulation_u32( uint32_t x, const uint32_t *p_table, uint32_t table_len );
+
+#endif /* __ACAMERA_MATH_REF_H__ */
@@ -0,0 +1,246 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+// Host test of the fixed-point math library.
+// Checks the table driven log2 against the exact value and the previous
+// bit-serial code, checks the other functions bit-exact against their previous
+// versions and reports the throughput of both.
+
+#include <stdlib.h>
+#include <math.h>
+#include "host_test.h"
+#include "acamera_math.h"
+#include "acamera_math_ref.h"
+
+// every input below 2^20, then a stride over the rest of the 32-bit range
+#define LOG2_DENSE_LIMIT ( 1u << 20 )
+#define LOG2_STRIDE 251
+
+//  The fraction is truncated (below 1 LSB) and the table interpolation stays
+//  within 2^-18 of log2, so the error bound is 1 + 2^(precision - 18) LSB.
+static double log2_error_bound( uint8_t precision )
+{
+    return 1.0 + ldexp( 1.0, precision - 18 ) + 1e-9;
+}
+
+static void test_log2_int( uint8_t precision )
+{
+    const double lsb = 1.0 / ( 1 << precision );
+    const double max_err_lsb = log2_error_bound( precision );
+    double err_new = 0, err_ref = 0;
+    int32_t max_diff = 0;
+    uint32_t int_mismatch = 0;
+    uint64_t v;
+
+    for ( v = 1; v <= 0xFFFFFFFFull; v += ( v < LOG2_DENSE_LIMIT ) ? 1 : LOG2_STRIDE ) {
+        const uint32_t r_new = acamera_log2_int_to_fixed( (uint32_t)v, precision, 0 );
+        const uint32_t r_ref = ref_acamera_log2_int_to_fixed( (uint32_t)v, precision, 0 );
+        const double exact = log2( (double)v );
+        const double e_new = fabs( r_new * lsb - exact ) / lsb;
+        const double e_ref = fabs( r_ref * lsb - exact ) / lsb;
+        const int32_t diff = (int32_t)r_new - (int32_t)r_ref;
+
+        if ( e_new > err_new )
+            err_new = e_new;
+        if ( e_ref > err_ref )
+            err_ref = e_ref;
+        if ( abs( diff ) > max_diff )
+            max_diff = abs( diff );
+        if ( ( r_new >> precision ) != ( r_ref >> precision ) )
+            int_mismatch++;
+    }
+
+    printf( "log2_int_to_fixed  prec %2d: max error new %.3f LSB, old %.3f LSB, max new-old %d LSB\n", precision, err_new, err_ref, max_diff );
+    CHECK( int_mismatch == 0, "log2 prec %d: integer part differs from the old code for %u inputs", precision, int_mismatch );
+    CHECK( err_new <= max_err_lsb, "log2 prec %d: error %.3f LSB above the %.3f LSB bound", precision, err_new, max_err_lsb );
+    CHECK( err_new <= err_ref + 1.0, "log2 prec %d: error %.3f LSB worse than the old code %.3f LSB", precision, err_new, err_ref );
+}
+
+static void test_log2_64( uint8_t precision )
+{
+    const double lsb = 1.0 / ( 1 << precision );
+    const double max_err_lsb = log2_error_bound( precision );
+    double err_new = 0, err_ref = 0;
+    int i;
+
+    for ( i = 0; i < 4000000; i++ ) {
+        const uint64_t v = ( ( (uint64_t)rng() << 32 ) | rng() ) >> ( rng() & 63 );
+        int32_t r_new, r_ref;
+        double exact, e_new, e_ref;
+
+        if ( v == 0 )
+            continue;
+        r_new = acamera_log2_fixed_to_fixed_64( v, 0, precision );
+        r_ref = ref_acamera_log2_fixed_to_fixed_64( v, 0, precision );
+        exact = log2( (double)v );
+        e_new = fabs( r_new * lsb - exact ) / lsb;
+        e_ref = fabs( r_ref * lsb - exact ) / lsb;
+        if ( e_new > err_new )
+            err_new = e_new;
+        if ( e_ref > err_ref )
+            err_ref = e_ref;
+    }
+
+    printf( "log2_fixed_to_fixed_64 prec %2d: max error new %.3f LSB, old %.3f LSB\n", precision, err_new, err_ref );
+    CHECK( err_new <= max_err_lsb, "log2_64 prec %d: error %.3f LSB above the %.3f LSB bound", precision, err_new, max_err_lsb );
+}
+
+static void test_exact( void )
+{
+    modulation_entry_t tab16[64];
+    modulation_entry_32_t tab32[64];
+    uint16_t inv16[33];
+    uint32_t inv32[33];
+    const int failures_before = failures;
+    uint32_t mismatch = 0;
+    uint32_t i;
+    int len;
+
+    for ( i = 0; i < 65536; i++ ) {
+        mismatch += acamera_sqrt16( (uint16_t)i ) != ref_acamera_sqrt16( (uint16_t)i );
+        mismatch += acamera_log16( (uint16_t)i ) != ref_acamera_log16( (uint16_t)i );
+    }
+    CHECK( mismatch == 0, "sqrt16/log16: %u mismatches", mismatch );
+
+    mismatch = 0;
+    for ( i = 0; i < 4000000; i++ ) {
+        const uint32_t v = rng() >> ( rng() & 31 );
+        const uint64_t w = ( ( (uint64_t)rng() << 32 ) | rng() ) >> ( rng() & 63 );
+        const uint32_t b = ( rng() >> ( rng() & 31 ) ) | 1;
+        const int16_t frac = rng() & 15;
+        mismatch += acamera_sqrt32( v ) != ref_acamera_sqrt32( v );
+        mismatch += acamera_sqrt64( w ) != ref_acamera_sqrt64( w );
+        mismatch += acamera_div_fixed( v, b, frac ) != ref_acamera_div_fixed( v, b, frac );
+    }
+    CHECK( mismatch == 0, "sqrt32/sqrt64/div_fixed: %u mismatches", mismatch );
+
+    // sorted tables of every length, with repeated x to take the zero width segment
+    mismatch = 0;
+    for ( len = 2; len <= 64; len++ ) {
+        uint32_t x16 = 0, x32 = 0;
+        int k;
+        for ( k = 0; k < len; k++ ) {
+            x16 += ( k == len / 2 ) ? 0 : rng() % ( 65535 / len );
+            x32 += ( k == len / 2 ) ? 0 : rng() % ( 0x7FFFFFFF / len );
+            tab16[k].x = (uint16_t)x16;
+            tab16[k].y = rng() & 0xFFF;
+            tab32[k].x = x32;
+            tab32[k].y = rng() & 0xFFFFF;
+        }
+        for ( i = 0; i < 65536; i++ ) {
+            const uint32_t x = rng() % ( x32 + 2 );
+            mismatch += acamera_calc_modulation_u16( (uint16_t)i, tab16, len ) != ref_acamera_calc_modulation_u16( (uint16_t)i, tab16, len );
+            mismatch += acamera_calc_scaled_modulation_u16( (uint16_t)i, 100, 900, tab16, len ) != ref_acamera_calc_scaled_modulation_u16( (uint16_t)i, 100, 900, tab16, len );
+            mismatch += acamera_calc_modulation_u32( x, tab32, len ) != ref_acamera_calc_modulation_u32( x, tab32, len );
+        }
+    }
+    CHECK( mismatch == 0, "modulation: %u mismatches", mismatch );
+
+    mismatch = 0;
+    for ( i = 0; i < 33; i++ ) {
+        inv16[i] = (uint16_t)( i * i * 50 + ( i == 20 ? 0 : i ) );
+        inv32[i] = i * i * i * 1000;
+    }
+    inv16[21] = inv16[20];
+    for ( i = 0; i < 65536; i++ ) {
+        mismatch += acamera_calc_inv_equidistant_modulation_u16( (uint16_t)i, inv16, 33 ) != ref_acamera_calc_inv_equidistant_modulation_u16( (uint16_t)i, inv16, 33 );
+        mismatch += acamera_calc_inv_equidistant_modulation_u32( i * 500, inv32, 33 ) != ref_acamera_calc_inv_equidistant_modulation_u32( i * 500, inv32, 33 );
+    }
+    CHECK( mismatch == 0, "inverse equidistant modulation: %u mismatches", mismatch );
+
+    mismatch = 0;
+    for ( i = 0; i < 1000000; i++ ) {
+        const uint32_t d = ( i < 70000 ) ? i + 1 : ( rng() >> ( rng() & 31 ) ) | 1;
+        acamera_reciprocal_t rcp;
+        int k;
+        acamera_reciprocal_init( &rcp, d );
+        for ( k = 0; k < 8; k++ ) {
+            const uint32_t n = ( k == 0 ) ? 0xFFFFFFFF : ( k == 1 ) ? d - 1 : ( k == 2 ) ? d : rng();
+            mismatch += acamera_reciprocal_div( n, &rcp ) != n / d;
+        }
+    }
+    CHECK( mismatch == 0, "reciprocal division: %u mismatches", mismatch );
+
+    printf( "sqrt, log16, div_fixed, modulation and reciprocal division: %s\n", ( failures != failures_before ) ? "mismatches found" : "bit-exact" );
+}
+
+#define BENCH_CALLS 20000000
+
+#define BENCH( name, expr )                                                  \
+    do {                                                                     \
+        volatile uint32_t sink = 0;                                          \
+        double t0 = now_s();                                                 \
+        uint32_t n;                                                          \
+        for ( n = 1; n <= BENCH_CALLS; n++ ) {                               \
+            sink += ( expr );                                                \
+        }                                                                    \
+        printf( "  %-36s %6.2f ns/call\n", name, ( now_s() - t0 ) * 1e9 / BENCH_CALLS ); \
+        (void)sink;                                                          \
+    } while ( 0 )
+
+static void bench( void )
+{
+    modulation_entry_t tab[32];
+    uint16_t inv[33];
+    acamera_reciprocal_t rcp;
+    volatile uint32_t divisor = 1000 + ( rng() & 0xFF );
+    int k;
+
+    for ( k = 0; k < 32; k++ ) {
+        tab[k].x = (uint16_t)( k * 2000 + k * k * 2 );
+        tab[k].y = (uint16_t)( ( k * 37 ) % 500 );
+    }
+    for ( k = 0; k < 33; k++ ) {
+        inv[k] = (uint16_t)( k * k * 50 );
+    }
+    acamera_reciprocal_init( &rcp, divisor );
+
+    printf( "throughput:\n" );
+    BENCH( "old log2_int_to_fixed(18)", ref_acamera_log2_int_to_fixed( n * 2654435761u, 18, 0 ) );
+    BENCH( "new log2_int_to_fixed(18)", acamera_log2_int_to_fixed( n * 2654435761u, 18, 0 ) );
+    BENCH( "old log2_fixed_to_fixed_64(18)", ref_acamera_log2_fixed_to_fixed_64( (uint64_t)n * 2654435761u, 0, 18 ) );
+    BENCH( "new log2_fixed_to_fixed_64(18)", acamera_log2_fixed_to_fixed_64( (uint64_t)n * 2654435761u, 0, 18 ) );
+    BENCH( "old calc_modulation_u16 (32 entries)", ref_acamera_calc_modulation_u16( n & 0xFFFF, tab, 32 ) );
+    BENCH( "new calc_modulation_u16 (32 entries)", acamera_calc_modulation_u16( n & 0xFFFF, tab, 32 ) );
+    BENCH( "old inv_equidistant_u16 (33 entries)", ref_acamera_calc_inv_equidistant_modulation_u16( n & 0xFFFF, inv, 33 ) );
+    BENCH( "new inv_equidistant_u16 (33 entries)", acamera_calc_inv_equidistant_modulation_u16( n & 0xFFFF, inv, 33 ) );
+    BENCH( "old div_fixed", ref_acamera_div_fixed( n & 0xFFFFF, divisor, 8 ) );
+    BENCH( "new div_fixed", acamera_div_fixed( n & 0xFFFFF, divisor, 8 ) );
+    BENCH( "division by a zone weight sum", n / divisor );
+    BENCH( "reciprocal_div", acamera_reciprocal_div( n, &rcp ) );
+}
+
+int main( int argc, char **argv )
+{
+    test_log2_int( 0 );
+    test_log2_int( 6 );
+    test_log2_int( 8 );
+    test_log2_int( 16 );
+    test_log2_int( LOG2_GAIN_SHIFT );
+    test_log2_64( LOG2_GAIN_SHIFT );
+    test_exact();
+
+    if ( bench_enabled( argc, argv ) ) {
+        bench();
+    }
+
+    printf( "acamera_math: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,240 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// Host test of the sensor preset switch against a stub bus. The stub keeps a
+// register image of the sensor and the time each transfer takes on a 400kHz
+// i2c bus, so the test checks that a switch leaves the sensor exactly as a
+// full load of the target preset does, and how much bus time it saves.
+
+#include "host_test.h"
+#include "sensor_init.h"
+#include "system_stdlib.h"
+#include "system_timer.h"
+
+#define BUS_BYTE_NS 22500 // 9 bits at 400kHz
+#define BUS_HEADER 3      // device address and a 16-bit register address
+
+typedef struct _stub_bus_t {
+    uint8_t regs[0x10000];
+    uint64_t bus_ns;
+    uint64_t sleep_ns;
+    uint32_t transfers;
+} stub_bus_t;
+
+static stub_bus_t bus;
+static acamera_sbus_t sbus;
+
+static void bus_transfer( uint32_t bytes )
+{
+    bus.transfers++;
+    bus.bus_ns += (uint64_t)( BUS_HEADER + bytes ) * BUS_BYTE_NS;
+}
+
+// registers wider than 8 bits are big endian like on most sensors
+static uint32_t bus_read( uintptr_t addr, int bytes )
+{
+    uint32_t value = 0;
+    int i;
+    bus_transfer( bytes );
+    for ( i = 0; i < bytes; i++ )
+        value = ( value << 8 ) | bus.regs[( addr + i ) & 0xffff];
+    return value;
+}
+
+static void bus_write( uintptr_t addr, uint32_t value, int bytes )
+{
+    int i;
+    bus_transfer( bytes );
+    for ( i = bytes - 1; i >= 0; i--, value >>= 8 )
+        bus.regs[( addr + i ) & 0xffff] = (uint8_t)value;
+}
+
+uint8_t acamera_sbus_read_u8( acamera_sbus_ptr_t p_bus, uintptr_t addr ) { return (uint8_t)bus_read( addr, 1 ); }
+uint16_t acamera_sbus_read_u16( acamera_sbus_ptr_t p_bus, uintptr_t addr ) { return (uint16_t)bus_read( addr, 2 ); }
+uint32_t acamera_sbus_read_u32( acamera_sbus_ptr_t p_bus, uintptr_t addr ) { return bus_read( addr, 4 ); }
+void acamera_sbus_write_u8( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint8_t sample ) { bus_write( addr, sample, 1 ); }
+void acamera_sbus_write_u16( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint16_t sample ) { bus_write( addr, sample, 2 ); }
+void acamera_sbus_write_u32( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint32_t sample ) { bus_write( addr, sample, 4 ); }
+
+void acamera_sbus_write_data_u8( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint8_t *p_data, int n_count )
+{
+    CHECK( n_count > 0 && n_count <= SBUS_BLOCK_MAX, "block of %d bytes", n_count );
+    bus_transfer( n_count );
+    memcpy( bus.regs + addr, p_data, n_count );
+}
+
+int32_t system_timer_usleep( uint32_t usec )
+{
+    bus.sleep_ns += (uint64_t)usec * 1000;
+    return 0;
+}
+
+int32_t system_memcpy( void *dst, const void *src, uint32_t size )
+{
+    memcpy( dst, src, size );
+    return 0;
+}
+
+// A shared base group, two presets written as deltas and an end marker.
+enum { GROUP_BASE,
+       GROUP_A,
+       GROUP_B,
+       GROUP_R,
+       GROUP_NUM };
+
+#define SEQ_END {0x0000, 0x0000, 0x0000, 0x0000}
+#define SEQ_WAIT( ms ) {0xFFFF, ms, 0x0000, 0x0000}
+
+static acam_reg_t seq_base[512];
+static acam_reg_t seq_a[64];
+static acam_reg_t seq_b[64];
+static acam_reg_t seq_r[8];
+static const acam_reg_t *sequence[GROUP_NUM] = {seq_base, seq_a, seq_b, seq_r};
+
+static void build_sequences( void )
+{
+    int n = 0, i;
+
+    // a typical init: soft reset, a wait, then long runs of 8-bit registers
+    seq_base[n++] = ( acam_reg_t ){0x0103, 0x01, 0, 0};
+    seq_base[n++] = ( acam_reg_t )SEQ_WAIT( 5 );
+    seq_base[n++] = ( acam_reg_t ){0x0100, 0x01, 0, 0}; // streaming
+    for ( i = 0; i < 320; i++ )
+        seq_base[n++] = ( acam_reg_t ){0x3000 + i, ( i * 7 ) & 0xff, 0, 0};
+    for ( i = 0; i < 64; i++ )
+        seq_base[n++] = ( acam_reg_t ){0x3800 + i, i, 0, 0};
+    seq_base[n++] = ( acam_reg_t ){0x4010, 0x0f, 0, 0};
+    // the loader keeps an entry size for the rest of the group, so wide registers go last
+    seq_base[n++] = ( acam_reg_t ){0x4000, 0x1234, 0, 2};
+    seq_base[n] = ( acam_reg_t )SEQ_END;
+
+    // preset A: window and timing, a register set only by A and a masked update
+    n = 0;
+    for ( i = 0; i < 8; i++ )
+        seq_a[n++] = ( acam_reg_t ){0x3800 + i, 0xa0 + i, 0, 0};
+    seq_a[n++] = ( acam_reg_t ){0x3100, 0x55, 0, 0}; // only in A, base has another value
+    seq_a[n++] = ( acam_reg_t ){0x3101, ( 1 * 7 ) & 0xff, 0, 0};
+    seq_a[n++] = ( acam_reg_t ){0x4010, 0x30, 0xf0, 0};
+    seq_a[n++] = ( acam_reg_t ){0x4000, 0x0780, 0, 2};
+    seq_a[n] = ( acam_reg_t )SEQ_END;
+
+    // preset B: part of the same window with other values, a wait and B only registers
+    n = 0;
+    for ( i = 0; i < 4; i++ )
+        seq_b[n++] = ( acam_reg_t ){0x3800 + i, 0xa0 + i, 0, 0}; // same as A
+    for ( i = 4; i < 12; i++ )
+        seq_b[n++] = ( acam_reg_t ){0x3800 + i, 0xb0 + i, 0, 0};
+    seq_b[n++] = ( acam_reg_t )SEQ_WAIT( 1 );
+    seq_b[n++] = ( acam_reg_t ){0x3200, 0x99, 0, 0}; // only in B, not in base
+    seq_b[n++] = ( acam_reg_t ){0x4010, 0x50, 0xf0, 0};
+    seq_b[n++] = ( acam_reg_t ){0x4000, 0x0438, 0, 2};
+    seq_b[n] = ( acam_reg_t )SEQ_END;
+
+    // preset R: stops streaming around a window change and starts it again
+    n = 0;
+    seq_r[n++] = ( acam_reg_t ){0x0100, 0x00, 0, 0};
+    seq_r[n++] = ( acam_reg_t ){0x3800, 0xc0, 0, 0};
+    seq_r[n++] = ( acam_reg_t ){0x0100, 0x01, 0, 0};
+    seq_r[n] = ( acam_reg_t )SEQ_END;
+}
+
+static void bus_reset( void )
+{
+    memset( &bus, 0, sizeof( bus ) );
+}
+
+static void test_switch( void )
+{
+    static uint8_t expected[0x10000];
+    uint64_t full_ns, switch_ns;
+    uint32_t full_transfers, written;
+
+    // reference: the sensor after a full load of B
+    bus_reset();
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_BASE );
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_B );
+    memcpy( expected, bus.regs, sizeof( expected ) );
+    full_ns = bus.bus_ns + bus.sleep_ns;
+    full_transfers = bus.transfers;
+
+    // the sensor running A switches to B
+    bus_reset();
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_BASE );
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_A );
+    bus.bus_ns = bus.sleep_ns = bus.transfers = 0;
+    written = acamera_sensor_switch_array_sequence( &sbus, 1, sequence, GROUP_BASE, GROUP_A, GROUP_B );
+    switch_ns = bus.bus_ns + bus.sleep_ns;
+
+    CHECK( memcmp( bus.regs, expected, sizeof( expected ) ) == 0, "switch A -> B does not match a full load of B" );
+    CHECK( bus.regs[0x3100] == ( ( 0x100 * 7 ) & 0xff ), "register set only by A not restored: 0x%x", bus.regs[0x3100] );
+    CHECK( bus.regs[0x4010] == 0x5f, "masked register 0x%x", bus.regs[0x4010] );
+    CHECK( bus.sleep_ns == 1000000, "switch slept %llu ns", (unsigned long long)bus.sleep_ns );
+    // 8 window registers, 0x3100, 0x4000, 0x3200 and the masked register
+    CHECK( written == 12, "switch wrote %u registers", written );
+    CHECK( switch_ns * 10 < full_ns, "switch takes %llu us, full load %llu us", (unsigned long long)( switch_ns / 1000 ), (unsigned long long)( full_ns / 1000 ) );
+
+    printf( "preset switch: %u registers in %u transfers, %llu us; full load %u transfers, %llu us\n",
+            written, bus.transfers, (unsigned long long)( switch_ns / 1000 ), full_transfers, (unsigned long long)( full_ns / 1000 ) );
+
+    // and back: the B only register has no base value and is left alone
+    bus.bus_ns = bus.sleep_ns = bus.transfers = 0;
+    acamera_sensor_switch_array_sequence( &sbus, 1, sequence, GROUP_BASE, GROUP_B, GROUP_A );
+    memcpy( expected, bus.regs, sizeof( expected ) );
+    bus_reset();
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_BASE );
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_A );
+    expected[0x3200] = 0;
+    CHECK( memcmp( bus.regs, expected, sizeof( expected ) ) == 0, "switch B -> A does not match a full load of A" );
+}
+
+// A register written twice by the target preset is compared against its
+// own earlier write, not against the value it had before the switch.
+static void test_rewrite( void )
+{
+    static uint8_t expected[0x10000];
+    uint32_t written;
+
+    bus_reset();
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_BASE );
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_R );
+    memcpy( expected, bus.regs, sizeof( expected ) );
+
+    bus_reset();
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_BASE );
+    acamera_sensor_load_array_sequence( &sbus, 1, sequence, GROUP_A );
+    written = acamera_sensor_switch_array_sequence( &sbus, 1, sequence, GROUP_BASE, GROUP_A, GROUP_R );
+
+    CHECK( bus.regs[0x0100] == 0x01, "streaming left off by the switch" );
+    // the three R entries, 7 window registers, 0x3100, 0x4010 and 0x4000 restored
+    CHECK( written == 3 + 10, "switch wrote %u registers", written );
+    // A only registers are restored from the base, so compare what R sets
+    CHECK( memcmp( bus.regs, expected, sizeof( expected ) ) == 0, "switch A -> R does not match a full load of R" );
+}
+
+int main( int argc, char **argv )
+{
+    build_sequences();
+    test_switch();
+    test_rewrite();
+
+    printf( "sensor_switch: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// Per frame register writes of the white balance, mesh shading alpha, colour
+// matrix and crop to the software config map. The file is built once per
+// accessor flavour, FRAME_WRITES names the function and GROUPED selects the
+// grouped accessors of acamera_isp1_group_config.h.
+
+#include "acamera_isp_config.h"
+#include "sw_io_frame.h"
+
+void FRAME_WRITES( uintptr_t base, const sw_io_frame_t *p_frame )
+{
+#if GROUPED
+    acamera_isp_white_balance_gain_00_01_write( base, p_frame->wb[0], p_frame->wb[1] );
+    acamera_isp_white_balance_gain_10_11_write( base, p_frame->wb[2], p_frame->wb[3] );
+    acamera_isp_mesh_shading_mesh_alpha_bank_rgb_write( base, p_frame->bank, p_frame->bank, p_frame->bank );
+    acamera_isp_mesh_shading_mesh_alpha_rgb_write( base, p_frame->alpha, p_frame->alpha, p_frame->alpha );
+#else
+    acamera_isp_white_balance_gain_00_write( base, p_frame->wb[0] );
+    acamera_isp_white_balance_gain_01_write( base, p_frame->wb[1] );
+    acamera_isp_white_balance_gain_10_write( base, p_frame->wb[2] );
+    acamera_isp_white_balance_gain_11_write( base, p_frame->wb[3] );
+    acamera_isp_mesh_shading_mesh_alpha_bank_r_write( base, p_frame->bank );
+    acamera_isp_mesh_shading_mesh_alpha_bank_g_write( base, p_frame->bank );
+    acamera_isp_mesh_shading_mesh_alpha_bank_b_write( base, p_frame->bank );
+    acamera_isp_mesh_shading_mesh_alpha_r_write( base, p_frame->alpha );
+    acamera_isp_mesh_shading_mesh_alpha_g_write( base, p_frame->alpha );
+    acamera_isp_mesh_shading_mesh_alpha_b_write( base, p_frame->alpha );
+#endif
+    acamera_isp_ccm_coefft_r_r_write( base, p_frame->ccm[0] );
+    acamera_isp_ccm_coefft_r_g_write( base, p_frame->ccm[1] );
+    acamera_isp_ccm_coefft_r_b_write( base, p_frame->ccm[2] );
+    acamera_isp_ccm_coefft_g_r_write( base, p_frame->ccm[3] );
+    acamera_isp_ccm_coefft_g_g_write( base, p_frame->ccm[4] );
+    acamera_isp_ccm_coefft_g_b_write( base, p_frame->ccm[5] );
+    acamera_isp_ccm_coefft_b_r_write( base, p_frame->ccm[6] );
+    acamera_isp_ccm_coefft_b_g_write( base, p_frame->ccm[7] );
+    acamera_isp_ccm_coefft_b_b_write( base, p_frame->ccm[8] );
+    acamera_isp_fr_crop_start_x_write( base, p_frame->crop[0] );
+    acamera_isp_fr_crop_start_y_write( base, p_frame->crop[1] );
+    acamera_isp_fr_crop_size_x_write( base, p_frame->crop[2] );
+    acamera_isp_fr_crop_size_y_write( base, p_frame->crop[3] );
+}
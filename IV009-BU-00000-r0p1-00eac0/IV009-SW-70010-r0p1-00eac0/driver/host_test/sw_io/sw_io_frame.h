@@ -0,0 +1,43 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+#if !defined( __SW_IO_FRAME_H__ )
+#define __SW_IO_FRAME_H__
+
+#include <stdint.h>
+
+// values written by one frame
+typedef struct _sw_io_frame_t {
+    uint16_t wb[4];
+    uint8_t bank;
+    uint8_t alpha;
+    uint16_t ccm[9];
+    uint16_t crop[4];
+} sw_io_frame_t;
+
+// out-of-line accessors, field by field
+void sw_io_frame_out( uintptr_t base, const sw_io_frame_t *p_frame );
+// inline accessors, field by field
+void sw_io_frame_inline( uintptr_t base, const sw_io_frame_t *p_frame );
+// inline accessors, grouped fields
+void sw_io_frame_grouped( uintptr_t base, const sw_io_frame_t *p_frame );
+
+#endif /* __SW_IO_FRAME_H__ */
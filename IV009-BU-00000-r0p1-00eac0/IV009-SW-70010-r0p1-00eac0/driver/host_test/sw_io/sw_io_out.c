@@ -0,0 +1,44 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// The out-of-line accessors as the platforms without SYSTEM_SW_IO_INLINE
+// build them, with the NULL base check of the kernel platform.
+
+#include <stddef.h>
+#include "system_sw_io.h"
+
+uint32_t system_sw_read_32( uintptr_t addr )
+{
+    uint32_t result = 0;
+    if ( (void *)addr != NULL ) {
+        volatile uint32_t *p_addr = (volatile uint32_t *)( addr );
+        result = *p_addr;
+    }
+    return result;
+}
+
+void system_sw_write_32( uintptr_t addr, uint32_t data )
+{
+    if ( (void *)addr != NULL ) {
+        volatile uint32_t *p_addr = (volatile uint32_t *)( addr );
+        *p_addr = data;
+    }
+}
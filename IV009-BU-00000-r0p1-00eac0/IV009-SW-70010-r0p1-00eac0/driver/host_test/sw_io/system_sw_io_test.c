@@ -0,0 +1,137 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+
+// Checks that the inline and grouped software config map accessors leave
+// the map exactly as the out-of-line ones do, and that the inline ones keep
+// the NULL base check. The throughput report times the per frame writes of
+// each flavour.
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "system_sw_io.h"
+#include "sw_io_frame.h"
+
+#define MAP_SIZE 0x20000
+#define FRAMES 2000
+#define BENCH_FRAMES 20000000
+
+static int null_reads;
+static int null_writes;
+
+void system_sw_io_null_access( uintptr_t addr, uint32_t data, int write )
+{
+    if ( write ) {
+        null_writes++;
+    } else {
+        null_reads++;
+    }
+}
+
+typedef void ( *frame_writes_f )( uintptr_t base, const sw_io_frame_t *p_frame );
+
+static void random_frame( sw_io_frame_t *p_frame )
+{
+    int i;
+
+    for ( i = 0; i < 4; i++ )
+        p_frame->wb[i] = rng() & 0xFFF;
+    p_frame->bank = rng() & 7;
+    p_frame->alpha = rng() & 0xFF;
+    for ( i = 0; i < 9; i++ )
+        p_frame->ccm[i] = rng() & 0x1FFF;
+    for ( i = 0; i < 4; i++ )
+        p_frame->crop[i] = rng() & 0xFFFF;
+}
+
+static void test_maps( void )
+{
+    uint32_t *map_out = malloc( MAP_SIZE );
+    uint32_t *map_inline = malloc( MAP_SIZE );
+    uint32_t *map_grouped = malloc( MAP_SIZE );
+    sw_io_frame_t frame;
+    int i, ok = 1;
+
+    // the bits next to the fields written must survive as well
+    for ( i = 0; i < MAP_SIZE / 4; i++ )
+        map_out[i] = rng();
+    memcpy( map_inline, map_out, MAP_SIZE );
+    memcpy( map_grouped, map_out, MAP_SIZE );
+
+    for ( i = 0; i < FRAMES && ok; i++ ) {
+        random_frame( &frame );
+        sw_io_frame_out( (uintptr_t)map_out, &frame );
+        sw_io_frame_inline( (uintptr_t)map_inline, &frame );
+        sw_io_frame_grouped( (uintptr_t)map_grouped, &frame );
+        ok = memcmp( map_out, map_inline, MAP_SIZE ) == 0 && memcmp( map_out, map_grouped, MAP_SIZE ) == 0;
+    }
+    CHECK( ok, "config maps differ after frame %d", i );
+
+    free( map_out );
+    free( map_inline );
+    free( map_grouped );
+}
+
+static void test_null_base( void )
+{
+    CHECK( system_sw_read_32( 0 ) == 0 && null_reads == 1, "read through a NULL base: %d reports", null_reads );
+    system_sw_write_32( 0, 0x1234 );
+    CHECK( null_writes == 1, "write through a NULL base: %d reports", null_writes );
+    system_sw_update_32( 0, 0xFF, 0x12 );
+    CHECK( null_reads == 2 && null_writes == 2, "update through a NULL base: %d reads, %d writes reported", null_reads, null_writes );
+}
+
+static double ns_per_frame( frame_writes_f frame_writes, uint32_t *map )
+{
+    sw_io_frame_t frame;
+    double start;
+    int i;
+
+    random_frame( &frame );
+    start = now_s();
+    for ( i = 0; i < BENCH_FRAMES; i++ ) {
+        frame.alpha = (uint8_t)i;
+        frame_writes( (uintptr_t)map, &frame );
+    }
+    return ( now_s() - start ) * 1e9 / BENCH_FRAMES;
+}
+
+static void bench( void )
+{
+    uint32_t *map = calloc( 1, MAP_SIZE );
+
+    printf( "out-of-line accessors:      %6.1f ns/frame\n", ns_per_frame( sw_io_frame_out, map ) );
+    printf( "inline accessors:           %6.1f ns/frame\n", ns_per_frame( sw_io_frame_inline, map ) );
+    printf( "inline + grouped accessors: %6.1f ns/frame\n", ns_per_frame( sw_io_frame_grouped, map ) );
+
+    free( map );
+}
+
+int main( int argc, char **argv )
+{
+    test_maps();
+    test_null_base();
+
+    if ( bench_enabled( argc, argv ) )
+        bench();
+
+    printf( "system_sw_io: %s\n", failures ? "FAILED" : "passed" );
+    return failures ? 1 : 0;
+}
@@ -60,6 +60,9 @@ void AE_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     AE_fsm_clear( p_fsm );
 
+    // the AE parameters are read as a structure
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_CONTROL, sizeof( ae_balanced_param_t ) );
+
     ae_initialize( p_fsm );
 
     AE_request_interrupt( p_fsm, ACAMERA_IRQ_MASK( ACAMERA_IRQ_AE_STATS ) );
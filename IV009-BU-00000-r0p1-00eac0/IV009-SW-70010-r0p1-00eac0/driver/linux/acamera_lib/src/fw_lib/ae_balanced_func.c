@@ -99,6 +99,12 @@ void ae_roi_update( AE_fsm_ptr_t p_fsm )
 
     uint16_t gaus_center_x = ( _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_ZONE_WGHT_HOR ) * 256 / 2 ) * scale_x;
     uint16_t gaus_center_y = ( _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_ZONE_WGHT_VER ) * 256 / 2 ) * scale_y;
+    acamera_reciprocal_t rcp_scale_x;
+    acamera_reciprocal_t rcp_scale_y;
+
+    // zone scales are invariant for the whole grid
+    acamera_reciprocal_init( &rcp_scale_x, scale_x );
+    acamera_reciprocal_init( &rcp_scale_y, scale_y );
 
     for ( y = 0; y < vert_zones; y++ ) {
         uint8_t ae_coeff = 0;
@@ -124,8 +130,8 @@ void ae_roi_update( AE_fsm_ptr_t p_fsm )
                     if ( distance_y > 0 && ( distance_y & 0x80 ) )
                         coeff_y--;
 
-                    coeff_x = ptr_ae_zone_whgh_h[coeff_x / scale_x];
-                    coeff_y = ptr_ae_zone_whgh_v[coeff_y / scale_y];
+                    coeff_x = ptr_ae_zone_whgh_h[acamera_reciprocal_div( coeff_x, &rcp_scale_x )];
+                    coeff_y = ptr_ae_zone_whgh_v[acamera_reciprocal_div( coeff_y, &rcp_scale_y )];
 
                     ae_coeff = ( coeff_x * coeff_y ) >> 4;
                     if ( ae_coeff > 1 )
@@ -271,7 +277,7 @@ uint32_t ae_calculate_exposure_ratio( AE_fsm_ptr_t p_fsm )
         acamera_fsm_mgr_get_param( p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_IRIDIX_CONTRAST, NULL, 0, &iridix_contrast, sizeof( iridix_contrast ) );
 
         uint32_t calibration_exposure_ratio_adjustment_idx = CALIBRATION_EXPOSURE_RATIO_ADJUSTMENT;
-        uint32_t er_contrast_adj = acamera_calc_modulation_u16( iridix_contrast, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), calibration_exposure_ratio_adjustment_idx ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), calibration_exposure_ratio_adjustment_idx ) );
+        uint32_t er_contrast_adj = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), calibration_exposure_ratio_adjustment_idx, iridix_contrast );
 
         //uint32_t max_clipped_amount = (uint32_t)((uint64_t)p_fsm->fullhist_sum*param->long_clip>>8); //without modulation
         uint32_t long_clip = ( uint32_t )( param->long_clip * er_contrast_adj ) >> 8;
@@ -465,7 +471,7 @@ void ae_calculate_target( AE_fsm_ptr_t p_fsm )
     // LOG( LOG_NOTICE, "log2_gain %d total_gain %d", log2_gain, total_gain );
 
     const int32_t ldr_target = param->target_point;
-    const int32_t hdr_target = acamera_calc_modulation_u16( log2_gain, (modulation_entry_t *)_GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_CONTROL_HDR_TARGET ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_CONTROL_HDR_TARGET ) );
+    const int32_t hdr_target = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_CONTROL_HDR_TARGET, log2_gain );
 
     LOG( LOG_DEBUG, "hdr_target %d log2_gain %d", hdr_target, log2_gain );
 
@@ -54,6 +54,10 @@ void AF_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     AF_fsm_clear( p_fsm );
 
+    // the AF and status parameters are read as structures
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AF_LMS, sizeof( af_lms_param_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STATUS_INFO, sizeof( status_info_param_t ) );
+
     AF_init( p_fsm );
 }
 
@@ -446,6 +446,12 @@ void awb_roi_update( AWB_fsm_ptr_t p_fsm )
 
     uint16_t gaus_center_x = ( len_zone_wght_hor * 256 / 2 ) * scale_x;
     uint16_t gaus_center_y = ( len_zone_wght_ver * 256 / 2 ) * scale_y;
+    acamera_reciprocal_t rcp_scale_x;
+    acamera_reciprocal_t rcp_scale_y;
+
+    // zone scales are invariant for the whole grid
+    acamera_reciprocal_init( &rcp_scale_x, scale_x );
+    acamera_reciprocal_init( &rcp_scale_y, scale_y );
 
     for ( y = 0; y < vert_zones; y++ ) {
         uint8_t awb_coeff = 0;
@@ -471,8 +477,8 @@ void awb_roi_update( AWB_fsm_ptr_t p_fsm )
                     if ( distance_y > 0 && ( distance_y & 0x80 ) )
                         coeff_y--;
 
-                    coeff_x = ptr_awb_zone_whgh_h[coeff_x / scale_x];
-                    coeff_y = ptr_awb_zone_whgh_v[coeff_y / scale_y];
+                    coeff_x = ptr_awb_zone_whgh_h[acamera_reciprocal_div( coeff_x, &rcp_scale_x )];
+                    coeff_y = ptr_awb_zone_whgh_v[acamera_reciprocal_div( coeff_y, &rcp_scale_y )];
 
                     awb_coeff = ( coeff_x * coeff_y ) >> 4;
                     if ( awb_coeff > 1 )
@@ -1077,7 +1083,7 @@ void awb_calc_avg_weighted_gr_gb_mesh( AWB_fsm_t *p_fsm )
     acamera_fsm_mgr_get_param( p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_CMOS_TOTAL_GAIN, NULL, 0, &total_gain, sizeof( total_gain ) );
     uint16_t log2_gain = total_gain >> ( LOG2_GAIN_SHIFT - 8 );
 
-    int16_t max_bg_gain = acamera_calc_modulation_u16( log2_gain, _GET_MOD_ENTRY16_PTR( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AWB_BG_MAX_GAIN ), _GET_ROWS( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AWB_BG_MAX_GAIN ) );
+    int16_t max_bg_gain = acamera_calib_modulation_u16( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AWB_BG_MAX_GAIN, log2_gain );
 
     if ( avg_BG < max_bg_gain ) {
         avg_BG = max_bg_gain;
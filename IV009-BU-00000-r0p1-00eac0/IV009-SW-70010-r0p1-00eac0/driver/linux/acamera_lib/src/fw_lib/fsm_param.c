@@ -116,6 +116,11 @@ int acamera_fsm_mgr_set_param(acamera_fsm_mgr_t * p_fsm_mgr, uint32_t param_id,
         rc = -1;
     }
 
+    /* a set_param() out of the event pass, from the api for instance, takes effect now */
+    if( !p_fsm_mgr->in_event_pass ) {
+        acamera_reg_script_apply( &ACAMERA_MGR2CTX_PTR( p_fsm_mgr )->reg_script, p_fsm_mgr->isp_base );
+    }
+
     return rc;
 }
 
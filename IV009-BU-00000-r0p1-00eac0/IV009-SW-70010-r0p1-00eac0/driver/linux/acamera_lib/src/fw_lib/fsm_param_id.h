@@ -86,6 +86,7 @@ typedef enum {
     FSM_PARAM_SET_MATRIX_YUV_BRIGHTNESS_STRENGTH,
     FSM_PARAM_SET_MATRIX_YUV_CONTRAST_STRENGTH,
     FSM_PARAM_SET_MATRIX_YUV_COLOR_MODE,
+    FSM_PARAM_SET_MATRIX_YUV_UPDATE,
     FSM_PARAM_SET_MATRIX_YUV_END,
 
     /* GAMMA_CONTRAST */
@@ -191,6 +192,7 @@ typedef enum {
     FSM_PARAM_GET_COLOR_MATRIX_START,
     FSM_PARAM_GET_CCM_INFO,
     FSM_PARAM_GET_SHADING_ALPHA,
+    FSM_PARAM_GET_COLOR_MATRIX_REUSE_STATS,
     FSM_PARAM_GET_COLOR_MATRIX_END,
 
     /* IRIDIX */
@@ -210,6 +212,7 @@ typedef enum {
     FSM_PARAM_GET_MATRIX_YUV_BRIGHTNESS_STRENGTH,
     FSM_PARAM_GET_MATRIX_YUV_CONTRAST_STRENGTH,
     FSM_PARAM_GET_MATRIX_YUV_COLOR_MODE,
+    FSM_PARAM_GET_MATRIX_YUV_REUSE_STATS,
     FSM_PARAM_GET_MATRIX_YUV_END,
 
     /* GAMMA_CONTRAST */
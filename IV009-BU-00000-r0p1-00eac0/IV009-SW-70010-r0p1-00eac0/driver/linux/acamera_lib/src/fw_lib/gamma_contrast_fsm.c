@@ -52,6 +52,9 @@ void gamma_contrast_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     gamma_contrast_fsm_clear( p_fsm );
 
+    // the auto level parameters are read by index
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AUTO_LEVEL_CONTROL, 7 * sizeof( uint32_t ) );
+
     gamma_contrast_init( p_fsm );
 }
 
@@ -106,9 +106,13 @@ struct sensor_info {
     sensor_mode_t modes[ISP_MAX_SENSOR_MODES];
 };
 
+// Calibration data is not part of struct fw_sbuf, it follows the structure
+// in the same mapping at data_offset. The kernel-FW sizes it from the
+// calibration set in use, data_size is the room it has reserved.
 struct calibration_info {
     uint8_t is_fetched;
-    uint8_t cali_data[ISP_MAX_CALIBRATION_DATA_SIZE];
+    uint32_t data_offset;
+    uint32_t data_size;
 };
 
 struct kf_info {
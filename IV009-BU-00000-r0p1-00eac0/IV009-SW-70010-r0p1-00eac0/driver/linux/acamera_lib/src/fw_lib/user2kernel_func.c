@@ -631,9 +631,17 @@ int user2kernel_initialize( user2kernel_fsm_ptr_t p_fsm )
         return -2;
     }
 
+    // the calibration data follows struct fw_sbuf and is sized by KF,
+    // map the structure first to learn the size of the whole buffer
     p_ctx->map_len = sizeof( struct fw_sbuf );
-    LOG( LOG_INFO, "mmap request size: %lu.", p_ctx->map_len );
-    p_ctx->map_base = mmap( NULL, p_ctx->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, p_ctx->fd_dev, 0 );
+    p_ctx->map_base = mmap( NULL, p_ctx->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, p_ctx->fd_dev, 0 );
+    if ( p_ctx->map_base != (void *)MAP_FAILED ) {
+        struct calibration_info cali_info = ( (struct fw_sbuf *)p_ctx->map_base )->kf_info.cali_info;
+        munmap( p_ctx->map_base, p_ctx->map_len );
+        p_ctx->map_len = (unsigned long)cali_info.data_offset + cali_info.data_size;
+        LOG( LOG_INFO, "mmap request size: %lu, calibration data: %u bytes.", p_ctx->map_len, cali_info.data_size );
+        p_ctx->map_base = mmap( NULL, p_ctx->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, p_ctx->fd_dev, 0 );
+    }
     if ( p_ctx->map_base == (void *)MAP_FAILED ) {
         LOG( LOG_ERR, "sbuf map failed, err: %s.", strerror( errno ) );
         close( p_ctx->fd_dev );
@@ -1032,7 +1040,7 @@ uint8_t user2kernel_get_calibrations( uint32_t ctx_id, void *sensor_arg, ACamera
         p_ctx->cur_wdr_mode = new_wdr_mode;
     }
 
-    uint8_t *cali_base = (uint8_t *)&p_ctx->fw_sbuf->kf_info.cali_info.cali_data;
+    uint8_t *cali_base = (uint8_t *)p_ctx->map_base + p_ctx->fw_sbuf->kf_info.cali_info.data_offset;
     LookupTable *cali_lut_base = (LookupTable *)cali_base;
     uint8_t *cali_data_base = (uint8_t *)cali_base + sizeof( struct sbuf_lookup_table ) * CALIBRATION_TOTAL_SIZE;
     LOG( LOG_INFO, "p_ctx: %p, cali_base: %p, cali_data_base: %p, CALIBRATION_TOTAL_SIZE: %d.", p_ctx, cali_base, cali_data_base, CALIBRATION_TOTAL_SIZE );
@@ -52,3 +52,19 @@ void system_hw_write_16( uintptr_t addr, uint16_t data )
 void system_hw_write_8( uintptr_t addr, uint8_t data )
 {
 }
+
+void system_hw_read_block_32( uintptr_t addr, uint32_t *data, uint32_t count )
+{
+    while ( count-- ) {
+        *data++ = system_hw_read_32( addr );
+        addr += 4;
+    }
+}
+
+void system_hw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+    while ( count-- ) {
+        system_hw_write_32( addr, *data++ );
+        addr += 4;
+    }
+}
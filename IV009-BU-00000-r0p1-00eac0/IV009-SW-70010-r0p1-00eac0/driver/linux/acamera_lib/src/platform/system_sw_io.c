@@ -64,3 +64,7 @@ void system_sw_write_16( uintptr_t addr, uint16_t data )
 void system_sw_write_8( uintptr_t addr, uint8_t data )
 {
 }
+
+void system_sw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+}
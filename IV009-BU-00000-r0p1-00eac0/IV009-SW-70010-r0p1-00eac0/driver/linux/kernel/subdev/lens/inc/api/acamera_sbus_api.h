@@ -48,6 +48,9 @@ typedef const struct _acamera_sbus_t *acamera_sbus_const_ptr_t;
 #define SBUS_MASK_SPI_LSB 0x10000
 #define SBUS_MASK_NO_STOP 0x20000
 
+// maximum number of data bytes passed to write_block in one call
+#define SBUS_BLOCK_MAX 32
+
 typedef enum _sbus_type_t {
     sbus_i2c = 0,
     sbus_spi,
@@ -65,6 +68,10 @@ struct _acamera_sbus_t {
     void *p_control;
     uint32_t ( *read_sample )( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint8_t sample_size );
     void ( *write_sample )( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint32_t sample, uint8_t sample_size );
+    // optional: write up to SBUS_BLOCK_MAX bytes to auto-incrementing registers in one transfer
+    void ( *write_block )( acamera_sbus_ptr_t p_bus, uintptr_t addr, const uint8_t *p_data, uint32_t size );
+    // optional: wait for the queued writes and return 0 if all of them were acknowledged
+    int32_t ( *sync )( acamera_sbus_ptr_t p_bus );
 };
 
 
@@ -82,6 +89,7 @@ void acamera_sbus_write_data_u16( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint
 void acamera_sbus_write_data_u32( acamera_sbus_ptr_t p_bus, uintptr_t addr, uint32_t *p_data, int n_count );
 void acamera_sbus_write_data( acamera_sbus_ptr_t p_bus, uintptr_t addr, void *p_data, int n_size );
 void acamera_sbus_copy( acamera_sbus_t *p_bus_to, uintptr_t addr_to, acamera_sbus_t *p_bus_from, uint32_t addr_from, int n_size );
+int32_t acamera_sbus_sync( acamera_sbus_ptr_t p_bus );
 
 void acamera_sbus_init( acamera_sbus_t *p_bus, sbus_type_t interface_type );
 void acamera_sbus_deinit( acamera_sbus_t *p_bus, sbus_type_t interface_type );
@@ -285,6 +285,141 @@ void acamera_load_array_sequence( acamera_sbus_ptr_t p_sbus, uintptr_t isp_offse
 }
 
 
+#define ARRAY_SEQUENCE_IS_END( seq ) ( ( seq )->address == 0x0000 && ( seq )->len == 0 && ( seq )->value == 0 )
+#define ARRAY_SEQUENCE_IS_WAIT( seq ) ( ( seq )->address == 0xFFFF )
+
+// The value a sequence leaves in a register is the one of the last write to it.
+static const acam_reg_t *array_sequence_find_last( const acam_reg_t *seq, uint32_t address )
+{
+    const acam_reg_t *result = NULL;
+    for ( ; !ARRAY_SEQUENCE_IS_END( seq ); seq++ ) {
+        if ( seq->address == address && !ARRAY_SEQUENCE_IS_WAIT( seq ) ) {
+            result = seq;
+        }
+    }
+    return result;
+}
+
+// The last write to the register among the entries of seq before end.
+static const acam_reg_t *array_sequence_find_before( const acam_reg_t *seq, const acam_reg_t *end, uint32_t address )
+{
+    const acam_reg_t *result = NULL;
+    for ( ; seq != end; seq++ ) {
+        if ( seq->address == address && !ARRAY_SEQUENCE_IS_WAIT( seq ) ) {
+            result = seq;
+        }
+    }
+    return result;
+}
+
+typedef struct _array_sequence_block_t {
+    uint32_t address;
+    uint32_t count;
+    uint8_t data[SBUS_BLOCK_MAX];
+} array_sequence_block_t;
+
+static void array_sequence_flush( acamera_sbus_ptr_t p_sbus, array_sequence_block_t *p_block )
+{
+    if ( p_block->count ) {
+        acamera_sbus_write_data_u8( p_sbus, p_block->address, p_block->data, p_block->count );
+        LOG( LOG_DEBUG, "S8: 0x%x : %d bytes", p_block->address, p_block->count );
+        p_block->count = 0;
+    }
+}
+
+// Both entries leave the same value in the register, masked entries never compare equal.
+static int array_sequence_same_value( const acam_reg_t *a, const acam_reg_t *b, char size )
+{
+    return a->mask == 0 && b->mask == 0 && a->value == b->value && ( a->len ? a->len : size ) == ( b->len ? b->len : size );
+}
+
+static void array_sequence_write( acamera_sbus_ptr_t p_sbus, array_sequence_block_t *p_block, char size, const acam_reg_t *seq )
+{
+    const char reg_size = seq->len ? seq->len : size;
+
+    if ( reg_size == 1 && seq->mask == 0 ) {
+        if ( p_block->count == SBUS_BLOCK_MAX || ( p_block->count && seq->address != p_block->address + p_block->count ) ) {
+            array_sequence_flush( p_sbus, p_block );
+        }
+        if ( p_block->count == 0 ) {
+            p_block->address = seq->address;
+        }
+        p_block->data[p_block->count++] = (uint8_t)seq->value;
+    } else {
+        // masked registers are merged with the sensor value by the loader
+        const acam_reg_t single[2] = {*seq, {0x0000, 0x0000, 0x0000, 0x0000}};
+        const acam_reg_t *single_seq[1] = {single};
+        array_sequence_flush( p_sbus, p_block );
+        acamera_load_array_sequence( p_sbus, 0, reg_size, single_seq, 0 );
+    }
+}
+
+uint32_t acamera_sensor_switch_array_sequence( acamera_sbus_ptr_t p_sbus, char size, const acam_reg_t **sequence, int base_group, int from_group, int to_group )
+{
+    const acam_reg_t *base = base_group >= 0 ? sequence[base_group] : NULL;
+    const acam_reg_t *from = sequence[from_group];
+    const acam_reg_t *to = sequence[to_group];
+    const acam_reg_t *seq;
+    array_sequence_block_t block;
+    uint32_t written = 0;
+
+    block.count = 0;
+
+    // registers set only by from_group go back to the base group value first
+    for ( seq = from; !ARRAY_SEQUENCE_IS_END( seq ); seq++ ) {
+        const acam_reg_t *restore;
+
+        if ( ARRAY_SEQUENCE_IS_WAIT( seq ) || array_sequence_find_last( from, seq->address ) != seq || array_sequence_find_last( to, seq->address ) != NULL ) {
+            continue;
+        }
+
+        restore = base != NULL ? array_sequence_find_last( base, seq->address ) : NULL;
+        if ( restore == NULL ) {
+            LOG( LOG_WARNING, "Register 0x%x of sequence %d has no base value and keeps its value after the switch", seq->address, from_group );
+            continue;
+        }
+        if ( array_sequence_same_value( restore, seq, size ) ) {
+            continue;
+        }
+
+        array_sequence_write( p_sbus, &block, size, restore );
+        written++;
+    }
+
+    for ( seq = to; !ARRAY_SEQUENCE_IS_END( seq ); seq++ ) {
+        const acam_reg_t *prev;
+
+        if ( ARRAY_SEQUENCE_IS_WAIT( seq ) ) {
+            // everything before the wait must reach the sensor first
+            array_sequence_flush( p_sbus, &block );
+            system_timer_usleep( seq->value * 1000 );
+            continue;
+        }
+
+        // the sensor holds the value of an earlier entry of to_group, else the
+        // from_group value, or the base value when from_group left it alone
+        prev = array_sequence_find_before( to, seq, seq->address );
+        if ( prev == NULL ) {
+            prev = array_sequence_find_last( from, seq->address );
+        }
+        if ( prev == NULL && base != NULL ) {
+            prev = array_sequence_find_last( base, seq->address );
+        }
+        if ( prev != NULL && array_sequence_same_value( prev, seq, size ) ) {
+            continue;
+        }
+
+        array_sequence_write( p_sbus, &block, size, seq );
+        written++;
+    }
+    array_sequence_flush( p_sbus, &block );
+
+    LOG( LOG_INFO, "Sensor sequence switch %d -> %d wrote %u registers", from_group, to_group, (unsigned int)written );
+
+    return written;
+}
+
+
 void acamera_sensor_load_binary_sequence( acamera_sbus_ptr_t p_sbus, char size, const char *sequence, int group )
 {
     acamera_load_binary_sequence( p_sbus, 0, size, sequence, group );
@@ -20,6 +20,7 @@
 #include <linux/platform_device.h>
 #include <linux/device.h>
 #include <linux/module.h>
+#include <linux/ktime.h>
 #include <media/v4l2-subdev.h>
 #include <media/v4l2-async.h>
 #include "acamera_logger.h"
@@ -92,6 +93,41 @@ static int camera_reset( struct v4l2_subdev *sd, u32 val )
 }
 
 
+static void camera_fill_descriptor( const sensor_param_t *params, struct soc_sensor_descriptor *p_desc )
+{
+    uint32_t idx;
+
+    p_desc->exp_number = params->sensor_exp_number;
+    p_desc->again_log2_max = params->again_log2_max;
+    p_desc->dgain_log2_max = params->dgain_log2_max;
+    p_desc->update_latency = params->integration_time_apply_delay;
+    p_desc->integration_time_min = params->integration_time_min;
+    p_desc->integration_time_max = params->integration_time_max;
+    p_desc->integration_time_long_max = params->integration_time_long_max;
+    p_desc->integration_time_limit = params->integration_time_limit;
+    p_desc->lines_per_second = params->lines_per_second;
+    p_desc->active_width = params->active.width;
+    p_desc->active_height = params->active.height;
+    p_desc->preset_cur = params->mode;
+    p_desc->skip_frames = params->mode_switch_skip_frames;
+    p_desc->preset_num = params->modes_num;
+
+    if ( p_desc->preset_num > SOC_SENSOR_PRESETS_MAX ) {
+        LOG( LOG_WARNING, "Sensor has %d presets, only %d are reported", params->modes_num, SOC_SENSOR_PRESETS_MAX );
+        p_desc->preset_num = SOC_SENSOR_PRESETS_MAX;
+    }
+
+    for ( idx = 0; idx < p_desc->preset_num; idx++ ) {
+        p_desc->presets[idx].width = params->modes_table[idx].resolution.width;
+        p_desc->presets[idx].height = params->modes_table[idx].resolution.height;
+        p_desc->presets[idx].fps = params->modes_table[idx].fps;
+        p_desc->presets[idx].exposures = params->modes_table[idx].exposures;
+        p_desc->presets[idx].wdr_mode = params->modes_table[idx].wdr_mode;
+        p_desc->presets[idx].bits = params->modes_table[idx].bits;
+    }
+}
+
+
 static long camera_ioctl( struct v4l2_subdev *sd, unsigned int cmd, void *arg )
 {
     long rc = 0;
@@ -119,9 +155,13 @@ static long camera_ioctl( struct v4l2_subdev *sd, unsigned int cmd, void *arg )
     case SOC_SENSOR_STREAMING_OFF:
         ctx->camera_control.stop_streaming( ctx->camera_context );
         break;
-    case SOC_SENSOR_SET_PRESET:
+    case SOC_SENSOR_SET_PRESET: {
+        ktime_t start = ktime_get();
         ctx->camera_control.set_mode( ctx->camera_context, ARGS_TO_PTR( arg )->args.general.val_in );
-        break;
+        // the skip count goes back in the descriptor and the isp drops those frames
+        LOG( LOG_INFO, "Sensor switched to preset %d in %lld us, %d frames to skip", ARGS_TO_PTR( arg )->args.general.val_in,
+             ktime_to_us( ktime_sub( ktime_get(), start ) ), params->mode_switch_skip_frames );
+    } break;
     case SOC_SENSOR_ALLOC_AGAIN:
         ARGS_TO_PTR( arg )
             ->args.general.val_out = ctx->camera_control.alloc_analog_gain( ctx->camera_context, ARGS_TO_PTR( arg )->args.general.val_in );
@@ -134,8 +174,28 @@ static long camera_ioctl( struct v4l2_subdev *sd, unsigned int cmd, void *arg )
         ctx->camera_control.alloc_integration_time( ctx->camera_context, &ARGS_TO_PTR( arg )->args.integration_time.it_short, &ARGS_TO_PTR( arg )->args.integration_time.it_medium, &ARGS_TO_PTR( arg )->args.integration_time.it_long );
         break;
     case SOC_SENSOR_UPDATE_EXP:
-        ctx->camera_control.sensor_update( ctx->camera_context );
+        if ( ctx->camera_control.sensor_update( ctx->camera_context ) != 0 ) {
+            LOG( LOG_ERR, "Sensor did not acknowledge the exposure update" );
+            rc = -1;
+        }
         break;
+    case SOC_SENSOR_SET_EXPOSURE: {
+        struct soc_sensor_ioctl_args *p_args = ARGS_TO_PTR( arg );
+        // all values are allocated first so the sensor update writes them as one set
+        if ( p_args->args.exposure.mask & SOC_SENSOR_EXP_AGAIN )
+            p_args->args.exposure.again = ctx->camera_control.alloc_analog_gain( ctx->camera_context, p_args->args.exposure.again );
+        if ( p_args->args.exposure.mask & SOC_SENSOR_EXP_DGAIN )
+            p_args->args.exposure.dgain = ctx->camera_control.alloc_digital_gain( ctx->camera_context, p_args->args.exposure.dgain );
+        if ( p_args->args.exposure.mask & SOC_SENSOR_EXP_IT )
+            ctx->camera_control.alloc_integration_time( ctx->camera_context, &p_args->args.exposure.it_short, &p_args->args.exposure.it_medium, &p_args->args.exposure.it_long );
+        if ( ctx->camera_control.sensor_update( ctx->camera_context ) != 0 ) {
+            LOG( LOG_ERR, "Sensor did not acknowledge exposure update %u", p_args->args.exposure.sequence );
+            rc = -1;
+            break;
+        }
+        LOG( LOG_DEBUG, "Exposure update %u applied: again %d, dgain %d, it %u %u %u", p_args->args.exposure.sequence, p_args->args.exposure.again, p_args->args.exposure.dgain,
+             p_args->args.exposure.it_short, p_args->args.exposure.it_medium, p_args->args.exposure.it_long );
+    } break;
     case SOC_SENSOR_READ_REG:
         ARGS_TO_PTR( arg )
             ->args.general.val_out = ctx->camera_control.read_sensor_register( ctx->camera_context, ARGS_TO_PTR( arg )->args.general.val_in );
@@ -260,6 +320,15 @@ static long camera_ioctl( struct v4l2_subdev *sd, unsigned int cmd, void *arg )
         ARGS_TO_PTR( arg )
             ->args.general.val_out = params->active.width;
     } break;
+    case SOC_SENSOR_GET_DESCRIPTOR: {
+        struct soc_sensor_descriptor *p_desc = ARGS_TO_PTR( arg )->args.descriptor.p_desc;
+        if ( p_desc != NULL ) {
+            camera_fill_descriptor( params, p_desc );
+        } else {
+            LOG( LOG_ERR, "Sensor descriptor pointer is NULL" );
+            rc = -1;
+        }
+    } break;
     default:
         LOG( LOG_WARNING, "Unknown soc sensor ioctl cmd %d", cmd );
         rc = -1;
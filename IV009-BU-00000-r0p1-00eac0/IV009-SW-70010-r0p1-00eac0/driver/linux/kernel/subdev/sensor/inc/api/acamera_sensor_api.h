@@ -67,6 +67,7 @@ typedef struct _sensor_param_t {
     uint32_t modes_num;                      // The number of predefined modes
     uint8_t mode;                            // Current mode. This value is from the range [ 0 : modes_num - 1 ]
     void *sensor_ctx;                        // Conext to a sensor structure. This structure is not available to firmware
+    uint8_t mode_switch_skip_frames;         // Number of corrupted frames the sensor outputs after a mode switch
 } sensor_param_t;
 
 
@@ -126,10 +127,14 @@ typedef struct _sensor_control_t {
      *
      *   The function is called from IRQ thread in vertical blanking.
      *   All sensor parameters must be updated here.
+     *   Register writes may be queued to the bus, the driver should
+     *   collect their status with acamera_sbus_sync before it returns.
      *   @param ctx - pointer to the sensor context
      *
+     *   @return 0 - success
+     *          -1 - the sensor did not acknowledge the update
      */
-    void ( *sensor_update )( void *ctx );
+    int32_t ( *sensor_update )( void *ctx );
 
 
     /**
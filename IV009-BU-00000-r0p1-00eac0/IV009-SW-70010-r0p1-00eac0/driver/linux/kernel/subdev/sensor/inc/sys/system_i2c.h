@@ -82,4 +82,21 @@ uint8_t system_i2c_write( uint32_t bus, uint32_t address, uint8_t *data, uint32_
 uint8_t system_i2c_read( uint32_t bus, uint32_t address, uint8_t *data, uint32_t size );
 
 
+/**
+ *   Collect the status of queued writes
+ *
+ *   system_i2c_write returns as soon as a transaction is queued to
+ *   the controller. This function waits until the bus is idle and
+ *   returns the first error of the writes completed since the previous call.
+ *
+ *   @param bus - i2c bus
+ *
+ *   @return I2C_NOCONNECT - no connection
+ *           I2C_OK - every write was acknowledged
+ *           I2C_NOACK - no acknowledge from a device
+ *           I2C_ABITRATION_LOST - the bus was taken by another master
+ */
+uint8_t system_i2c_sync( uint32_t bus );
+
+
 #endif /* __SYSTEM_I2C_H__ */
@@ -77,8 +77,9 @@ static void sensor_alloc_integration_time( void *ctx, uint16_t *int_time, uint16
 {
 }
 
-static void sensor_update( void *ctx )
+static int32_t sensor_update( void *ctx )
 {
+    return 0;
 }
 
 static void sensor_set_mode( void *ctx, uint8_t mode )
@@ -97,6 +98,7 @@ static void sensor_set_mode( void *ctx, uint8_t mode )
     param->mode = mode;
     param->lines_per_second = 0;
     param->sensor_exp_number = param->modes_table[mode].exposures;
+    param->mode_switch_skip_frames = 0;
 }
 
 static uint16_t sensor_get_id( void *ctx )
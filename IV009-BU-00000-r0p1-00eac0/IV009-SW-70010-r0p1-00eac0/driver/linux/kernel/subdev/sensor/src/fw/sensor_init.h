@@ -39,4 +39,14 @@ typedef struct acam_reg_t {
 void acamera_sensor_load_binary_sequence( acamera_sbus_ptr_t p_sbus, char size, const char *sequence, int group );
 void acamera_sensor_load_array_sequence( acamera_sbus_ptr_t p_sbus, char size, const acam_reg_t **sequence, int group );
 
+// Switch the sensor from one array sequence group to another.
+// Only registers whose value differs from the one the sensor holds are
+// written, contiguous 8-bit registers go out as one bus block. The sensor is
+// assumed to hold base_group overlaid with from_group: registers written only
+// by from_group are restored to their base_group value. Pass -1 as base_group
+// when the presets do not share a base group.
+// Presets are meant to be described as a shared base group plus a short
+// per-preset delta group. Returns the number of registers written.
+uint32_t acamera_sensor_switch_array_sequence( acamera_sbus_ptr_t p_sbus, char size, const acam_reg_t **sequence, int base_group, int from_group, int to_group );
+
 #endif /* __SENSOR_INIT_H__ */
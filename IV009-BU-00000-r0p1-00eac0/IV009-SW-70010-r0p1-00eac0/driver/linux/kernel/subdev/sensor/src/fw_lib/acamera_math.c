@@ -22,6 +22,9 @@
 
 static uint8_t leading_one_position( const uint32_t in )
 {
+#if defined( __GNUC__ )
+    return ( in == 0 ) ? 0 : ( uint8_t )( 31 - __builtin_clz( in ) );
+#else
     uint8_t pos = 0;
     uint32_t val = in;
     if ( val >= 1 << 16 ) {
@@ -44,10 +47,14 @@ static uint8_t leading_one_position( const uint32_t in )
         pos += 1;
     }
     return pos;
+#endif
 }
 
 static int leading_one_position_64( uint64_t val )
 {
+#if defined( __GNUC__ )
+    return ( val == 0 ) ? 0 : ( 63 - __builtin_clzll( val ) );
+#else
     int pos = 0;
     if ( val >= (uint64_t)1 << 32 ) {
         val >>= 32;
@@ -73,7 +80,66 @@ static int leading_one_position_64( uint64_t val )
         pos += 1;
     }
     return pos;
+#endif
 }
+//  log2(1 + i / 256) for i = 0..256 in Q30.
+//  The linear interpolation error between entries stays below 2^-18, so at
+//  LOG2_GAIN_SHIFT precision the result is within two LSB of the exact value.
+//
+static const uint32_t _log2_lut[257] = {
+    0, 6039314, 12055174, 18047761, 24017256, 29963836, 35887675, 41788947,
+    47667823, 53524472, 59359063, 65171760, 70962728, 76732128, 82480119, 88206862,
+    93912511, 99597222, 105261148, 110904440, 116527248, 122129721, 127712004, 133274244,
+    138816582, 144339162, 149842124, 155325606, 160789745, 166234679, 171660541, 177067464,
+    182455581, 187825021, 193175914, 198508388, 203822568, 209118580, 214396548, 219656594,
+    224898839, 230123404, 235330407, 240519966, 245692198, 250847218, 255985140, 261106077,
+    266210141, 271297442, 276368092, 281422197, 286459867, 291481207, 296486323, 301475319,
+    306448299, 311405366, 316346620, 321272163, 326182095, 331076513, 335955515, 340819199,
+    345667660, 350500993, 355319292, 360122651, 364911162, 369684916, 374444004, 379188517,
+    383918542, 388634168, 393335482, 398022572, 402695523, 407354420, 411999347, 416630388,
+    421247625, 425851141, 430441017, 435017334, 439580170, 444129607, 448665721, 453188592,
+    457698295, 462194908, 466678506, 471149164, 475606957, 480051959, 484484242, 488903880,
+    493310944, 497705506, 502087636, 506457405, 510814882, 515160136, 519493235, 523814248,
+    528123241, 532420281, 536705435, 540978767, 545240343, 549490228, 553728485, 557955178,
+    562170370, 566374123, 570566499, 574747559, 578917365, 583075977, 587223455, 591359858,
+    595485245, 599599675, 603703206, 607795895, 611877800, 615948977, 620009483, 624059373,
+    628098702, 632127527, 636145900, 640153876, 644151509, 648138853, 652115959, 656082880,
+    660039669, 663986377, 667923055, 671849754, 675766525, 679673418, 683570481, 687457766,
+    691335320, 695203192, 699061430, 702910083, 706749198, 710578822, 714399001, 718209783,
+    722011213, 725803337, 729586201, 733359850, 737124328, 740879680, 744625951, 748363183,
+    752091421, 755810707, 759521085, 763222597, 766915285, 770599192, 774274358, 777940826,
+    781598637, 785247830, 788888448, 792520529, 796144114, 799759243, 803365955, 806964289,
+    810554283, 814135978, 817709409, 821274617, 824831638, 828380510, 831921271, 835453956,
+    838978604, 842495250, 846003931, 849504683, 852997541, 856482542, 859959719, 863429109,
+    866890747, 870344666, 873790901, 877229486, 880660455, 884083842, 887499680, 890908003,
+    894308843, 897702233, 901088206, 904466794, 907838029, 911201944, 914558569, 917907937,
+    921250079, 924585025, 927912807, 931233456, 934547002, 937853475, 941152905, 944445323,
+    947730758, 951009239, 954280797, 957545460, 960803257, 964054218, 967298370, 970535742,
+    973766362, 976990259, 980207461, 983417995, 986621888, 989819169, 993009864, 996194001,
+    999371606, 1002542707, 1005707329, 1008865499, 1012017244, 1015162589, 1018301561, 1021434185,
+    1024560487, 1027680492, 1030794226, 1033901713, 1037002979, 1040098049, 1043186948, 1046269699,
+    1049346328, 1052416858, 1055481314, 1058539720, 1061592099, 1064638476, 1067678873, 1070713315,
+    1073741824};
+
+//  Fractional part of log2 for a mantissa normalised to bit 31, Q30.
+static uint32_t log2_mantissa_q30( const uint32_t norm )
+{
+    const uint32_t idx = ( norm >> 23 ) & 0xFF;
+    const uint32_t alpha = ( norm >> 7 ) & 0xFFFF;
+    const uint32_t a = _log2_lut[idx];
+    const uint32_t b = _log2_lut[idx + 1];
+
+    return a + ( uint32_t )( ( (uint64_t)( b - a ) * alpha ) >> 16 );
+}
+
+static uint32_t log2_compose( const int pos, const uint32_t frac_q30, const uint8_t out_precision, const uint8_t shift_out )
+{
+    const int frac_bits = out_precision + shift_out;
+    const uint32_t frac = ( frac_bits <= 30 ) ? ( frac_q30 >> ( 30 - frac_bits ) ) : ( frac_q30 << ( frac_bits - 30 ) );
+
+    return ( (uint32_t)pos << frac_bits ) + frac;
+}
+
 //  y = log2(x)
 //
 //    input:  Integer: val
@@ -82,13 +148,7 @@ static int leading_one_position_64( uint64_t val )
 //
 uint32_t acamera_log2_int_to_fixed( const uint32_t val, const uint8_t out_precision, const uint8_t shift_out )
 {
-    int i;
-    int pos = 0;
-    uint32_t a = 0;
-    uint32_t b = 0;
-    uint32_t in = val;
-    uint32_t result = 0;
-    const unsigned char precision = out_precision;
+    int pos;
 
     if ( 0 == val ) {
         return 0;
@@ -96,47 +156,19 @@ uint32_t acamera_log2_int_to_fixed( const uint32_t val, const uint8_t out_precis
     // integral part
     pos = leading_one_position( val );
     // fractional part
-    a = ( pos <= 15 ) ? ( in << ( 15 - pos ) ) : ( in >> ( pos - 15 ) );
-    for ( i = 0; i < precision; ++i ) {
-        b = a * a;
-        if ( b & ( (uint32_t)1 << 31 ) ) {
-            result = ( result << 1 ) + 1;
-            a = b >> 16;
-        } else {
-            result = ( result << 1 );
-            a = b >> 15;
-        }
-    }
-    return ( ( ( pos << precision ) + result ) << shift_out ) | ( ( a & 0x7fff ) >> ( 15 - shift_out ) );
+    return log2_compose( pos, log2_mantissa_q30( val << ( 31 - pos ) ), out_precision, shift_out );
 }
 static uint32_t log2_int_to_fixed_64( uint64_t val, uint8_t out_precision, uint8_t shift_out )
 {
-    int i;
-    int pos = 0;
-    uint64_t a = 0;
-    uint64_t b = 0;
-    uint64_t in = val;
-    uint64_t result = 0;
-    const unsigned char precision = out_precision;
+    int pos;
 
     if ( 0 == val ) {
         return 0;
     }
     // integral part
     pos = leading_one_position_64( val );
-    // fractional part
-    a = ( pos <= 15 ) ? ( in << ( 15 - pos ) ) : ( in >> ( pos - 15 ) );
-    for ( i = 0; i < precision; ++i ) {
-        b = a * a;
-        if ( b & ( (uint32_t)1 << 31 ) ) {
-            result = ( result << 1 ) + 1;
-            a = b >> 16;
-        } else {
-            result = ( result << 1 );
-            a = b >> 15;
-        }
-    }
-    return ( uint32_t )( ( ( ( pos << precision ) + result ) << shift_out ) | ( ( a & 0x7fff ) >> ( 15 - shift_out ) ) );
+    // fractional part, only the top 32 bits of the mantissa are significant
+    return log2_compose( pos, log2_mantissa_q30( ( uint32_t )( ( val << ( 63 - pos ) ) >> 32 ) ), out_precision, shift_out );
 }
 //  y = log2(x)
 //
@@ -227,15 +259,15 @@ uint8_t acamera_sqrt16( uint16_t arg )
 //
 uint8_t acamera_log16( uint16_t arg )
 {
-    uint8_t k = 0;
-    uint8_t res = 0;
+    uint8_t k;
 
-    for ( k = 0; k < 16; k++ ) {
-        if ( arg > ( 1 << k ) ) {
-            res = ( k << 4 ) + ( ( arg << 4 ) / ( 1 << ( k ) ) ) - 16; // division by zero is checked
-        }
+    if ( arg <= 1 ) {
+        return 0;
     }
-    return res;
+
+    // k is the highest power of two strictly below arg
+    k = leading_one_position( arg - 1 );
+    return ( uint8_t )( ( k << 4 ) + ( ( (uint32_t)arg << 4 ) >> k ) - 16 );
 }
 //     y = a * b = x.x1 (output fraction size same with "a" fraction size)
 //    a: fixed x.x1
@@ -259,36 +291,7 @@ uint32_t acamera_math_log2(
     const uint8_t out_precision,
     const uint8_t shift_out )
 {
-    int i;
-    int pos = 0;
-    uint32_t a = 0;
-    uint32_t b = 0;
-    uint32_t in = val;
-    uint32_t result = 0;
-    const unsigned char precision = out_precision;
-
-    if ( 0 == val ) {
-        return 0;
-    }
-
-    // integral part
-    pos = leading_one_position( val );
-
-    // fractional part
-    a = ( pos <= 15 ) ? ( in << ( 15 - pos ) ) : ( in >> ( pos - 15 ) );
-    for ( i = 0; i < precision; ++i ) {
-        b = a * a;
-        if ( b & ( (uint32_t)1 << 31 ) ) {
-            result = ( result << 1 ) + 1;
-            a = b >> 16;
-        } else {
-            result = ( result << 1 );
-            a = b >> 15;
-        }
-    }
-
-    return ( ( ( pos << precision ) + result ) << shift_out ) |
-           ( ( a & 0x7fff ) >> ( 15 - shift_out ) );
+    return acamera_log2_int_to_fixed( val, out_precision, shift_out );
 }
 //  Linear equation solving
 //
@@ -330,8 +333,45 @@ uint32_t acamera_div_fixed( uint32_t a, uint32_t b, const int16_t fraction_size
         return a << fraction_size;
     }
     uint64_t c = ( (uint64_t)a << fraction_size );
+    if ( ( c >> 32 ) == 0 ) {
+        return (uint32_t)c / b; // division by zero is checked
+    }
     return ( uint32_t )( div64_u64( c, b ) ); // division by zero is checked
 }
+//  Division by an invariant divisor as a multiply and two shifts.
+//  The only division happens here, acamera_reciprocal_div() is then exact
+//  for every 32-bit numerator (round-up method, Granlund-Montgomery).
+//
+void acamera_reciprocal_init( acamera_reciprocal_t *p_rcp, uint32_t divisor )
+{
+    int l;
+
+    if ( divisor == 0 ) {
+        LOG( LOG_ERR, "AVOIDED DIVISION BY ZERO" );
+        divisor = 1;
+    }
+
+    // l = ceil(log2(divisor))
+    l = ( divisor == 1 ) ? 0 : leading_one_position( divisor - 1 ) + 1;
+
+    p_rcp->mul = ( uint32_t )( div64_u64( ( ( (uint64_t)1 << l ) - divisor ) << 32, divisor ) + 1 ); // division by zero is checked
+    p_rcp->shift1 = ( l > 0 ) ? 1 : 0;
+    p_rcp->shift2 = ( l > 0 ) ? l - 1 : 0;
+}
+
+uint32_t acamera_fingerprint32( uint32_t seed, const void *p_data, uint32_t size )
+{
+    const uint8_t *p = (const uint8_t *)p_data;
+    uint32_t hash = seed;
+
+    while ( size-- ) {
+        hash ^= *p++;
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
 //    nth root finding y = x^0.45
 //  not a precise equation - for speed issue
 //    Result is coefficient "y" in fixed format   xxx.fraction_size
@@ -347,6 +387,71 @@ uint16_t acamera_line_offset( uint16_t line_len, uint8_t bytes_per_pixel )
     return ( bytes_per_pixel * line_len + alignment - 1 ) & ~( alignment - 1 );
 }
 
+//  Modulation tables are sorted by x, so the segment containing x is found
+//  with a binary search instead of a linear scan.
+//  Returns the first index i in [1, table_len - 1] with x < table[i], callers
+//  have already handled x outside of the table range.
+//
+static int modulation_segment_u16( uint16_t x, const modulation_entry_t *p_table, int table_len )
+{
+    int lo = 1;
+    int hi = table_len - 1;
+    while ( lo < hi ) {
+        const int mid = ( lo + hi ) >> 1;
+        if ( x < p_table[mid].x ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static int modulation_segment_u32( uint32_t x, const modulation_entry_32_t *p_table, int table_len )
+{
+    int lo = 1;
+    int hi = table_len - 1;
+    while ( lo < hi ) {
+        const int mid = ( lo + hi ) >> 1;
+        if ( x < p_table[mid].x ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static int inv_equidistant_segment_u16( uint16_t x, const uint16_t *p_table, int table_len )
+{
+    int lo = 1;
+    int hi = table_len - 1;
+    while ( lo < hi ) {
+        const int mid = ( lo + hi ) >> 1;
+        if ( x < p_table[mid] ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static int inv_equidistant_segment_u32( uint32_t x, const uint32_t *p_table, int table_len )
+{
+    int lo = 1;
+    int hi = table_len - 1;
+    while ( lo < hi ) {
+        const int mid = ( lo + hi ) >> 1;
+        if ( x < p_table[mid] ) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
 uint16_t acamera_calc_modulation_u16( uint16_t x, const modulation_entry_t *p_table, int table_len )
 {
     if ( x <= p_table->x ) {
@@ -356,12 +461,7 @@ uint16_t acamera_calc_modulation_u16( uint16_t x, const modulation_entry_t *p_ta
         return p_table[table_len - 1].y;
     }
     {
-        int i;
-        for ( i = 1; i < table_len; ++i ) {
-            if ( x < p_table[i].x ) {
-                break;
-            }
-        }
+        int i = modulation_segment_u16( x, p_table, table_len );
         if ( ( p_table[i].x - p_table[i - 1].x ) != 0 ) {
             int alpha = ( x - p_table[i - 1].x ) * 256 / ( p_table[i].x - p_table[i - 1].x ); // division by zero is checked
             return ( p_table[i].y * alpha + p_table[i - 1].y * ( 256 - alpha ) ) >> 8;
@@ -381,12 +481,7 @@ uint32_t acamera_calc_modulation_u32( uint32_t x, const modulation_entry_32_t *p
         return p_table[table_len - 1].y;
     }
     {
-        uint16_t i;
-        for ( i = 1; i < table_len; ++i ) {
-            if ( x < p_table[i].x ) {
-                break;
-            }
-        }
+        int i = modulation_segment_u32( x, p_table, table_len );
         if ( ( p_table[i].x - p_table[i - 1].x ) != 0 ) {
             // 32bit choosen to prevent overflows
             uint32_t alpha = ( x - p_table[i - 1].x ) * 256 / ( p_table[i].x - p_table[i - 1].x ); // division by zero is checked
@@ -414,12 +509,7 @@ uint16_t acamera_calc_scaled_modulation_u16( uint16_t x, uint16_t target_min_y,
         uint32_t scale_max_y = (uint32_t)target_max_y * 256 / p_table[table_len - 1].y;       // division by zero is checked
         int alpha = ( x - p_table[0].x ) * 256 / ( p_table[table_len - 1].x - p_table[0].x ); // division by zero is checked
         uint32_t scale_factor = ( scale_max_y * alpha + scale_min_y * ( 256 - alpha ) ) >> 8;
-        int i;
-        for ( i = 1; i < table_len; ++i ) {
-            if ( x < p_table[i].x ) {
-                break;
-            }
-        }
+        int i = modulation_segment_u16( x, p_table, table_len );
         if ( ( p_table[i].x - p_table[i - 1].x ) != 0 ) {
             alpha = ( x - p_table[i - 1].x ) * 256 / ( p_table[i].x - p_table[i - 1].x ); // division by zero is checked
             return scale_factor * ( p_table[i].y * alpha + p_table[i - 1].y * ( 256 - alpha ) ) >> 16;
@@ -488,12 +578,7 @@ uint16_t acamera_calc_inv_equidistant_modulation_u16( uint16_t x, const uint16_t
         return 0;
     }
 
-    int i;
-    for ( i = 1; i < table_len; ++i ) {
-        if ( x < p_table[i] ) {
-            break;
-        }
-    }
+    int i = inv_equidistant_segment_u16( x, p_table, table_len );
 
 
     uint16_t d = ( 1 << 16 ) / ( table_len - 1 ); // division by zero is checked
@@ -519,12 +604,7 @@ uint32_t acamera_calc_inv_equidistant_modulation_u32( uint32_t x, const uint32_t
         return 0;
     }
 
-    int i;
-    for ( i = 1; i < table_len; ++i ) {
-        if ( x < p_table[i] ) {
-            break;
-        }
-    }
+    int i = inv_equidistant_segment_u32( x, p_table, table_len );
 
 
     uint32_t d = ( 1 << 16 ) / ( table_len - 1 ); // division by zero is checked
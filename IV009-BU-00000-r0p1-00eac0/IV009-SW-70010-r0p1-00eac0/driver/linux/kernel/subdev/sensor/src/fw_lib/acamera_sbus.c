@@ -318,6 +318,17 @@ void acamera_sbus_write_u32( acamera_sbus_t *p_bus, uintptr_t addr, uint32_t sam
 void acamera_sbus_write_data_u8( acamera_sbus_t *p_bus, uintptr_t addr, uint8_t *p_data, int n_count )
 {
     int i;
+    if ( p_bus->write_block != NULL && ( p_bus->mask & SBUS_MASK_SAMPLE_8BITS ) && SBUS_CAN_ADDRESS_8BITS( p_bus ) ) {
+        // the device increments the register address itself, one transfer per block
+        while ( n_count > 0 ) {
+            const int n_len = ( n_count > SBUS_BLOCK_MAX ) ? SBUS_BLOCK_MAX : n_count;
+            p_bus->write_block( p_bus, sbus_update_address( p_bus, addr ), p_data, n_len );
+            p_data += n_len;
+            addr += n_len;
+            n_count -= n_len;
+        }
+        return;
+    }
     for ( i = 0; i < n_count; ++i ) {
         acamera_sbus_write_u8( p_bus, addr, p_data[i] );
         addr += 1;
@@ -328,6 +339,28 @@ void acamera_sbus_write_data_u16( acamera_sbus_t *p_bus, uintptr_t addr, uint16_
 {
     const int addr_step = SBUS_ADDRESS_16BIT_INCREMENT( p_bus );
     int i;
+    if ( p_bus->write_block != NULL && ( p_bus->mask & SBUS_MASK_SAMPLE_16BITS ) ) {
+        uint8_t buf[SBUS_BLOCK_MAX];
+        while ( n_count > 0 ) {
+            const int n_len = ( n_count > SBUS_BLOCK_MAX / 2 ) ? SBUS_BLOCK_MAX / 2 : n_count;
+            for ( i = 0; i < n_len; ++i ) {
+                const uint16_t sample = acamera_mem_read_u16( p_data + i );
+                // the same byte order as write_sample puts on the bus
+                if ( p_bus->mask & SBUS_MASK_SAMPLE_SWAP_BYTES ) {
+                    buf[2 * i] = ( uint8_t )( sample >> 8 );
+                    buf[2 * i + 1] = (uint8_t)sample;
+                } else {
+                    buf[2 * i] = (uint8_t)sample;
+                    buf[2 * i + 1] = ( uint8_t )( sample >> 8 );
+                }
+            }
+            p_bus->write_block( p_bus, sbus_update_address( p_bus, addr ), buf, 2 * n_len );
+            p_data += n_len;
+            addr += n_len * addr_step;
+            n_count -= n_len;
+        }
+        return;
+    }
     if ( ( (size_t)p_data ) & 1 ) {
         // unaligned write
         for ( i = 0; i < n_count; ++i, ++p_data ) {
@@ -479,10 +512,23 @@ void acamera_sbus_copy( acamera_sbus_t *p_bus_to, uintptr_t addr_to, acamera_sbu
     }
 }
 
+// Writes may return before the device has acknowledged them.
+// Returns 0 when every write since the previous call was acknowledged.
+int32_t acamera_sbus_sync( acamera_sbus_t *p_bus )
+{
+    int32_t result = 0;
+    if ( p_bus->sync != NULL ) {
+        result = p_bus->sync( p_bus );
+    }
+    return result;
+}
+
 void acamera_sbus_init( acamera_sbus_t *p_bus, sbus_type_t interface_type )
 {
     if ( p_bus != NULL ) {
         p_bus->p_control = NULL;
+        p_bus->write_block = NULL;
+        p_bus->sync = NULL;
         switch ( interface_type ) {
         case sbus_i2c:
             acamera_sbus_i2c_init( p_bus );
@@ -23,6 +23,7 @@
 #include "acamera_fw.h"
 #endif
 #include "system_i2c.h"
+#include "system_stdlib.h"
 
 #include "acamera_logger.h"
 
@@ -75,6 +76,45 @@ static void i2c_io_write_sample( acamera_sbus_t *p_bus, uintptr_t addr, uint32_t
 #endif
 }
 
+static void i2c_io_write_block( acamera_sbus_t *p_bus, uintptr_t addr, const uint8_t *p_data, uint32_t size )
+{
+#if ISP_FW_BUILD
+    const acamera_context_ptr_t p_ctx = (const acamera_context_ptr_t)p_bus->p_control;
+#endif
+    uint8_t buf[4 + SBUS_BLOCK_MAX]; // maximum address and data
+    uint32_t buf_size = fill_address( buf, p_bus->mask, addr );
+    uint8_t i;
+
+    if ( size > SBUS_BLOCK_MAX ) {
+        LOG( LOG_ERR, "I2C block of %u bytes is too long", (unsigned int)size );
+        return;
+    }
+    system_memcpy( buf + buf_size, p_data, size );
+    buf_size += size;
+#if ISP_FW_BUILD
+    if ( p_ctx )
+        acamera_fw_interrupts_disable( p_ctx );
+#endif
+    i = system_i2c_write( p_bus->bus, p_bus->device, buf, buf_size );
+    if ( i != I2C_OK ) {
+        LOG( LOG_ERR, "I2C not ok" );
+    }
+#if ISP_FW_BUILD
+    if ( p_ctx )
+        acamera_fw_interrupts_enable( p_ctx );
+#endif
+}
+
+static int32_t i2c_io_sync( acamera_sbus_t *p_bus )
+{
+    uint8_t status = system_i2c_sync( p_bus->bus );
+    if ( status != I2C_OK ) {
+        LOG( LOG_ERR, "I2C write to device 0x%x not acknowledged, status %d", p_bus->device, status );
+        return -1;
+    }
+    return 0;
+}
+
 static uint32_t i2c_io_read_sample( acamera_sbus_t *p_bus, uintptr_t addr, uint8_t sample_size )
 {
     uint32_t res = 0;
@@ -116,6 +156,8 @@ void acamera_sbus_i2c_init( acamera_sbus_t *p_bus )
 {
     p_bus->read_sample = i2c_io_read_sample;
     p_bus->write_sample = i2c_io_write_sample;
+    p_bus->write_block = i2c_io_write_block;
+    p_bus->sync = i2c_io_sync;
     system_i2c_init( p_bus->bus );
 }
 
@@ -22,25 +22,55 @@
 #include "system_i2c.h"
 #include "acamera_logger.h"
 #include <linux/jiffies.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/string.h>
 
 #define FPGA_IIC_MEM_SIZE 0x1000
+#define FPGA_IIC_ISR 0x020
 #define FPGA_IIC_TX_FIFO 0x108
 #define FPGA_IIC_RX_FIFO_PIRQ 0x120
 #define FPGA_IIC_CR 0x100
 #define FPGA_IIC_SR 0x104
 #define FPGA_IIC_RX_FIFO 0x10c
+#define FPGA_IIC_TX_FIFO_OCY 0x114
 
 #define RX_EMPTY_SHIFT 6
 #define TX_EMPTY_SHIFT 7
+#define TX_FULL_SHIFT 4
 #define BUSY_BUS_SHIFT 2
 
+// interrupt status bits, they are latched even when the interrupts are not enabled
+#define ISR_ARB_LOST ( 1 << 0 )
+#define ISR_TX_ERROR ( 1 << 1 ) // no acknowledge from the device
+
+// depth of the AXI IIC transmit fifo, every entry holds one byte with its control bits
+#define FPGA_IIC_TX_FIFO_DEPTH 16
+
 #define FPGA_IIC_TIMEOUT_HZ ( HZ / 10 )
 // maximum i2c contexts = 2 * FIRMWARE_CONTEXT_NUMBER - one for sensor, one for lens
 #define FPGA_IIC_MASTERS_MAX ( 2 * FIRMWARE_CONTEXT_NUMBER )
 
+// bus time of one byte with its acknowledge bit on a 400kHz bus.
+// the waiting thread sleeps for the bus time of the bytes still queued in the
+// controller, waits shorter than FPGA_IIC_SLEEP_MIN_US are spun.
+#define FPGA_IIC_BYTE_US 23
+#define FPGA_IIC_SLEEP_MIN_US 20
+
+typedef struct _iic_stats_t {
+    uint32_t transactions; // write and read transactions started on the bus
+    uint32_t bytes;        // bytes pushed into the tx fifo
+    uint32_t sleeps;       // times a waiting thread gave up the cpu
+    uint64_t wait_ns;      // total time spent waiting for the controller
+} iic_stats_t;
+
 typedef struct _iic_master_t {
     uint32_t phy_addr;
     void *virt_addr;
+    iic_stats_t stats;
+    uint8_t write_queued; // a write was queued and its status is not collected yet
+    uint8_t write_status; // first error of the writes completed since the last system_i2c_sync
 } iic_master_t;
 
 
@@ -48,14 +78,14 @@ static iic_master_t iic_master[FPGA_IIC_MASTERS_MAX];
 static uint32_t bus_number = 0;
 
 
-static void *iic_get_vaddr( uint32_t bus )
+static iic_master_t *iic_get_master( uint32_t bus )
 {
-    void *result = NULL;
+    iic_master_t *result = NULL;
     uint32_t idx = 0;
 
     for ( idx = 0; idx < bus_number; idx++ ) {
         if ( iic_master[idx].phy_addr == bus ) {
-            result = iic_master[idx].virt_addr;
+            result = &iic_master[idx];
             break;
         }
     }
@@ -63,6 +93,13 @@ static void *iic_get_vaddr( uint32_t bus )
 }
 
 
+static void *iic_get_vaddr( uint32_t bus )
+{
+    iic_master_t *p_master = iic_get_master( bus );
+    return ( p_master != NULL ) ? p_master->virt_addr : NULL;
+}
+
+
 void system_i2c_init( uint32_t bus )
 {
     LOG( LOG_INFO, "I2C bus init for bus 0x%x", bus );
@@ -84,9 +121,14 @@ void system_i2c_init( uint32_t bus )
                 // reset
                 iowrite32( 2, virt_addr + FPGA_IIC_CR );
                 iowrite32( 1, virt_addr + FPGA_IIC_CR );
+                // clear the latched errors
+                iowrite32( ioread32( virt_addr + FPGA_IIC_ISR ) & ( ISR_ARB_LOST | ISR_TX_ERROR ), virt_addr + FPGA_IIC_ISR );
 
                 iic_master[bus_number].phy_addr = bus;
                 iic_master[bus_number].virt_addr = virt_addr;
+                memset( &iic_master[bus_number].stats, 0, sizeof( iic_stats_t ) );
+                iic_master[bus_number].write_queued = 0;
+                iic_master[bus_number].write_status = I2C_OK;
                 bus_number++;
                 // init communication phy_addr
                 LOG( LOG_INFO, "I2C connection has been opened" );
@@ -103,6 +145,12 @@ void system_i2c_init( uint32_t bus )
 
 void system_i2c_deinit( uint32_t bus )
 {
+    iic_master_t *p_master = iic_get_master( bus );
+    if ( p_master != NULL ) {
+        const iic_stats_t *p_stats = &p_master->stats;
+        LOG( LOG_INFO, "I2C bus 0x%x: %u transactions, %u bytes, waited %llu us, slept %u times",
+             bus, p_stats->transactions, p_stats->bytes, div_u64( p_stats->wait_ns, 1000 ), p_stats->sleeps );
+    }
 }
 
 void pcie_i2c_close( void )
@@ -110,45 +158,137 @@ void pcie_i2c_close( void )
 }
 
 
-static int32_t iic_bus_is_ready( void *virt_addr )
+// Number of bytes the controller still has to put on the bus:
+// the tx fifo entries and the one being shifted out.
+static uint32_t iic_pending_bytes( iic_master_t *p_master, uint32_t status )
+{
+    uint32_t result = ( ( status >> BUSY_BUS_SHIFT ) & 1 );
+    if ( !( ( status >> TX_EMPTY_SHIFT ) & 1 ) ) {
+        // the occupancy register holds the number of entries minus one
+        result += ( ioread32( p_master->virt_addr + FPGA_IIC_TX_FIFO_OCY ) & 0xf ) + 1;
+    }
+    return result;
+}
+
+
+// Wait until cond( status ) is true.
+// The thread sleeps for the bus time of the queued bytes, up to max_bytes of
+// them, instead of polling the status register, and checks again after that.
+// Returns 0 when the condition is met, 1 when the device did not acknowledge
+// or the arbitration was lost and -1 on timeout.
+static int32_t iic_wait_status( iic_master_t *p_master, int ( *cond )( uint32_t status ), uint32_t max_bytes )
 {
     int32_t result = 0;
-    uint32_t busy_bus = 0;
-    uint32_t ready = 0;
-    uint32_t status_reg = 0;
-    uint32_t rx_empty = 0;
-    uint32_t tx_empty = 0;
+    uint32_t status;
     uint32_t js = jiffies;
-    uint32_t jt = js;
-    LOG( LOG_DEBUG, "status reg 0x%x", status_reg );
-    while ( ready == 0 ) {
-        status_reg = ioread32( virt_addr + FPGA_IIC_SR );
-
-        rx_empty = ( status_reg >> RX_EMPTY_SHIFT ) & 1;
-        tx_empty = ( status_reg >> TX_EMPTY_SHIFT ) & 1;
-        busy_bus = ( status_reg >> BUSY_BUS_SHIFT ) & 1;
-
-        if ( rx_empty == 1 ) {
-            if ( tx_empty == 1 ) {
-                if ( busy_bus == 0 ) {
-                    ready = 1;
-                } else {
-                    LOG( LOG_DEBUG, "Error. Bus is busy" );
-                }
-            } else {
-                LOG( LOG_DEBUG, "Error. TX FIFO is not empty" );
-            }
-        } else {
-            LOG( LOG_DEBUG, "Error. RX FIFO is not empty" );
-        }
+    ktime_t start = ktime_get();
 
-        jt = jiffies;
-        if ( ( jt - js ) > FPGA_IIC_TIMEOUT_HZ ) {
+    while ( !cond( status = ioread32( p_master->virt_addr + FPGA_IIC_SR ) ) ) {
+        uint32_t bytes, wait_us;
+        if ( ioread32( p_master->virt_addr + FPGA_IIC_ISR ) & ( ISR_ARB_LOST | ISR_TX_ERROR ) ) {
+            // the transaction stopped, the condition will not be met
+            result = 1;
+            break;
+        }
+        if ( ( jiffies - js ) > FPGA_IIC_TIMEOUT_HZ ) {
             result = -1;
-            LOG( LOG_ERR, "IIC line is unavailable" );
             break;
         }
+        bytes = iic_pending_bytes( p_master, status );
+        if ( bytes > max_bytes )
+            bytes = max_bytes;
+        wait_us = ( bytes ? bytes : 1 ) * FPGA_IIC_BYTE_US;
+        if ( wait_us >= FPGA_IIC_SLEEP_MIN_US ) {
+            usleep_range( wait_us, wait_us + FPGA_IIC_BYTE_US );
+            p_master->stats.sleeps++;
+        } else {
+            cpu_relax();
+        }
+    }
+
+    p_master->stats.wait_ns += ktime_to_ns( ktime_sub( ktime_get(), start ) );
+    return result;
+}
+
+
+static int iic_status_idle( uint32_t status )
+{
+    // both fifos are empty and the bus is free
+    return ( ( status >> RX_EMPTY_SHIFT ) & 1 ) && ( ( status >> TX_EMPTY_SHIFT ) & 1 ) && !( ( status >> BUSY_BUS_SHIFT ) & 1 );
+}
+
+
+static int iic_status_tx_not_full( uint32_t status )
+{
+    return !( ( status >> TX_FULL_SHIFT ) & 1 );
+}
+
+
+static int iic_status_rx_ready( uint32_t status )
+{
+    return !( ( status >> RX_EMPTY_SHIFT ) & 1 );
+}
+
+
+// Read and clear the error bits latched by the last transaction.
+static uint8_t iic_take_status( iic_master_t *p_master )
+{
+    uint8_t result = I2C_OK;
+    uint32_t isr = ioread32( p_master->virt_addr + FPGA_IIC_ISR ) & ( ISR_ARB_LOST | ISR_TX_ERROR );
+    if ( isr ) {
+        // the status bits toggle on write
+        iowrite32( isr, p_master->virt_addr + FPGA_IIC_ISR );
+        result = ( isr & ISR_ARB_LOST ) ? I2C_ABITRATION_LOST : I2C_NOACK;
+        // drop what is left of the failed transaction
+        iowrite32( 3, p_master->virt_addr + FPGA_IIC_CR );
+        iowrite32( 1, p_master->virt_addr + FPGA_IIC_CR );
+    }
+    return result;
+}
+
+
+// Wait until the controller is idle and keep the status of a queued write
+// for system_i2c_sync.
+static int32_t iic_bus_is_ready( iic_master_t *p_master )
+{
+    int32_t result = iic_wait_status( p_master, iic_status_idle, FPGA_IIC_TX_FIFO_DEPTH + 1 );
+    if ( result >= 0 ) {
+        uint8_t status = iic_take_status( p_master );
+        if ( status != I2C_OK && p_master->write_queued ) {
+            LOG( LOG_ERR, "IIC write failed with status %d", status );
+            if ( p_master->write_status == I2C_OK )
+                p_master->write_status = status;
+        }
+        p_master->write_queued = 0;
+        if ( result > 0 ) {
+            // the failed transaction is dropped, the bus is released after its stop condition
+            result = iic_wait_status( p_master, iic_status_idle, 1 );
+        }
+    }
+    if ( result != 0 ) {
+        LOG( LOG_ERR, "IIC line is unavailable, status 0x%x", ioread32( p_master->virt_addr + FPGA_IIC_SR ) );
+        result = -1;
+    }
+    return result;
+}
+
+
+// Push one entry to the tx fifo. Only the entries above the fifo depth
+// have to wait for the controller to drain the fifo.
+static int32_t iic_tx_push( iic_master_t *p_master, uint32_t *p_queued, uint32_t val )
+{
+    int32_t result = 0;
+    if ( *p_queued >= FPGA_IIC_TX_FIFO_DEPTH ) {
+        // refill the fifo when half of it is sent
+        result = iic_wait_status( p_master, iic_status_tx_not_full, FPGA_IIC_TX_FIFO_DEPTH / 2 );
+        if ( result != 0 ) {
+            LOG( LOG_ERR, "IIC tx fifo is stuck" );
+            return result;
+        }
     }
+    iowrite32( val, p_master->virt_addr + FPGA_IIC_TX_FIFO );
+    ( *p_queued )++;
+    p_master->stats.bytes++;
     return result;
 }
 
@@ -169,11 +309,17 @@ uint8_t system_i2c_write( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32
     //5.   Write 0xAB to the TX_FIFO (byte 2).
     //6.   Write 0xCD to the TX_FIFO (byte 3).
     //7.   Write 0x2EF to the TX_FIFO (stop bit, byte 4).
-    void *virt_addr = iic_get_vaddr( bus );
+    //
+    //The function returns as soon as the whole transaction is queued to the controller,
+    //the bus time of the transfer is overlapped with the caller. The acknowledge status
+    //is collected before the next transaction and reported by system_i2c_sync. Blocks longer than
+    //the tx fifo are written as one transaction so the device auto-increments its
+    //register address for every byte.
+    iic_master_t *p_master = iic_get_master( bus );
     uint8_t result = I2C_OK;
     uint8_t addr = ( phy_addr << 1 ) & 0xff;
 
-    if ( virt_addr != NULL ) {
+    if ( p_master != NULL ) {
         LOG( LOG_DEBUG, "I2C Write phy_addr 0x%x  size %d", addr, size );
 
         uint32_t no_stop = phy_addr & 0x20000;
@@ -192,27 +338,37 @@ uint8_t system_i2c_write( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32
         }
 
         uint32_t idx = 0;
+        uint32_t queued = 0;
+        int32_t rc;
         // start sequence
-        //LOG(LOG_DEBUG, "I2C write phy_addr = 0x%x, size = %d", phy_addr, size ) ;
         uint32_t start_seq = 0x00000100 + addr;
         // wait until iic is ready
-        result = iic_bus_is_ready( virt_addr );
-        if ( result == 0 ) {
-            //LOG(LOG_DEBUG, "Writing 0x%x", start_seq ) ;
-            iowrite32( start_seq, virt_addr + FPGA_IIC_TX_FIFO );
-            for ( idx = 0; idx < size; idx++ ) {
+        rc = iic_bus_is_ready( p_master );
+        if ( rc == 0 ) {
+            p_master->stats.transactions++;
+            rc = iic_tx_push( p_master, &queued, start_seq );
+            for ( idx = 0; idx < size && rc == 0; idx++ ) {
                 uint32_t val = data[idx];
                 if ( idx == size - 1 ) {
                     // add termination bit
-                    //if ( no_stop == 0 ) {
                     val = 0x00000200 + val;
-                    //}
                 }
-                //LOG(LOG_DEBUG, "Writing 0x%x", val ) ;
-                iowrite32( val, virt_addr + FPGA_IIC_TX_FIFO );
+                rc = iic_tx_push( p_master, &queued, val );
+            }
+            if ( rc == 0 ) {
+                LOG( LOG_DEBUG, "I2C write finished. " );
+                p_master->write_queued = 1;
+                result = I2C_OK;
+            } else if ( rc > 0 ) {
+                // the device stopped the transaction before it was queued completely
+                result = iic_take_status( p_master );
+            } else {
+                // the tx fifo did not drain in time and the status bits say nothing
+                // about it, drop the unterminated transaction
+                iowrite32( 3, p_master->virt_addr + FPGA_IIC_CR );
+                iowrite32( 1, p_master->virt_addr + FPGA_IIC_CR );
+                result = I2C_NOACK;
             }
-            LOG( LOG_DEBUG, "I2C write finished. " );
-            result = I2C_OK;
         } else {
             LOG( LOG_CRIT, "I2C write failed. No connect for the bus 0x%x ", bus );
             result = I2C_NOCONNECT;
@@ -225,41 +381,6 @@ uint8_t system_i2c_write( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32
     return result;
 }
 
-static int32_t rx_fifo_has_data( void *virt_addr )
-{
-    uint32_t result = 0;
-    uint32_t rx_empty = 0;
-    uint32_t busy_bus = 0;
-    uint32_t status_reg = 0;
-    uint32_t js = jiffies;
-    uint32_t jt = js;
-
-    while ( result == 0 ) {
-        status_reg = ioread32( virt_addr + FPGA_IIC_SR );
-        LOG( LOG_DEBUG, "status reg 0x%x", status_reg );
-        rx_empty = ( status_reg >> RX_EMPTY_SHIFT ) & 1;
-        busy_bus = ( status_reg >> BUSY_BUS_SHIFT ) & 1;
-
-        if ( busy_bus == 0 ) {
-            if ( rx_empty == 0 ) {
-                result = 1;
-            } else {
-                LOG( LOG_DEBUG, "Read - RX fifo is empty" );
-            }
-        } else {
-            LOG( LOG_DEBUG, "Read - bus is busy" );
-        }
-
-        jt = jiffies;
-        if ( ( jt - js ) > FPGA_IIC_TIMEOUT_HZ ) {
-            result = -1;
-            LOG( LOG_ERR, "Has data timeout. " );
-            break;
-        }
-    }
-    return result;
-}
-
 //uint8_t i2c_read(uint8_t phy_addr, uint8_t* data, uint32_t size)
 uint8_t system_i2c_read( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32_t size )
 {
@@ -276,7 +397,8 @@ uint8_t system_i2c_read( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32_
     //a.   Read the RX_FIFO byte.
     //b.   If the fourth byte is read, exit; otherwise, continue checking RX_FIFO not empty.
 
-    void *virt_addr = iic_get_vaddr( bus );
+    iic_master_t *p_master = iic_get_master( bus );
+    void *virt_addr = ( p_master != NULL ) ? p_master->virt_addr : NULL;
     uint32_t result = 0;
     uint8_t addr = ( phy_addr << 1 ) & 0xff;
 
@@ -288,10 +410,11 @@ uint8_t system_i2c_read( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32_
         //LOG(LOG_DEBUG, "I2C write phy_addr = 0x%x, size = %d", phy_addr, size ) ;
         uint32_t start_seq = 0x00000100 + addr;
 
-        result = iic_bus_is_ready( virt_addr );
+        result = iic_bus_is_ready( p_master );
 
         if ( result == 0 ) {
             LOG( LOG_DEBUG, "Reading 0x%x", start_seq );
+            p_master->stats.transactions++;
 
             if ( read_size != 0 ) {
                 // the read_phy_addr and read_size values are saved in the system_i2c_write call.
@@ -313,10 +436,12 @@ uint8_t system_i2c_read( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32_
 
             for ( idx = 0; idx < size; idx++ ) {
                 // wait until the write is done
-                LOG( LOG_DEBUG, "Reading wait for rx fifo " );
-                if ( rx_fifo_has_data( virt_addr ) != 1 ) {
-                    LOG( LOG_DEBUG, "Failed to get data from FIFO" );
-                };
+                int32_t rc = iic_wait_status( p_master, iic_status_rx_ready, FPGA_IIC_TX_FIFO_DEPTH + 1 );
+                if ( rc != 0 ) {
+                    LOG( LOG_ERR, "Failed to get data from FIFO" );
+                    result = ( rc > 0 ) ? iic_take_status( p_master ) : I2C_NOACK;
+                    break;
+                }
                 *data = ioread32( virt_addr + FPGA_IIC_RX_FIFO );
                 LOG( LOG_DEBUG, "I2C read %d finished. val is 0x%x", idx, *data );
                 data++;
@@ -332,6 +457,23 @@ uint8_t system_i2c_read( uint32_t bus, uint32_t phy_addr, uint8_t *data, uint32_
 }
 
 
+uint8_t system_i2c_sync( uint32_t bus )
+{
+    iic_master_t *p_master = iic_get_master( bus );
+    uint8_t result = I2C_NOCONNECT;
+
+    if ( p_master != NULL ) {
+        if ( iic_bus_is_ready( p_master ) == 0 ) {
+            result = p_master->write_status;
+        }
+        p_master->write_status = I2C_OK;
+    } else {
+        LOG( LOG_ERR, "IIC virtual phy_addr for bus 0x%x was not found", bus );
+    }
+    return result;
+}
+
+
 uint32_t IORD( uint32_t BASE, uint32_t REGNUM )
 {
     return 0;
@@ -126,7 +126,13 @@ static int isp_fw_process( void *data )
 // Please see the ACamera Porting Guide for details.
 static void interrupt_handler( void *data, uint32_t mask )
 {
-    acamera_interrupt_handler();
+    acamera_interrupt_latch();
+}
+
+// runs in the irq thread and finishes the processing latched by interrupt_handler
+static void interrupt_thread_handler( void *data, uint32_t mask )
+{
+    acamera_interrupt_thread();
 }
 
 
@@ -163,6 +169,7 @@ int isp_fw_init( uint32_t hw_isp_addr )
         // function whenever the ISP interrupt happens.
         // This interrupt handling procedure is only advisable and is used in ACamera demo application.
         // It can be changed by a customer discretion.
+        system_interrupt_set_thread_handler( interrupt_thread_handler, NULL );
         system_interrupt_set_handler( interrupt_handler, NULL );
 
         // start streaming for sensors
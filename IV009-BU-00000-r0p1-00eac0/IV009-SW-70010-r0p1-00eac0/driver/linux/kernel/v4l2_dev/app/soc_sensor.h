@@ -25,9 +25,47 @@
 // V4L2 async subdevice list.
 #define V4L2_SOC_SENSOR_NAME "SocSensor"
 
+// Maximum number of presets returned by SOC_SENSOR_GET_DESCRIPTOR.
+#define SOC_SENSOR_PRESETS_MAX 16
+
+// Static description of one sensor preset.
+struct soc_sensor_preset_desc {
+    uint32_t width;     // preset width
+    uint32_t height;    // preset height
+    uint32_t fps;       // preset frame rate in the 8.8 format
+    uint32_t exposures; // number of exposures
+    uint32_t wdr_mode;  // wdr mode of the preset
+    uint32_t bits;      // number of bits in raw
+};
+
+// Everything the ISP device needs to know about the sensor.
+// The limits are reported for the current preset.
+struct soc_sensor_descriptor {
+    uint32_t exp_number;                // number of exposures
+    uint32_t again_log2_max;            // maximum analog gain in log2 format
+    uint32_t dgain_log2_max;            // maximum digital gain in log2 format
+    uint32_t update_latency;            // integration time apply delay in frames
+    uint32_t integration_time_min;      // minimum integration time
+    uint32_t integration_time_max;      // maximum integration time
+    uint32_t integration_time_long_max; // maximum long integration time
+    uint32_t integration_time_limit;    // maximum integration time limit
+    uint32_t lines_per_second;          // number of lines per second
+    uint32_t active_width;              // active width of the frame
+    uint32_t active_height;             // active height of the frame
+    uint32_t preset_num;                // number of presets in presets[]
+    uint32_t preset_cur;                // current preset
+    uint32_t skip_frames;               // frames to drop after switching to the current preset
+    struct soc_sensor_preset_desc presets[SOC_SENSOR_PRESETS_MAX];
+};
+
 // This is used as the main communication structure between
 // V4L2 ISP Device and V4L2 Sensor Subdevice
 // Parameters are used differently depending on the actual API command ID.
+// values carried by SOC_SENSOR_SET_EXPOSURE
+#define SOC_SENSOR_EXP_AGAIN 0x1
+#define SOC_SENSOR_EXP_DGAIN 0x2
+#define SOC_SENSOR_EXP_IT 0x4
+
 struct soc_sensor_ioctl_args {
     uint32_t ctx_num;
     union {
@@ -48,6 +86,22 @@ struct soc_sensor_ioctl_args {
             uint32_t val_in2; // second input value
             uint32_t val_out; // output value
         } general;
+        // This struct is used only for SOC_SENSOR_SET_EXPOSURE API call.
+        // It carries the requested exposure on input and the values
+        // which are really applied by the sensor on output.
+        struct {
+            int32_t again;      // analog gain in log2 format
+            int32_t dgain;      // digital gain in log2 format
+            uint16_t it_short;  // short integration time
+            uint16_t it_medium; // medium integration time
+            uint16_t it_long;   // long integration time
+            uint32_t sequence;  // number of the exposure update, one per frame
+            uint32_t mask;      // SOC_SENSOR_EXP_* values requested since the previous update
+        } exposure;
+        // This struct is used only for SOC_SENSOR_GET_DESCRIPTOR API call.
+        struct {
+            struct soc_sensor_descriptor *p_desc; // filled by the sensor subdevice
+        } descriptor;
     } args;
 };
 
@@ -251,7 +305,27 @@ enum SocCamera_ioctl {
     // return current number of bits in raw
     // input: sensor mode
     // output: val_out - current number of bits in raw
-   SOC_SENSOR_GET_SENSOR_BITS
+   SOC_SENSOR_GET_SENSOR_BITS,
+
+
+    //########## EXPOSURE ###########//
+
+    // allocate and apply an exposure in one call.
+    // It does the same as SOC_SENSOR_ALLOC_AGAIN, SOC_SENSOR_ALLOC_DGAIN, SOC_SENSOR_ALLOC_IT
+    // for the values selected in mask and SOC_SENSOR_UPDATE_EXP called one after another,
+    // but the sensor driver gets all values at once and writes them together on the sensor_update call.
+    // input: exposure - requested gains, integration times, mask and update sequence
+    // output: exposure - gains and integration times applied by the sensor
+    SOC_SENSOR_SET_EXPOSURE,
+
+
+    //########## DESCRIPTOR ###########//
+
+    // get the sensor limits and the whole preset table in one call.
+    // It replaces the SOC_SENSOR_GET_* calls above during init and mode change.
+    // input: descriptor.p_desc - memory for the descriptor
+    // output: *descriptor.p_desc - sensor descriptor
+    SOC_SENSOR_GET_DESCRIPTOR
 };
 
 
@@ -28,6 +28,7 @@
 
 #include "system_interrupts.h"
 #include "acamera_command_api.h"
+#include "acamera_firmware_api.h"
 #include "acamera_firmware_settings.h"
 #include "acamera_logger.h"
 #include "isp-v4l2-common.h"
@@ -444,8 +445,12 @@ int fw_intf_stream_set_output_format( uint32_t ctx_id, isp_v4l2_stream_type_t st
 #endif
 #if defined( DMA_FORMAT_NV12_Y )
     case V4L2_PIX_FMT_NV12:
+    case V4L2_PIX_FMT_NV12M:
         value = NV12_YUV;
         break;
+    case V4L2_PIX_FMT_NV21M:
+        value = NV12_YVU;
+        break;
 #endif
 #ifdef DMA_FORMAT_A2R10G10B10
     case ISP_V4L2_PIX_FMT_ARGB2101010:
@@ -1151,6 +1156,27 @@ bool fw_intf_validate_control( uint32_t id )
     return isp_fw_do_validate_control( id );
 }
 
+/* controls set until fw_intf_batch_end() are applied as one firmware transaction,
+ * fw_intf_batch_end() must only be called when this returned 0.
+ */
+int fw_intf_batch_begin( uint32_t ctx_id )
+{
+    if ( !isp_started ) {
+        LOG( LOG_ERR, "ISP FW not inited yet" );
+        return -EBUSY;
+    }
+
+    if ( acamera_command_batch_begin( ctx_id ) )
+        return -EINVAL;
+
+    return 0;
+}
+
+void fw_intf_batch_end( uint32_t ctx_id )
+{
+    acamera_command_batch_end( ctx_id );
+}
+
 int fw_intf_set_test_pattern( uint32_t ctx_id, int val )
 {
     return isp_fw_do_set_test_pattern( ctx_id, val );
@@ -51,6 +51,8 @@ int fw_intf_stream_set_output_format( uint32_t ctx_id, isp_v4l2_stream_type_t st
 
 /* fw-interface isp config interface */
 bool fw_intf_validate_control( uint32_t id );
+int fw_intf_batch_begin( uint32_t ctx_id );
+void fw_intf_batch_end( uint32_t ctx_id );
 int fw_intf_set_test_pattern( uint32_t ctx_id, int val );
 int fw_intf_set_test_pattern_type( uint32_t ctx_id, int val );
 int fw_intf_set_af_refocus( uint32_t ctx_id, int val );
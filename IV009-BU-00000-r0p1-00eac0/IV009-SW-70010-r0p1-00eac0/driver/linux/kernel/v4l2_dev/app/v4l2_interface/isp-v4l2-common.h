@@ -54,6 +54,15 @@ typedef struct _isp_v4l2_sensor_info {
 #define V4L2_EVENT_ACAMERA_CLASS ( V4L2_EVENT_PRIVATE_START + 0xA * 1000 )
 #define V4L2_EVENT_ACAMERA_FRAME_READY ( V4L2_EVENT_ACAMERA_CLASS + 0x1 )
 #define V4L2_EVENT_ACAMERA_STREAM_OFF ( V4L2_EVENT_ACAMERA_CLASS + 0x2 )
+#define V4L2_EVENT_ACAMERA_CTRL_APPLIED ( V4L2_EVENT_ACAMERA_CLASS + 0x3 )
+
+/* payload of V4L2_EVENT_ACAMERA_CTRL_APPLIED, carried in v4l2_event.u.data */
+typedef struct _isp_v4l2_ctrl_applied_event {
+    uint32_t stream_type; /* isp_v4l2_stream_type_t of the buffer */
+    uint32_t buf_index;   /* vb2 index of the buffer */
+    uint32_t sequence;    /* same as v4l2_buffer.sequence of that buffer */
+    uint32_t ctrl_num;    /* number of controls applied for it */
+} isp_v4l2_ctrl_applied_event_t;
 
 /* custom v4l2 controls */
 #define ISP_V4L2_CID_ISP_V4L2_CLASS ( 0x00f00000 | 1 )
@@ -65,6 +74,14 @@ typedef struct _isp_v4l2_sensor_info {
 #define ISP_V4L2_CID_AF_ROI ( ISP_V4L2_CID_BASE + 4 )
 #define ISP_V4L2_CID_OUTPUT_FR_ON_OFF ( ISP_V4L2_CID_BASE + 5 )
 #define ISP_V4L2_CID_OUTPUT_DS1_ON_OFF ( ISP_V4L2_CID_BASE + 6 )
+#define ISP_V4L2_CID_REQUEST_BUFFER ( ISP_V4L2_CID_BASE + 7 )
+
+/* ISP_V4L2_CID_REQUEST_BUFFER value: 0 applies controls immediately,
+ * otherwise bits [15:0] hold the vb2 buffer index + 1 and bits [23:16]
+ * the stream type the buffer belongs to.
+ */
+#define ISP_V4L2_REQUEST_BUFFER( stream_type, index ) ( ( ( stream_type ) << 16 ) | ( ( index ) + 1 ) )
+#define ISP_V4L2_REQUEST_BUFFER_MAX 0x00FFFFFF
 
 
 /* type of stream */
@@ -36,78 +36,227 @@ static int isp_v4l2_ctrl_check_valid( struct v4l2_ctrl *ctrl )
     return 0;
 }
 
-static int isp_v4l2_ctrl_s_ctrl_standard( struct v4l2_ctrl *ctrl )
+static int isp_v4l2_ctrl_set_standard( int ctx_id, uint32_t id, int32_t val )
 {
     int ret = 0;
-    struct v4l2_ctrl_handler *hdl = ctrl->handler;
-
-    isp_v4l2_ctrl_t *isp_ctrl = std_hdl_to_isp_ctrl( hdl );
-    int ctx_id = isp_ctrl->ctx_id;
 
-    LOG( LOG_INFO, "Control - id:0x%x, val:%d, is_int:%d, min:%d, max:%d.\n",
-         ctrl->id, ctrl->val, ctrl->is_int, ctrl->minimum, ctrl->maximum );
-
-    if ( isp_v4l2_ctrl_check_valid( ctrl ) < 0 ) {
-        return -EINVAL;
-    }
-
-    switch ( ctrl->id ) {
+    switch ( id ) {
     case V4L2_CID_BRIGHTNESS:
-        ret = fw_intf_set_brightness( ctx_id, ctrl->val );
+        ret = fw_intf_set_brightness( ctx_id, val );
         break;
     case V4L2_CID_CONTRAST:
-        ret = fw_intf_set_contrast( ctx_id, ctrl->val );
+        ret = fw_intf_set_contrast( ctx_id, val );
         break;
     case V4L2_CID_SATURATION:
-        ret = fw_intf_set_saturation( ctx_id, ctrl->val );
+        ret = fw_intf_set_saturation( ctx_id, val );
         break;
     case V4L2_CID_HUE:
-        ret = fw_intf_set_hue( ctx_id, ctrl->val );
+        ret = fw_intf_set_hue( ctx_id, val );
         break;
     case V4L2_CID_SHARPNESS:
-        ret = fw_intf_set_sharpness( ctx_id, ctrl->val );
+        ret = fw_intf_set_sharpness( ctx_id, val );
         break;
     case V4L2_CID_COLORFX:
-        ret = fw_intf_set_color_fx( ctx_id, ctrl->val );
+        ret = fw_intf_set_color_fx( ctx_id, val );
         break;
     case V4L2_CID_HFLIP:
-        ret = fw_intf_set_hflip( ctx_id, ctrl->val );
+        ret = fw_intf_set_hflip( ctx_id, val );
         break;
     case V4L2_CID_VFLIP:
-        ret = fw_intf_set_vflip( ctx_id, ctrl->val );
+        ret = fw_intf_set_vflip( ctx_id, val );
         break;
     case V4L2_CID_AUTOGAIN:
-        ret = fw_intf_set_autogain( ctx_id, ctrl->val );
+        ret = fw_intf_set_autogain( ctx_id, val );
         break;
     case V4L2_CID_GAIN:
-        ret = fw_intf_set_gain( ctx_id, ctrl->val );
+        ret = fw_intf_set_gain( ctx_id, val );
         break;
     case V4L2_CID_EXPOSURE_AUTO:
-        ret = fw_intf_set_exposure_auto( ctx_id, ctrl->val );
+        ret = fw_intf_set_exposure_auto( ctx_id, val );
         break;
     case V4L2_CID_EXPOSURE_ABSOLUTE:
-        ret = fw_intf_set_exposure( ctx_id, ctrl->val );
+        ret = fw_intf_set_exposure( ctx_id, val );
         break;
     case V4L2_CID_EXPOSURE_AUTO_PRIORITY:
-        ret = fw_intf_set_variable_frame_rate( ctx_id, ctrl->val );
+        ret = fw_intf_set_variable_frame_rate( ctx_id, val );
         break;
     case V4L2_CID_AUTO_WHITE_BALANCE:
-        ret = fw_intf_set_white_balance_auto( ctx_id, ctrl->val );
+        ret = fw_intf_set_white_balance_auto( ctx_id, val );
         break;
     case V4L2_CID_WHITE_BALANCE_TEMPERATURE:
-        ret = fw_intf_set_white_balance( ctx_id, ctrl->val );
+        ret = fw_intf_set_white_balance( ctx_id, val );
         break;
     case V4L2_CID_FOCUS_AUTO:
-        ret = fw_intf_set_focus_auto( ctx_id, ctrl->val );
+        ret = fw_intf_set_focus_auto( ctx_id, val );
         break;
     case V4L2_CID_FOCUS_ABSOLUTE:
-        ret = fw_intf_set_focus( ctx_id, ctrl->val );
+        ret = fw_intf_set_focus( ctx_id, val );
         break;
     }
 
     return ret;
 }
 
+/* controls which take effect per frame and may wait for a buffer */
+static int isp_v4l2_ctrl_is_per_frame( uint32_t id )
+{
+    switch ( id ) {
+    case V4L2_CID_AUTOGAIN:
+    case V4L2_CID_GAIN:
+    case V4L2_CID_EXPOSURE_AUTO:
+    case V4L2_CID_EXPOSURE_ABSOLUTE:
+    case V4L2_CID_AUTO_WHITE_BALANCE:
+    case V4L2_CID_WHITE_BALANCE_TEMPERATURE:
+        return 1;
+    }
+
+    return 0;
+}
+
+static int isp_v4l2_ctrl_queue_request( isp_v4l2_ctrl_t *isp_ctrl, uint32_t id, int32_t val )
+{
+    int ret = 0;
+    uint32_t i;
+
+    spin_lock( &isp_ctrl->req_lock );
+    if ( isp_ctrl->req_tag == 0 ) {
+        ret = 1; // no buffer selected any more, apply immediately
+    } else {
+        // a later value for the same buffer replaces the earlier one
+        for ( i = 0; i < isp_ctrl->req_num; i++ ) {
+            if ( isp_ctrl->req[i].tag == isp_ctrl->req_tag && isp_ctrl->req[i].id == id )
+                break;
+        }
+
+        if ( i < ISP_V4L2_CTRL_REQ_MAX ) {
+            isp_ctrl->req[i].tag = isp_ctrl->req_tag;
+            isp_ctrl->req[i].id = id;
+            isp_ctrl->req[i].val = val;
+            if ( i == isp_ctrl->req_num )
+                isp_ctrl->req_num++;
+        } else {
+            ret = -EBUSY;
+        }
+    }
+    spin_unlock( &isp_ctrl->req_lock );
+
+    if ( ret < 0 )
+        LOG( LOG_ERR, "Control request queue is full, id:0x%x dropped.", id );
+
+    return ret;
+}
+
+/* The standard controls form one cluster and ctrl is its master, the
+ * controls changed by this call are marked is_new. All of them are
+ * checked before the first one is applied and they reach the firmware
+ * as one batch, so FSM updates run once for the whole call. The first
+ * control the firmware refuses ends the call, the ones before it stay
+ * applied.
+ */
+static int isp_v4l2_ctrl_s_ctrl_standard( struct v4l2_ctrl *ctrl )
+{
+    int ret = 0;
+    int batch;
+    uint32_t i;
+    struct v4l2_ctrl *c;
+    struct v4l2_ctrl_handler *hdl = ctrl->handler;
+
+    isp_v4l2_ctrl_t *isp_ctrl = std_hdl_to_isp_ctrl( hdl );
+    int ctx_id = isp_ctrl->ctx_id;
+
+    for ( i = 0; i < ctrl->ncontrols; i++ ) {
+        c = ctrl->cluster[i];
+        if ( !c || !c->is_new )
+            continue;
+
+        LOG( LOG_INFO, "Control - id:0x%x, val:%d, is_int:%d, min:%d, max:%d.\n",
+             c->id, c->val, c->is_int, c->minimum, c->maximum );
+
+        if ( isp_v4l2_ctrl_check_valid( c ) < 0 ) {
+            return -EINVAL;
+        }
+    }
+
+    batch = ( fw_intf_batch_begin( ctx_id ) == 0 );
+
+    for ( i = 0; i < ctrl->ncontrols; i++ ) {
+        c = ctrl->cluster[i];
+        if ( !c || !c->is_new )
+            continue;
+
+        /* 0 when the value waits for its buffer, 1 to apply it now */
+        ret = 1;
+        if ( isp_ctrl->req_tag && isp_v4l2_ctrl_is_per_frame( c->id ) )
+            ret = isp_v4l2_ctrl_queue_request( isp_ctrl, c->id, c->val );
+
+        if ( ret > 0 )
+            ret = isp_v4l2_ctrl_set_standard( ctx_id, c->id, c->val );
+
+        if ( ret ) {
+            LOG( LOG_ERR, "Failed to set control id:0x%x, val:%d, ret: %d, the following controls are not set.", c->id, c->val, ret );
+            break;
+        }
+    }
+
+    if ( batch )
+        fw_intf_batch_end( ctx_id );
+
+    return ret;
+}
+
+int isp_v4l2_ctrl_apply_request( isp_v4l2_ctrl_t *isp_ctrl, uint32_t stream_type, uint32_t buf_index )
+{
+    isp_v4l2_ctrl_req_t req[ISP_V4L2_CTRL_REQ_MAX];
+    uint32_t tag = ISP_V4L2_REQUEST_BUFFER( stream_type, buf_index );
+    uint32_t num = 0;
+    uint32_t i, j;
+    int ret;
+
+    if ( isp_ctrl->req_num == 0 )
+        return 0;
+
+    // take the matching entries out, keep the others in order
+    spin_lock( &isp_ctrl->req_lock );
+    for ( i = 0, j = 0; i < isp_ctrl->req_num; i++ ) {
+        if ( isp_ctrl->req[i].tag == tag )
+            req[num++] = isp_ctrl->req[i];
+        else
+            isp_ctrl->req[j++] = isp_ctrl->req[i];
+    }
+    isp_ctrl->req_num = j;
+    spin_unlock( &isp_ctrl->req_lock );
+
+    // this runs on the frame path without the handler lock, so no batch is
+    // opened here. The firmware serialises its batch state, an update which
+    // an open s_ctrl batch defers runs when that batch ends.
+    for ( i = 0; i < num; i++ ) {
+        ret = isp_v4l2_ctrl_set_standard( isp_ctrl->ctx_id, req[i].id, req[i].val );
+        if ( ret )
+            LOG( LOG_ERR, "Failed to apply control 0x%x for buffer %u, ret: %d.", req[i].id, buf_index, ret );
+    }
+
+    if ( num )
+        LOG( LOG_DEBUG, "Applied %u controls for stream %u buffer %u.", num, stream_type, buf_index );
+
+    return num;
+}
+
+void isp_v4l2_ctrl_flush_request( isp_v4l2_ctrl_t *isp_ctrl, uint32_t stream_type )
+{
+    uint32_t i, j;
+
+    spin_lock( &isp_ctrl->req_lock );
+    for ( i = 0, j = 0; i < isp_ctrl->req_num; i++ ) {
+        if ( ( isp_ctrl->req[i].tag >> 16 ) != stream_type )
+            isp_ctrl->req[j++] = isp_ctrl->req[i];
+    }
+    if ( j != isp_ctrl->req_num )
+        LOG( LOG_INFO, "Dropped %u control requests of stream %u.", isp_ctrl->req_num - j, stream_type );
+    isp_ctrl->req_num = j;
+    spin_unlock( &isp_ctrl->req_lock );
+}
+
+
 static int isp_v4l2_ctrl_s_ctrl_custom( struct v4l2_ctrl *ctrl )
 {
     int ret = 0;
@@ -157,6 +306,12 @@ static int isp_v4l2_ctrl_s_ctrl_custom( struct v4l2_ctrl *ctrl )
         LOG( LOG_INFO, "output DS1 on/off: 0x%x.\n", ctrl->val );
         ret = fw_intf_set_output_ds1_on_off( ctx_id, ctrl->val );
         break;
+    case ISP_V4L2_CID_REQUEST_BUFFER:
+        LOG( LOG_INFO, "request buffer: 0x%x.\n", ctrl->val );
+        spin_lock( &isp_ctrl->req_lock );
+        isp_ctrl->req_tag = ctrl->val;
+        spin_unlock( &isp_ctrl->req_lock );
+        break;
     }
 
     return ret;
@@ -246,6 +401,21 @@ static const struct v4l2_ctrl_config isp_v4l2_ctrl_output_ds1_on_off = {
     .def = 0,
 };
 
+/* selecting the same buffer again must still reach s_ctrl */
+static const struct v4l2_ctrl_config isp_v4l2_ctrl_request_buffer = {
+    .ops = &isp_v4l2_ctrl_ops_custom,
+#if defined( V4L2_CTRL_FLAG_EXECUTE_ON_WRITE )
+    .flags = V4L2_CTRL_FLAG_EXECUTE_ON_WRITE,
+#endif
+    .id = ISP_V4L2_CID_REQUEST_BUFFER,
+    .name = "ISP Request Buffer",
+    .type = V4L2_CTRL_TYPE_INTEGER,
+    .min = 0,
+    .max = ISP_V4L2_REQUEST_BUFFER_MAX,
+    .step = 1,
+    .def = 0,
+};
+
 static const struct v4l2_ctrl_ops isp_v4l2_ctrl_ops = {
     .s_ctrl = isp_v4l2_ctrl_s_ctrl_standard,
 };
@@ -258,20 +428,41 @@ static const struct v4l2_ctrl_config isp_v4l2_ctrl_class = {
     .type = V4L2_CTRL_TYPE_CTRL_CLASS,
 };
 
-#define ADD_CTRL_STD( id, min, max, step, def )                  \
-    {                                                            \
-        if ( fw_intf_validate_control( id ) ) {                  \
-            v4l2_ctrl_new_std( hdl_std_ctrl, &isp_v4l2_ctrl_ops, \
-                               id, min, max, step, def );        \
-        }                                                        \
+static void isp_v4l2_ctrl_add_std( isp_v4l2_ctrl_t *isp_ctrl, struct v4l2_ctrl *ctrl )
+{
+    if ( !ctrl )
+        return;
+
+#if defined( V4L2_CTRL_FLAG_EXECUTE_ON_WRITE )
+    /* a per-frame value is queued for the selected buffer even when it
+     * equals the current value, the core skips s_ctrl for those otherwise
+     */
+    if ( isp_v4l2_ctrl_is_per_frame( ctrl->id ) )
+        ctrl->flags |= V4L2_CTRL_FLAG_EXECUTE_ON_WRITE;
+#endif
+
+    if ( isp_ctrl->std_num < ISP_V4L2_CTRL_STD_MAX )
+        isp_ctrl->std_cluster[isp_ctrl->std_num++] = ctrl;
+    else
+        LOG( LOG_ERR, "Too many standard controls, id:0x%x is not batched.", ctrl->id );
+}
+
+#define ADD_CTRL_STD( id, min, max, step, def )                                         \
+    {                                                                                   \
+        if ( fw_intf_validate_control( id ) ) {                                         \
+            isp_v4l2_ctrl_add_std( ctrl,                                                \
+                                   v4l2_ctrl_new_std( hdl_std_ctrl, &isp_v4l2_ctrl_ops, \
+                                                      id, min, max, step, def ) );      \
+        }                                                                               \
     }
 
-#define ADD_CTRL_STD_MENU( id, max, skipmask, def )                   \
-    {                                                                 \
-        if ( fw_intf_validate_control( id ) ) {                       \
-            v4l2_ctrl_new_std_menu( hdl_std_ctrl, &isp_v4l2_ctrl_ops, \
-                                    id, max, skipmask, def );         \
-        }                                                             \
+#define ADD_CTRL_STD_MENU( id, max, skipmask, def )                                          \
+    {                                                                                        \
+        if ( fw_intf_validate_control( id ) ) {                                              \
+            isp_v4l2_ctrl_add_std( ctrl,                                                     \
+                                   v4l2_ctrl_new_std_menu( hdl_std_ctrl, &isp_v4l2_ctrl_ops, \
+                                                           id, max, skipmask, def ) );       \
+        }                                                                                    \
     }
 
 #define ADD_CTRL_CST( id, cfg, priv )                        \
@@ -287,6 +478,11 @@ int isp_v4l2_ctrl_init( uint32_t ctx_id, isp_v4l2_ctrl_t *ctrl )
     struct v4l2_ctrl_handler *hdl_cst_ctrl = &ctrl->ctrl_hdl_cst_ctrl;
     ctrl->ctx_id = ctx_id;
 
+    spin_lock_init( &ctrl->req_lock );
+    ctrl->req_tag = 0;
+    ctrl->req_num = 0;
+    ctrl->std_num = 0;
+
     LOG( LOG_INFO, "[ctrl] ctx_id#%d: ctrl: %p, hdl_std_ctrl: %p, ctrl_hdl_cst_ctrl: %p.", ctx_id, ctrl, hdl_std_ctrl, hdl_cst_ctrl );
 
     /* Init and add standard controls */
@@ -322,6 +518,10 @@ int isp_v4l2_ctrl_init( uint32_t ctx_id, isp_v4l2_ctrl_t *ctrl )
     ADD_CTRL_STD( V4L2_CID_FOCUS_ABSOLUTE,
                   0, 255, 1, 0 );
 
+    /* set the standard controls of one request together */
+    if ( ctrl->std_num )
+        v4l2_ctrl_cluster( ctrl->std_num, ctrl->std_cluster );
+
     /* Init and add custom controls */
     v4l2_ctrl_handler_init( hdl_cst_ctrl, 2 );
     v4l2_ctrl_new_custom( hdl_cst_ctrl, &isp_v4l2_ctrl_class, NULL );
@@ -340,6 +540,8 @@ int isp_v4l2_ctrl_init( uint32_t ctx_id, isp_v4l2_ctrl_t *ctrl )
                   &isp_v4l2_ctrl_output_fr_on_off, NULL );
     ADD_CTRL_CST( ISP_V4L2_CID_OUTPUT_DS1_ON_OFF,
                   &isp_v4l2_ctrl_output_ds1_on_off, NULL );
+    ADD_CTRL_CST( ISP_V4L2_CID_REQUEST_BUFFER,
+                  &isp_v4l2_ctrl_request_buffer, NULL );
 
     /* Add control handler to v4l2 device */
     v4l2_ctrl_add_handler( hdl_std_ctrl, hdl_cst_ctrl, NULL );
@@ -20,12 +20,26 @@
 #ifndef _ISP_V4L2_CTRL_H_
 #define _ISP_V4L2_CTRL_H_
 
+#include <linux/spinlock.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-ctrls.h>
 
 #define std_hdl_to_isp_ctrl( hdl ) container_of( hdl, isp_v4l2_ctrl_t, ctrl_hdl_std_ctrl )
 #define cst_hdl_to_isp_ctrl( hdl ) container_of( hdl, isp_v4l2_ctrl_t, ctrl_hdl_cst_ctrl )
 
+/* max number of controls waiting for their buffer */
+#define ISP_V4L2_CTRL_REQ_MAX 32
+
+/* max number of standard controls, they are set as one cluster */
+#define ISP_V4L2_CTRL_STD_MAX 24
+
+/* control value held back until the tagged buffer is programmed */
+typedef struct _isp_v4l2_ctrl_req {
+    uint32_t tag;
+    uint32_t id;
+    int32_t val;
+} isp_v4l2_ctrl_req_t;
+
 typedef struct _isp_v4l2_ctrl {
     /* Fields need to be filled by owner */
     struct v4l2_device *v4l2_dev;
@@ -35,10 +49,22 @@ typedef struct _isp_v4l2_ctrl {
     uint32_t ctx_id;
     struct v4l2_ctrl_handler ctrl_hdl_std_ctrl; /* STD ctrl */
     struct v4l2_ctrl_handler ctrl_hdl_cst_ctrl; /* CST ctrl */
+    uint32_t std_num;
+    struct v4l2_ctrl *std_cluster[ISP_V4L2_CTRL_STD_MAX];
+
+    /* per-buffer control requests */
+    spinlock_t req_lock;
+    uint32_t req_tag; /* ISP_V4L2_CID_REQUEST_BUFFER value, 0 - immediate */
+    uint32_t req_num;
+    isp_v4l2_ctrl_req_t req[ISP_V4L2_CTRL_REQ_MAX];
 } isp_v4l2_ctrl_t;
 
 /* external interface to isp-v4l2 module */
 int isp_v4l2_ctrl_init( uint32_t ctx_id, isp_v4l2_ctrl_t *ctrl );
 void isp_v4l2_ctrl_deinit( isp_v4l2_ctrl_t *dev );
 
+/* per-buffer requests, called from the stream module */
+int isp_v4l2_ctrl_apply_request( isp_v4l2_ctrl_t *ctrl, uint32_t stream_type, uint32_t buf_index );
+void isp_v4l2_ctrl_flush_request( isp_v4l2_ctrl_t *ctrl, uint32_t stream_type );
+
 #endif
@@ -17,6 +17,7 @@
 *
 */
 
+#include <linux/module.h>
 #include <linux/device.h>
 #include <linux/slab.h>
 #include <linux/random.h>
@@ -56,6 +57,13 @@
 /* max size */
 #define ISP_V4L2_MAX_WIDTH 4000
 #define ISP_V4L2_MAX_HEIGHT 3000
+#define ISP_V4L2_MAX_STRIDE ( ISP_V4L2_MAX_WIDTH * 4 )
+
+/* line stride alignment in bytes, must be a power of 2 */
+#define ISP_V4L2_STRIDE_ALIGN 128
+static unsigned int stride_align = ISP_V4L2_STRIDE_ALIGN;
+module_param( stride_align, uint, 0444 );
+MODULE_PARM_DESC( stride_align, "Line stride alignment of capture buffers in bytes (power of 2)" );
 
 /* default size & format */
 #define ISP_DEFAULT_FORMAT V4L2_PIX_FMT_RGB32
@@ -65,7 +73,8 @@ typedef struct _isp_v4l2_fmt {
     uint32_t fourcc;
     uint8_t depth;
     bool is_yuv;
-    uint8_t planes;
+    uint8_t planes;        /* buffer planes as seen by vb2 */
+    uint8_t uv_height_div; /* chroma plane height divider, 0 - no chroma plane */
 } isp_v4l2_fmt_t;
 
 static isp_v4l2_fmt_t isp_v4l2_supported_formats[] =
@@ -89,7 +98,24 @@ static isp_v4l2_fmt_t isp_v4l2_supported_formats[] =
             .fourcc = V4L2_PIX_FMT_NV12,
             .depth = 8,
             .is_yuv = true,
+            .planes = 1,
+            .uv_height_div = 2,
+        },
+        {
+            .name = "NV12M",
+            .fourcc = V4L2_PIX_FMT_NV12M,
+            .depth = 8,
+            .is_yuv = true,
             .planes = 2,
+            .uv_height_div = 2,
+        },
+        {
+            .name = "NV21M",
+            .fourcc = V4L2_PIX_FMT_NV21M,
+            .depth = 8,
+            .is_yuv = true,
+            .planes = 2,
+            .uv_height_div = 2,
         },
 /* NOTE: Linux kernel 3.19 doesn't support RAW colorspace,
              V4L2_COLORSPACE_RAW is added in Linux 4.2, we support
@@ -158,13 +184,9 @@ void callback_meta( uint32_t ctx_id, const void *fw_metadata )
     LOG( LOG_INFO, "[ctx_id#%d::stream#%d] Meta Frame ID %d.", ctx_id, pstream->stream_id, frame_id );
 
     /* get buffer from vb2 queue  */
-    spin_lock( &pstream->slock );
-    if ( !list_empty( &pstream->stream_buffer_list ) ) {
-        pbuf = list_entry( pstream->stream_buffer_list.next, isp_v4l2_buffer_t, list );
-        list_del( &pbuf->list );
-    }
-    spin_unlock( &pstream->slock );
+    pbuf = isp_v4l2_buf_ring_get( &pstream->ready_ring );
     if ( !pbuf ) {
+        pstream->frames_no_buffer++;
         LOG( LOG_INFO, "[Stream#%d] No active buffer in queue !", pstream->stream_id );
         return;
     }
@@ -205,6 +227,7 @@ void callback_meta( uint32_t ctx_id, const void *fw_metadata )
     else
         memcpy( vb2_buf, fw_metadata, pstream->cur_v4l2_fmt.fmt.pix.sizeimage );
 
+    pstream->frames_done++;
 
     /* Put buffer back to vb2 queue */
     vb2_buffer_done( vb, VB2_BUF_STATE_DONE );
@@ -236,11 +259,18 @@ static uint32_t isp_v4l2_format_to_dma_output( uint32_t pixelformat, uint32_t pl
         dma_format = DMA_FORMAT_A2R10G10B10;
         break;
     case V4L2_PIX_FMT_NV12:
+    case V4L2_PIX_FMT_NV12M:
         if ( plane_no == 0 )
             dma_format = DMA_FORMAT_NV12_Y;
         else if ( plane_no == 1 )
             dma_format = DMA_FORMAT_NV12_UV;
         break;
+    case V4L2_PIX_FMT_NV21M:
+        if ( plane_no == 0 )
+            dma_format = DMA_FORMAT_NV12_Y;
+        else if ( plane_no == 1 )
+            dma_format = DMA_FORMAT_NV12_VU;
+        break;
     default:
         LOG( LOG_CRIT, "Unknown pixelformat: %d", pixelformat );
         break;
@@ -249,46 +279,116 @@ static uint32_t isp_v4l2_format_to_dma_output( uint32_t pixelformat, uint32_t pl
     return dma_format;
 }
 
-static int isp_v4l2_stream_get_plane( struct vb2_buffer *vb,
-                                      struct v4l2_pix_format_mplane *pix_mp,
-                                      aframe_t *aframe, uint32_t plane_no )
+/* number of planes the DMA writer fills for a buffer of this format */
+static uint32_t isp_v4l2_stream_dma_planes( struct v4l2_pix_format_mplane *pix_mp )
 {
-    dma_addr_t addr;
+    // NV12 keeps Y and UV in one buffer plane, the writer still needs both
+    if ( pix_mp->pixelformat == V4L2_PIX_FMT_NV12 )
+        return 2;
 
-    addr = vb2_dma_contig_plane_dma_addr( vb, plane_no );
-    addr -= ISP_SOC_DMA_BUS_OFFSET;
+    return pix_mp->num_planes;
+}
 
-    aframe->address = (uint32_t)addr;
-    aframe->status = dma_buf_empty;
+/* bus address and size of one DMA writer plane inside a vb2 buffer */
+static int isp_v4l2_stream_plane_layout( struct vb2_buffer *vb,
+                                         struct v4l2_pix_format_mplane *pix_mp,
+                                         uint32_t plane_no, uint32_t *addr, uint32_t *size )
+{
+    struct v4l2_plane_pix_format *plane_fmt;
+    dma_addr_t dma_addr;
+
+    if ( pix_mp->pixelformat == V4L2_PIX_FMT_NV12 ) {
+        // UV follows the luma lines in the same plane
+        plane_fmt = &pix_mp->plane_fmt[0];
+        dma_addr = vb2_dma_contig_plane_dma_addr( vb, 0 );
+        if ( plane_no == 0 ) {
+            *size = plane_fmt->bytesperline * pix_mp->height;
+        } else {
+            dma_addr += plane_fmt->bytesperline * pix_mp->height;
+            *size = plane_fmt->sizeimage - plane_fmt->bytesperline * pix_mp->height;
+        }
+    } else {
+        if ( plane_no >= vb->num_planes ) {
+            LOG( LOG_CRIT, "Invalid plane_no: %d", plane_no );
+            return -1;
+        }
+        dma_addr = vb2_dma_contig_plane_dma_addr( vb, plane_no );
+        *size = pix_mp->plane_fmt[plane_no].sizeimage;
+    }
 
-    aframe->type = isp_v4l2_format_to_dma_output( pix_mp->pixelformat, plane_no );
-    aframe->width = pix_mp->width;
-    aframe->height = pix_mp->height;
-    aframe->line_offset = pix_mp->plane_fmt[plane_no].bytesperline;
-    aframe->size = pix_mp->plane_fmt[plane_no].sizeimage;
+    dma_addr -= ISP_SOC_DMA_BUS_OFFSET;
+    *addr = (uint32_t)dma_addr;
 
     return 0;
 }
 
-static void isp_v4l2_stream_put_plane( struct vb2_buffer *vb,
-                                       aframe_t *aframe, uint32_t plane_no )
+int isp_v4l2_stream_prepare_buffer( isp_v4l2_stream_t *pstream, struct vb2_buffer *vb )
 {
-    dma_addr_t addr;
+#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
+    isp_v4l2_buffer_t *pbuf = container_of( to_vb2_v4l2_buffer( vb ), isp_v4l2_buffer_t, vvb );
+#else
+    isp_v4l2_buffer_t *pbuf = container_of( vb, isp_v4l2_buffer_t, vb );
+#endif
+    struct v4l2_pix_format_mplane *pix_mp = &pstream->cur_v4l2_fmt.fmt.pix_mp;
+    aframe_t *aframe;
+    uint32_t dma_planes;
+    uint32_t addr;
+    uint32_t size;
+    uint32_t i;
+
+    /* metadata is copied by the cpu, not written by the dma writer */
+    if ( pix_mp->pixelformat == ISP_V4L2_PIX_FMT_META ) {
+        pbuf->dma_planes = 0;
+        return 0;
+    }
 
-    if ( plane_no >= vb->num_planes ) {
-        LOG( LOG_CRIT, "Invalid plane_no: %d", plane_no );
-        return;
+    /* the frame-end path only copies these descriptors,
+     * a buffer with more planes is refused there.
+     */
+    dma_planes = isp_v4l2_stream_dma_planes( pix_mp );
+    for ( i = 0; i < dma_planes && i < ISP_V4L2_DMA_PLANES_MAX; i++ ) {
+        if ( isp_v4l2_stream_plane_layout( vb, pix_mp, i, &addr, &size ) < 0 )
+            return -EINVAL;
+
+        aframe = &pbuf->dma_plane[i];
+        memset( aframe, 0, sizeof( *aframe ) );
+        aframe->address = addr;
+        aframe->status = dma_buf_empty;
+        aframe->type = isp_v4l2_format_to_dma_output( pix_mp->pixelformat, i );
+        aframe->width = pix_mp->width;
+        aframe->height = pix_mp->height;
+        aframe->line_offset = pix_mp->plane_fmt[pix_mp->num_planes > 1 ? i : 0].bytesperline;
+        aframe->size = size;
     }
+    pbuf->dma_planes = dma_planes;
 
-    addr = vb2_dma_contig_plane_dma_addr( vb, plane_no );
-    addr -= ISP_SOC_DMA_BUS_OFFSET;
+    return 0;
+}
 
-    if ( aframe->address != (uint32_t)addr ) {
-        LOG( LOG_CRIT, "Bad dma address %x %x", aframe->address, (uint32_t)addr );
-        return;
-    }
+void isp_v4l2_stream_queue_buffer( isp_v4l2_stream_t *pstream, isp_v4l2_buffer_t *pbuf )
+{
+    // vb2 never has more than VIDEO_MAX_FRAME buffers, so the ring can't be full
+    if ( isp_v4l2_buf_ring_put( &pstream->ready_ring, pbuf ) < 0 )
+        LOG( LOG_CRIT, "[Stream#%d] ready ring overflow", pstream->stream_id );
+}
+
+static void isp_v4l2_stream_buffer_release( isp_v4l2_stream_t *pstream, isp_v4l2_buffer_t *pbuf )
+{
+    struct vb2_buffer *vb;
+    unsigned int buf_index;
+
+#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
+    vb = &pbuf->vvb.vb2_buf;
+    buf_index = vb->index;
+#else
+    vb = &pbuf->vb;
+    buf_index = vb->v4l2_buf.index;
+#endif
 
-    aframe->status = dma_buf_purge;
+    vb2_buffer_done( vb, VB2_BUF_STATE_ERROR );
+
+    LOG( LOG_INFO, "[Stream#%d] vid_cap buffer %d done",
+         pstream->stream_id, buf_index );
 }
 
 #if ISP_V4L2_DMA_COHERENT_DUMMY_ALLOC == 0
@@ -351,105 +451,60 @@ void callback_dma_free_coherent( uint32_t ctx_id, uint64_t size, void *virt_addr
 #endif
 
 
-int callback_stream_get_frame( uint32_t ctx_id, acamera_stream_type_t type, aframe_t *aframes, uint64_t num_planes )
+static int isp_v4l2_stream_get_frame( isp_v4l2_stream_t *pstream, aframe_t *aframes, uint64_t num_planes )
 {
-    int rc;
-    isp_v4l2_stream_type_t v4l2_type;
-    isp_v4l2_stream_t *pstream;
-    isp_v4l2_buffer_t *pbuf = NULL;
-    struct v4l2_format *v4l2_fmt;
-    struct v4l2_pix_format_mplane *pix_mp;
-#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
-    struct vb2_v4l2_buffer *vvb;
-#endif
-    struct vb2_buffer *vb;
+    isp_v4l2_buffer_t *pbuf;
+    isp_v4l2_dev_t *pdev;
+    uint32_t buf_index;
     int i;
 
-    for ( i = 0; i < num_planes; i++ ) {
-        aframes[i].status = dma_buf_purge;
-    }
-
-    v4l2_type = fw_to_isp_v4l2_stream_type( type );
-    if ( v4l2_type == V4L2_STREAM_TYPE_MAX )
-        return -1;
-
-    /* find stream pointer */
-    rc = isp_v4l2_find_stream( &pstream, ctx_id, v4l2_type );
-    if ( rc < 0 ) {
-        LOG( LOG_DEBUG, "can't find stream on ctx %d (errno = %d)",
-             ctx_id, rc );
+    /* take a ready buffer, addresses were computed at buf_prepare */
+    pbuf = isp_v4l2_buf_ring_get( &pstream->ready_ring );
+    if ( !pbuf ) {
+        pstream->frames_no_buffer++;
+        LOG( LOG_INFO, "[Stream#%d] type: %d no empty buffers (%u frames missed)",
+             pstream->stream_id, pstream->stream_type, pstream->frames_no_buffer );
         return -1;
     }
 
-    /* check if stream is on */
-    if ( !pstream->stream_started ) {
-        LOG( LOG_DEBUG, "[Stream#%d] type: %d is not started yet on ctx %d",
-             pstream->stream_id, type, ctx_id );
+    if ( num_planes < pbuf->dma_planes ) {
+        LOG( LOG_CRIT, "Bad num of planes: num_planes: %d dma_planes: %d",
+             num_planes, pbuf->dma_planes );
+        isp_v4l2_stream_buffer_release( pstream, pbuf );
         return -1;
     }
 
-    v4l2_fmt = &pstream->cur_v4l2_fmt;
-
-    /* try to get an active buffer from vb2 queue  */
-    spin_lock( &pstream->slock );
-    if ( !list_empty( &pstream->stream_buffer_list ) ) {
-        pbuf = list_entry( pstream->stream_buffer_list.next, isp_v4l2_buffer_t, list );
-        list_del( &pbuf->list );
-        list_add_tail( &pbuf->list, &pstream->stream_buffer_list_busy );
-    }
-    spin_unlock( &pstream->slock );
-
-    if ( !pbuf ) {
-        LOG( LOG_INFO, "[Stream#%d] type: %d no empty buffers",
-             pstream->stream_id, type );
-        return -1;
-    }
+    isp_v4l2_buf_ring_put( &pstream->busy_ring, pbuf );
 
 #if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
-    vvb = &pbuf->vvb;
-    vb = &vvb->vb2_buf;
+    buf_index = pbuf->vvb.vb2_buf.index;
 #else
-    vb = &pbuf->vb;
+    buf_index = pbuf->vb.v4l2_buf.index;
 #endif
 
-    if ( v4l2_fmt->type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ) {
-        pix_mp = &v4l2_fmt->fmt.pix_mp;
-
-        if ( pix_mp->num_planes != vb->num_planes ) {
-            LOG( LOG_CRIT, "Different num of planes: %d %d",
-                 pix_mp->num_planes, vb->num_planes );
-            return -1;
-        }
+    /* controls bound to this buffer take effect on the frame written into it */
+    pdev = isp_v4l2_get_dev( pstream->ctx_id );
+    pbuf->ctrl_applied = pdev ? isp_v4l2_ctrl_apply_request( &pdev->isp_v4l2_ctrl, pstream->stream_type, buf_index ) : 0;
 
-        if ( num_planes < vb->num_planes ) {
-            LOG( LOG_CRIT, "Bad num of planes: num_planes: %d vb->num_planes: %d",
-                 num_planes, vb->num_planes );
-            return -1;
-        }
-
-        for ( i = 0; i < vb->num_planes; i++ ) {
-            isp_v4l2_stream_get_plane( vb, pix_mp, &aframes[i], i );
-        }
-    } else {
-        LOG( LOG_CRIT, "Invalid v4l2_fmt_type: %d", v4l2_fmt->type );
-        return -1;
+    /* each plane gets its own address, separate buffer planes need not be contiguous */
+    for ( i = 0; i < pbuf->dma_planes; i++ ) {
+        aframes[i] = pbuf->dma_plane[i];
     }
 
     return 0;
 }
 
-int callback_stream_put_frame( uint32_t ctx_id, acamera_stream_type_t type, aframe_t *aframes, uint64_t num_planes )
+int callback_stream_get_frame( uint32_t ctx_id, acamera_stream_type_t type, aframe_t *aframes, uint64_t num_planes )
 {
     int rc;
     isp_v4l2_stream_type_t v4l2_type;
     isp_v4l2_stream_t *pstream;
-    isp_v4l2_buffer_t *pbuf = NULL;
-#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
-    struct vb2_v4l2_buffer *vvb;
-#endif
-    struct vb2_buffer *vb;
     int i;
 
+    for ( i = 0; i < num_planes; i++ ) {
+        aframes[i].status = dma_buf_purge;
+    }
+
     v4l2_type = fw_to_isp_v4l2_stream_type( type );
     if ( v4l2_type == V4L2_STREAM_TYPE_MAX )
         return -1;
@@ -462,24 +517,39 @@ int callback_stream_put_frame( uint32_t ctx_id, acamera_stream_type_t type, afra
         return -1;
     }
 
+    /* stream off waits for us once we are counted */
+    atomic_inc( &pstream->cb_running );
+    smp_mb();
+
     /* check if stream is on */
     if ( !pstream->stream_started ) {
         LOG( LOG_DEBUG, "[Stream#%d] type: %d is not started yet on ctx %d",
              pstream->stream_id, type, ctx_id );
-        return -1;
+        rc = -1;
+    } else {
+        rc = isp_v4l2_stream_get_frame( pstream, aframes, num_planes );
     }
 
-    /* try to get an active buffer from vb2 queue  */
-    spin_lock( &pstream->slock );
-    if ( !list_empty( &pstream->stream_buffer_list_busy ) ) {
-        pbuf = list_entry( pstream->stream_buffer_list_busy.next, isp_v4l2_buffer_t, list );
-        list_del( &pbuf->list );
-    }
-    spin_unlock( &pstream->slock );
+    atomic_dec( &pstream->cb_running );
+
+    return rc;
+}
+
+static int isp_v4l2_stream_put_frame( isp_v4l2_stream_t *pstream, aframe_t *aframes, uint64_t num_planes )
+{
+    isp_v4l2_buffer_t *pbuf;
+#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
+    struct vb2_v4l2_buffer *vvb;
+#endif
+    struct vb2_buffer *vb;
+    isp_v4l2_ctrl_applied_event_t applied = {0};
+    int i;
 
+    /* buffers come back in the order they were handed out */
+    pbuf = isp_v4l2_buf_ring_get( &pstream->busy_ring );
     if ( !pbuf ) {
-        LOG( LOG_INFO, "[Stream#%d] type: %d no empty buffers",
-             pstream->stream_id, type );
+        LOG( LOG_INFO, "[Stream#%d] type: %d no busy buffers",
+             pstream->stream_id, pstream->stream_type );
         return -1;
     }
 
@@ -494,15 +564,22 @@ int callback_stream_put_frame( uint32_t ctx_id, acamera_stream_type_t type, afra
     vb->v4l2_buf.field = V4L2_FIELD_NONE;
 #endif
 
-    if ( num_planes < vb->num_planes ) {
-        LOG( LOG_CRIT, "Bad num of planes: num_planes: %d vb->num_planes: %d",
-             num_planes, vb->num_planes );
+    if ( num_planes < pbuf->dma_planes ) {
+        LOG( LOG_CRIT, "Bad num of planes: num_planes: %d dma_planes: %d",
+             num_planes, pbuf->dma_planes );
         return -1;
     }
 
-    for ( i = 0; i < vb->num_planes; i++ ) {
-        if ( aframes[i].status == dma_buf_busy )
-            isp_v4l2_stream_put_plane( vb, &aframes[i], i );
+    for ( i = 0; i < pbuf->dma_planes; i++ ) {
+        if ( aframes[i].status != dma_buf_busy )
+            continue;
+
+        if ( aframes[i].address != pbuf->dma_plane[i].address ) {
+            LOG( LOG_CRIT, "Bad dma address %x %x", aframes[i].address, pbuf->dma_plane[i].address );
+            continue;
+        }
+
+        aframes[i].status = dma_buf_purge;
     }
 
 #if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
@@ -511,14 +588,68 @@ int callback_stream_put_frame( uint32_t ctx_id, acamera_stream_type_t type, afra
     v4l2_get_timestamp( &vb->v4l2_buf.timestamp );
 #endif
 
+    if ( pbuf->ctrl_applied ) {
+        applied.stream_type = pstream->stream_type;
+#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
+        applied.buf_index = vb->index;
+        applied.sequence = vvb->sequence;
+#else
+        applied.buf_index = vb->v4l2_buf.index;
+        applied.sequence = vb->v4l2_buf.sequence;
+#endif
+        applied.ctrl_num = pbuf->ctrl_applied;
+        pbuf->ctrl_applied = 0;
+    }
+
+    pstream->frames_done++;
+
     /* Put buffer back to vb2 queue */
     vb2_buffer_done( vb, VB2_BUF_STATE_DONE );
     /* Notify buffer ready */
     isp_v4l2_notify_event( pstream->ctx_id, pstream->stream_id, V4L2_EVENT_ACAMERA_FRAME_READY );
+    /* Report the controls which took effect on this buffer */
+    if ( applied.ctrl_num )
+        isp_v4l2_notify_event_data( pstream->ctx_id, pstream->stream_id, V4L2_EVENT_ACAMERA_CTRL_APPLIED,
+                                    &applied, sizeof( applied ) );
 
     return 0;
 }
 
+int callback_stream_put_frame( uint32_t ctx_id, acamera_stream_type_t type, aframe_t *aframes, uint64_t num_planes )
+{
+    int rc;
+    isp_v4l2_stream_type_t v4l2_type;
+    isp_v4l2_stream_t *pstream;
+
+    v4l2_type = fw_to_isp_v4l2_stream_type( type );
+    if ( v4l2_type == V4L2_STREAM_TYPE_MAX )
+        return -1;
+
+    /* find stream pointer */
+    rc = isp_v4l2_find_stream( &pstream, ctx_id, v4l2_type );
+    if ( rc < 0 ) {
+        LOG( LOG_DEBUG, "can't find stream on ctx %d (errno = %d)",
+             ctx_id, rc );
+        return -1;
+    }
+
+    atomic_inc( &pstream->cb_running );
+    smp_mb();
+
+    /* check if stream is on */
+    if ( !pstream->stream_started ) {
+        LOG( LOG_DEBUG, "[Stream#%d] type: %d is not started yet on ctx %d",
+             pstream->stream_id, type, ctx_id );
+        rc = -1;
+    } else {
+        rc = isp_v4l2_stream_put_frame( pstream, aframes, num_planes );
+    }
+
+    atomic_dec( &pstream->cb_running );
+
+    return rc;
+}
+
 /* ----------------------------------------------------------------
  * Stream control interface
  */
@@ -578,12 +709,10 @@ int isp_v4l2_stream_init( isp_v4l2_stream_t **ppstream, int stream_id, int ctx_i
     //format new stream to default isp settings
     isp_v4l2_stream_try_format( new_stream, &( new_stream->cur_v4l2_fmt ) );
 
-    /* init list */
-    INIT_LIST_HEAD( &new_stream->stream_buffer_list );
-    INIT_LIST_HEAD( &new_stream->stream_buffer_list_busy );
-
-    /* init locks */
-    spin_lock_init( &new_stream->slock );
+    /* init buffer rings */
+    isp_v4l2_buf_ring_init( &new_stream->ready_ring );
+    isp_v4l2_buf_ring_init( &new_stream->busy_ring );
+    atomic_set( &new_stream->cb_running, 0 );
 
     /* return stream private ptr to caller */
     *ppstream = new_stream;
@@ -610,39 +739,6 @@ void isp_v4l2_stream_deinit( isp_v4l2_stream_t *pstream )
     }
 }
 
-static void isp_v4l2_stream_buffer_list_release( isp_v4l2_stream_t *pstream,
-                                                 struct list_head *stream_buffer_list )
-{
-    isp_v4l2_buffer_t *buf;
-#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
-    struct vb2_v4l2_buffer *vvb;
-#endif
-    struct vb2_buffer *vb;
-    unsigned int buf_index;
-
-    while ( !list_empty( stream_buffer_list ) ) {
-        buf = list_entry( stream_buffer_list->next,
-                          isp_v4l2_buffer_t, list );
-        list_del( &buf->list );
-
-#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
-        vvb = &buf->vvb;
-        vb = &vvb->vb2_buf;
-
-        buf_index = vb->index;
-#else
-        vb = &buf->vb;
-
-        buf_index = vb->v4l2_buf.index;
-#endif
-
-        vb2_buffer_done( vb, VB2_BUF_STATE_ERROR );
-
-        LOG( LOG_INFO, "[Stream#%d] vid_cap buffer %d done",
-             pstream->stream_id, buf_index );
-    }
-}
-
 int isp_v4l2_stream_on( isp_v4l2_stream_t *pstream )
 {
     if ( !pstream ) {
@@ -652,6 +748,9 @@ int isp_v4l2_stream_on( isp_v4l2_stream_t *pstream )
 
     LOG( LOG_DEBUG, "[Stream#%d] called", pstream->stream_id );
 
+    pstream->frames_done = 0;
+    pstream->frames_no_buffer = 0;
+
 /* for now, we need memcpy */
 #if ISP_HAS_META_CB
     if ( pstream->stream_type != V4L2_STREAM_TYPE_META )
@@ -678,6 +777,9 @@ int isp_v4l2_stream_on( isp_v4l2_stream_t *pstream )
 
 void isp_v4l2_stream_off( isp_v4l2_stream_t *pstream )
 {
+    isp_v4l2_dev_t *pdev;
+    isp_v4l2_buffer_t *pbuf;
+
     if ( !pstream ) {
         LOG( LOG_ERR, "Null stream passed" );
         return;
@@ -690,6 +792,11 @@ void isp_v4l2_stream_off( isp_v4l2_stream_t *pstream )
 
     fw_intf_stream_stop( pstream->ctx_id, pstream->stream_type );
 
+    /* requests for buffers about to be released can't complete any more */
+    pdev = isp_v4l2_get_dev( pstream->ctx_id );
+    if ( pdev )
+        isp_v4l2_ctrl_flush_request( &pdev->isp_v4l2_ctrl, pstream->stream_type );
+
 #if ISP_HAS_META_CB
     if ( pstream->stream_type == V4L2_STREAM_TYPE_META ) {
         while ( atomic_read( &pstream->running ) > 0 ) { //metadata has no thread
@@ -700,11 +807,22 @@ void isp_v4l2_stream_off( isp_v4l2_stream_t *pstream )
     }
 #endif
 
-    /* Release all active buffers */
-    spin_lock( &pstream->slock );
-    isp_v4l2_stream_buffer_list_release( pstream, &pstream->stream_buffer_list );
-    isp_v4l2_stream_buffer_list_release( pstream, &pstream->stream_buffer_list_busy );
-    spin_unlock( &pstream->slock );
+    /* wait for dma writer callbacks which saw the stream still on */
+    smp_mb();
+    while ( atomic_read( &pstream->cb_running ) > 0 ) {
+        LOG( LOG_INFO, "[Stream#%d] callbacks still running %d !", pstream->stream_id, atomic_read( &pstream->cb_running ) );
+        schedule();
+    }
+
+    if ( pstream->frames_no_buffer )
+        LOG( LOG_NOTICE, "[Stream#%d] %u frames done, %u frames had no buffer and were dropped",
+             pstream->stream_id, pstream->frames_done, pstream->frames_no_buffer );
+
+    /* Release all active buffers, the rings have no other user now */
+    while ( ( pbuf = isp_v4l2_buf_ring_get( &pstream->busy_ring ) ) != NULL )
+        isp_v4l2_stream_buffer_release( pstream, pbuf );
+    while ( ( pbuf = isp_v4l2_buf_ring_get( &pstream->ready_ring ) ) != NULL )
+        isp_v4l2_stream_buffer_release( pstream, pbuf );
 }
 
 
@@ -788,6 +906,7 @@ int isp_v4l2_stream_enum_format( isp_v4l2_stream_t *pstream, struct v4l2_fmtdesc
 int isp_v4l2_stream_try_format( isp_v4l2_stream_t *pstream, struct v4l2_format *f )
 {
     isp_v4l2_fmt_t *tfmt;
+    uint32_t align = stride_align;
     int i;
     LOG( LOG_INFO, "[Stream#%d] try fmt type: %u, pixelformat: 0x%x, width: %u, height: %u.\n",
          pstream->stream_id, f->type, f->fmt.pix_mp.pixelformat, f->fmt.pix_mp.width, f->fmt.pix_mp.height );
@@ -843,15 +962,34 @@ int isp_v4l2_stream_try_format( isp_v4l2_stream_t *pstream, struct v4l2_format *
 
     f->fmt.pix.field = V4L2_FIELD_NONE;
 
+    if ( align == 0 || ( align & ( align - 1 ) ) ) {
+        LOG( LOG_ERR, "stride_align %u is not a power of 2, using %d.", align, ISP_V4L2_STRIDE_ALIGN );
+        align = ISP_V4L2_STRIDE_ALIGN;
+    }
+
 
     //all stream multiplanar
     f->type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
     f->fmt.pix_mp.num_planes = tfmt->planes;
     f->fmt.pix_mp.colorspace = ( tfmt->is_yuv ) ? V4L2_COLORSPACE_SMPTE170M : V4L2_COLORSPACE_SRGB;
     for ( i = 0; i < tfmt->planes; i++ ) {
-        f->fmt.pix_mp.plane_fmt[i].bytesperline = ( ( ( f->fmt.pix_mp.width * tfmt->depth / 8 ) + 127 ) >> 7 ) << 7; // for padding
-        f->fmt.pix_mp.plane_fmt[i].sizeimage = f->fmt.pix_mp.height * f->fmt.pix_mp.plane_fmt[i].bytesperline;
-        memset( f->fmt.pix_mp.plane_fmt[i].reserved, 0, sizeof( f->fmt.pix_mp.plane_fmt[i].reserved ) );
+        struct v4l2_plane_pix_format *plane_fmt = &f->fmt.pix_mp.plane_fmt[i];
+        uint32_t min_stride = f->fmt.pix_mp.width * tfmt->depth / 8;
+
+        // keep a larger stride the application asked for, within limits
+        if ( plane_fmt->bytesperline < min_stride || plane_fmt->bytesperline > ISP_V4L2_MAX_STRIDE )
+            plane_fmt->bytesperline = min_stride;
+        plane_fmt->bytesperline = ALIGN( plane_fmt->bytesperline, align );
+
+        if ( tfmt->uv_height_div && tfmt->planes == 1 ) {
+            // luma and chroma in one plane
+            plane_fmt->sizeimage = plane_fmt->bytesperline * ( f->fmt.pix_mp.height + f->fmt.pix_mp.height / tfmt->uv_height_div );
+        } else if ( tfmt->uv_height_div && i == 1 ) {
+            plane_fmt->sizeimage = plane_fmt->bytesperline * ( f->fmt.pix_mp.height / tfmt->uv_height_div );
+        } else {
+            plane_fmt->sizeimage = plane_fmt->bytesperline * f->fmt.pix_mp.height;
+        }
+        memset( plane_fmt->reserved, 0, sizeof( plane_fmt->reserved ) );
         memset( f->fmt.pix_mp.reserved, 0, sizeof( f->fmt.pix_mp.reserved ) );
     }
 
@@ -907,6 +1045,8 @@ int isp_v4l2_stream_set_format( isp_v4l2_stream_t *pstream, struct v4l2_format *
     case V4L2_PIX_FMT_RGB32:
     case ISP_V4L2_PIX_FMT_ARGB2101010:
     case V4L2_PIX_FMT_NV12:
+    case V4L2_PIX_FMT_NV12M:
+    case V4L2_PIX_FMT_NV21M:
         pstream->stream_type = pstream->stream_id;
         break;
 #if ISP_HAS_RAW_CB
@@ -20,6 +20,8 @@
 #ifndef _ISP_V4L2_STREAM_H_
 #define _ISP_V4L2_STREAM_H_
 
+#include <linux/compiler.h>
+#include <asm/barrier.h>
 #include <linux/videodev2.h>
 #if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 4, 0 ) )
 #include <media/videobuf2-v4l2.h>
@@ -29,6 +31,9 @@
 
 #include "isp-v4l2-common.h"
 
+/* planes the dma writer fills per buffer: primary and uv */
+#define ISP_V4L2_DMA_PLANES_MAX 2
+
 /* buffer for one video frame */
 typedef struct _isp_v4l2_buffer {
 /* vb or vvb (depending on kernel version) must be first */
@@ -38,9 +43,60 @@ typedef struct _isp_v4l2_buffer {
     struct vb2_buffer vb;
 #endif
 
-    struct list_head list;
+    /* dma writer descriptors, filled at buf_prepare */
+    aframe_t dma_plane[ISP_V4L2_DMA_PLANES_MAX];
+    uint32_t dma_planes;
+
+    /* controls applied when this buffer was programmed */
+    uint32_t ctrl_applied;
 } isp_v4l2_buffer_t;
 
+/* single producer / single consumer ring of buffers, no locking needed.
+ * Size is a power of 2 and covers VIDEO_MAX_FRAME so a put never fails.
+ */
+#define ISP_V4L2_BUF_RING_SIZE 32
+
+typedef struct _isp_v4l2_buf_ring {
+    isp_v4l2_buffer_t *buf[ISP_V4L2_BUF_RING_SIZE];
+    uint32_t head; /* written by the producer only */
+    uint32_t tail; /* written by the consumer only */
+} isp_v4l2_buf_ring_t;
+
+static inline void isp_v4l2_buf_ring_init( isp_v4l2_buf_ring_t *ring )
+{
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+static inline int isp_v4l2_buf_ring_put( isp_v4l2_buf_ring_t *ring, isp_v4l2_buffer_t *buf )
+{
+    uint32_t head = ring->head;
+
+    if ( head - READ_ONCE( ring->tail ) >= ISP_V4L2_BUF_RING_SIZE )
+        return -1;
+
+    ring->buf[head & ( ISP_V4L2_BUF_RING_SIZE - 1 )] = buf;
+    /* publish the slot before the new head */
+    smp_store_release( &ring->head, head + 1 );
+
+    return 0;
+}
+
+static inline isp_v4l2_buffer_t *isp_v4l2_buf_ring_get( isp_v4l2_buf_ring_t *ring )
+{
+    uint32_t tail = ring->tail;
+    isp_v4l2_buffer_t *buf;
+
+    if ( tail == smp_load_acquire( &ring->head ) )
+        return NULL;
+
+    buf = ring->buf[tail & ( ISP_V4L2_BUF_RING_SIZE - 1 )];
+    /* the slot may be reused once the tail moves */
+    smp_store_release( &ring->tail, tail + 1 );
+
+    return buf;
+}
+
 /**
  * struct isp_v4l2_stream_common
  */
@@ -73,9 +129,13 @@ typedef struct _isp_v4l2_stream_t {
     struct v4l2_format cur_v4l2_fmt;
 
     /* Video buffer field*/
-    struct list_head stream_buffer_list;
-    struct list_head stream_buffer_list_busy;
-    spinlock_t slock;
+    isp_v4l2_buf_ring_t ready_ring; /* vb2 buf_queue -> frame start */
+    isp_v4l2_buf_ring_t busy_ring;  /* frame start -> frame done */
+    atomic_t cb_running;            /* dma writer callbacks in flight */
+
+    /* frame counters, reset on stream on */
+    uint32_t frames_done;
+    uint32_t frames_no_buffer; /* frames written to the default buffer */
 
     /* Temporal fields for memcpy */
 #if ISP_HAS_META_CB
@@ -92,6 +152,8 @@ int isp_v4l2_stream_init( isp_v4l2_stream_t **ppstream, int stream_id, int ctx_n
 void isp_v4l2_stream_deinit( isp_v4l2_stream_t *pstream );
 int isp_v4l2_stream_on( isp_v4l2_stream_t *pstream );
 void isp_v4l2_stream_off( isp_v4l2_stream_t *pstream );
+int isp_v4l2_stream_prepare_buffer( isp_v4l2_stream_t *pstream, struct vb2_buffer *vb );
+void isp_v4l2_stream_queue_buffer( isp_v4l2_stream_t *pstream, isp_v4l2_buffer_t *pbuf );
 
 /* stream configuration interface */
 int isp_v4l2_stream_enum_framesizes( isp_v4l2_stream_t *pstream, struct v4l2_frmsizeenum *fsize );
@@ -506,6 +506,18 @@ static int isp_v4l2_dqbuf( struct file *file, void *priv, struct v4l2_buffer *p
     return rc;
 }
 
+static int isp_v4l2_subscribe_event( struct v4l2_fh *fh, const struct v4l2_event_subscription *sub )
+{
+    switch ( sub->type ) {
+    case V4L2_EVENT_ACAMERA_FRAME_READY:
+    case V4L2_EVENT_ACAMERA_STREAM_OFF:
+    case V4L2_EVENT_ACAMERA_CTRL_APPLIED:
+        return v4l2_event_subscribe( fh, sub, VIDEO_MAX_FRAME, NULL );
+    }
+
+    return v4l2_ctrl_subscribe_event( fh, sub );
+}
+
 static const struct v4l2_ioctl_ops isp_v4l2_ioctl_ops = {
     .vidioc_querycap = isp_v4l2_querycap,
 
@@ -535,7 +547,7 @@ static const struct v4l2_ioctl_ops isp_v4l2_ioctl_ops = {
 
     /* v4l2 event ioctls */
     .vidioc_log_status = v4l2_ctrl_log_status,
-    .vidioc_subscribe_event = v4l2_ctrl_subscribe_event,
+    .vidioc_subscribe_event = isp_v4l2_subscribe_event,
     .vidioc_unsubscribe_event = v4l2_event_unsubscribe,
 };
 
@@ -781,9 +793,19 @@ isp_v4l2_dev_t *isp_v4l2_get_dev( uint32_t ctx_number )
  * event notifier utility function
  */
 int isp_v4l2_notify_event( int ctx_id, int stream_id, uint32_t event_type )
+{
+    return isp_v4l2_notify_event_data( ctx_id, stream_id, event_type, NULL, 0 );
+}
+
+int isp_v4l2_notify_event_data( int ctx_id, int stream_id, uint32_t event_type, const void *data, uint32_t size )
 {
     struct v4l2_event event;
 
+    if ( size > sizeof( event.u.data ) ) {
+        LOG( LOG_ERR, "Event payload too big: %u (event_type = %d)", size, event_type );
+        return -EINVAL;
+    }
+
     if ( g_isp_v4l2_devs[ctx_id] == NULL ) {
         return -EBUSY;
     }
@@ -799,6 +821,8 @@ int isp_v4l2_notify_event( int ctx_id, int stream_id, uint32_t event_type )
 
     memset( &event, 0, sizeof( event ) );
     event.type = event_type;
+    if ( data )
+        memcpy( event.u.data, data, size );
 
     v4l2_event_queue_fh( g_isp_v4l2_devs[ctx_id]->fh_ptr[stream_id], &event );
     mutex_unlock( &g_isp_v4l2_devs[ctx_id]->notify_lock );
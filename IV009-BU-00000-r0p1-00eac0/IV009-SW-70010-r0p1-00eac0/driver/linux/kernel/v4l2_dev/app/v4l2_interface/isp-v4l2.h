@@ -69,5 +69,6 @@ isp_v4l2_stream_type_t fw_to_isp_v4l2_stream_type( acamera_stream_type_t type );
 
 /* Frame ready event */
 int isp_v4l2_notify_event( int ctx_num, int stream_id, uint32_t event_type );
+int isp_v4l2_notify_event_data( int ctx_num, int stream_id, uint32_t event_type, const void *data, uint32_t size );
 
 #endif
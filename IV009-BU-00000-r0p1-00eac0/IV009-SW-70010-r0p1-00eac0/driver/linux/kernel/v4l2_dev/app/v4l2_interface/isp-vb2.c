@@ -127,6 +127,8 @@ static int isp_vb2_buf_prepare( struct vb2_buffer *vb )
             vb2_set_plane_payload( vb, i, size );
             LOG( LOG_INFO, "i:%d payload set %d", i, size );
         }
+
+        return isp_v4l2_stream_prepare_buffer( pstream, vb );
     }
 
     return 0;
@@ -145,9 +147,7 @@ static void isp_vb2_buf_queue( struct vb2_buffer *vb )
 
     LOG( LOG_INFO, "Enter id:%d, cnt: %lu.", pstream->stream_id, cnt++ );
 
-    spin_lock( &pstream->slock );
-    list_add_tail( &buf->list, &pstream->stream_buffer_list );
-    spin_unlock( &pstream->slock );
+    isp_v4l2_stream_queue_buffer( pstream, buf );
 }
 
 static const struct vb2_ops isp_vb2_ops = {
@@ -22,6 +22,7 @@
 #include "acamera_logger.h"
 
 extern uint32_t soc_iq_get_calibrations( int32_t, void *, ACameraCalibrations *c );
+extern uint32_t soc_iq_get_calibrations_size( int32_t, void * );
 
 uint32_t get_calibrations_v4l2( uint32_t ctx_id, void *sensor_arg, ACameraCalibrations *c )
 {
@@ -32,3 +33,8 @@ uint32_t get_calibrations_v4l2( uint32_t ctx_id, void *sensor_arg, ACameraCalibr
 
     return ret;
 }
+
+uint32_t get_calibrations_size_v4l2( uint32_t ctx_id, void *sensor_arg )
+{
+    return soc_iq_get_calibrations_size( ctx_id, sensor_arg );
+}
@@ -66,8 +66,34 @@ extern void *acamera_camera_v4l2_get_subdev_by_name( const char *name );
 #endif
 
 
-static void *g_lut_data_ptr_arr[FIRMWARE_CONTEXT_NUMBER] = {0};
-static int32_t g_lut_data_size_arr[FIRMWARE_CONTEXT_NUMBER] = {0};
+// Two banks per context: the firmware keeps using the set in one bank
+// until the set loaded into the other one is published at a frame boundary.
+#define SOC_IQ_LUT_BANKS 2
+
+static void *g_lut_data_ptr_arr[FIRMWARE_CONTEXT_NUMBER][SOC_IQ_LUT_BANKS] = {{0}};
+static int32_t g_lut_data_size_arr[FIRMWARE_CONTEXT_NUMBER][SOC_IQ_LUT_BANKS] = {{0}};
+
+// The firmware passes in the set it is using, which may differ from the set
+// loaded last when that one is still pending. Pick the bank it does not
+// point into, a pending set in the other bank is simply replaced.
+static int32_t get_free_bank( int32_t ctx_id, const ACameraCalibrations *c )
+{
+    const uint8_t *bank0 = (const uint8_t *)g_lut_data_ptr_arr[ctx_id][0];
+    int32_t idx;
+
+    for ( idx = 0; idx < CALIBRATION_TOTAL_SIZE; idx++ ) {
+        const uint8_t *lut = (const uint8_t *)c->calibrations[idx];
+
+        if ( lut != NULL ) {
+            if ( bank0 != NULL && lut >= bank0 && lut < bank0 + g_lut_data_size_arr[ctx_id][0] ) {
+                return 1;
+            }
+            return 0;
+        }
+    }
+
+    return 0;
+}
 
 static uint32_t get_calibration_total_size( void *iq_ctx, int32_t ctx_id, void *sensor_arg )
 {
@@ -96,6 +122,37 @@ static uint32_t get_calibration_total_size( void *iq_ctx, int32_t ctx_id, void *
 }
 
 
+// Size of the calibration set of a sensor mode, 0 if it cannot be queried.
+uint32_t soc_iq_get_calibrations_size( int32_t ctx_id, void *sensor_arg )
+{
+    uint32_t total_size = 0;
+
+    if ( ctx_id >= FIRMWARE_CONTEXT_NUMBER ) {
+        LOG( LOG_CRIT, "ctx_id:%d >= FIRMWARE_CONTEXT_NUMBER:%d\n", ctx_id, FIRMWARE_CONTEXT_NUMBER );
+        return 0;
+    }
+#if KERNEL_MODULE
+    struct v4l2_subdev *iq_ctx = acamera_camera_v4l2_get_subdev_by_name( V4L2_SOC_IQ_NAME );
+    if ( iq_ctx == NULL ) {
+        LOG( LOG_ERR, "Error: cannot get iq subdevice pointer. Returned value is null\n" );
+        return 0;
+    }
+#else
+    int32_t iq_ctx = open( V4L2_IQ_SUBDEV_NAME, O_RDWR );
+
+    if ( iq_ctx == -1 ) {
+        LOG( LOG_ERR, "Error: cannot open iq subdevice file %s\n", V4L2_IQ_SUBDEV_NAME );
+        return 0;
+    }
+#endif
+
+    total_size = get_calibration_total_size( iq_ctx, ctx_id, sensor_arg );
+
+    __CLOSE( iq_ctx );
+
+    return total_size;
+}
+
 uint32_t soc_iq_get_calibrations( int32_t ctx_id, void *sensor_arg, ACameraCalibrations *c )
 {
     uint32_t result = 0;
@@ -128,34 +185,38 @@ uint32_t soc_iq_get_calibrations( int32_t ctx_id, void *sensor_arg, ACameraCalib
     LOG( LOG_INFO, "ctx_id:%d sensor_arg:0x%x Total size for all Luts is %d bytes", ctx_id, sensor_arg, total_size );
 
     if ( total_size != 0 ) {
+        // never touch the bank the firmware may still be reading from
+        int32_t bank = get_free_bank( ctx_id, c );
+        void **p_lut_data = &g_lut_data_ptr_arr[ctx_id][bank];
+        int32_t *p_lut_size = &g_lut_data_size_arr[ctx_id][bank];
 
         // allocate memory for all tables
-        if ( g_lut_data_size_arr[ctx_id] >= total_size && g_lut_data_ptr_arr[ctx_id] != NULL ) {
-            LOG( LOG_INFO, "Previously allocated %d bytes. Required %d. Old memory will be reused", g_lut_data_size_arr[ctx_id], total_size );
+        if ( *p_lut_size >= total_size && *p_lut_data != NULL ) {
+            LOG( LOG_INFO, "Previously allocated %d bytes in bank %d. Required %d. Old memory will be reused", *p_lut_size, bank, total_size );
         } else {
-            LOG( LOG_INFO, "Previously allocated %d bytes. Required %d. new memory will be allocated", g_lut_data_size_arr[ctx_id], total_size );
-            if ( g_lut_data_ptr_arr[ctx_id] )
-                __FREE( g_lut_data_ptr_arr[ctx_id] );
-            g_lut_data_ptr_arr[ctx_id] = NULL;
-            g_lut_data_size_arr[ctx_id] = 0;
-
-            g_lut_data_ptr_arr[ctx_id] = __MALLOC( total_size );
-            if ( g_lut_data_ptr_arr[ctx_id] != NULL ) {
-                g_lut_data_size_arr[ctx_id] = total_size;
+            LOG( LOG_INFO, "Previously allocated %d bytes in bank %d. Required %d. new memory will be allocated", *p_lut_size, bank, total_size );
+            if ( *p_lut_data )
+                __FREE( *p_lut_data );
+            *p_lut_data = NULL;
+            *p_lut_size = 0;
+
+            *p_lut_data = __MALLOC( total_size );
+            if ( *p_lut_data != NULL ) {
+                *p_lut_size = total_size;
             } else {
-                g_lut_data_size_arr[ctx_id] = 0;
+                *p_lut_size = 0;
             }
         }
 
 
-        if ( g_lut_data_ptr_arr[ctx_id] != NULL && g_lut_data_size_arr[ctx_id] > 0 ) {
+        if ( *p_lut_data != NULL && *p_lut_size > 0 ) {
             int32_t idx = 0;
-            void *cur_ptr = g_lut_data_ptr_arr[ctx_id];
+            void *cur_ptr = *p_lut_data;
             struct soc_iq_ioctl_args args;
 
             // request calibration data for all luts
             for ( idx = 0; idx < CALIBRATION_TOTAL_SIZE; idx++ ) {
-                if ( cur_ptr < ( g_lut_data_ptr_arr[ctx_id] + g_lut_data_size_arr[ctx_id] ) ) {
+                if ( cur_ptr < ( *p_lut_data + *p_lut_size ) ) {
                     // request calibration size
                     args.ioctl.request_info.context = ctx_id;
                     args.ioctl.request_info.sensor_arg = sensor_arg;
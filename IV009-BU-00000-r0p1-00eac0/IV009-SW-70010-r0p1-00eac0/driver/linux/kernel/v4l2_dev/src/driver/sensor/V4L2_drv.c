@@ -31,10 +31,31 @@
 extern void *acamera_camera_v4l2_get_subdev_by_name( const char *name );
 
 
+// exposure values exchanged with the soc sensor subdev
+typedef struct _sensor_exposure_t {
+    int32_t again;
+    int32_t dgain;
+    uint16_t it_short;
+    uint16_t it_medium;
+    uint16_t it_long;
+} sensor_exposure_t;
+
 typedef struct _sensor_context_t {
     sensor_param_t param;
     sensor_mode_t supported_modes[ISP_MAX_SENSOR_MODES];
     struct v4l2_subdev *soc_sensor;
+    // exposure requested by the firmware since the last sensor_update
+    sensor_exposure_t exp_request;
+    uint32_t exp_request_mask;
+    // the last values allocated by the sensor, with SOC_SENSOR_ALLOC_* or
+    // SOC_SENSOR_SET_EXPOSURE: the requested values and what the sensor
+    // allocated for them, per SOC_SENSOR_EXP_* bit
+    sensor_exposure_t exp_alloc_request;
+    sensor_exposure_t exp_alloc;
+    uint32_t exp_alloc_valid;
+    uint32_t exp_sequence;
+    // the last descriptor returned by the sensor subdev
+    struct soc_sensor_descriptor desc;
 } sensor_context_t;
 
 
@@ -53,6 +74,13 @@ static uint32_t get_ctx_num( void *ctx )
 }
 
 
+static void sensor_exposure_reset( sensor_context_t *p_ctx )
+{
+    p_ctx->exp_request_mask = 0;
+    p_ctx->exp_alloc_valid = 0;
+}
+
+
 static void sensor_print_params( void *ctx )
 {
     sensor_context_t *p_ctx = ctx;
@@ -87,88 +115,150 @@ static void sensor_print_params( void *ctx )
 }
 
 
-static void sensor_update_parameters( void *ctx )
+// Query the sensor parameters one by one.
+// Used with sensor subdevices which do not support SOC_SENSOR_GET_DESCRIPTOR.
+static void sensor_read_parameters( sensor_context_t *p_ctx, struct v4l2_subdev *sd, uint32_t ctx_num )
 {
-    sensor_context_t *p_ctx = ctx;
+    struct soc_sensor_ioctl_args settings;
     int32_t rc = 0;
-    //int32_t result = 0;
-    if ( p_ctx != NULL ) {
-        struct soc_sensor_ioctl_args settings;
-        struct v4l2_subdev *sd = p_ctx->soc_sensor;
-        uint32_t ctx_num = get_ctx_num( ctx );
-        if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
-            LOG( LOG_INFO, "Found context num:%d", ctx_num );
-            settings.ctx_num = ctx_num;
-            // Initial local parameters
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_EXP_NUMBER, &settings );
-            p_ctx->param.sensor_exp_number = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_ANALOG_GAIN_MAX, &settings );
-            p_ctx->param.again_log2_max = settings.args.general.val_out;
+    settings.ctx_num = ctx_num;
+    // Initial local parameters
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_EXP_NUMBER, &settings );
+    p_ctx->param.sensor_exp_number = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_DIGITAL_GAIN_MAX, &settings );
-            p_ctx->param.dgain_log2_max = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_ANALOG_GAIN_MAX, &settings );
+    p_ctx->param.again_log2_max = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_UPDATE_LATENCY, &settings );
-            p_ctx->param.integration_time_apply_delay = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_DIGITAL_GAIN_MAX, &settings );
+    p_ctx->param.dgain_log2_max = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_MIN, &settings );
-            p_ctx->param.integration_time_min = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_UPDATE_LATENCY, &settings );
+    p_ctx->param.integration_time_apply_delay = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_MAX, &settings );
-            p_ctx->param.integration_time_max = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_MIN, &settings );
+    p_ctx->param.integration_time_min = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_LONG_MAX, &settings );
-            p_ctx->param.integration_time_long_max = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_MAX, &settings );
+    p_ctx->param.integration_time_max = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_LIMIT, &settings );
-            p_ctx->param.integration_time_limit = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_LONG_MAX, &settings );
+    p_ctx->param.integration_time_long_max = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_LINES_PER_SECOND, &settings );
-            p_ctx->param.lines_per_second = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_INTEGRATION_TIME_LIMIT, &settings );
+    p_ctx->param.integration_time_limit = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_ACTIVE_HEIGHT, &settings );
-            p_ctx->param.active.height = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_LINES_PER_SECOND, &settings );
+    p_ctx->param.lines_per_second = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_ACTIVE_WIDTH, &settings );
-            p_ctx->param.active.width = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_ACTIVE_HEIGHT, &settings );
+    p_ctx->param.active.height = settings.args.general.val_out;
 
-            p_ctx->param.isp_exposure_channel_delay = 0;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_ACTIVE_WIDTH, &settings );
+    p_ctx->param.active.width = settings.args.general.val_out;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_NUM, &settings );
-            p_ctx->param.modes_num = settings.args.general.val_out;
+    p_ctx->param.isp_exposure_channel_delay = 0;
 
-            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_CUR, &settings );
-            p_ctx->param.mode = settings.args.general.val_out;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_NUM, &settings );
+    p_ctx->param.modes_num = settings.args.general.val_out;
 
-            if ( p_ctx->param.modes_num > ISP_MAX_SENSOR_MODES ) {
-                p_ctx->param.modes_num = ISP_MAX_SENSOR_MODES;
-                LOG( LOG_WARNING, "Exceed maximum supported presets. Sensor driver returned %d but maximum is %d", p_ctx->param.modes_num, ISP_MAX_SENSOR_MODES );
-            }
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_CUR, &settings );
+    p_ctx->param.mode = settings.args.general.val_out;
 
+    if ( p_ctx->param.modes_num > ISP_MAX_SENSOR_MODES ) {
+        p_ctx->param.modes_num = ISP_MAX_SENSOR_MODES;
+        LOG( LOG_WARNING, "Exceed maximum supported presets. Sensor driver returned %d but maximum is %d", p_ctx->param.modes_num, ISP_MAX_SENSOR_MODES );
+    }
 
-            p_ctx->param.modes_table = p_ctx->supported_modes;
 
-            int32_t idx = 0;
-            for ( idx = 0; idx < p_ctx->param.modes_num; idx++ ) {
-                settings.args.general.val_in = idx;
-                rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_WIDTH, &settings );
-                p_ctx->param.modes_table[idx].resolution.width = settings.args.general.val_out;
+    p_ctx->param.modes_table = p_ctx->supported_modes;
 
-                rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_HEIGHT, &settings );
-                p_ctx->param.modes_table[idx].resolution.height = settings.args.general.val_out;
+    int32_t idx = 0;
+    for ( idx = 0; idx < p_ctx->param.modes_num; idx++ ) {
+        settings.args.general.val_in = idx;
+        rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_WIDTH, &settings );
+        p_ctx->param.modes_table[idx].resolution.width = settings.args.general.val_out;
+
+        rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_HEIGHT, &settings );
+        p_ctx->param.modes_table[idx].resolution.height = settings.args.general.val_out;
+
+        rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_FPS, &settings );
+        p_ctx->param.modes_table[idx].fps = settings.args.general.val_out;
 
-                rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_FPS, &settings );
-                p_ctx->param.modes_table[idx].fps = settings.args.general.val_out;
+        rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_EXP, &settings );
+        p_ctx->param.modes_table[idx].exposures = settings.args.general.val_out;
 
-                rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_EXP, &settings );
-                p_ctx->param.modes_table[idx].exposures = settings.args.general.val_out;
+        rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_MODE, &settings );
+        p_ctx->param.modes_table[idx].wdr_mode = settings.args.general.val_out;
 
-                rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_PRESET_MODE, &settings );
-                p_ctx->param.modes_table[idx].wdr_mode = settings.args.general.val_out;
+        rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_SENSOR_BITS, &settings );
+        p_ctx->param.modes_table[idx].bits = settings.args.general.val_out;
+    }
+}
 
-                rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_SENSOR_BITS, &settings );
-                p_ctx->param.modes_table[idx].bits = settings.args.general.val_out;
+
+static int32_t sensor_read_descriptor( sensor_context_t *p_ctx, struct v4l2_subdev *sd, uint32_t ctx_num )
+{
+    struct soc_sensor_ioctl_args settings;
+    const struct soc_sensor_descriptor *p_desc = &p_ctx->desc;
+    int32_t idx;
+    int rc;
+
+    settings.ctx_num = ctx_num;
+    settings.args.descriptor.p_desc = &p_ctx->desc;
+    rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_GET_DESCRIPTOR, &settings );
+    if ( rc != 0 ) {
+        return rc;
+    }
+
+    p_ctx->param.sensor_exp_number = p_desc->exp_number;
+    p_ctx->param.again_log2_max = p_desc->again_log2_max;
+    p_ctx->param.dgain_log2_max = p_desc->dgain_log2_max;
+    p_ctx->param.integration_time_apply_delay = p_desc->update_latency;
+    p_ctx->param.integration_time_min = p_desc->integration_time_min;
+    p_ctx->param.integration_time_max = p_desc->integration_time_max;
+    p_ctx->param.integration_time_long_max = p_desc->integration_time_long_max;
+    p_ctx->param.integration_time_limit = p_desc->integration_time_limit;
+    p_ctx->param.lines_per_second = p_desc->lines_per_second;
+    p_ctx->param.active.height = p_desc->active_height;
+    p_ctx->param.active.width = p_desc->active_width;
+    p_ctx->param.isp_exposure_channel_delay = 0;
+    p_ctx->param.mode = p_desc->preset_cur;
+    p_ctx->param.mode_switch_skip_frames = p_desc->skip_frames;
+    p_ctx->param.modes_num = p_desc->preset_num;
+
+    if ( p_ctx->param.modes_num > ISP_MAX_SENSOR_MODES ) {
+        LOG( LOG_WARNING, "Exceed maximum supported presets. Sensor driver returned %d but maximum is %d", p_ctx->param.modes_num, ISP_MAX_SENSOR_MODES );
+        p_ctx->param.modes_num = ISP_MAX_SENSOR_MODES;
+    }
+
+    p_ctx->param.modes_table = p_ctx->supported_modes;
+
+    for ( idx = 0; idx < p_ctx->param.modes_num; idx++ ) {
+        p_ctx->param.modes_table[idx].resolution.width = p_desc->presets[idx].width;
+        p_ctx->param.modes_table[idx].resolution.height = p_desc->presets[idx].height;
+        p_ctx->param.modes_table[idx].fps = p_desc->presets[idx].fps;
+        p_ctx->param.modes_table[idx].exposures = p_desc->presets[idx].exposures;
+        p_ctx->param.modes_table[idx].wdr_mode = p_desc->presets[idx].wdr_mode;
+        p_ctx->param.modes_table[idx].bits = p_desc->presets[idx].bits;
+    }
+
+    return 0;
+}
+
+
+static void sensor_update_parameters( void *ctx )
+{
+    sensor_context_t *p_ctx = ctx;
+    if ( p_ctx != NULL ) {
+        struct v4l2_subdev *sd = p_ctx->soc_sensor;
+        uint32_t ctx_num = get_ctx_num( ctx );
+        if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
+            LOG( LOG_INFO, "Found context num:%d", ctx_num );
+            // one call returns the limits and the whole preset table
+            if ( sensor_read_descriptor( p_ctx, sd, ctx_num ) != 0 ) {
+                LOG( LOG_INFO, "Sensor descriptor is not supported, reading the parameters one by one" );
+                sensor_read_parameters( p_ctx, sd, ctx_num );
             }
 
             p_ctx->param.sensor_ctx = p_ctx;
@@ -183,26 +273,50 @@ static void sensor_update_parameters( void *ctx )
 }
 
 
+// The gains and integration times are recorded here and applied by the subdev
+// in the SOC_SENSOR_SET_EXPOSURE call made from sensor_update. The firmware has
+// to get the value the sensor will really use, so a request which differs from
+// the last allocated one is allocated by the subdev right away. A steady
+// exposure costs a single subdev call per frame.
+static int32_t sensor_alloc_call( sensor_context_t *p_ctx, int cmd, struct soc_sensor_ioctl_args *settings )
+{
+    struct v4l2_subdev *sd = p_ctx->soc_sensor;
+    uint32_t ctx_num = get_ctx_num( p_ctx );
+    int rc;
+
+    if ( sd == NULL || ctx_num >= FIRMWARE_CONTEXT_NUMBER ) {
+        LOG( LOG_ERR, "SOC sensor subdev pointer is NULL" );
+        return -1;
+    }
+
+    settings->ctx_num = ctx_num;
+    rc = v4l2_subdev_call( sd, core, ioctl, cmd, settings );
+    if ( rc != 0 ) {
+        LOG( LOG_ERR, "Failed to alloc exposure value %d. rc = %d", cmd, rc );
+    }
+
+    return rc;
+}
+
+
 static int32_t sensor_alloc_analog_gain( void *ctx, int32_t gain )
 {
     sensor_context_t *p_ctx = ctx;
     int32_t result = 0;
     if ( p_ctx != NULL ) {
-        struct soc_sensor_ioctl_args settings;
-        struct v4l2_subdev *sd = p_ctx->soc_sensor;
-        uint32_t ctx_num = get_ctx_num( ctx );
-        if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
-            settings.ctx_num = ctx_num;
+        p_ctx->exp_request.again = gain;
+        p_ctx->exp_request_mask |= SOC_SENSOR_EXP_AGAIN;
+        if ( !( p_ctx->exp_alloc_valid & SOC_SENSOR_EXP_AGAIN ) || p_ctx->exp_alloc_request.again != gain ) {
+            struct soc_sensor_ioctl_args settings;
             settings.args.general.val_in = gain;
-            int rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_ALLOC_AGAIN, &settings );
-            if ( rc == 0 ) {
-                result = settings.args.general.val_out;
-            } else {
-                LOG( LOG_ERR, "Failed to alloc again. rc = %d", rc );
+            if ( sensor_alloc_call( p_ctx, SOC_SENSOR_ALLOC_AGAIN, &settings ) != 0 ) {
+                return result;
             }
-        } else {
-            LOG( LOG_ERR, "SOC sensor subdev pointer is NULL" );
+            p_ctx->exp_alloc_request.again = gain;
+            p_ctx->exp_alloc.again = settings.args.general.val_out;
+            p_ctx->exp_alloc_valid |= SOC_SENSOR_EXP_AGAIN;
         }
+        result = p_ctx->exp_alloc.again;
     } else {
         LOG( LOG_ERR, "Sensor context pointer is NULL" );
     }
@@ -215,21 +329,19 @@ static int32_t sensor_alloc_digital_gain( void *ctx, int32_t gain )
     sensor_context_t *p_ctx = ctx;
     int32_t result = 0;
     if ( p_ctx != NULL ) {
-        struct soc_sensor_ioctl_args settings;
-        struct v4l2_subdev *sd = p_ctx->soc_sensor;
-        uint32_t ctx_num = get_ctx_num( ctx );
-        if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
-            settings.ctx_num = ctx_num;
+        p_ctx->exp_request.dgain = gain;
+        p_ctx->exp_request_mask |= SOC_SENSOR_EXP_DGAIN;
+        if ( !( p_ctx->exp_alloc_valid & SOC_SENSOR_EXP_DGAIN ) || p_ctx->exp_alloc_request.dgain != gain ) {
+            struct soc_sensor_ioctl_args settings;
             settings.args.general.val_in = gain;
-            int rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_ALLOC_DGAIN, &settings );
-            if ( rc == 0 ) {
-                result = settings.args.general.val_out;
-            } else {
-                LOG( LOG_ERR, "Failed to digital again. rc = %d", rc );
+            if ( sensor_alloc_call( p_ctx, SOC_SENSOR_ALLOC_DGAIN, &settings ) != 0 ) {
+                return result;
             }
-        } else {
-            LOG( LOG_ERR, "SOC sensor subdev pointer is NULL" );
+            p_ctx->exp_alloc_request.dgain = gain;
+            p_ctx->exp_alloc.dgain = settings.args.general.val_out;
+            p_ctx->exp_alloc_valid |= SOC_SENSOR_EXP_DGAIN;
         }
+        result = p_ctx->exp_alloc.dgain;
     } else {
         LOG( LOG_ERR, "Sensor context pointer is NULL" );
     }
@@ -240,27 +352,33 @@ static int32_t sensor_alloc_digital_gain( void *ctx, int32_t gain )
 static void sensor_alloc_integration_time( void *ctx, uint16_t *int_time, uint16_t *int_time_M, uint16_t *int_time_L )
 {
     sensor_context_t *p_ctx = ctx;
-    //int32_t result = 0;
     if ( p_ctx != NULL ) {
-        struct soc_sensor_ioctl_args settings;
-        struct v4l2_subdev *sd = p_ctx->soc_sensor;
-        uint32_t ctx_num = get_ctx_num( ctx );
-        if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
-            settings.ctx_num = ctx_num;
+        p_ctx->exp_request.it_short = *int_time;
+        p_ctx->exp_request.it_medium = *int_time_M;
+        p_ctx->exp_request.it_long = *int_time_L;
+        p_ctx->exp_request_mask |= SOC_SENSOR_EXP_IT;
+        if ( !( p_ctx->exp_alloc_valid & SOC_SENSOR_EXP_IT ) ||
+             p_ctx->exp_alloc_request.it_short != *int_time ||
+             p_ctx->exp_alloc_request.it_medium != *int_time_M ||
+             p_ctx->exp_alloc_request.it_long != *int_time_L ) {
+            struct soc_sensor_ioctl_args settings;
             settings.args.integration_time.it_short = *int_time;
             settings.args.integration_time.it_medium = *int_time_M;
             settings.args.integration_time.it_long = *int_time_L;
-            int rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_ALLOC_IT, &settings );
-            if ( rc == 0 ) {
-                *int_time = settings.args.integration_time.it_short;
-                *int_time_M = settings.args.integration_time.it_medium;
-                *int_time_L = settings.args.integration_time.it_long;
-            } else {
-                LOG( LOG_ERR, "Failed to alloc integration time. rc = %d", rc );
+            if ( sensor_alloc_call( p_ctx, SOC_SENSOR_ALLOC_IT, &settings ) != 0 ) {
+                return;
             }
-        } else {
-            LOG( LOG_ERR, "SOC sensor subdev pointer is NULL" );
+            p_ctx->exp_alloc_request.it_short = *int_time;
+            p_ctx->exp_alloc_request.it_medium = *int_time_M;
+            p_ctx->exp_alloc_request.it_long = *int_time_L;
+            p_ctx->exp_alloc.it_short = settings.args.integration_time.it_short;
+            p_ctx->exp_alloc.it_medium = settings.args.integration_time.it_medium;
+            p_ctx->exp_alloc.it_long = settings.args.integration_time.it_long;
+            p_ctx->exp_alloc_valid |= SOC_SENSOR_EXP_IT;
         }
+        *int_time = p_ctx->exp_alloc.it_short;
+        *int_time_M = p_ctx->exp_alloc.it_medium;
+        *int_time_L = p_ctx->exp_alloc.it_long;
     } else {
         LOG( LOG_ERR, "Sensor context pointer is NULL" );
     }
@@ -276,10 +394,40 @@ static void sensor_update( void *ctx )
         struct v4l2_subdev *sd = p_ctx->soc_sensor;
         uint32_t ctx_num = get_ctx_num( ctx );
         if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
+            int rc;
+            uint32_t mask = p_ctx->exp_request_mask;
+            // the subdev allocates the values requested since the last update and applies them as one set
             settings.ctx_num = ctx_num;
-            int rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_UPDATE_EXP, &settings );
-            if ( rc != 0 ) {
-                LOG( LOG_ERR, "Failed to update sensor exposure. rc = %d", rc );
+            settings.args.exposure.mask = mask;
+            settings.args.exposure.again = p_ctx->exp_request.again;
+            settings.args.exposure.dgain = p_ctx->exp_request.dgain;
+            settings.args.exposure.it_short = p_ctx->exp_request.it_short;
+            settings.args.exposure.it_medium = p_ctx->exp_request.it_medium;
+            settings.args.exposure.it_long = p_ctx->exp_request.it_long;
+            settings.args.exposure.sequence = p_ctx->exp_sequence++;
+            p_ctx->exp_request_mask = 0;
+            rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_SET_EXPOSURE, &settings );
+            if ( rc == 0 ) {
+                if ( mask & SOC_SENSOR_EXP_AGAIN ) {
+                    p_ctx->exp_alloc_request.again = p_ctx->exp_request.again;
+                    p_ctx->exp_alloc.again = settings.args.exposure.again;
+                }
+                if ( mask & SOC_SENSOR_EXP_DGAIN ) {
+                    p_ctx->exp_alloc_request.dgain = p_ctx->exp_request.dgain;
+                    p_ctx->exp_alloc.dgain = settings.args.exposure.dgain;
+                }
+                if ( mask & SOC_SENSOR_EXP_IT ) {
+                    p_ctx->exp_alloc_request.it_short = p_ctx->exp_request.it_short;
+                    p_ctx->exp_alloc_request.it_medium = p_ctx->exp_request.it_medium;
+                    p_ctx->exp_alloc_request.it_long = p_ctx->exp_request.it_long;
+                    p_ctx->exp_alloc.it_short = settings.args.exposure.it_short;
+                    p_ctx->exp_alloc.it_medium = settings.args.exposure.it_medium;
+                    p_ctx->exp_alloc.it_long = settings.args.exposure.it_long;
+                }
+                p_ctx->exp_alloc_valid |= mask;
+            } else {
+                p_ctx->exp_alloc_valid = 0;
+                LOG( LOG_ERR, "Failed to set sensor exposure. rc = %d", rc );
             }
         } else {
             LOG( LOG_ERR, "SOC sensor subdev pointer is NULL" );
@@ -308,6 +456,8 @@ static void sensor_set_mode( void *ctx, uint8_t mode )
         if ( sd != NULL && ctx_num < FIRMWARE_CONTEXT_NUMBER ) {
             settings.ctx_num = ctx_num;
             settings.args.general.val_in = mode;
+            // allocation depends on the preset so nothing can be reused
+            sensor_exposure_reset( p_ctx );
             int rc = v4l2_subdev_call( sd, core, ioctl, SOC_SENSOR_SET_PRESET, &settings );
             if ( rc == 0 ) {
                 sensor_update_parameters( p_ctx );
@@ -481,6 +631,8 @@ void sensor_init_v4l2( void **ctx, sensor_control_t *ctrl )
 
         p_ctx->param.modes_table = p_ctx->supported_modes;
         p_ctx->param.modes_num = 0;
+        p_ctx->exp_sequence = 0;
+        sensor_exposure_reset( p_ctx );
 
         *ctx = p_ctx;
 
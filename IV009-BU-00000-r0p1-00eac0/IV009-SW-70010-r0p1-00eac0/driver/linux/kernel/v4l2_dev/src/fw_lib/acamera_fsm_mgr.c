@@ -155,6 +155,7 @@ static const char * const event_name[] = {
 void acamera_fsm_mgr_process_events(acamera_fsm_mgr_t *p_fsm_mgr,int n_max_events)
 {
     int n_event=0;
+    p_fsm_mgr->in_event_pass=1;
     for(;;)
     {
         acamera_isp_interrupts_disable(p_fsm_mgr);
@@ -194,6 +195,10 @@ void acamera_fsm_mgr_process_events(acamera_fsm_mgr_t *p_fsm_mgr,int n_max_event
             }
         }
     }
+
+    /* write the register outputs of the processed events in one pass */
+    p_fsm_mgr->in_event_pass=0;
+    acamera_reg_script_apply(&ACAMERA_MGR2CTX_PTR(p_fsm_mgr)->reg_script, p_fsm_mgr->isp_base);
 }
 
 
@@ -105,6 +105,7 @@ struct _acamera_fsm_mgr_t
     fsm_common_t *fsm_arr[FSM_ID_MAX];
     acamera_event_queue_t event_queue;
     uint8_t event_queue_data[ACAMERA_EVENT_QUEUE_SIZE];
+    uint8_t in_event_pass; // the register outputs of set_param() wait for the end of the pass
     uint32_t reserved;
 };
 
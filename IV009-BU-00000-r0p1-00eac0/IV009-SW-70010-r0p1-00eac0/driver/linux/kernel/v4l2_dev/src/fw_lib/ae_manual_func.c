@@ -76,6 +76,12 @@ void ae_roi_update( AE_fsm_ptr_t p_fsm )
 
     uint16_t gaus_center_x = ( _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_ZONE_WGHT_HOR ) * 256 / 2 ) * scale_x;
     uint16_t gaus_center_y = ( _GET_LEN( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AE_ZONE_WGHT_VER ) * 256 / 2 ) * scale_y;
+    acamera_reciprocal_t rcp_scale_x;
+    acamera_reciprocal_t rcp_scale_y;
+
+    // zone scales are invariant for the whole grid
+    acamera_reciprocal_init( &rcp_scale_x, scale_x );
+    acamera_reciprocal_init( &rcp_scale_y, scale_y );
 
     for ( y = 0; y < vert_zones; y++ ) {
         uint8_t ae_coeff = 0;
@@ -101,8 +107,8 @@ void ae_roi_update( AE_fsm_ptr_t p_fsm )
                     if ( distance_y > 0 && ( distance_y & 0x80 ) )
                         coeff_y--;
 
-                    coeff_x = ptr_ae_zone_whgh_h[coeff_x / scale_x];
-                    coeff_y = ptr_ae_zone_whgh_v[coeff_y / scale_y];
+                    coeff_x = ptr_ae_zone_whgh_h[acamera_reciprocal_div( coeff_x, &rcp_scale_x )];
+                    coeff_y = ptr_ae_zone_whgh_v[acamera_reciprocal_div( coeff_y, &rcp_scale_y )];
 
                     ae_coeff = ( coeff_x * coeff_y ) >> 4;
                     if ( ae_coeff > 1 )
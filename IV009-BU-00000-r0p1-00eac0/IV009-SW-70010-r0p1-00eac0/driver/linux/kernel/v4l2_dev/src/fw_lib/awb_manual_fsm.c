@@ -169,6 +169,12 @@ void AWB_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     AWB_fsm_clear( p_fsm );
 
+    // the status parameters are read as a structure and the white
+    // balance parameters by index
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STATUS_INFO, sizeof( status_info_param_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_AWB_WARMING_LS_D50, 3 * sizeof( uint16_t ) );
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_STATIC_WB, 4 * sizeof( uint16_t ) );
+
     awb_init( p_fsm );
     awb_coeffs_write( p_fsm );
     AWB_request_interrupt( p_fsm, ACAMERA_IRQ_MASK( ACAMERA_IRQ_AWB_STATS ) );
@@ -87,7 +87,12 @@ void awb_roi_update( AWB_fsm_ptr_t p_fsm )
 
     uint16_t gaus_center_x = ( len_zone_wght_hor * 256 / 2 ) * scale_x;
     uint16_t gaus_center_y = ( len_zone_wght_ver * 256 / 2 ) * scale_y;
+    acamera_reciprocal_t rcp_scale_x;
+    acamera_reciprocal_t rcp_scale_y;
 
+    // zone scales are invariant for the whole grid
+    acamera_reciprocal_init( &rcp_scale_x, scale_x );
+    acamera_reciprocal_init( &rcp_scale_y, scale_y );
 
     for ( y = 0; y < vert_zones; y++ ) {
         uint8_t awb_coeff = 0;
@@ -113,8 +118,8 @@ void awb_roi_update( AWB_fsm_ptr_t p_fsm )
                     if ( distance_y > 0 && ( distance_y & 0x80 ) )
                         coeff_y--;
 
-                    coeff_x = ptr_awb_zone_whgh_h[coeff_x / scale_x];
-                    coeff_y = ptr_awb_zone_whgh_v[coeff_y / scale_y];
+                    coeff_x = ptr_awb_zone_whgh_h[acamera_reciprocal_div( coeff_x, &rcp_scale_x )];
+                    coeff_y = ptr_awb_zone_whgh_v[acamera_reciprocal_div( coeff_y, &rcp_scale_y )];
 
                     awb_coeff = ( coeff_x * coeff_y ) >> 4;
                     if ( awb_coeff > 1 )
@@ -0,0 +1,316 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+
+#include "crop_cfg.h"
+
+void crop_cfg_compute( crop_cfg_t *p_cfg )
+{
+    const crop_cfg_key_t *p_key = &p_cfg->key;
+    uint16_t width = p_key->in_width;
+    uint16_t height = p_key->in_height;
+
+    p_cfg->crop_xoffset = p_key->crop_xoffset;
+    p_cfg->crop_yoffset = p_key->crop_yoffset;
+    p_cfg->crop_xsize = p_key->crop_xsize;
+    p_cfg->crop_ysize = p_key->crop_ysize;
+
+    if ( p_key->crop_enable ) {
+        // check limits
+        if ( p_cfg->crop_xoffset >= width )
+            p_cfg->crop_xoffset = width - 1;
+        if ( p_cfg->crop_yoffset >= height )
+            p_cfg->crop_yoffset = height - 1;
+        if ( p_cfg->crop_xoffset + p_cfg->crop_xsize > width )
+            p_cfg->crop_xsize = width - p_cfg->crop_xoffset;
+        if ( p_cfg->crop_yoffset + p_cfg->crop_ysize > height )
+            p_cfg->crop_ysize = height - p_cfg->crop_yoffset;
+
+        width = p_cfg->crop_xsize;
+        height = p_cfg->crop_ysize;
+    }
+
+    p_cfg->scaler_width = width;
+    p_cfg->scaler_height = height;
+    p_cfg->out_xsize = p_key->out_xsize;
+    p_cfg->out_ysize = p_key->out_ysize;
+    p_cfg->scaler_valid = 0;
+
+    if ( p_key->scaler_enable ) {
+        // check limits
+        if ( p_cfg->out_xsize > width )
+            p_cfg->out_xsize = width;
+        if ( p_cfg->out_ysize > height )
+            p_cfg->out_ysize = height;
+
+        if ( ( p_cfg->out_xsize != 0 ) && ( p_cfg->out_ysize != 0 ) ) {
+            if ( width >= 0x1000 )
+                p_cfg->hfilt_tinc = ( ( (uint32_t)width << 18 ) / p_cfg->out_xsize ) << 2; // division by zero is checked
+            else
+                p_cfg->hfilt_tinc = ( (uint32_t)width << 20 ) / p_cfg->out_xsize; // division by zero is checked
+            if ( height >= 0x1000 )
+                p_cfg->vfilt_tinc = ( ( (uint32_t)height << 18 ) / p_cfg->out_ysize ) << 2; // division by zero is checked
+            else
+                p_cfg->vfilt_tinc = ( (uint32_t)height << 20 ) / p_cfg->out_ysize; // division by zero is checked
+            // filt_coefset_table
+            //0    1.000
+            //1    0.75
+            //2    0.5
+            //3    0.25
+            if ( width >= 3 * p_cfg->out_xsize )
+                p_cfg->hfilt_coefset = 3;
+            else
+                p_cfg->hfilt_coefset = 2 * width / p_cfg->out_xsize - 2; // division by zero is checked
+            if ( height >= 3 * p_cfg->out_ysize )
+                p_cfg->vfilt_coefset = 3;
+            else
+                p_cfg->vfilt_coefset = 2 * height / p_cfg->out_ysize - 2; // division by zero is checked
+            p_cfg->scaler_valid = 1;
+        }
+
+        width = p_cfg->out_xsize;
+        height = p_cfg->out_ysize;
+    }
+
+    p_cfg->width = width;
+    p_cfg->height = height;
+    p_cfg->valid = 1;
+}
+
+// The key has no padding and every field is always set, so it is compared
+// as a whole. The compiler turns this into a few wide loads instead of ten
+// separate branches, which is most of the cost of a hit.
+static int crop_cfg_key_equal( const crop_cfg_key_t *p_a, const crop_cfg_key_t *p_b )
+{
+    return __builtin_memcmp( p_a, p_b, sizeof( *p_a ) ) == 0;
+}
+
+// The fields are packed in pairs and multiplied independently, so the hash
+// costs a few cycles. Zero is reserved for the empty entries.
+static uint32_t crop_cfg_key_hash( const crop_cfg_key_t *p_key )
+{
+    uint32_t h;
+
+    h = ( p_key->in_width | (uint32_t)p_key->in_height << 16 ) * 0x9E3779B1u;
+    h ^= ( p_key->crop_xoffset | (uint32_t)p_key->crop_yoffset << 16 ) * 0x85EBCA77u;
+    h ^= ( p_key->crop_xsize | (uint32_t)p_key->crop_ysize << 16 ) * 0xC2B2AE3Du;
+    h ^= ( p_key->out_xsize | (uint32_t)p_key->out_ysize << 16 ) * 0x27D4EB2Fu;
+    h ^= ( (uint32_t)p_key->crop_enable << 1 ) | p_key->scaler_enable;
+    h ^= h >> 15;
+
+    return h ? h : 1;
+}
+
+// index of the entry with the key, CROP_CFG_CACHE_SIZE when it is not cached
+static uint32_t crop_cfg_find( const crop_cfg_cache_t *p_cache, const crop_cfg_key_t *p_key, uint32_t hash )
+{
+    uint32_t idx;
+
+    for ( idx = 0; idx < CROP_CFG_CACHE_SIZE; idx++ ) {
+        if ( p_cache->hash[idx] == hash && crop_cfg_key_equal( &p_cache->entry[idx].key, p_key ) ) {
+            break;
+        }
+    }
+
+    return idx;
+}
+
+// takes the next entry round robin
+static crop_cfg_t *crop_cfg_replace( crop_cfg_cache_t *p_cache, uint32_t hash )
+{
+    uint32_t idx = p_cache->next;
+
+    p_cache->next = ( idx + 1 ) & ( CROP_CFG_CACHE_SIZE - 1 );
+    p_cache->last = idx;
+    p_cache->hash[idx] = hash;
+
+    return &p_cache->entry[idx];
+}
+
+// returns the configuration for the key, computing it on a miss
+const crop_cfg_t *crop_cfg_get( crop_cfg_cache_t *p_cache, const crop_cfg_key_t *p_key )
+{
+    crop_cfg_t *p_cfg = &p_cache->entry[p_cache->last];
+    uint32_t hash;
+    uint32_t idx;
+
+    // a static crop asks for the same key every frame
+    if ( p_cfg->valid && crop_cfg_key_equal( &p_cfg->key, p_key ) ) {
+        p_cache->hits++;
+        return p_cfg;
+    }
+
+    // a preloaded zoom path continues with the next entry
+    idx = ( p_cache->last + 1 ) & ( CROP_CFG_CACHE_SIZE - 1 );
+    p_cfg = &p_cache->entry[idx];
+    if ( p_cfg->valid && crop_cfg_key_equal( &p_cfg->key, p_key ) ) {
+        p_cache->last = idx;
+        p_cache->hits++;
+        return p_cfg;
+    }
+
+    // anywhere else only the entry with the same hash is compared
+    hash = crop_cfg_key_hash( p_key );
+    idx = crop_cfg_find( p_cache, p_key, hash );
+    if ( idx < CROP_CFG_CACHE_SIZE ) {
+        p_cache->last = idx;
+        p_cache->hits++;
+        return &p_cache->entry[idx];
+    }
+
+    p_cache->misses++;
+
+    p_cfg = crop_cfg_replace( p_cache, hash );
+    p_cfg->key = *p_key;
+    crop_cfg_compute( p_cfg );
+
+    return p_cfg;
+}
+
+// Stores a configuration computed by crop_cfg_compute() unless its key is
+// cached already. The hit and miss counters are left alone, so preloading
+// can compute outside of the lock of the cache and only insert under it.
+void crop_cfg_put( crop_cfg_cache_t *p_cache, const crop_cfg_t *p_cfg )
+{
+    uint32_t hash = crop_cfg_key_hash( &p_cfg->key );
+    uint32_t idx = crop_cfg_find( p_cache, &p_cfg->key, hash );
+
+    if ( idx < CROP_CFG_CACHE_SIZE ) {
+        p_cache->last = idx;
+        return;
+    }
+
+    *crop_cfg_replace( p_cache, hash ) = *p_cfg;
+}
+
+void crop_cfg_cache_reset( crop_cfg_cache_t *p_cache )
+{
+    uint32_t i;
+
+    for ( i = 0; i < CROP_CFG_CACHE_SIZE; i++ ) {
+        p_cache->hash[i] = 0;
+        p_cache->entry[i].valid = 0;
+    }
+    p_cache->last = 0;
+    p_cache->next = 0;
+    p_cache->hits = 0;
+    p_cache->misses = 0;
+}
+
+// Downscaling is limited by the 24-bit tinc register, as in crop_cfg_compute().
+static int crop_scaler_ratio_valid( uint16_t size, uint16_t out )
+{
+    uint32_t tinc;
+
+    if ( size >= 0x1000 )
+        tinc = ( ( (uint32_t)size << 18 ) / out ) << 2; // out is checked to be non zero
+    else
+        tinc = ( (uint32_t)size << 20 ) / out; // out is checked to be non zero
+
+    return tinc < ( 1 << 24 );
+}
+
+// A window has to lie within the input and, with the scaler, its output size
+// must be non zero and a downscale of the window. The windows in between
+// two valid keyframes are then valid as well.
+int crop_keyframe_valid( const acamera_crop_keyframe_t *p_key, uint32_t index, uint16_t width, uint16_t height, uint8_t scaler )
+{
+    const acamera_crop_window_t *p_window = &p_key->window;
+
+    if ( p_window->xsize == 0 || p_window->ysize == 0 ||
+         (uint32_t)p_window->xoffset + p_window->xsize > width || (uint32_t)p_window->yoffset + p_window->ysize > height ) {
+        return 0;
+    }
+
+    if ( index > 0 && p_key->frames == 0 ) {
+        return 0;
+    }
+
+    if ( scaler ) {
+        if ( p_window->out_xsize == 0 || p_window->out_ysize == 0 ||
+             p_window->out_xsize > p_window->xsize || p_window->out_ysize > p_window->ysize ) {
+            return 0;
+        }
+        if ( !crop_scaler_ratio_valid( p_window->xsize, p_window->out_xsize ) || !crop_scaler_ratio_valid( p_window->ysize, p_window->out_ysize ) ) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// the keyframes are expected to be checked with crop_keyframe_valid()
+void crop_trajectory_load( crop_trajectory_t *p_traj, const acamera_crop_keyframe_t *p_keyframes, uint8_t count )
+{
+    uint32_t i;
+
+    for ( i = 0; i < count; i++ ) {
+        p_traj->keyframe[i] = p_keyframes[i];
+    }
+    p_traj->count = count;
+    p_traj->segment = 0;
+    p_traj->step = 0;
+    p_traj->active = 1;
+}
+
+static uint16_t crop_trajectory_lerp( uint16_t from, uint16_t to, uint32_t step, uint32_t frames )
+{
+    int32_t offset = ( (int32_t)to - (int32_t)from ) * (int32_t)step;
+
+    // round half away from zero so zooming in and out follow the same path
+    if ( offset >= 0 )
+        offset = ( offset + (int32_t)( frames >> 1 ) ) / (int32_t)frames; // frames is checked to be non zero
+    else
+        offset = -( ( -offset + (int32_t)( frames >> 1 ) ) / (int32_t)frames );
+
+    return (uint16_t)( (int32_t)from + offset );
+}
+
+// Window for the current frame. The first frame shows the first keyframe,
+// each segment then takes exactly keyframe[segment + 1].frames frames and
+// ends on that keyframe.
+void crop_trajectory_step( crop_trajectory_t *p_traj, acamera_crop_window_t *p_window )
+{
+    const acamera_crop_keyframe_t *p_from = &p_traj->keyframe[p_traj->segment];
+    const acamera_crop_keyframe_t *p_to = p_from + 1;
+
+    if ( p_traj->step == 0 ) {
+        *p_window = p_from->window;
+    } else {
+        p_window->xoffset = crop_trajectory_lerp( p_from->window.xoffset, p_to->window.xoffset, p_traj->step, p_to->frames );
+        p_window->yoffset = crop_trajectory_lerp( p_from->window.yoffset, p_to->window.yoffset, p_traj->step, p_to->frames );
+        p_window->xsize = crop_trajectory_lerp( p_from->window.xsize, p_to->window.xsize, p_traj->step, p_to->frames );
+        p_window->ysize = crop_trajectory_lerp( p_from->window.ysize, p_to->window.ysize, p_traj->step, p_to->frames );
+        p_window->out_xsize = crop_trajectory_lerp( p_from->window.out_xsize, p_to->window.out_xsize, p_traj->step, p_to->frames );
+        p_window->out_ysize = crop_trajectory_lerp( p_from->window.out_ysize, p_to->window.out_ysize, p_traj->step, p_to->frames );
+    }
+
+    if ( p_traj->segment + 1 >= p_traj->count ) {
+        // a single keyframe is a jump
+        p_traj->active = 0;
+    } else if ( p_traj->step == p_to->frames ) {
+        p_traj->segment++;
+        p_traj->step = 1;
+        if ( p_traj->segment + 1 >= p_traj->count ) {
+            p_traj->active = 0;
+        }
+    } else {
+        p_traj->step++;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+*
+* SPDX-License-Identifier: GPL-2.0
+*
+* Copyright (C) 2011-2018 ARM or its affiliates
+*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; version 2.
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*
+*/
+
+#if !defined( __CROP_CFG_H__ )
+#define __CROP_CFG_H__
+
+#include "acamera_types.h"
+#include "acamera_command_api.h"
+
+// number of precomputed configurations kept per output, a power of two
+#define CROP_CFG_CACHE_SIZE 32
+
+// what the register values of one output are computed from, the fields
+// are ordered so that the key has no padding and all of them must be set
+typedef struct _crop_cfg_key_t {
+    uint16_t in_width;
+    uint16_t in_height;
+    uint16_t crop_xoffset;
+    uint16_t crop_yoffset;
+    uint16_t crop_xsize;
+    uint16_t crop_ysize;
+    uint16_t out_xsize;
+    uint16_t out_ysize;
+    uint8_t crop_enable;
+    uint8_t scaler_enable;
+} crop_cfg_key_t;
+
+// crop window and scaler registers fully computed for one key
+typedef struct _crop_cfg_t {
+    crop_cfg_key_t key;
+    uint8_t valid;
+    uint8_t scaler_valid;
+    uint8_t hfilt_coefset;
+    uint8_t vfilt_coefset;
+    uint16_t crop_xoffset;
+    uint16_t crop_yoffset;
+    uint16_t crop_xsize;
+    uint16_t crop_ysize;
+    uint16_t scaler_width;
+    uint16_t scaler_height;
+    uint16_t out_xsize;
+    uint16_t out_ysize;
+    uint32_t hfilt_tinc;
+    uint32_t vfilt_tinc;
+    // output resolution of this pipe
+    uint16_t width;
+    uint16_t height;
+} crop_cfg_t;
+
+// A lookup checks the last used entry and the one after it directly, then
+// scans the key hashes and compares the full key only for the entry whose
+// hash matches. A hash of 0 marks an empty entry.
+typedef struct _crop_cfg_cache_t {
+    uint32_t hash[CROP_CFG_CACHE_SIZE];
+    crop_cfg_t entry[CROP_CFG_CACHE_SIZE];
+    // most recently used entry, a zoom path usually continues with the next one
+    uint8_t last;
+    // round robin replacement
+    uint8_t next;
+    uint32_t hits;
+    uint32_t misses;
+} crop_cfg_cache_t;
+
+#define CROP_TRAJECTORY_MAX_KEYFRAMES 8
+
+typedef struct _crop_trajectory_t {
+    acamera_crop_keyframe_t keyframe[CROP_TRAJECTORY_MAX_KEYFRAMES];
+    uint8_t count;
+    // moving from keyframe[segment] to keyframe[segment + 1]
+    uint8_t segment;
+    // frames done within the segment, 0 before the first frame
+    uint16_t step;
+    uint8_t active;
+} crop_trajectory_t;
+
+void crop_cfg_cache_reset( crop_cfg_cache_t *p_cache );
+const crop_cfg_t *crop_cfg_get( crop_cfg_cache_t *p_cache, const crop_cfg_key_t *p_key );
+void crop_cfg_put( crop_cfg_cache_t *p_cache, const crop_cfg_t *p_cfg );
+void crop_cfg_compute( crop_cfg_t *p_cfg );
+
+int crop_keyframe_valid( const acamera_crop_keyframe_t *p_key, uint32_t index, uint16_t width, uint16_t height, uint8_t scaler );
+void crop_trajectory_load( crop_trajectory_t *p_traj, const acamera_crop_keyframe_t *p_keyframes, uint8_t count );
+void crop_trajectory_step( crop_trajectory_t *p_traj, acamera_crop_window_t *p_window );
+
+#endif /* __CROP_CFG_H__ */
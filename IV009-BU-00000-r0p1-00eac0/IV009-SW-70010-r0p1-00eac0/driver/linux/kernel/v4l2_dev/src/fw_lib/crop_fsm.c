@@ -69,9 +69,18 @@ void crop_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     crop_fsm_clear( p_fsm );
 
+    system_spinlock_init( &p_fsm->lock );
     crop_initialize( p_fsm );
 }
 
+void crop_fsm_deinit( void *fsm )
+{
+    crop_fsm_t *p_fsm = (crop_fsm_t *)fsm;
+
+    system_spinlock_destroy( p_fsm->lock );
+    p_fsm->lock = NULL;
+}
+
 #ifdef IMAGE_RESIZE_TYPE_ID
 static int crop_set_resize_type( crop_fsm_t *p_fsm, uint16_t type )
 {
@@ -305,6 +314,26 @@ int crop_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_t inpu
 #endif
     } break;
 
+    case FSM_PARAM_SET_CROP_PRELOAD:
+        if ( !input || input_size != sizeof( fsm_param_crop_preload_t ) ) {
+            LOG( LOG_ERR, "Invalid param, param_id: %d, p_fsm: %p.", param_id, p_fsm );
+            rc = -1;
+            break;
+        }
+
+        rc = crop_preload( p_fsm, (fsm_param_crop_preload_t *)input );
+        break;
+
+    case FSM_PARAM_SET_CROP_TRAJECTORY:
+        if ( !input || input_size != sizeof( fsm_param_crop_trajectory_t ) ) {
+            LOG( LOG_ERR, "Invalid param, param_id: %d, p_fsm: %p.", param_id, p_fsm );
+            rc = -1;
+            break;
+        }
+
+        rc = crop_trajectory_start( p_fsm, (fsm_param_crop_trajectory_t *)input );
+        break;
+
     default:
         rc = -1;
         break;
@@ -20,6 +20,7 @@
 #if !defined( __CROP_FSM_H__ )
 #define __CROP_FSM_H__
 
+#include "crop_cfg.h"
 
 
 typedef struct _crop_fsm_t crop_fsm_t;
@@ -41,8 +42,11 @@ typedef struct _scaler_t {
     uint16_t ysize;
     uint16_t bank;
 } scaler_t;
+
 void crop_initialize( crop_fsm_ptr_t p_fsm );
 void crop_resolution_changed( crop_fsm_ptr_t p_fsm );
+int crop_preload( crop_fsm_ptr_t p_fsm, const fsm_param_crop_preload_t *p_preload );
+int crop_trajectory_start( crop_fsm_ptr_t p_fsm, const fsm_param_crop_trajectory_t *p_trajectory );
 
 struct _crop_fsm_t {
     fsm_common_t cmn;
@@ -50,9 +54,14 @@ struct _crop_fsm_t {
     acamera_fsm_mgr_t *p_fsm_mgr;
     fsm_irq_mask_t mask;
     uint16_t resize_type;
+    // The API, the firmware thread and the frame interrupts all use the crop
+    // windows, the caches and the trajectories below, they do it under this lock.
+    sys_spinlock lock;
     crop_t crop_fr;
     uint16_t width_fr;
     uint16_t height_fr;
+    crop_cfg_cache_t cfg_cache_fr;
+    crop_trajectory_t trajectory_fr;
 
 
 #if ISP_HAS_DS1
@@ -60,6 +69,8 @@ struct _crop_fsm_t {
     scaler_t scaler_ds;
     uint16_t width_ds;
     uint16_t height_ds;
+    crop_cfg_cache_t cfg_cache_ds;
+    crop_trajectory_t trajectory_ds;
 #endif
     uint8_t need_updating;
 };
@@ -67,6 +78,7 @@ struct _crop_fsm_t {
 
 void crop_fsm_clear( crop_fsm_ptr_t p_fsm );
 void crop_fsm_init( void *fsm, fsm_init_param_t *init_param );
+void crop_fsm_deinit( void *fsm );
 
 int crop_fsm_set_param( void *fsm, uint32_t param_id, void *input, uint32_t input_size );
 int crop_fsm_get_param( void *fsm, uint32_t param_id, void *input, uint32_t input_size, void *output, uint32_t output_size );
@@ -86,86 +86,73 @@ int crop_validate_size( crop_fsm_t *p_fsm, uint16_t type, uint16_t sizeto, int i
 
 #if ISP_HAS_DS1
 
+static void crop_cfg_key_ds( crop_fsm_ptr_t p_fsm, crop_cfg_key_t *p_key )
+{
+    //width and height should be from the top in case that RAW SCALER was updated
+    p_key->in_width = acamera_isp_top_active_width_read( p_fsm->cmn.isp_base );
+    p_key->in_height = acamera_isp_top_active_height_read( p_fsm->cmn.isp_base );
+    p_key->crop_enable = p_fsm->crop_ds.enable;
+    p_key->crop_xoffset = p_fsm->crop_ds.xoffset;
+    p_key->crop_yoffset = p_fsm->crop_ds.yoffset;
+    p_key->crop_xsize = p_fsm->crop_ds.xsize;
+    p_key->crop_ysize = p_fsm->crop_ds.ysize;
+    p_key->scaler_enable = p_fsm->scaler_ds.enable;
+    p_key->out_xsize = p_fsm->scaler_ds.xsize;
+    p_key->out_ysize = p_fsm->scaler_ds.ysize;
+}
+
 // update functions must be called inside interrupt to avoid broken frames
 void _update_ds( crop_fsm_ptr_t p_fsm, int isr )
 {
-    // get actual image resolution from sensor
-    uint16_t width = 0;
-    uint16_t height = 0;
+    crop_cfg_key_t key;
+    crop_cfg_t cfg;
+    const crop_cfg_t *p_cfg = &cfg;
+    unsigned long flags;
 
-    //width and height should be from the top in case that RAW SCALER was updated
-    width = acamera_isp_top_active_width_read( p_fsm->cmn.isp_base );
-    height = acamera_isp_top_active_height_read( p_fsm->cmn.isp_base );
+    // the entry is copied, the API may refill the cache meanwhile
+    flags = system_spinlock_lock( p_fsm->lock );
+    crop_cfg_key_ds( p_fsm, &key );
+    cfg = *crop_cfg_get( &p_fsm->cfg_cache_ds, &key );
+    system_spinlock_unlock( p_fsm->lock, flags );
 
     // configure crop
     if ( p_fsm->crop_ds.enable ) {
-        // check limits
-
-        if ( p_fsm->crop_ds.xoffset >= width )
-            p_fsm->crop_ds.xoffset = width - 1;
-        if ( p_fsm->crop_ds.yoffset >= height )
-            p_fsm->crop_ds.yoffset = height - 1;
-        if ( p_fsm->crop_ds.xoffset + p_fsm->crop_ds.xsize > width )
-            p_fsm->crop_ds.xsize = width - p_fsm->crop_ds.xoffset;
-        if ( p_fsm->crop_ds.yoffset + p_fsm->crop_ds.ysize > height )
-            p_fsm->crop_ds.ysize = height - p_fsm->crop_ds.yoffset;
+        p_fsm->crop_ds.xoffset = p_cfg->crop_xoffset;
+        p_fsm->crop_ds.yoffset = p_cfg->crop_yoffset;
+        p_fsm->crop_ds.xsize = p_cfg->crop_xsize;
+        p_fsm->crop_ds.ysize = p_cfg->crop_ysize;
 
         // apply crop
-        acamera_isp_ds1_crop_start_x_write( p_fsm->cmn.isp_base, p_fsm->crop_ds.xoffset );
-        acamera_isp_ds1_crop_start_y_write( p_fsm->cmn.isp_base, p_fsm->crop_ds.yoffset );
-        acamera_isp_ds1_crop_size_x_write( p_fsm->cmn.isp_base, p_fsm->crop_ds.xsize );
-        acamera_isp_ds1_crop_size_y_write( p_fsm->cmn.isp_base, p_fsm->crop_ds.ysize );
-        width = p_fsm->crop_ds.xsize;
-        height = p_fsm->crop_ds.ysize;
+        acamera_isp_ds1_crop_start_x_write( p_fsm->cmn.isp_base, p_cfg->crop_xoffset );
+        acamera_isp_ds1_crop_start_y_write( p_fsm->cmn.isp_base, p_cfg->crop_yoffset );
+        acamera_isp_ds1_crop_size_x_write( p_fsm->cmn.isp_base, p_cfg->crop_xsize );
+        acamera_isp_ds1_crop_size_y_write( p_fsm->cmn.isp_base, p_cfg->crop_ysize );
     }
     acamera_isp_ds1_crop_enable_crop_write( p_fsm->cmn.isp_base, p_fsm->crop_ds.enable );
     p_fsm->crop_ds.done = 1; //done
     // configure downscaler
     if ( p_fsm->scaler_ds.enable ) {
-        // check limits
-
-        if ( p_fsm->scaler_ds.xsize > width )
-            p_fsm->scaler_ds.xsize = width;
-        if ( p_fsm->scaler_ds.ysize > height )
-            p_fsm->scaler_ds.ysize = height;
+        p_fsm->scaler_ds.xsize = p_cfg->out_xsize;
+        p_fsm->scaler_ds.ysize = p_cfg->out_ysize;
 
         // apply parameters
-        acamera_isp_ds1_scaler_width_write( p_fsm->cmn.isp_base, width );
-        acamera_isp_ds1_scaler_height_write( p_fsm->cmn.isp_base, height );
-        acamera_isp_ds1_scaler_owidth_write( p_fsm->cmn.isp_base, p_fsm->scaler_ds.xsize );
-        acamera_isp_ds1_scaler_oheight_write( p_fsm->cmn.isp_base, p_fsm->scaler_ds.ysize );
-        if ( ( p_fsm->scaler_ds.xsize != 0 ) && ( p_fsm->scaler_ds.ysize != 0 ) ) {
-            if ( width >= 0x1000 )
-                acamera_isp_ds1_scaler_hfilt_tinc_write( p_fsm->cmn.isp_base, ( ( (uint32_t)width << 18 ) / p_fsm->scaler_ds.xsize ) << 2 ); // division by zero is checked
-            else
-                acamera_isp_ds1_scaler_hfilt_tinc_write( p_fsm->cmn.isp_base, ( (uint32_t)width << 20 ) / p_fsm->scaler_ds.xsize ); // division by zero is checked
-            if ( height >= 0x1000 )
-                acamera_isp_ds1_scaler_vfilt_tinc_write( p_fsm->cmn.isp_base, ( ( (uint32_t)height << 18 ) / p_fsm->scaler_ds.ysize ) << 2 ); // division by zero is checked
-            else
-                acamera_isp_ds1_scaler_vfilt_tinc_write( p_fsm->cmn.isp_base, ( (uint32_t)height << 20 ) / p_fsm->scaler_ds.ysize ); // division by zero is checked
-            // filt_coefset_table
-            //0    1.000
-            //1    0.75
-            //2    0.5
-            //3    0.25
-            if ( width >= 3 * p_fsm->scaler_ds.xsize )
-                acamera_isp_ds1_scaler_hfilt_coefset_write( p_fsm->cmn.isp_base, 3 );
-            else
-                acamera_isp_ds1_scaler_hfilt_coefset_write( p_fsm->cmn.isp_base, 2 * width / p_fsm->scaler_ds.xsize - 2 ); // division by zero is checked
-            if ( height >= 3 * p_fsm->scaler_ds.ysize )
-                acamera_isp_ds1_scaler_vfilt_coefset_write( p_fsm->cmn.isp_base, 3 );
-            else
-                acamera_isp_ds1_scaler_vfilt_coefset_write( p_fsm->cmn.isp_base, 2 * height / p_fsm->scaler_ds.ysize - 2 ); // division by zero is checked
+        acamera_isp_ds1_scaler_width_write( p_fsm->cmn.isp_base, p_cfg->scaler_width );
+        acamera_isp_ds1_scaler_height_write( p_fsm->cmn.isp_base, p_cfg->scaler_height );
+        acamera_isp_ds1_scaler_owidth_write( p_fsm->cmn.isp_base, p_cfg->out_xsize );
+        acamera_isp_ds1_scaler_oheight_write( p_fsm->cmn.isp_base, p_cfg->out_ysize );
+        if ( p_cfg->scaler_valid ) {
+            acamera_isp_ds1_scaler_hfilt_tinc_write( p_fsm->cmn.isp_base, p_cfg->hfilt_tinc );
+            acamera_isp_ds1_scaler_vfilt_tinc_write( p_fsm->cmn.isp_base, p_cfg->vfilt_tinc );
+            acamera_isp_ds1_scaler_hfilt_coefset_write( p_fsm->cmn.isp_base, p_cfg->hfilt_coefset );
+            acamera_isp_ds1_scaler_vfilt_coefset_write( p_fsm->cmn.isp_base, p_cfg->vfilt_coefset );
         } else {
             LOG( LOG_ERR, "WRONG DS DOWNSCALER PARAMETERS: width: %d, height: %d", p_fsm->scaler_ds.xsize, p_fsm->scaler_ds.ysize );
         }
-        width = p_fsm->scaler_ds.xsize;
-        height = p_fsm->scaler_ds.ysize;
     }
     acamera_isp_top_bypass_ds1_scaler_write( p_fsm->cmn.isp_base, !p_fsm->scaler_ds.enable );
     p_fsm->scaler_ds.done = 1; //done
-    p_fsm->width_ds = width;
-    p_fsm->height_ds = height;
+    p_fsm->width_ds = p_cfg->width;
+    p_fsm->height_ds = p_cfg->height;
     if ( !isr )
         LOG( LOG_NOTICE, "DS update: Crop: e %d x %d, y %d, w %d, h %d, Downscaler: e %d, w %d, h %d", p_fsm->crop_ds.enable, p_fsm->crop_ds.xoffset, p_fsm->crop_ds.yoffset, p_fsm->crop_ds.xsize, p_fsm->crop_ds.ysize, p_fsm->scaler_ds.enable, p_fsm->scaler_ds.xsize, p_fsm->scaler_ds.ysize );
     LOG( LOG_INFO, "DS info: Crop: e %d x %d, y %d, w %d, h %d, Downscaler: e %d, w %d, h %d", p_fsm->crop_ds.enable, p_fsm->crop_ds.xoffset, p_fsm->crop_ds.yoffset, p_fsm->crop_ds.xsize, p_fsm->crop_ds.ysize, p_fsm->scaler_ds.enable, p_fsm->scaler_ds.xsize, p_fsm->scaler_ds.ysize );
@@ -173,54 +160,295 @@ void _update_ds( crop_fsm_ptr_t p_fsm, int isr )
 #endif //ISP_HAS_DS1
 
 
+static void crop_cfg_key_fr( crop_fsm_ptr_t p_fsm, crop_cfg_key_t *p_key )
+{
+    p_key->in_width = acamera_isp_top_active_width_read( p_fsm->cmn.isp_base );
+    p_key->in_height = acamera_isp_top_active_height_read( p_fsm->cmn.isp_base );
+    p_key->crop_enable = p_fsm->crop_fr.enable;
+    p_key->crop_xoffset = p_fsm->crop_fr.xoffset;
+    p_key->crop_yoffset = p_fsm->crop_fr.yoffset;
+    p_key->crop_xsize = p_fsm->crop_fr.xsize;
+    p_key->crop_ysize = p_fsm->crop_fr.ysize;
+    // there is no scaler on the full resolution pipe
+    p_key->scaler_enable = 0;
+    p_key->out_xsize = 0;
+    p_key->out_ysize = 0;
+}
+
 void _update_fr( crop_fsm_ptr_t p_fsm, int isr )
 {
-    // get actual image resolution from sensor
-    uint16_t width = 0;
-    uint16_t height = 0;
-    fsm_param_sensor_info_t sensor_info;
-    acamera_fsm_mgr_get_param( p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_SENSOR_INFO, NULL, 0, &sensor_info, sizeof( sensor_info ) );
+    crop_cfg_key_t key;
+    crop_cfg_t cfg;
+    const crop_cfg_t *p_cfg = &cfg;
+    unsigned long flags;
 
-    width = acamera_isp_top_active_width_read( p_fsm->cmn.isp_base );
-    height = acamera_isp_top_active_height_read( p_fsm->cmn.isp_base );
-    LOG( LOG_INFO, "crop was configured with w:%u h:%u\n", width, height );
+    // the entry is copied, the API may refill the cache meanwhile
+    flags = system_spinlock_lock( p_fsm->lock );
+    crop_cfg_key_fr( p_fsm, &key );
+    cfg = *crop_cfg_get( &p_fsm->cfg_cache_fr, &key );
+    system_spinlock_unlock( p_fsm->lock, flags );
 
+    LOG( LOG_INFO, "crop was configured with w:%u h:%u\n", key.in_width, key.in_height );
 
     if ( p_fsm->crop_fr.enable ) {
-        // check limits
-
-        if ( p_fsm->crop_fr.xoffset >= width )
-            p_fsm->crop_fr.xoffset = width - 1;
-        if ( p_fsm->crop_fr.yoffset >= height )
-            p_fsm->crop_fr.yoffset = height - 1;
-        if ( p_fsm->crop_fr.xoffset + p_fsm->crop_fr.xsize > width )
-            p_fsm->crop_fr.xsize = width - p_fsm->crop_fr.xoffset;
-        if ( p_fsm->crop_fr.yoffset + p_fsm->crop_fr.ysize > height )
-            p_fsm->crop_fr.ysize = height - p_fsm->crop_fr.yoffset;
+        p_fsm->crop_fr.xoffset = p_cfg->crop_xoffset;
+        p_fsm->crop_fr.yoffset = p_cfg->crop_yoffset;
+        p_fsm->crop_fr.xsize = p_cfg->crop_xsize;
+        p_fsm->crop_fr.ysize = p_cfg->crop_ysize;
+
         // apply crop
-        acamera_isp_fr_crop_start_x_write( p_fsm->cmn.isp_base, p_fsm->crop_fr.xoffset );
-        acamera_isp_fr_crop_start_y_write( p_fsm->cmn.isp_base, p_fsm->crop_fr.yoffset );
-        acamera_isp_fr_crop_size_x_write( p_fsm->cmn.isp_base, p_fsm->crop_fr.xsize );
-        acamera_isp_fr_crop_size_y_write( p_fsm->cmn.isp_base, p_fsm->crop_fr.ysize );
-        width = p_fsm->crop_fr.xsize;
-        height = p_fsm->crop_fr.ysize;
+        acamera_isp_fr_crop_start_x_write( p_fsm->cmn.isp_base, p_cfg->crop_xoffset );
+        acamera_isp_fr_crop_start_y_write( p_fsm->cmn.isp_base, p_cfg->crop_yoffset );
+        acamera_isp_fr_crop_size_x_write( p_fsm->cmn.isp_base, p_cfg->crop_xsize );
+        acamera_isp_fr_crop_size_y_write( p_fsm->cmn.isp_base, p_cfg->crop_ysize );
     }
 
 
     acamera_isp_fr_crop_enable_crop_write( p_fsm->cmn.isp_base, p_fsm->crop_fr.enable );
     p_fsm->crop_fr.done = 1; //done
-    p_fsm->width_fr = width;
-    p_fsm->height_fr = height;
+    p_fsm->width_fr = p_cfg->width;
+    p_fsm->height_fr = p_cfg->height;
     if ( !isr )
         LOG( LOG_NOTICE, "FR update: Crop: e %d x %d, y %d, w %d, h %d", p_fsm->crop_fr.enable, p_fsm->crop_fr.xoffset, p_fsm->crop_fr.yoffset, p_fsm->crop_fr.xsize, p_fsm->crop_fr.ysize );
 }
 
+// every window of a zoom path is a crop of the current input
+static void crop_cfg_key_window( crop_cfg_key_t *p_key, const acamera_crop_window_t *p_window )
+{
+    p_key->crop_enable = 1;
+    p_key->crop_xoffset = p_window->xoffset;
+    p_key->crop_yoffset = p_window->yoffset;
+    p_key->crop_xsize = p_window->xsize;
+    p_key->crop_ysize = p_window->ysize;
+    if ( p_key->scaler_enable ) {
+        p_key->out_xsize = p_window->out_xsize;
+        p_key->out_ysize = p_window->out_ysize;
+    }
+}
+
+// windows computed per lock section, keeps the stack use small
+#define CROP_PRELOAD_CHUNK 4
+
+// Computes the windows with the lock released and only inserts the results
+// into the cache under it, so the frame path is never held up by the math.
+static void crop_cfg_preload_windows( crop_fsm_ptr_t p_fsm, crop_cfg_cache_t *p_cache, const crop_cfg_key_t *p_key, const acamera_crop_window_t *p_windows, uint32_t count )
+{
+    crop_cfg_t cfg[CROP_PRELOAD_CHUNK];
+    unsigned long flags;
+    uint32_t i;
+
+    for ( i = 0; i < count; i++ ) {
+        crop_cfg_t *p_cfg = &cfg[i % CROP_PRELOAD_CHUNK];
+
+        p_cfg->key = *p_key;
+        crop_cfg_key_window( &p_cfg->key, &p_windows[i] );
+        crop_cfg_compute( p_cfg );
+
+        if ( i % CROP_PRELOAD_CHUNK == CROP_PRELOAD_CHUNK - 1 || i == count - 1 ) {
+            uint32_t k;
+
+            flags = system_spinlock_lock( p_fsm->lock );
+            for ( k = 0; k <= i % CROP_PRELOAD_CHUNK; k++ ) {
+                crop_cfg_put( p_cache, &cfg[k] );
+            }
+            system_spinlock_unlock( p_fsm->lock, flags );
+        }
+    }
+}
+
+int crop_preload( crop_fsm_ptr_t p_fsm, const fsm_param_crop_preload_t *p_preload )
+{
+    crop_cfg_cache_t *p_cache = NULL;
+    crop_cfg_key_t key;
+    uint32_t hits, misses;
+    unsigned long flags;
+    uint32_t first = 0;
+
+    switch ( p_preload->resize_type ) {
+    case CROP_FR:
+        p_cache = &p_fsm->cfg_cache_fr;
+        break;
+#if ISP_HAS_DS1
+    case CROP_DS:
+        p_cache = &p_fsm->cfg_cache_ds;
+        break;
+#endif
+    default:
+        LOG( LOG_ERR, "Unsupported resize type %d for preload", p_preload->resize_type );
+        return -1;
+    }
+
+    // only the last CROP_CFG_CACHE_SIZE windows can stay in the cache
+    if ( p_preload->count > CROP_CFG_CACHE_SIZE ) {
+        LOG( LOG_WARNING, "Zoom path of %d steps is longer than the cache, only the last %d are preloaded", p_preload->count, CROP_CFG_CACHE_SIZE );
+        first = p_preload->count - CROP_CFG_CACHE_SIZE;
+    }
+
+    // the windows are crops of the input the pipe has now
+    flags = system_spinlock_lock( p_fsm->lock );
+
+    if ( p_preload->resize_type == CROP_FR ) {
+        crop_cfg_key_fr( p_fsm, &key );
+    }
+#if ISP_HAS_DS1
+    else {
+        crop_cfg_key_ds( p_fsm, &key );
+    }
+#endif
+
+    // counters reflect the per-frame updates only
+    hits = p_cache->hits;
+    misses = p_cache->misses;
+
+    system_spinlock_unlock( p_fsm->lock, flags );
+
+    crop_cfg_preload_windows( p_fsm, p_cache, &key, &p_preload->windows[first], p_preload->count - first );
+
+    LOG( LOG_INFO, "Preloaded %d crop configurations, cache hits %u misses %u", p_preload->count, (unsigned int)hits, (unsigned int)misses );
+
+    return 0;
+}
+
+// The trajectory is checked and staged here, then handed to the frame path
+// under the lock. A rejected one leaves the running trajectory alone.
+int crop_trajectory_start( crop_fsm_ptr_t p_fsm, const fsm_param_crop_trajectory_t *p_trajectory )
+{
+    crop_trajectory_t *p_traj = NULL;
+    crop_cfg_cache_t *p_cache = NULL;
+    crop_trajectory_t staged;
+    crop_trajectory_t path;
+    crop_cfg_key_t key;
+    uint16_t width = acamera_isp_top_active_width_read( p_fsm->cmn.isp_base );
+    uint16_t height = acamera_isp_top_active_height_read( p_fsm->cmn.isp_base );
+    uint8_t scaler = 0;
+    unsigned long flags;
+    uint32_t i, n;
+
+    switch ( p_trajectory->resize_type ) {
+    case CROP_FR:
+        p_traj = &p_fsm->trajectory_fr;
+        p_cache = &p_fsm->cfg_cache_fr;
+        break;
+#if ISP_HAS_DS1
+    case CROP_DS:
+        p_traj = &p_fsm->trajectory_ds;
+        p_cache = &p_fsm->cfg_cache_ds;
+        scaler = p_fsm->scaler_ds.enable;
+        break;
+#endif
+    default:
+        LOG( LOG_ERR, "Unsupported resize type %d for crop trajectory", p_trajectory->resize_type );
+        return -1;
+    }
+
+    if ( p_trajectory->count == 0 ) {
+        flags = system_spinlock_lock( p_fsm->lock );
+        p_traj->active = 0;
+        system_spinlock_unlock( p_fsm->lock, flags );
+        LOG( LOG_INFO, "Crop trajectory for type %d is stopped", p_trajectory->resize_type );
+        return 0;
+    }
+
+    if ( p_trajectory->count > CROP_TRAJECTORY_MAX_KEYFRAMES || p_trajectory->keyframes == NULL ) {
+        LOG( LOG_ERR, "Crop trajectory supports up to %d keyframes, requested %d", CROP_TRAJECTORY_MAX_KEYFRAMES, p_trajectory->count );
+        return -1;
+    }
+
+    for ( i = 0; i < p_trajectory->count; i++ ) {
+        const acamera_crop_keyframe_t *p_key = &p_trajectory->keyframes[i];
+
+        if ( !crop_keyframe_valid( p_key, i, width, height, scaler ) ) {
+            LOG( LOG_ERR, "Invalid crop keyframe %d: x %d, y %d, w %d, h %d, out w %d, out h %d, frames %d", i, p_key->window.xoffset, p_key->window.yoffset, p_key->window.xsize, p_key->window.ysize, p_key->window.out_xsize, p_key->window.out_ysize, p_key->frames );
+            return -1;
+        }
+    }
+
+    crop_trajectory_load( &staged, p_trajectory->keyframes, p_trajectory->count );
+
+    flags = system_spinlock_lock( p_fsm->lock );
+
+    *p_traj = staged;
+
+    if ( p_trajectory->resize_type == CROP_FR ) {
+        crop_cfg_key_fr( p_fsm, &key );
+    }
+#if ISP_HAS_DS1
+    else {
+        crop_cfg_key_ds( p_fsm, &key );
+    }
+#endif
+
+    system_spinlock_unlock( p_fsm->lock, flags );
+
+    // compute the first frames of the path now, not in the frame path
+    path = staged;
+    for ( i = 0; i < CROP_CFG_CACHE_SIZE && path.active; i += n ) {
+        acamera_crop_window_t windows[CROP_PRELOAD_CHUNK];
+
+        for ( n = 0; n < CROP_PRELOAD_CHUNK && i + n < CROP_CFG_CACHE_SIZE && path.active; n++ ) {
+            crop_trajectory_step( &path, &windows[n] );
+        }
+        crop_cfg_preload_windows( p_fsm, p_cache, &key, windows, n );
+    }
+
+    LOG( LOG_INFO, "Crop trajectory for type %d started with %d keyframes", p_trajectory->resize_type, p_trajectory->count );
+
+    return 0;
+}
+
+// moves every running trajectory one step, returns non zero if the crop changed
+static int crop_trajectory_advance( crop_fsm_ptr_t p_fsm )
+{
+    acamera_crop_window_t window;
+    int moved = 0;
+    unsigned long flags = system_spinlock_lock( p_fsm->lock );
+
+    if ( p_fsm->trajectory_fr.active ) {
+        crop_trajectory_step( &p_fsm->trajectory_fr, &window );
+        p_fsm->crop_fr.enable = 1;
+        p_fsm->crop_fr.xoffset = window.xoffset;
+        p_fsm->crop_fr.yoffset = window.yoffset;
+        p_fsm->crop_fr.xsize = window.xsize;
+        p_fsm->crop_fr.ysize = window.ysize;
+        moved = 1;
+    }
+
+#if ISP_HAS_DS1
+    if ( p_fsm->trajectory_ds.active ) {
+        crop_trajectory_step( &p_fsm->trajectory_ds, &window );
+        p_fsm->crop_ds.enable = 1;
+        p_fsm->crop_ds.xoffset = window.xoffset;
+        p_fsm->crop_ds.yoffset = window.yoffset;
+        p_fsm->crop_ds.xsize = window.xsize;
+        p_fsm->crop_ds.ysize = window.ysize;
+        if ( p_fsm->scaler_ds.enable ) {
+            p_fsm->scaler_ds.xsize = window.out_xsize;
+            p_fsm->scaler_ds.ysize = window.out_ysize;
+        }
+        moved = 1;
+    }
+#endif
+
+    system_spinlock_unlock( p_fsm->lock, flags );
+
+    return moved;
+}
+
 void crop_fsm_process_interrupt( crop_fsm_const_ptr_t p_fsm, uint8_t irq_event )
 {
     if ( acamera_fsm_util_is_irq_event_ignored( (fsm_irq_mask_t *)( &p_fsm->mask ), irq_event ) )
         return;
 
     int no_log_in_isr = 1;
+
+    // frame start comes before the frame writer interrupts of the same frame
+    if ( irq_event == ACAMERA_IRQ_FRAME_START ) {
+        if ( crop_trajectory_advance( (crop_fsm_ptr_t)p_fsm ) ) {
+            ( (crop_fsm_ptr_t)p_fsm )->need_updating = 1;
+        }
+        return;
+    }
+
     if ( p_fsm->need_updating ) {
         LOG( LOG_INFO, "_update_ds from crop_fsm_process_interrupt irq_event:%d", irq_event );
         switch ( irq_event ) {
@@ -244,12 +472,15 @@ void crop_resolution_changed( crop_fsm_ptr_t p_fsm )
 #if ISP_HAS_DS1
     LOG( LOG_INFO, "_update_ds from crop_resolution_changed" );
     _update_ds( p_fsm, 0 );
+    LOG( LOG_DEBUG, "DS config cache: hits %u, misses %u", (unsigned int)p_fsm->cfg_cache_ds.hits, (unsigned int)p_fsm->cfg_cache_ds.misses );
 #endif
+    LOG( LOG_DEBUG, "FR config cache: hits %u, misses %u", (unsigned int)p_fsm->cfg_cache_fr.hits, (unsigned int)p_fsm->cfg_cache_fr.misses );
     fsm_raise_event( p_fsm, event_id_crop_updated );
 }
 
 void crop_initialize( crop_fsm_ptr_t p_fsm )
 {
+    unsigned long flags;
 #if ISP_HAS_DS1
     int i;
 #endif
@@ -292,6 +523,15 @@ void crop_initialize( crop_fsm_ptr_t p_fsm )
 
 #endif //FW_DO_INITIALIZATION
 
+    flags = system_spinlock_lock( p_fsm->lock );
+    crop_cfg_cache_reset( &p_fsm->cfg_cache_fr );
+    p_fsm->trajectory_fr.active = 0;
+#if ISP_HAS_DS1
+    crop_cfg_cache_reset( &p_fsm->cfg_cache_ds );
+    p_fsm->trajectory_ds.active = 0;
+#endif
+    system_spinlock_unlock( p_fsm->lock, flags );
+
     p_fsm->resize_type = 0;
 #if ( ISP_HAS_DS1 ) && defined( SCALER )
     p_fsm->resize_type = SCALER;
@@ -319,6 +559,7 @@ void crop_initialize( crop_fsm_ptr_t p_fsm )
 
     // Called once at boot up
     p_fsm->mask.repeat_irq_mask = 0;
+    p_fsm->mask.repeat_irq_mask |= ACAMERA_IRQ_MASK( ACAMERA_IRQ_FRAME_START );
     p_fsm->mask.repeat_irq_mask |= ACAMERA_IRQ_MASK( ACAMERA_IRQ_FRAME_WRITER_FR );
 #if ISP_HAS_DS1
     p_fsm->mask.repeat_irq_mask |= ACAMERA_IRQ_MASK( ACAMERA_IRQ_FRAME_WRITER_DS );
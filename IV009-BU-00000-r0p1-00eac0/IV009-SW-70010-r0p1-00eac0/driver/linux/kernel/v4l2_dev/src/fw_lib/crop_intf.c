@@ -43,7 +43,7 @@ fsm_common_t *crop_get_fsm_common( uint8_t ctx_id )
     p_fsm_ctx->cmn.p_fsm = (void *)p_fsm_ctx;
 
     p_fsm_ctx->cmn.ops.init = crop_fsm_init;
-    p_fsm_ctx->cmn.ops.deinit = NULL;
+    p_fsm_ctx->cmn.ops.deinit = crop_fsm_deinit;
     p_fsm_ctx->cmn.ops.run = NULL;
     p_fsm_ctx->cmn.ops.get_param = crop_fsm_get_param;
     p_fsm_ctx->cmn.ops.set_param = crop_fsm_set_param;
@@ -247,7 +247,6 @@ static int dma_writer_configure_pipe( dma_pipe *pipe )
     tframe_t *delay_frame = &pipe->settings.delay_frame;
     dma_writer_reg_ops_t *primary_ops = &pipe->primary;
     dma_writer_reg_ops_t *secondary_ops = &pipe->secondary;
-    int rc;
 
     if ( !p_ctx ) {
         LOG( LOG_ERR, "No context available." );
@@ -272,9 +271,19 @@ static int dma_writer_configure_pipe( dma_pipe *pipe )
     /* delay_frame is the last current frame written in the software config */
     *delay_frame = *curr_frame;
 
-    /* try to get a new buffer from application (V4l2 for example) */
-    rc = dma_writer_stream_get_frame( pipe, curr_frame );
-    if ( rc ) {
+    /* the sensor outputs corrupted frames right after a mode switch */
+    if ( pipe->settings.mode_switches != p_ctx->sensor_mode_switches ) {
+        pipe->settings.mode_switches = p_ctx->sensor_mode_switches;
+        pipe->settings.frames_to_drop = p_ctx->sensor_switch_skip_frames;
+    }
+    if ( pipe->settings.frames_to_drop ) {
+        pipe->settings.frames_to_drop--;
+        pipe->settings.frames_dropped++;
+        curr_frame->primary.status = dma_buf_purge;
+        curr_frame->secondary.status = dma_buf_purge;
+    } else if ( dma_writer_stream_get_frame( pipe, curr_frame ) ) {
+        /* no new buffer from the application (V4l2 for example) */
+        pipe->settings.frames_fallback++;
 #if CONFIG_DMA_WRITER_DEFAULT_BUFFER
         /* if there is no available buffer, use one of the default buffers */
         *curr_frame = pipe->settings.default_frame[pipe->settings.default_index];
@@ -284,6 +293,7 @@ static int dma_writer_configure_pipe( dma_pipe *pipe )
         curr_frame->secondary.status = dma_buf_purge;
 #endif
     } else {
+        pipe->settings.frames_written++;
         if ( curr_frame->primary.status == dma_buf_empty )
             curr_frame->primary.status = dma_buf_busy;
         if ( curr_frame->secondary.status == dma_buf_empty )
@@ -319,11 +329,24 @@ dma_error dma_writer_create( void **handle )
     return result;
 }
 
+static void dma_writer_report_stats( dma_pipe *pipe )
+{
+    if ( pipe->settings.frames_written || pipe->settings.frames_fallback || pipe->settings.frames_dropped )
+        LOG( LOG_NOTICE, "dma pipe %d: %u frames written, %u frames without a buffer, %u frames dropped after mode switches",
+             (int)pipe->type, (unsigned int)pipe->settings.frames_written, (unsigned int)pipe->settings.frames_fallback,
+             (unsigned int)pipe->settings.frames_dropped );
+}
+
 void dma_writer_exit( void *handle )
 {
-#if CONFIG_DMA_WRITER_DEFAULT_BUFFER
     dma_handle *p_dma = (dma_handle *)handle;
 
+    dma_writer_report_stats( &p_dma->pipe[dma_fr] );
+#if ISP_HAS_DS1
+    dma_writer_report_stats( &p_dma->pipe[dma_ds1] );
+#endif
+
+#if CONFIG_DMA_WRITER_DEFAULT_BUFFER
     dma_writer_free_default_frame( &p_dma->pipe[dma_fr] );
 #if ISP_HAS_DS1
     dma_writer_free_default_frame( &p_dma->pipe[dma_ds1] );
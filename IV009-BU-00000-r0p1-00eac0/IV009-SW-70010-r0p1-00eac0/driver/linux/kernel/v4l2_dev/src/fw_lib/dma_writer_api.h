@@ -116,6 +116,13 @@ typedef struct dma_pipe_settings {
     uint32_t ctx_id;
     uint8_t pause;
     struct _acamera_context_t *p_ctx;
+
+    uint32_t frames_written;  // frames written into application buffers
+    uint32_t frames_fallback; // frames with no application buffer
+    uint32_t frames_dropped;  // frames dropped while the sensor settles after a mode switch
+
+    uint32_t mode_switches;   // last sensor mode switch seen by the pipe
+    uint32_t frames_to_drop;  // frames still to drop after that switch
 } dma_pipe_settings;
 
 
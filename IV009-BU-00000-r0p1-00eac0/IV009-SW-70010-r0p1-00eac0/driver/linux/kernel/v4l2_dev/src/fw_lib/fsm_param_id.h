@@ -48,6 +48,8 @@ typedef enum {
     /* CROP */
     FSM_PARAM_SET_CROP_START,
     FSM_PARAM_SET_CROP_SETTING,
+    FSM_PARAM_SET_CROP_PRELOAD,
+    FSM_PARAM_SET_CROP_TRAJECTORY,
     FSM_PARAM_SET_CROP_END,
 
     /* GENERAL */
@@ -104,6 +106,7 @@ typedef enum {
     FSM_PARAM_SET_MATRIX_YUV_BRIGHTNESS_STRENGTH,
     FSM_PARAM_SET_MATRIX_YUV_CONTRAST_STRENGTH,
     FSM_PARAM_SET_MATRIX_YUV_COLOR_MODE,
+    FSM_PARAM_SET_MATRIX_YUV_UPDATE,
     FSM_PARAM_SET_MATRIX_YUV_END,
 
     /* GAMMA_MANUAL */
@@ -218,6 +221,7 @@ typedef enum {
     FSM_PARAM_GET_COLOR_MATRIX_START,
     FSM_PARAM_GET_CCM_INFO,
     FSM_PARAM_GET_SHADING_ALPHA,
+    FSM_PARAM_GET_COLOR_MATRIX_REUSE_STATS,
     FSM_PARAM_GET_COLOR_MATRIX_END,
 
     /* IRIDIX */
@@ -239,6 +243,7 @@ typedef enum {
     FSM_PARAM_GET_MATRIX_YUV_BRIGHTNESS_STRENGTH,
     FSM_PARAM_GET_MATRIX_YUV_CONTRAST_STRENGTH,
     FSM_PARAM_GET_MATRIX_YUV_COLOR_MODE,
+    FSM_PARAM_GET_MATRIX_YUV_REUSE_STATS,
     FSM_PARAM_GET_MATRIX_YUV_END,
 
     /* MONITOR */
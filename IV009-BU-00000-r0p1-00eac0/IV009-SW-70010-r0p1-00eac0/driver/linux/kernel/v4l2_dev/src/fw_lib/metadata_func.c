@@ -103,6 +103,10 @@ void metadata_update_meta( metadata_fsm_t *p_fsm )
 
     LOG( LOG_DEBUG, "updating metadata ( isp_base = 0x%x)", isp_base );
 
+    // the register outputs of this event pass are still in the script, the
+    // registers read back below must hold the values of this frame
+    acamera_reg_script_apply( &p_ctx->reg_script, isp_base );
+
     // Frame counter
     md->frame_id = ACAMERA_FSM2CTX_PTR( p_fsm )->isp_frame_counter;
 
@@ -49,6 +49,11 @@ void noise_reduction_fsm_init( void *fsm, fsm_init_param_t *init_param )
 
     noise_reduction_fsm_clear( p_fsm );
 
+#if ISP_HAS_SINTER_RADIAL_LUT
+    // the radial parameters are read by index
+    acamera_calibrations_require( ACAMERA_FSM2CTX_PTR( p_fsm ), CALIBRATION_SINTER_RADIAL_PARAMS, 4 * sizeof( uint16_t ) );
+#endif
+
     noise_reduction_initialize( p_fsm );
     noise_reduction_hw_init( p_fsm );
 }
@@ -31,6 +31,8 @@
 #include "sbuf_fsm.h"
 #include "acamera_firmware_settings.h"
 
+extern uint32_t get_calibrations_size_v4l2( uint32_t ctx_id, void *sensor_arg );
+
 
 #ifdef LOG_MODULE
 #undef LOG_MODULE
@@ -78,6 +80,10 @@ struct sbuf_mgr {
     void *buf_allocated;
     void *buf_used;
 
+    /* calibration data region which follows struct fw_sbuf */
+    uint32_t cali_offset;
+    uint32_t cali_size;
+
     uint32_t cur_wdr_mode;
 
     struct fw_sbuf *sbuf_base;
@@ -133,7 +139,9 @@ struct sbuf_context {
     wait_queue_head_t idx_set_wait_queue;
 };
 
-static struct sbuf_context sbuf_contexts[FIRMWARE_CONTEXT_NUMBER];
+/* allocated for the contexts in use by the first sbuf FSM, freed by the last one */
+static struct sbuf_context *sbuf_contexts;
+static uint32_t sbuf_contexts_ref;
 
 static int is_sbuf_inited( struct sbuf_mgr *p_sbuf_mgr )
 {
@@ -147,7 +155,7 @@ static int is_sbuf_inited( struct sbuf_mgr *p_sbuf_mgr )
     return tmp_inited;
 }
 
-static int sbuf_mgr_alloc_sbuf( struct sbuf_mgr *p_sbuf_mgr )
+static int sbuf_mgr_alloc_sbuf( struct sbuf_mgr *p_sbuf_mgr, uint32_t cali_size )
 {
     int i;
 
@@ -156,8 +164,10 @@ static int sbuf_mgr_alloc_sbuf( struct sbuf_mgr *p_sbuf_mgr )
         return -1;
     }
 
-    /* round up to whole number of pages  */
-    p_sbuf_mgr->len_used = ( sizeof( struct fw_sbuf ) + 1 + PAGE_SIZE ) & PAGE_MASK;
+    /* round up to whole number of pages, the calibration data gets the rest of the last page */
+    p_sbuf_mgr->cali_offset = ALIGN( sizeof( struct fw_sbuf ), sizeof( uint64_t ) );
+    p_sbuf_mgr->len_used = PAGE_ALIGN( p_sbuf_mgr->cali_offset + cali_size );
+    p_sbuf_mgr->cali_size = p_sbuf_mgr->len_used - p_sbuf_mgr->cali_offset;
 
     /* allocate one more page for user-sapce mapping */
     p_sbuf_mgr->len_allocated = p_sbuf_mgr->len_used - 1 + PAGE_SIZE;
@@ -171,8 +181,8 @@ static int sbuf_mgr_alloc_sbuf( struct sbuf_mgr *p_sbuf_mgr )
     /* make the used buffer page aligned  */
     p_sbuf_mgr->buf_used = (void *)( ( (unsigned long)p_sbuf_mgr->buf_allocated + PAGE_SIZE - 1 ) & PAGE_MASK );
 
-    LOG( LOG_NOTICE, "sbuf: len_needed: %zu, len_alloc: %u, len_used: %u, page_size: %lu, buf_alloc: %p, buf_used: %p.",
-         sizeof( struct fw_sbuf ), p_sbuf_mgr->len_allocated, p_sbuf_mgr->len_used, PAGE_SIZE, p_sbuf_mgr->buf_allocated, p_sbuf_mgr->buf_used );
+    LOG( LOG_NOTICE, "sbuf: len_needed: %zu, cali_size: %u, len_alloc: %u, len_used: %u, page_size: %lu, buf_alloc: %p, buf_used: %p.",
+         sizeof( struct fw_sbuf ), p_sbuf_mgr->cali_size, p_sbuf_mgr->len_allocated, p_sbuf_mgr->len_used, PAGE_SIZE, p_sbuf_mgr->buf_allocated, p_sbuf_mgr->buf_used );
 
     /* set the page as reserved so that it won't be swapped out */
     for ( i = 0; i < p_sbuf_mgr->len_used; i += PAGE_SIZE ) {
@@ -190,6 +200,8 @@ static void sbuf_mgr_init_sbuf( struct sbuf_mgr *p_sbuf_mgr )
     spin_lock_irqsave( &p_sbuf_mgr->sbuf_lock, irq_flags );
     p_sbuf_mgr->sbuf_inited = 1;
     p_sbuf_mgr->sbuf_base = (struct fw_sbuf *)p_sbuf_mgr->buf_used;
+    p_sbuf_mgr->sbuf_base->kf_info.cali_info.data_offset = p_sbuf_mgr->cali_offset;
+    p_sbuf_mgr->sbuf_base->kf_info.cali_info.data_size = p_sbuf_mgr->cali_size;
     p_sbuf_mgr->cur_wdr_mode = 0xFFFF; // Invalid
 
 #if defined( ISP_HAS_AE_MANUAL_FSM )
@@ -281,14 +293,14 @@ static void sbuf_mgr_init_sbuf( struct sbuf_mgr *p_sbuf_mgr )
     spin_unlock_irqrestore( &p_sbuf_mgr->sbuf_lock, irq_flags );
 }
 
-static int sbuf_mgr_init( struct sbuf_mgr *p_sbuf_mgr )
+static int sbuf_mgr_init( struct sbuf_mgr *p_sbuf_mgr, uint32_t cali_size )
 {
     int rc;
 
     p_sbuf_mgr->sbuf_inited = 0;
     spin_lock_init( &( p_sbuf_mgr->sbuf_lock ) );
 
-    rc = sbuf_mgr_alloc_sbuf( p_sbuf_mgr );
+    rc = sbuf_mgr_alloc_sbuf( p_sbuf_mgr, cali_size );
     if ( rc ) {
         LOG( LOG_ERR, "sbuf_mgr alloc buffer failed, ret: %d.", rc );
         return rc;
@@ -299,6 +311,39 @@ static int sbuf_mgr_init( struct sbuf_mgr *p_sbuf_mgr )
     return 0;
 }
 
+static int sbuf_mgr_free( struct sbuf_mgr *p_sbuf_mgr )
+{
+    unsigned long irq_flags;
+
+    if ( !is_sbuf_inited( p_sbuf_mgr ) ) {
+        LOG( LOG_ERR, "Error: sbuf alloc is not inited, can't free." );
+        return -ENOMEM;
+    }
+
+    /* set the flag before we free in case sb use it after free but before flag is clear. */
+    spin_lock_irqsave( &p_sbuf_mgr->sbuf_lock, irq_flags );
+    p_sbuf_mgr->sbuf_inited = 0;
+    spin_unlock_irqrestore( &p_sbuf_mgr->sbuf_lock, irq_flags );
+
+    LOG( LOG_INFO, "prepare to free buffer %p.", p_sbuf_mgr->buf_allocated );
+    if ( p_sbuf_mgr->buf_allocated ) {
+        int i;
+        /* clear the reserved flag before free so that no bug showed when freeed */
+        for ( i = 0; i < p_sbuf_mgr->len_used; i += PAGE_SIZE ) {
+            ClearPageReserved( virt_to_page( p_sbuf_mgr->buf_used + i ) );
+        }
+
+        kfree( p_sbuf_mgr->buf_allocated );
+        LOG( LOG_INFO, "sbuf alloc buffer %p is freed.", p_sbuf_mgr->buf_allocated );
+        p_sbuf_mgr->buf_allocated = NULL;
+        p_sbuf_mgr->buf_used = NULL;
+    } else {
+        LOG( LOG_ERR, "Error: sbuf allocated memory is NULL." );
+    }
+
+    return 0;
+}
+
 #define _GET_LUT_SIZE( lut ) ( lut->rows * lut->cols * lut->width )
 
 static uint32_t get_cur_calibration_total_size( void *fw_instance )
@@ -326,6 +371,34 @@ static uint32_t get_cur_calibration_total_size( void *fw_instance )
     return result;
 }
 
+// largest calibration set of the sensor modes, the current set counts when a mode can't be queried
+static uint32_t get_max_calibration_total_size( struct sbuf_context *p_ctx, uint32_t cur_size )
+{
+    const sensor_param_t *param = NULL;
+    uint32_t result = cur_size;
+    uint32_t idx;
+
+    acamera_fsm_mgr_get_param( p_ctx->p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_SENSOR_PARAM, NULL, 0, &param, sizeof( param ) );
+
+    if ( param ) {
+        for ( idx = 0; idx < param->modes_num; idx++ ) {
+            uint32_t size = get_calibrations_size_v4l2( p_ctx->fw_id, (void *)&param->modes_table[idx] );
+
+            LOG( LOG_INFO, "Sensor_mode[%d]: wdr_mode: %d, calibration size: %u.", idx, param->modes_table[idx].wdr_mode, size );
+            if ( size > result ) {
+                result = size;
+            }
+        }
+    }
+
+    if ( result > ISP_MAX_CALIBRATION_DATA_SIZE ) {
+        LOG( LOG_WARNING, "Largest calibration set of %u bytes is limited to %u bytes.", result, ISP_MAX_CALIBRATION_DATA_SIZE );
+        result = ISP_MAX_CALIBRATION_DATA_SIZE;
+    }
+
+    return result;
+}
+
 /*
     sbuf calibration memory layout: N is CALIBRATION_TOTAL_SIZE
 
@@ -354,7 +427,7 @@ static int update_cur_calibration_to_sbuf( void *fw_instance, struct sbuf_mgr *p
     uint32_t lut_size = 0;
     LookupTable *p_lut = NULL;
 
-    uint8_t *sbuf_cali_base = (uint8_t *)&p_sbuf_mgr->sbuf_base->kf_info.cali_info.cali_data;
+    uint8_t *sbuf_cali_base = (uint8_t *)p_sbuf_mgr->sbuf_base + p_sbuf_mgr->cali_offset;
     struct sbuf_lookup_table *p_sbuf_lut_arr = (struct sbuf_lookup_table *)sbuf_cali_base;
     uint8_t *p_sbuf_cali_data = sbuf_cali_base + sizeof( struct sbuf_lookup_table ) * CALIBRATION_TOTAL_SIZE;
 
@@ -443,6 +516,31 @@ static uint8_t sbuf_calibration_is_ready_to_update( struct sbuf_context *p_ctx )
     return rc;
 }
 
+// The sbuf is sized for the largest calibration set of the sensor modes, so
+// a wdr mode switch after UF mapped it finds room for its set. It can only be
+// replaced while UF has not mapped it.
+static int sbuf_calibration_resize( struct sbuf_context *p_ctx, uint32_t cali_size )
+{
+    int rc;
+
+    mutex_lock( &p_ctx->fops_lock );
+
+    if ( p_ctx->dev_opened ) {
+        LOG( LOG_CRIT, "Error: calibration data of %u bytes doesn't fit the %u bytes mapped by UF.", cali_size, p_ctx->sbuf_mgr.cali_size );
+        rc = -1;
+    } else {
+        if ( is_sbuf_inited( &p_ctx->sbuf_mgr ) ) {
+            sbuf_mgr_free( &p_ctx->sbuf_mgr );
+        }
+
+        rc = sbuf_mgr_init( &p_ctx->sbuf_mgr, cali_size );
+    }
+
+    mutex_unlock( &p_ctx->fops_lock );
+
+    return rc;
+}
+
 static int sbuf_calibration_init( struct sbuf_context *p_ctx )
 {
     int rc = 0;
@@ -455,7 +553,7 @@ static int sbuf_calibration_init( struct sbuf_context *p_ctx )
 
     acamera_fsm_mgr_get_param( p_ctx->p_fsm->cmn.p_fsm_mgr, FSM_PARAM_GET_WDR_MODE, NULL, 0, &wdr_mode, sizeof( wdr_mode ) );
 
-    if ( wdr_mode == p_ctx->sbuf_mgr.cur_wdr_mode ) {
+    if ( is_sbuf_inited( &p_ctx->sbuf_mgr ) && wdr_mode == p_ctx->sbuf_mgr.cur_wdr_mode ) {
         LOG( LOG_INFO, "same wdr_mode, already inited, return." );
         return 0;
     }
@@ -471,6 +569,14 @@ static int sbuf_calibration_init( struct sbuf_context *p_ctx )
         return -1;
     }
 
+    if ( !is_sbuf_inited( &p_ctx->sbuf_mgr ) || cali_total_size > p_ctx->sbuf_mgr.cali_size ) {
+        rc = sbuf_calibration_resize( p_ctx, get_max_calibration_total_size( p_ctx, cali_total_size ) );
+        if ( rc ) {
+            p_ctx->p_fsm->is_paused = 0;
+            return rc;
+        }
+    }
+
     while ( !sbuf_calibration_is_ready_to_update( p_ctx ) ) {
         LOG( LOG_NOTICE, "wait for UF to finish using" );
         // sleep 3 ms
@@ -521,13 +627,7 @@ static int sbuf_ctx_init( struct sbuf_context *p_ctx )
 {
     int rc;
 
-    rc = sbuf_mgr_init( &p_ctx->sbuf_mgr );
-    if ( rc ) {
-        LOG( LOG_ERR, "init failed, error: sbuf_mgr init failed, ret: %d.", rc );
-
-        return rc;
-    }
-
+    // sbuf is allocated by the calibration init, its size depends on the calibration set
     rc = sbuf_calibration_init( p_ctx );
     if ( rc ) {
         LOG( LOG_ERR, "init failed, error: calibration init failed, ret: %d.", rc );
@@ -647,39 +747,6 @@ static void sbuf_mgr_reset( struct sbuf_mgr *p_sbuf_mgr )
     spin_unlock_irqrestore( &p_sbuf_mgr->sbuf_lock, irq_flags );
 }
 
-static int sbuf_mgr_free( struct sbuf_mgr *p_sbuf_mgr )
-{
-    unsigned long irq_flags;
-
-    if ( !is_sbuf_inited( p_sbuf_mgr ) ) {
-        LOG( LOG_ERR, "Error: sbuf alloc is not inited, can't free." );
-        return -ENOMEM;
-    }
-
-    /* set the flag before we free in case sb use it after free but before flag is clear. */
-    spin_lock_irqsave( &p_sbuf_mgr->sbuf_lock, irq_flags );
-    p_sbuf_mgr->sbuf_inited = 0;
-    spin_unlock_irqrestore( &p_sbuf_mgr->sbuf_lock, irq_flags );
-
-    LOG( LOG_INFO, "prepare to free buffer %p.", p_sbuf_mgr->buf_allocated );
-    if ( p_sbuf_mgr->buf_allocated ) {
-        int i;
-        /* clear the reserved flag before free so that no bug showed when freeed */
-        for ( i = 0; i < p_sbuf_mgr->len_used; i += PAGE_SIZE ) {
-            ClearPageReserved( virt_to_page( p_sbuf_mgr->buf_used + i ) );
-        }
-
-        kfree( p_sbuf_mgr->buf_allocated );
-        LOG( LOG_INFO, "sbuf alloc buffer %p is freed.", p_sbuf_mgr->buf_allocated );
-        p_sbuf_mgr->buf_allocated = NULL;
-        p_sbuf_mgr->buf_used = NULL;
-    } else {
-        LOG( LOG_ERR, "Error: sbuf allocated memory is NULL." );
-    }
-
-    return 0;
-}
-
 /* function will be called when this FSM received ae_stats_data_ready event */
 void sbuf_update_ae_idx( sbuf_fsm_t *p_fsm )
 {
@@ -1402,6 +1469,11 @@ int sbuf_get_item( int fw_id, struct sbuf_item *item )
 
     LOG( LOG_DEBUG, "fw_id: %d.", fw_id );
 
+    if ( !sbuf_contexts ) {
+        LOG( LOG_ERR, "Error: sbuf contexts are not allocated, can't get_item." );
+        return -ENOMEM;
+    }
+
     p_sbuf_mgr = &( sbuf_contexts[fw_id].sbuf_mgr );
     if ( !is_sbuf_inited( p_sbuf_mgr ) ) {
         LOG( LOG_ERR, "Error: sbuf is not inited, can't get_item." );
@@ -1464,6 +1536,11 @@ int sbuf_set_item( int fw_id, struct sbuf_item *item )
 
     LOG( LOG_DEBUG, "fw_id: %d.", fw_id );
 
+    if ( !sbuf_contexts ) {
+        LOG( LOG_ERR, "Error: sbuf contexts are not allocated, can't set_item." );
+        return -ENOMEM;
+    }
+
     p_sbuf_mgr = &( sbuf_contexts[fw_id].sbuf_mgr );
     if ( !is_sbuf_inited( p_sbuf_mgr ) ) {
         LOG( LOG_ERR, "Error: sbuf is not inited, can't set_item." );
@@ -1690,22 +1767,20 @@ static int sbuf_fops_mmap( struct file *file, struct vm_area_struct *vma )
 
     LOG( LOG_INFO, "User app want to get %ld bytes.", user_buf_len );
 
-    /*
-     * the user_buf_len will be page aligned even struct fw_sbuf is not
-     * page aligned, in this case, the size maybe unmatched, but the
-     * delta should not exceed 1 page
-     */
-    if ( ( user_buf_len != sizeof( struct fw_sbuf ) ) &&
-         ( user_buf_len - sizeof( struct fw_sbuf ) >= PAGE_SIZE ) ) {
-        LOG( LOG_ERR, "Not matched buf size, User app size: %ld, kernel sbuf size: %zu.", user_buf_len, sizeof( struct fw_sbuf ) );
-        return -EINVAL;
-    }
-
     if ( !is_sbuf_inited( p_sbuf_mgr ) ) {
         LOG( LOG_ERR, "Error: sbuf is not inited, can't map." );
         return -ENOMEM;
     }
 
+    /*
+     * UF maps struct fw_sbuf first to learn where the calibration data
+     * ends, then the whole buffer, the length is page aligned by mmap.
+     */
+    if ( ( user_buf_len < sizeof( struct fw_sbuf ) ) || ( user_buf_len > p_sbuf_mgr->len_used ) ) {
+        LOG( LOG_ERR, "Not matched buf size, User app size: %ld, kernel sbuf size: %zu - %u.", user_buf_len, sizeof( struct fw_sbuf ), p_sbuf_mgr->len_used );
+        return -EINVAL;
+    }
+
     /* remap the kernel buffer into the user app address space. */
     rc = remap_pfn_range( vma, vma->vm_start, virt_to_phys( p_sbuf_mgr->buf_used ) >> PAGE_SHIFT, user_buf_len, vma->vm_page_prot );
     if ( rc < 0 ) {
@@ -1784,8 +1859,20 @@ void sbuf_fsm_initialize( sbuf_fsm_t *p_fsm )
         return;
     }
 
+    if ( !sbuf_contexts ) {
+        sbuf_contexts = kcalloc( acamera_get_context_number(), sizeof( struct sbuf_context ), GFP_KERNEL );
+        if ( !sbuf_contexts ) {
+            LOG( LOG_CRIT, "Fatal error: alloc %d sbuf contexts failed.", acamera_get_context_number() );
+            return;
+        }
+    }
+    sbuf_contexts_ref++;
+
     p_ctx = &( sbuf_contexts[fw_id] );
     memset( p_ctx, 0, sizeof( *p_ctx ) );
+    mutex_init( &p_ctx->fops_lock );
+    mutex_init( &p_ctx->idx_set_lock );
+    init_waitqueue_head( &p_ctx->idx_set_wait_queue );
     p_dev = &p_ctx->sbuf_dev;
     snprintf( p_ctx->dev_name, SBUF_DEV_NAME_LEN, SBUF_DEV_FORMAT, fw_id );
     p_dev->name = p_ctx->dev_name;
@@ -1825,30 +1912,20 @@ void sbuf_fsm_initialize( sbuf_fsm_t *p_fsm )
         return;
     }
 
-    mutex_init( &p_ctx->fops_lock );
-    mutex_init( &p_ctx->idx_set_lock );
-    init_waitqueue_head( &p_ctx->idx_set_wait_queue );
-
     LOG( LOG_INFO, "sbuf FSM init OK, fw_id: %d, name: '%s', minor_id: %d, p_fsm: %p.", p_ctx->fw_id, p_dev->name, p_ctx->dev_minor_id, p_ctx->p_fsm );
+    LOG( LOG_NOTICE, "ctx %d memory: sbuf context %zu bytes, shared buffer %u bytes (fixed part %zu, calibration data %u).",
+         fw_id, sizeof( struct sbuf_context ), p_ctx->sbuf_mgr.len_allocated, sizeof( struct fw_sbuf ), p_ctx->sbuf_mgr.cali_size );
 
     return;
 }
 
-void sbuf_deinit( sbuf_fsm_ptr_t p_fsm )
+static void sbuf_ctx_deinit( struct sbuf_context *p_ctx )
 {
 #if ( LINUX_VERSION_CODE < KERNEL_VERSION( 4, 3, 0 ) )
     int rc;
 #endif
-    uint32_t fw_id = p_fsm->cmn.ctx_id;
-    struct sbuf_context *p_ctx = NULL;
     struct miscdevice *p_dev = NULL;
 
-    p_ctx = &( sbuf_contexts[fw_id] );
-    if ( p_ctx->fw_id != fw_id ) {
-        LOG( LOG_ERR, "Error: ctx_id not match, fsm fw_id: %d, ctx_id: %d.", fw_id, p_ctx->fw_id );
-        return;
-    }
-
     LOG( LOG_INFO, "deinit sbuf_context: fw_id: %d, dev: %s, minor_id: %d.",
          p_ctx->fw_id,
          p_ctx->dev_name,
@@ -1858,7 +1935,7 @@ void sbuf_deinit( sbuf_fsm_ptr_t p_fsm )
 
     p_dev = &p_ctx->sbuf_dev;
     if ( !p_dev->name ) {
-        LOG( LOG_ERR, "skip sbuf[%d] deregister due to NULL name", fw_id );
+        LOG( LOG_ERR, "skip sbuf[%d] deregister due to NULL name", p_ctx->fw_id );
         return;
     }
 
@@ -1873,5 +1950,28 @@ void sbuf_deinit( sbuf_fsm_ptr_t p_fsm )
     }
 #endif
 
-    LOG( LOG_INFO, "sbuf deinit for ctx_id '%d' is done", fw_id );
+    LOG( LOG_INFO, "sbuf deinit for ctx_id '%d' is done", p_ctx->fw_id );
+}
+
+void sbuf_deinit( sbuf_fsm_ptr_t p_fsm )
+{
+    uint32_t fw_id = p_fsm->cmn.ctx_id;
+    struct sbuf_context *p_ctx = NULL;
+
+    if ( !sbuf_contexts || fw_id >= acamera_get_context_number() ) {
+        LOG( LOG_ERR, "Error: no sbuf context for fw_id: %d.", fw_id );
+        return;
+    }
+
+    p_ctx = &( sbuf_contexts[fw_id] );
+    if ( p_ctx->fw_id != fw_id ) {
+        LOG( LOG_ERR, "Error: ctx_id not match, fsm fw_id: %d, ctx_id: %d.", fw_id, p_ctx->fw_id );
+    } else {
+        sbuf_ctx_deinit( p_ctx );
+    }
+
+    if ( sbuf_contexts_ref && --sbuf_contexts_ref == 0 ) {
+        kfree( sbuf_contexts );
+        sbuf_contexts = NULL;
+    }
 }
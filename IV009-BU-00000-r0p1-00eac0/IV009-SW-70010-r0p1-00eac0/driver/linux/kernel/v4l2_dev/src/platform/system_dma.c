@@ -22,6 +22,9 @@
 #include <linux/gfp.h>
 #include <linux/cdev.h>
 #include <linux/slab.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/version.h>
 #include <asm/types.h>
 #include <asm/io.h>
 #include <linux/time.h>
@@ -31,13 +34,31 @@
 
 #define SYSTEM_DMA_TOGGLE_COUNT 2
 #define SYSTEM_DMA_MAX_CHANNEL 2
+#define SYSTEM_DMA_DIRECTION_COUNT 2
+
+// report the transfer latency every this many completed transfers
+#define SYSTEM_DMA_LATENCY_REPORT_PERIOD 1024
+
+//latency from submission (frame start irq) to the completion of the whole transfer
+typedef struct {
+    ktime_t start;
+    uint64_t sum_ns;
+    uint32_t max_ns;
+    uint32_t count;
+} system_dma_latency_t;
 
 #if FW_USE_SYSTEM_DMA
 
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
 #include <asm/dma-mapping.h>
-#include <asm/cacheflush.h>
+
+// reusable descriptors are available from 4.5, older kernels prepare a new descriptor per transfer
+#if ( LINUX_VERSION_CODE >= KERNEL_VERSION( 4, 5, 0 ) )
+#define SYSTEM_DMA_DESC_REUSE 1
+#else
+#define SYSTEM_DMA_DESC_REUSE 0
+#endif
 
 typedef struct {
     //in case scatter and gather is not supported, need more than one channel
@@ -48,10 +69,15 @@ typedef struct {
 
     struct sg_table sg_fwmem_table[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
     unsigned int sg_fwmem_nents[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
+    //fwmem tables are mapped once on setup and only synced around each transfer
+    uint8_t sg_fwmem_mapped[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
 
-    //for flushing
-    fwmem_addr_pair_t *fwmem_pair_flush[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
-    //for callback unmapping
+    //descriptors prepared on the first transfer and resubmitted afterwards
+    uint8_t desc_reuse;
+    struct dma_async_tx_descriptor **tx_desc[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT][SYSTEM_DMA_DIRECTION_COUNT];
+    unsigned int tx_desc_count[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT][SYSTEM_DMA_DIRECTION_COUNT];
+
+    //for callback syncing
     int32_t buff_loc;
     uint32_t direction;
     uint32_t cur_fw_ctx_id;
@@ -61,11 +87,13 @@ typedef struct {
     atomic_t nents_done;
     struct completion comp;
 
+    system_dma_latency_t latency;
+
 } system_dma_device_t;
 
 #else
 
-#include <linux/interrupt.h>
+#include <linux/workqueue.h>
 
 typedef struct {
     void *dev_addr;
@@ -74,10 +102,18 @@ typedef struct {
     void *sys_back_ptr;
 } mem_addr_pair_t;
 
+//one work item per buffer of a context, it keeps the parameters of its own
+//transfer so a later request cannot change them before the copy runs
 typedef struct {
-    struct tasklet_struct m_task;
-    mem_addr_pair_t *mem_data;
-} mem_tasklet_t;
+    struct work_struct work;
+    uint32_t fw_ctx_id;
+    int32_t buff_loc;
+    uint32_t direction;
+    dma_completion_callback complete_func;
+    struct completion comp;
+    ktime_t start;
+    void *sys_back_ptr;
+} mem_work_t;
 
 
 typedef struct {
@@ -88,21 +124,45 @@ typedef struct {
 
     mem_addr_pair_t *mem_addrs[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
 
-    mem_tasklet_t task_list[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT][SYSTEM_DMA_MAX_CHANNEL];
+    //one work item copies all entries of a buffer
+    mem_work_t copy_work[FIRMWARE_CONTEXT_NUMBER][SYSTEM_DMA_TOGGLE_COUNT];
 
-    int32_t buff_loc;
-    uint32_t direction;
-    uint32_t cur_fw_ctx_id;
+    //serialises the submissions and the latency statistics
+    spinlock_t lock;
 
-    //conf synchronization and completion
-    dma_completion_callback complete_func;
-    atomic_t nents_done;
-    struct completion comp;
+    system_dma_latency_t latency;
 
 } system_dma_device_t;
 
 #endif
 
+static void system_dma_latency_report( system_dma_device_t *system_dma_device, int log_level )
+{
+    system_dma_latency_t *latency = &system_dma_device->latency;
+
+    if ( latency->count ) {
+        LOG( log_level, "dma transfers %u latency avg %u ns max %u ns",
+             (unsigned int)latency->count, (unsigned int)div_u64( latency->sum_ns, latency->count ), (unsigned int)latency->max_ns );
+    }
+}
+
+static void system_dma_latency_stop( system_dma_device_t *system_dma_device, ktime_t start )
+{
+    system_dma_latency_t *latency = &system_dma_device->latency;
+    uint32_t delta = (uint32_t)ktime_to_ns( ktime_sub( ktime_get(), start ) );
+
+    latency->sum_ns += delta;
+    latency->count++;
+    if ( delta > latency->max_ns )
+        latency->max_ns = delta;
+
+    if ( ( latency->count % SYSTEM_DMA_LATENCY_REPORT_PERIOD ) == 0 )
+        system_dma_latency_report( system_dma_device, LOG_DEBUG );
+}
+
+#if !FW_USE_SYSTEM_DMA
+static void memcopy_work_func( struct work_struct *work );
+#endif
 
 int32_t system_dma_init( void **ctx )
 {
@@ -131,6 +191,8 @@ int32_t system_dma_init( void **ctx )
             if ( dma_channel != NULL ) {
                 system_dma_device->dma_channel[i] = dma_channel;
             } else {
+                while ( i-- > 0 )
+                    dma_release_channel( system_dma_device->dma_channel[i] );
                 kfree( *ctx );
                 LOG( LOG_CRIT, "Failed to request DMA channel" );
                 return -1;
@@ -141,9 +203,22 @@ int32_t system_dma_init( void **ctx )
             for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ ) {
                 system_dma_device->sg_device_nents[idx][i] = 0;
                 system_dma_device->sg_fwmem_nents[idx][i] = 0;
+                system_dma_device->sg_fwmem_mapped[idx][i] = 0;
             }
         }
 
+        system_dma_device->desc_reuse = 0;
+#if SYSTEM_DMA_DESC_REUSE
+        //descriptors are only kept when every channel can resubmit them
+        system_dma_device->desc_reuse = 1;
+        for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
+            struct dma_slave_caps caps;
+            if ( dma_get_slave_caps( system_dma_device->dma_channel[i], &caps ) || !caps.descriptor_reuse )
+                system_dma_device->desc_reuse = 0;
+        }
+#endif
+        LOG( LOG_INFO, "dma descriptor reuse %s", system_dma_device->desc_reuse ? "enabled" : "disabled" );
+
 #else
         system_dma_device->name = "TSK_DMA";
         for ( idx = 0; idx < FIRMWARE_CONTEXT_NUMBER; idx++ ) {
@@ -152,7 +227,14 @@ int32_t system_dma_init( void **ctx )
                 system_dma_device->sg_fwmem_nents[idx][i] = 0;
                 system_dma_device->mem_addrs[idx][i] = 0;
             }
+            for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ ) {
+                system_dma_device->copy_work[idx][i].fw_ctx_id = idx;
+                system_dma_device->copy_work[idx][i].buff_loc = i;
+                system_dma_device->copy_work[idx][i].sys_back_ptr = system_dma_device;
+                INIT_WORK( &system_dma_device->copy_work[idx][i].work, memcopy_work_func );
+            }
         }
+        spin_lock_init( &system_dma_device->lock );
 #endif
     } else {
         result = -1;
@@ -162,6 +244,78 @@ int32_t system_dma_init( void **ctx )
     return result;
 }
 
+#if FW_USE_SYSTEM_DMA
+static struct device *system_dma_map_dev( system_dma_device_t *system_dma_device )
+{
+    //fwmem tables are mapped for the first channel, all channels come from the same engine
+    return system_dma_device->dma_channel[0]->device->dev;
+}
+
+static void system_dma_free_desc( system_dma_device_t *system_dma_device, uint32_t fw_ctx_id, int32_t buff_loc )
+{
+    int dir;
+
+    for ( dir = 0; dir < SYSTEM_DMA_DIRECTION_COUNT; dir++ ) {
+        struct dma_async_tx_descriptor **tx_desc = system_dma_device->tx_desc[fw_ctx_id][buff_loc][dir];
+
+        if ( !tx_desc )
+            continue;
+
+#if SYSTEM_DMA_DESC_REUSE
+        int i;
+        for ( i = 0; i < system_dma_device->tx_desc_count[fw_ctx_id][buff_loc][dir]; i++ ) {
+            if ( tx_desc[i] )
+                dmaengine_desc_free( tx_desc[i] );
+        }
+#endif
+        kfree( tx_desc );
+        system_dma_device->tx_desc[fw_ctx_id][buff_loc][dir] = NULL;
+        system_dma_device->tx_desc_count[fw_ctx_id][buff_loc][dir] = 0;
+    }
+}
+
+//Descriptor slots are allocated once both tables of a buffer are set, whichever is set last.
+//The descriptors themselves are prepared on the first transfer and kept until a table changes.
+static void system_dma_alloc_desc( system_dma_device_t *system_dma_device, uint32_t fw_ctx_id, int32_t buff_loc )
+{
+    unsigned int nents = system_dma_device->sg_device_nents[fw_ctx_id][buff_loc];
+    int dir;
+
+    if ( !system_dma_device->desc_reuse || !nents || !system_dma_device->sg_fwmem_mapped[fw_ctx_id][buff_loc] ||
+         nents != system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] )
+        return;
+
+    for ( dir = 0; dir < SYSTEM_DMA_DIRECTION_COUNT; dir++ ) {
+        if ( system_dma_device->tx_desc[fw_ctx_id][buff_loc][dir] )
+            continue;
+
+        system_dma_device->tx_desc[fw_ctx_id][buff_loc][dir] = kcalloc( nents, sizeof( struct dma_async_tx_descriptor * ), GFP_KERNEL );
+        if ( system_dma_device->tx_desc[fw_ctx_id][buff_loc][dir] )
+            system_dma_device->tx_desc_count[fw_ctx_id][buff_loc][dir] = nents;
+    }
+}
+
+static void system_dma_release_fwmem( system_dma_device_t *system_dma_device, uint32_t fw_ctx_id, int32_t buff_loc )
+{
+    if ( system_dma_device->sg_fwmem_mapped[fw_ctx_id][buff_loc] ) {
+        dma_unmap_sg( system_dma_map_dev( system_dma_device ), system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc].sgl, system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc], DMA_BIDIRECTIONAL );
+        system_dma_device->sg_fwmem_mapped[fw_ctx_id][buff_loc] = 0;
+    }
+
+    if ( system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] ) {
+        sg_free_table( &system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc] );
+        system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] = 0;
+    }
+}
+
+static void system_dma_release_device( system_dma_device_t *system_dma_device, uint32_t fw_ctx_id, int32_t buff_loc )
+{
+    if ( system_dma_device->sg_device_nents[fw_ctx_id][buff_loc] ) {
+        sg_free_table( &system_dma_device->sg_device_table[fw_ctx_id][buff_loc] );
+        system_dma_device->sg_device_nents[fw_ctx_id][buff_loc] = 0;
+    }
+}
+#endif
 
 int32_t system_dma_destroy( void *ctx )
 {
@@ -172,24 +326,25 @@ int32_t system_dma_destroy( void *ctx )
         system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
 
 #if FW_USE_SYSTEM_DMA
+        //descriptors and mappings belong to the channels, drop them first
+        for ( idx = 0; idx < FIRMWARE_CONTEXT_NUMBER; idx++ ) {
+            for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ ) {
+                system_dma_free_desc( system_dma_device, idx, i );
+                system_dma_release_fwmem( system_dma_device, idx, i );
+                system_dma_release_device( system_dma_device, idx, i );
+            }
+        }
+
         for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
             dma_release_channel( system_dma_device->dma_channel[i] );
         }
 
+#else
         for ( idx = 0; idx < FIRMWARE_CONTEXT_NUMBER; idx++ ) {
-            for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ ) {
-                if ( system_dma_device->sg_device_nents[idx][i] )
-                    sg_free_table( &system_dma_device->sg_device_table[idx][i] );
-
-                if ( system_dma_device->sg_fwmem_nents[idx][i] )
-                    sg_free_table( &system_dma_device->sg_device_table[idx][i] );
-
-                if ( system_dma_device->fwmem_pair_flush[idx][i] )
-                    kfree( system_dma_device->fwmem_pair_flush[idx][i] );
-            }
+            for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ )
+                cancel_work_sync( &system_dma_device->copy_work[idx][i].work );
         }
 
-#else
         for ( idx = 0; idx < FIRMWARE_CONTEXT_NUMBER; idx++ ) {
             for ( i = 0; i < SYSTEM_DMA_TOGGLE_COUNT; i++ ) {
                 if ( system_dma_device->mem_addrs[idx][i] ) {
@@ -202,6 +357,8 @@ int32_t system_dma_destroy( void *ctx )
         }
 #endif
 
+        system_dma_latency_report( system_dma_device, LOG_INFO );
+
         kfree( ctx );
 
     } else {
@@ -210,6 +367,7 @@ int32_t system_dma_destroy( void *ctx )
     return result;
 }
 
+#if FW_USE_SYSTEM_DMA
 static void dma_complete_func( void *ctx )
 {
     LOG( LOG_DEBUG, "\nIRQ completion called" );
@@ -217,6 +375,7 @@ static void dma_complete_func( void *ctx )
 
     unsigned int nents_done = atomic_inc_return( &system_dma_device->nents_done );
     if ( nents_done >= system_dma_device->sg_device_nents[system_dma_device->cur_fw_ctx_id][system_dma_device->buff_loc] ) {
+        system_dma_latency_stop( system_dma_device, system_dma_device->latency.start );
         if ( system_dma_device->complete_func ) {
             system_dma_device->complete_func( ctx );
             LOG( LOG_DEBUG, "async completed on buff:%d dir:%d", system_dma_device->buff_loc, system_dma_device->direction );
@@ -227,7 +386,6 @@ static void dma_complete_func( void *ctx )
     }
 }
 
-#if FW_USE_SYSTEM_DMA
 //sg from here
 int32_t system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t *device_addr_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
 {
@@ -240,6 +398,10 @@ int32_t system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t
 
     struct sg_table *table = &system_dma_device->sg_device_table[fw_ctx_id][buff_loc];
 
+    //prepared descriptors point to the previous addresses
+    system_dma_free_desc( system_dma_device, fw_ctx_id, buff_loc );
+    system_dma_release_device( system_dma_device, fw_ctx_id, buff_loc );
+
     /* Allocate the scatterlist table */
     ret = sg_alloc_table( table, addr_pairs, GFP_KERNEL );
     if ( ret ) {
@@ -255,13 +417,15 @@ int32_t system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t
         sg_dma_len( sg ) = device_addr_pair[i].size;
         sg = sg_next( sg );
     }
+
+    system_dma_alloc_desc( system_dma_device, fw_ctx_id, buff_loc );
+
     LOG( LOG_INFO, "dma device setup success %d", system_dma_device->sg_device_nents[fw_ctx_id][buff_loc] );
     return 0;
 }
 
 int32_t system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_t *fwmem_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
 {
-    //unsigned int nr_pages;
     int i, ret;
     struct scatterlist *sg;
     system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
@@ -272,6 +436,11 @@ int32_t system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_
     }
 
     struct sg_table *table = &system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc];
+
+    //prepared descriptors point to the previous addresses
+    system_dma_free_desc( system_dma_device, fw_ctx_id, buff_loc );
+    system_dma_release_fwmem( system_dma_device, fw_ctx_id, buff_loc );
+
     /* Allocate the scatterlist table */
     ret = sg_alloc_table( table, addr_pairs, GFP_KERNEL );
     if ( ret ) {
@@ -279,21 +448,28 @@ int32_t system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_
         return ret;
     }
     system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] = addr_pairs;
-    system_dma_device->fwmem_pair_flush[fw_ctx_id][buff_loc] = kmalloc( sizeof( fwmem_addr_pair_t ) * addr_pairs, GFP_KERNEL );
-    if ( !system_dma_device->fwmem_pair_flush[fw_ctx_id][buff_loc] ) {
-        LOG( LOG_CRIT, "Failed to allocate virtual address pairs for flushing!!" );
-        return -1;
-    }
-    for ( i = 0; i < addr_pairs; i++ ) {
-        system_dma_device->fwmem_pair_flush[fw_ctx_id][buff_loc][i] = fwmem_pair[i];
-    }
     sg = table->sgl;
     for ( i = 0; i < addr_pairs; i++ ) {
         sg_set_buf( sg, fwmem_pair[i].address, fwmem_pair[i].size );
         sg = sg_next( sg );
     }
 
-    LOG( LOG_INFO, "fwmem setup success %d", system_dma_device->sg_device_nents[fw_ctx_id][buff_loc] );
+    //the same table is used for config and metering in both directions, map it once here
+    //and only sync it around each transfer
+    ret = dma_map_sg( system_dma_map_dev( system_dma_device ), table->sgl, addr_pairs, DMA_BIDIRECTIONAL );
+    if ( ret != addr_pairs ) {
+        LOG( LOG_CRIT, "unable to map %d entries, mapped %d", addr_pairs, ret );
+        if ( ret > 0 )
+            dma_unmap_sg( system_dma_map_dev( system_dma_device ), table->sgl, addr_pairs, DMA_BIDIRECTIONAL );
+        sg_free_table( table );
+        system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] = 0;
+        return -1;
+    }
+    system_dma_device->sg_fwmem_mapped[fw_ctx_id][buff_loc] = 1;
+
+    system_dma_alloc_desc( system_dma_device, fw_ctx_id, buff_loc );
+
+    LOG( LOG_INFO, "fwmem setup success %d", system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc] );
 
     return 0;
 }
@@ -304,13 +480,48 @@ void system_dma_unmap_sg( void *ctx )
         return;
     system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
     int32_t buff_loc = system_dma_device->buff_loc;
-    uint32_t direction = system_dma_device->direction;
     uint32_t cur_fw_ctx_id = system_dma_device->cur_fw_ctx_id;
-    int i;
-    for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
-        struct dma_chan *chan = system_dma_device->dma_channel[i];
-        dma_unmap_sg( chan->device->dev, system_dma_device->sg_fwmem_table[cur_fw_ctx_id][buff_loc].sgl, system_dma_device->sg_fwmem_nents[cur_fw_ctx_id][buff_loc], direction );
+
+    //the table stays mapped, only hand the data read back from the isp over to the cpu
+    if ( system_dma_device->direction == DMA_FROM_DEVICE ) {
+        dma_sync_sg_for_cpu( system_dma_map_dev( system_dma_device ), system_dma_device->sg_fwmem_table[cur_fw_ctx_id][buff_loc].sgl, system_dma_device->sg_fwmem_nents[cur_fw_ctx_id][buff_loc], DMA_FROM_DEVICE );
+    }
+}
+
+//returns the descriptor for one entry, or for the whole list when the engine supports sg.
+//reusable descriptors are prepared on the first transfer and resubmitted as they are afterwards.
+static struct dma_async_tx_descriptor *system_dma_get_desc( system_dma_device_t *system_dma_device, struct dma_chan *chan, uint32_t fw_ctx_id, int32_t buff_loc, uint32_t dir_idx, uint32_t idx, struct scatterlist *dst_sg, struct scatterlist *src_sg, unsigned int nents )
+{
+    struct dma_async_tx_descriptor **tx_desc = system_dma_device->tx_desc[fw_ctx_id][buff_loc][dir_idx];
+    struct dma_async_tx_descriptor *tx = NULL;
+    enum dma_ctrl_flags flags = DMA_CTRL_ACK | DMA_PREP_FENCE | DMA_PREP_INTERRUPT;
+
+    if ( tx_desc && tx_desc[idx] )
+        return tx_desc[idx];
+
+    if ( chan->device->device_prep_dma_sg ) {
+        /* setup the scatterlist to scatterlist transfer */
+        tx = chan->device->device_prep_dma_sg( chan,
+                                               dst_sg, nents,
+                                               src_sg, nents,
+                                               0 );
+    } else {
+        LOG( LOG_DEBUG, "src:0x%llx (%d) to dst:0x%llx (%d)", (unsigned long long)sg_dma_address( src_sg ), sg_dma_len( src_sg ), (unsigned long long)sg_dma_address( dst_sg ), sg_dma_len( dst_sg ) );
+        tx = chan->device->device_prep_dma_memcpy( chan, sg_dma_address( dst_sg ), sg_dma_address( src_sg ), sg_dma_len( src_sg ), flags );
     }
+
+    if ( !tx )
+        return NULL;
+
+    tx->callback = dma_complete_func;
+    tx->callback_param = system_dma_device;
+
+#if SYSTEM_DMA_DESC_REUSE
+    if ( tx_desc && dmaengine_desc_set_reuse( tx ) == 0 )
+        tx_desc[idx] = tx;
+#endif
+
+    return tx;
 }
 
 int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma_completion_callback complete_func, uint32_t fw_ctx_id )
@@ -334,7 +545,7 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
     struct dma_chan *chan = system_dma_device->dma_channel[0]; //probe the first channel
     struct dma_async_tx_descriptor *tx = NULL;
     dma_cookie_t cookie;
-    enum dma_ctrl_flags flags = DMA_CTRL_ACK | DMA_PREP_FENCE | DMA_PREP_INTERRUPT;
+    uint32_t dir_idx;
 
     if ( direction == SYS_DMA_TO_DEVICE ) {
         dst_sg = system_dma_device->sg_device_table[fw_ctx_id][buff_loc].sgl;
@@ -342,42 +553,26 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
         src_sg = system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc].sgl;
         src_nents = system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc];
         direction = DMA_TO_DEVICE;
+        dir_idx = 0;
     } else {
         src_sg = system_dma_device->sg_device_table[fw_ctx_id][buff_loc].sgl;
         src_nents = system_dma_device->sg_device_nents[fw_ctx_id][buff_loc];
         dst_sg = system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc].sgl;
         dst_nents = system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc];
         direction = DMA_FROM_DEVICE;
+        dir_idx = 1;
     }
 
-    if ( src_nents != dst_nents || !src_nents || !dst_nents ) {
+    if ( src_nents != dst_nents || !src_nents || !dst_nents || !system_dma_device->sg_fwmem_mapped[fw_ctx_id][buff_loc] ) {
         LOG( LOG_ERR, "Unbalance src_nents:%d dst_nents:%d", src_nents, dst_nents );
         return -1;
     }
 
-    //flush memory before transfer
-    for ( i = 0; i < src_nents; i++ ) {
-        flush_icache_range( (unsigned long)( system_dma_device->fwmem_pair_flush[fw_ctx_id][buff_loc][i].address ), (unsigned long)( (uintptr_t)system_dma_device->fwmem_pair_flush[fw_ctx_id][buff_loc][i].address + system_dma_device->fwmem_pair_flush[fw_ctx_id][buff_loc][i].size ) );
-    }
-
-    for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
-        chan = system_dma_device->dma_channel[i];
-
-        result = dma_map_sg( chan->device->dev, system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc].sgl, system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc], direction );
-        if ( result <= 0 ) {
-            LOG( LOG_CRIT, "unable to map %d", result );
-            return -1;
-        }
-        LOG( LOG_DEBUG, "src_nents:%d src_sg:%p dst_nents:%d dst_sg:%p dma map res:%d", src_nents, src_sg, dst_nents, dst_sg, result );
-    }
+    //write back the cpu view before a transfer to the isp, drop stale lines before a read back
+    dma_sync_sg_for_device( system_dma_map_dev( system_dma_device ), system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc].sgl, system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc], direction );
 
     system_dma_device->cur_fw_ctx_id = fw_ctx_id;
 
-    /*
-     * All buffers passed to this function should be ready and mapped
-     * for DMA already. Therefore, we don't need to do anything except
-     * submit it to the Freescale DMA Engine for processing
-     */
     atomic_set( &system_dma_device->nents_done, 0 ); //set the number of nents done
     if ( async_dma == 0 ) {
         system_dma_device->complete_func = NULL; //async mode is not allowed to have callback
@@ -388,22 +583,17 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
     system_dma_device->direction = direction;
     system_dma_device->buff_loc = buff_loc;
 
+    system_dma_device->latency.start = ktime_get();
+
     if ( !chan->device->device_prep_dma_sg ) {
         LOG( LOG_DEBUG, "missing device_prep_dma_sg %p %p", chan->device->device_prep_dma_sg, chan->device->device_prep_interleaved_dma );
 
         for ( i = 0; i < src_nents; i++ ) {
 
-            struct dma_chan *chan = system_dma_device->dma_channel[i];
+            chan = system_dma_device->dma_channel[i % SYSTEM_DMA_MAX_CHANNEL];
 
-            uint32_t dst = sg_dma_address( dst_sg );
-            uint32_t src = sg_dma_address( src_sg );
-            uint32_t size_to_copy = sg_dma_len( src_sg );
-            LOG( LOG_DEBUG, "src:0x%x (%d) to dst:0x%x (%d)", src, size_to_copy, dst, sg_dma_len( dst_sg ) );
-
-            tx = chan->device->device_prep_dma_memcpy( chan, dst, src, size_to_copy, flags );
+            tx = system_dma_get_desc( system_dma_device, chan, fw_ctx_id, buff_loc, dir_idx, i, dst_sg, src_sg, 1 );
             if ( tx ) {
-                tx->callback = dma_complete_func;
-                tx->callback_param = ctx;
                 cookie = tx->tx_submit( tx );
                 if ( dma_submit_error( cookie ) ) {
                     LOG( LOG_CRIT, "unable to submit scatterlist DMA\n" );
@@ -414,21 +604,18 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
                 return -ENOMEM;
             }
             dma_async_issue_pending( chan );
-            //}
+
             dst_sg = sg_next( dst_sg );
             src_sg = sg_next( src_sg );
         }
 
     } else {
         chan = system_dma_device->dma_channel[0];
-        /* setup the scatterlist to scatterlist transfer */
-        tx = chan->device->device_prep_dma_sg( chan,
-                                               dst_sg, dst_nents,
-                                               src_sg, src_nents,
-                                               0 );
+
+        atomic_set( &system_dma_device->nents_done, dst_nents - 1 ); //only need to issue once
+
+        tx = system_dma_get_desc( system_dma_device, chan, fw_ctx_id, buff_loc, dir_idx, 0, dst_sg, src_sg, dst_nents );
         if ( tx ) {
-            tx->callback = dma_complete_func;
-            tx->callback_param = ctx;
             cookie = tx->tx_submit( tx );
             if ( dma_submit_error( cookie ) ) {
                 LOG( LOG_CRIT, "unable to submit scatterlist DMA\n" );
@@ -439,7 +626,6 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
             return -ENOMEM;
         }
 
-        atomic_set( &system_dma_device->nents_done, dst_nents - 1 ); //only need to issue once
         dma_async_issue_pending( chan );
     }
 
@@ -447,10 +633,7 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
     if ( async_dma == 0 ) {
         LOG( LOG_DEBUG, "scatterlist DMA waiting completion\n" );
         wait_for_completion( &system_dma_device->comp );
-        for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
-            chan = system_dma_device->dma_channel[i];
-            dma_unmap_sg( chan->device->dev, system_dma_device->sg_fwmem_table[fw_ctx_id][buff_loc].sgl, system_dma_device->sg_fwmem_nents[fw_ctx_id][buff_loc], direction );
-        }
+        system_dma_unmap_sg( ctx );
     }
 
     LOG( LOG_DEBUG, "scatterlist DMA success\n" );
@@ -458,7 +641,6 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
 }
 
 #else
-
 int32_t system_dma_sg_device_setup( void *ctx, int32_t buff_loc, dma_addr_pair_t *device_addr_pair, int32_t addr_pairs, uint32_t fw_ctx_id )
 {
     system_dma_device_t *system_dma_device = (system_dma_device_t *)ctx;
@@ -515,32 +697,47 @@ int32_t system_dma_sg_fwmem_setup( void *ctx, int32_t buff_loc, fwmem_addr_pair_
     return 0;
 }
 
-static void memcopy_func( unsigned long p_task )
+static void memcopy_work_func( struct work_struct *work )
 {
-    mem_tasklet_t *mem_task = (mem_tasklet_t *)p_task;
-    mem_addr_pair_t *mem_addr = (mem_addr_pair_t *)mem_task->mem_data;
-    system_dma_device_t *system_dma_device = (system_dma_device_t *)mem_addr->sys_back_ptr;
-    void *src_mem = 0;
-    void *dst_mem = 0;
+    mem_work_t *mem_work = container_of( work, mem_work_t, work );
+    system_dma_device_t *system_dma_device = (system_dma_device_t *)mem_work->sys_back_ptr;
+    int32_t buff_loc = mem_work->buff_loc;
+    uint32_t direction = mem_work->direction;
+    mem_addr_pair_t *mem_addrs = system_dma_device->mem_addrs[mem_work->fw_ctx_id][buff_loc];
+    unsigned int nents = system_dma_device->sg_device_nents[mem_work->fw_ctx_id][buff_loc];
+    unsigned long flags;
+    int i;
 
-    int32_t buff_loc = system_dma_device->buff_loc;
-    uint32_t direction = system_dma_device->direction;
+    for ( i = 0; i < nents; i++ ) {
+        mem_addr_pair_t *mem_addr = &mem_addrs[i];
+        void *src_mem = 0;
+        void *dst_mem = 0;
 
-    if ( direction == SYS_DMA_TO_DEVICE ) {
-        src_mem = mem_addr->fw_addr;
-        dst_mem = mem_addr->dev_addr;
-    } else {
-        dst_mem = mem_addr->fw_addr;
-        src_mem = mem_addr->dev_addr;
-    }
+        if ( direction == SYS_DMA_TO_DEVICE ) {
+            src_mem = mem_addr->fw_addr;
+            dst_mem = mem_addr->dev_addr;
+        } else {
+            dst_mem = mem_addr->fw_addr;
+            src_mem = mem_addr->dev_addr;
+        }
 
-    memcpy( dst_mem, src_mem, mem_addr->size );
+        memcpy( dst_mem, src_mem, mem_addr->size );
 
-    LOG( LOG_DEBUG, "(%d:%d) d:%p s:%p l:%ld", buff_loc, direction, dst_mem, src_mem, mem_addr->size );
+        LOG( LOG_DEBUG, "(%d:%d) d:%p s:%p l:%ld", buff_loc, direction, dst_mem, src_mem, mem_addr->size );
+    }
 
-    dma_complete_func( mem_addr->sys_back_ptr );
+    spin_lock_irqsave( &system_dma_device->lock, flags );
+    system_dma_latency_stop( system_dma_device, mem_work->start );
+    spin_unlock_irqrestore( &system_dma_device->lock, flags );
 
-    return;
+    //the item may be queued again as soon as the transfer is reported
+    if ( mem_work->complete_func ) {
+        LOG( LOG_DEBUG, "async completed on buff:%d dir:%d", buff_loc, direction );
+        mem_work->complete_func( system_dma_device );
+    } else {
+        LOG( LOG_DEBUG, "sync completed on buff:%d dir:%d", buff_loc, direction );
+        complete( &mem_work->comp );
+    }
 }
 
 void system_dma_unmap_sg( void *ctx )
@@ -550,9 +747,12 @@ void system_dma_unmap_sg( void *ctx )
 
 int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma_completion_callback complete_func, uint32_t fw_ctx_id )
 {
-    int32_t i, result = 0;
-    if ( !ctx ) {
-        LOG( LOG_ERR, "Input ctx pointer is NULL" );
+    int32_t result = 0;
+    mem_work_t *mem_work;
+    unsigned long flags;
+
+    if ( !ctx || buff_loc >= SYSTEM_DMA_TOGGLE_COUNT || fw_ctx_id >= FIRMWARE_CONTEXT_NUMBER ) {
+        LOG( LOG_ERR, "Input ctx pointer is NULL or buffer %d of context %d is out of range", (int)buff_loc, (int)fw_ctx_id );
         return -1;
     }
 
@@ -572,29 +772,35 @@ int32_t system_dma_copy_sg( void *ctx, int32_t buff_loc, uint32_t direction, dma
         return -1;
     }
 
-    system_dma_device->cur_fw_ctx_id = fw_ctx_id;
+    mem_work = &system_dma_device->copy_work[fw_ctx_id][buff_loc];
 
-    atomic_set( &system_dma_device->nents_done, 0 ); //set the number of nents done
-    if ( async_dma == 0 ) {
-        system_dma_device->complete_func = NULL; //async mode is not allowed to have callback
-        init_completion( &system_dma_device->comp );
-    } else {
-        system_dma_device->complete_func = complete_func; //call this function if all nents are done;
+    spin_lock_irqsave( &system_dma_device->lock, flags );
+
+    //a copy which has not started yet still needs its own parameters
+    if ( work_pending( &mem_work->work ) ) {
+        spin_unlock_irqrestore( &system_dma_device->lock, flags );
+        LOG( LOG_ERR, "Copy of buff:%d ctx:%d is still pending, dir:%d is not queued", (int)buff_loc, (int)fw_ctx_id, (int)direction );
+        return -1;
     }
-    system_dma_device->direction = direction;
-    system_dma_device->buff_loc = buff_loc;
 
+    mem_work->direction = direction;
+    mem_work->complete_func = complete_func; //called once all entries are copied, a sync copy waits instead
+    if ( async_dma == 0 )
+        init_completion( &mem_work->comp );
+    mem_work->start = ktime_get();
 
-    for ( i = 0; i < SYSTEM_DMA_MAX_CHANNEL; i++ ) {
-        system_dma_device->task_list[fw_ctx_id][buff_loc][i].mem_data = &( system_dma_device->mem_addrs[fw_ctx_id][buff_loc][i] );
-        system_dma_device->task_list[fw_ctx_id][buff_loc][i].m_task.data = (unsigned long)&system_dma_device->task_list[fw_ctx_id][buff_loc][i];
-        system_dma_device->task_list[fw_ctx_id][buff_loc][i].m_task.func = memcopy_func;
-        tasklet_schedule( &system_dma_device->task_list[fw_ctx_id][buff_loc][i].m_task );
+    //all entries of the buffer are copied by a single work item
+    if ( !queue_work( system_highpri_wq, &mem_work->work ) ) {
+        spin_unlock_irqrestore( &system_dma_device->lock, flags );
+        LOG( LOG_ERR, "Copy of buff:%d ctx:%d could not be queued", (int)buff_loc, (int)fw_ctx_id );
+        return -1;
     }
 
+    spin_unlock_irqrestore( &system_dma_device->lock, flags );
+
     if ( async_dma == 0 ) {
         LOG( LOG_DEBUG, "scatterlist DMA waiting completion\n" );
-        wait_for_completion( &system_dma_device->comp );
+        wait_for_completion( &mem_work->comp );
     }
 
     LOG( LOG_DEBUG, "scatterlist DMA success\n" );
@@ -24,6 +24,9 @@
 static void *p_hw_base = NULL;
 static sys_spinlock reg_lock;
 
+// words accessed under one lock by the block functions, bounds the time with irqs disabled
+#define HW_IO_BLOCK_WORDS 64
+
 int32_t init_hw_io( resource_size_t addr , resource_size_t size )
 {
     p_hw_base = ioremap( addr, size );
@@ -126,3 +129,43 @@ void system_hw_write_8( uintptr_t addr, uint8_t data )
         LOG( LOG_ERR, "Failed to write value %d to memory with offset %d. Base pointer is null ", data, addr );
     }
 }
+
+void system_hw_read_block_32( uintptr_t addr, uint32_t *data, uint32_t count )
+{
+    if ( p_hw_base != NULL ) {
+        void *ptr = (void *)( p_hw_base + addr );
+        while ( count ) {
+            uint32_t cnt = ( count < HW_IO_BLOCK_WORDS ) ? count : HW_IO_BLOCK_WORDS;
+            unsigned long flags;
+            count -= cnt;
+            flags = system_spinlock_lock( reg_lock );
+            while ( cnt-- ) {
+                *data++ = ioread32( ptr );
+                ptr += 4;
+            }
+            system_spinlock_unlock( reg_lock, flags );
+        }
+    } else {
+        LOG( LOG_ERR, "Failed to read memory from address %d. Base pointer is null ", addr );
+    }
+}
+
+void system_hw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+    if ( p_hw_base != NULL ) {
+        void *ptr = (void *)( p_hw_base + addr );
+        while ( count ) {
+            uint32_t cnt = ( count < HW_IO_BLOCK_WORDS ) ? count : HW_IO_BLOCK_WORDS;
+            unsigned long flags;
+            count -= cnt;
+            flags = system_spinlock_lock( reg_lock );
+            while ( cnt-- ) {
+                iowrite32( *data++, ptr );
+                ptr += 4;
+            }
+            system_spinlock_unlock( reg_lock, flags );
+        }
+    } else {
+        LOG( LOG_ERR, "Failed to write %d words to memory with offset %d. Base pointer is null ", count, addr );
+    }
+}
@@ -21,39 +21,20 @@
 #include "acamera_firmware_config.h"
 #include <linux/kernel.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
 #include "acamera_logger.h"
 
-//#define ENABLE_BOTTOM_HALF_TASKLET
-
-#ifdef ENABLE_BOTTOM_HALF_TASKLET
-#include <linux/list.h>
-#include "acamera_isp_config.h"
-
-#define ISP_TASKLET_Q_SIZE 16
-
-// tasklet queue command structure
-struct isp_tasklet_q_cmd {
-    struct list_head list;
-    uint32_t irq_status;
-    uint8_t cmd_used;
-};
-
-// tasklet structure
-struct isp_tasklet_t {
-    // tasklet
-    atomic_t tasklet_irq_cnt;
-    spinlock_t tasklet_lock;
-    struct tasklet_struct tasklet_obj;
-    // tasklet q
-    uint8_t tasklet_q_idx;
-    struct list_head tasklet_q;
-    struct isp_tasklet_q_cmd tasklet_q_cmd[ISP_TASKLET_Q_SIZE];
-};
-
-// gloval variable for tasklet access
-static struct isp_tasklet_t isp_tasklet;
-static int temp_irq = 0;
-#endif
+// bucket n counts durations below 2^n us from 2^(n-1) us, the last one everything longer
+#define ISP_IRQ_HIST_BUCKETS 12
+// report the histograms every this many interrupts
+#define ISP_IRQ_HIST_REPORT_PERIOD 4096
+
+typedef struct {
+    const char *name;
+    uint32_t bucket[ISP_IRQ_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} irq_histogram_t;
 
 typedef enum {
     ISP_IRQ_STATUS_DEINIT = 0,
@@ -64,69 +45,75 @@ typedef enum {
 
 static system_interrupt_handler_t app_handler = NULL;
 static void *app_param = NULL;
+static system_interrupt_handler_t app_thread_handler = NULL;
+static void *app_thread_param = NULL;
 static int interrupt_line_ACAMERA_JUNO_IRQ = -1;
 static int interrupt_line_ACAMERA_JUNO_IRQ_FLAGS = -1;
 static irq_status interrupt_request_status = ISP_IRQ_STATUS_DEINIT;
 
-#ifdef ENABLE_BOTTOM_HALF_TASKLET
-void isp_do_tasklet( unsigned long data )
+// time spent in the hard irq handler with interrupts off
+static irq_histogram_t irq_off_hist = {.name = "irq off"};
+// delay from the hard irq handler to the irq thread
+static irq_histogram_t irq_thread_hist = {.name = "irq thread wakeup"};
+static ktime_t irq_latch_time;
+
+static void irq_histogram_add( irq_histogram_t *hist, s64 us )
 {
-    unsigned long flags;
-    uint32_t irq_status;
-    struct isp_tasklet_q_cmd *queue_cmd;
-
-    while ( atomic_read( &isp_tasklet.tasklet_irq_cnt ) ) {
-        spin_lock_irqsave( &isp_tasklet.tasklet_lock, flags );
-        queue_cmd = list_first_entry( &isp_tasklet.tasklet_q, struct isp_tasklet_q_cmd, list );
-        if ( !queue_cmd ) {
-            atomic_set( &isp_tasklet.tasklet_irq_cnt, 0 );
-            spin_unlock_irqrestore( &isp_tasklet.tasklet_lock, flags );
-            return;
-        }
-        atomic_sub( 1, &isp_tasklet.tasklet_irq_cnt );
-        list_del( &queue_cmd->list );
-        queue_cmd->cmd_used = 0;
-        irq_status = queue_cmd->irq_status;
-
-        spin_unlock_irqrestore( &isp_tasklet.tasklet_lock, flags );
-
-        LOG( LOG_INFO, "debug value on tasklet: 0x%x\n", irq_status );
-    }
+    uint32_t idx = ( us > 0 ) ? fls( (uint32_t)min_t( s64, us, U32_MAX ) ) : 0;
+
+    if ( idx >= ISP_IRQ_HIST_BUCKETS )
+        idx = ISP_IRQ_HIST_BUCKETS - 1;
+
+    hist->bucket[idx]++;
+    hist->count++;
+    if ( us > hist->max_us )
+        hist->max_us = (uint32_t)min_t( s64, us, U32_MAX );
 }
-#endif
-irqreturn_t system_interrupt_handler( int irq, void *dev_id )
+
+static void irq_histogram_report( const irq_histogram_t *hist, int log_level )
 {
-#ifdef ENABLE_BOTTOM_HALF_TASKLET
-    unsigned long flags;
-    uint32_t irq_status;
-    struct isp_tasklet_q_cmd *queue_cmd;
-    irq_status = temp_irq++;
-    LOG( LOG_INFO, "debug value: 0x%x\n", irq_status );
-
-    spin_lock_irqsave( &isp_tasklet.tasklet_lock, flags );
-    queue_cmd = &isp_tasklet.tasklet_q_cmd[isp_tasklet.tasklet_q_idx];
-    if ( queue_cmd->cmd_used ) {
-        LOG( LOG_ERR, "Error: isp tasklet queue overflow !\n" );
-        list_del( &queue_cmd->list );
-    } else {
-        atomic_add( 1, &isp_tasklet.tasklet_irq_cnt );
-    }
-    queue_cmd->irq_status = irq_status;
-    queue_cmd->cmd_used = 1;
-    isp_tasklet.tasklet_q_idx =
-        ( isp_tasklet.tasklet_q_idx + 1 ) % ISP_TASKLET_Q_SIZE;
-    list_add_tail( &queue_cmd->list, &isp_tasklet.tasklet_q );
-    spin_unlock_irqrestore( &isp_tasklet.tasklet_lock, flags );
+    char buf[ISP_IRQ_HIST_BUCKETS * 16];
+    int len = 0;
+    int i;
+
+    for ( i = 0; i < ISP_IRQ_HIST_BUCKETS - 1; i++ )
+        len += scnprintf( buf + len, sizeof( buf ) - len, " <%uus:%u", 1U << i, hist->bucket[i] );
+    scnprintf( buf + len, sizeof( buf ) - len, " >=%uus:%u", 1U << ( ISP_IRQ_HIST_BUCKETS - 2 ), hist->bucket[ISP_IRQ_HIST_BUCKETS - 1] );
 
-    tasklet_schedule( &isp_tasklet.tasklet_obj );
+    LOG( log_level, "%s: %u interrupts, max %u us,%s", hist->name, hist->count, hist->max_us, buf );
+}
+
+// hard irq: only the time critical part, the rest is done by the irq thread
+irqreturn_t system_interrupt_handler( int irq, void *dev_id )
+{
+    irqreturn_t result = IRQ_HANDLED;
+    ktime_t start = ktime_get();
 
     if ( app_handler )
         app_handler( app_param, 0 );
-#else
+
+    if ( app_thread_handler ) {
+        irq_latch_time = start;
+        result = IRQ_WAKE_THREAD;
+    }
+
+    irq_histogram_add( &irq_off_hist, ktime_us_delta( ktime_get(), start ) );
+
+    return result;
+}
+
+static irqreturn_t system_interrupt_thread( int irq, void *dev_id )
+{
+    irq_histogram_add( &irq_thread_hist, ktime_us_delta( ktime_get(), irq_latch_time ) );
+
     LOG( LOG_INFO, "interrupt comes in (irq = %d)\n", irq );
-    if ( app_handler )
-        app_handler( app_param, 0 );
-#endif
+    if ( app_thread_handler )
+        app_thread_handler( app_thread_param, 0 );
+
+    if ( ( irq_thread_hist.count % ISP_IRQ_HIST_REPORT_PERIOD ) == 0 ) {
+        irq_histogram_report( &irq_off_hist, LOG_DEBUG );
+        irq_histogram_report( &irq_thread_hist, LOG_DEBUG );
+    }
 
     return IRQ_HANDLED;
 }
@@ -153,18 +140,9 @@ void system_interrupts_init( void )
     }
     interrupt_request_status = ISP_IRQ_STATUS_ENABLED;
 
-#ifdef ENABLE_BOTTOM_HALF_TASKLET
-    // init tasklet and tasklet_q
-    atomic_set( &isp_tasklet.tasklet_irq_cnt, 0 );
-    spin_lock_init( &isp_tasklet.tasklet_lock );
-    isp_tasklet.tasklet_q_idx = 0;
-    INIT_LIST_HEAD( &isp_tasklet.tasklet_q );
-    tasklet_init( &isp_tasklet.tasklet_obj, isp_do_tasklet, (unsigned long)&isp_tasklet );
-#endif
-
     // No dev_id for now, but will need this to be shared
-    if ( ( ret = request_irq( interrupt_line_ACAMERA_JUNO_IRQ,
-                              &system_interrupt_handler, interrupt_line_ACAMERA_JUNO_IRQ_FLAGS, "isp", NULL ) ) ) {
+    if ( ( ret = request_threaded_irq( interrupt_line_ACAMERA_JUNO_IRQ,
+                                       &system_interrupt_handler, &system_interrupt_thread, interrupt_line_ACAMERA_JUNO_IRQ_FLAGS, "isp", NULL ) ) ) {
         LOG( LOG_ERR, "Could not get interrupt %d (ret=%d)\n", interrupt_line_ACAMERA_JUNO_IRQ, ret );
     } else {
         LOG( LOG_INFO, "Interrupt %d requested (flags = 0x%x, ret = %d)\n",
@@ -187,12 +165,11 @@ void system_interrupts_deinit( void )
     }
     app_handler = NULL;
     app_param = NULL;
+    app_thread_handler = NULL;
+    app_thread_param = NULL;
 
-#ifdef ENABLE_BOTTOM_HALF_TASKLET
-    // kill tasklet
-    tasklet_kill( &isp_tasklet.tasklet_obj );
-    atomic_set( &isp_tasklet.tasklet_irq_cnt, 0 );
-#endif
+    irq_histogram_report( &irq_off_hist, LOG_INFO );
+    irq_histogram_report( &irq_thread_hist, LOG_INFO );
 }
 
 void system_interrupt_set_handler( system_interrupt_handler_t handler, void *param )
@@ -201,6 +178,12 @@ void system_interrupt_set_handler( system_interrupt_handler_t handler, void *par
     app_param = param;
 }
 
+void system_interrupt_set_thread_handler( system_interrupt_handler_t handler, void *param )
+{
+    app_thread_param = param;
+    app_thread_handler = handler;
+}
+
 void system_interrupts_enable( void )
 {
     if ( interrupt_request_status == ISP_IRQ_STATUS_DISABLED ) {
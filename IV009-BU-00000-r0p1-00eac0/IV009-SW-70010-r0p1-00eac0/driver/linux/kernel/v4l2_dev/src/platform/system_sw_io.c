@@ -20,6 +20,7 @@
 #include "acamera_logger.h"
 #include <linux/gfp.h>
 #include <linux/slab.h>
+#include <linux/string.h>
 
 int32_t init_sw_io( void )
 {
@@ -44,6 +45,16 @@ void system_sw_free( void *ptr )
     kfree( ptr );
 }
 
+#if SYSTEM_SW_IO_INLINE
+void system_sw_io_null_access( uintptr_t addr, uint32_t data, int write )
+{
+    if ( write ) {
+        LOG( LOG_ERR, "Failed to write %d to memory 0x%x. Base pointer is null ", data, addr );
+    } else {
+        LOG( LOG_ERR, "Failed to read memory from address 0x%x. Base pointer is null ", addr );
+    }
+}
+#else
 uint32_t system_sw_read_32( uintptr_t addr )
 {
     uint32_t result = 0;
@@ -55,6 +66,7 @@ uint32_t system_sw_read_32( uintptr_t addr )
     }
     return result;
 }
+#endif
 
 uint16_t system_sw_read_16( uintptr_t addr )
 {
@@ -81,6 +93,7 @@ uint8_t system_sw_read_8( uintptr_t addr )
 }
 
 
+#if !SYSTEM_SW_IO_INLINE
 void system_sw_write_32( uintptr_t addr, uint32_t data )
 {
     if ( (void *)addr != NULL ) {
@@ -90,6 +103,7 @@ void system_sw_write_32( uintptr_t addr, uint32_t data )
         LOG( LOG_ERR, "Failed to write %d to memory 0x%x. Base pointer is null ", data, addr );
     }
 }
+#endif
 
 void system_sw_write_16( uintptr_t addr, uint16_t data )
 {
@@ -110,3 +124,12 @@ void system_sw_write_8( uintptr_t addr, uint8_t data )
         LOG( LOG_ERR, "Failed to write %d to memory 0x%x. Base pointer is null ", data, addr );
     }
 }
+
+void system_sw_write_block_32( uintptr_t addr, const uint32_t *data, uint32_t count )
+{
+    if ( (void *)addr != NULL ) {
+        memcpy( (void *)addr, data, count * sizeof( uint32_t ) );
+    } else {
+        LOG( LOG_ERR, "Failed to write %d words to memory 0x%x. Base pointer is null ", count, addr );
+    }
+}